@@ -1,471 +1,982 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/stat.h>
 #include "first_second_pass_data.h"
 #include "macro_data.h"
 #include "first_second_pass.h"
+#include "io_backend.h"
+#include "diagnostics.h"
+#include "work_stealing_pool.h"
+#include "assembly_cache.h"
+#include "file_watch.h"
+#include "assembly_daemon.h"
+#include "language_server.h"
+#include "object_reader.h"
+#include "linker.h"
+#include "assembly.h"
 
+/**
+ * Holds the state shared by the workers of a concurrent run of several files.
+ */
+typedef struct {
+    char **arguments; /* The file arguments, in command-line order */
+    AssemblerOptions *options; /* Pointer to the command-line options */
+    IoBackend *backends; /* One batched I/O backend per worker, NULL for plain I/O */
+    OutputBuffer *diagnostics; /* The diagnostics reported while assembling every file */
+    int *error_flags; /* ERROR_FOUND for every file that could not be assembled into its outputs */
+} ParallelAssembly;
 
 /**
- * Checks if there is any symbol in the symbol table with the entry flag set to 1.
+ * Holds what the reassembly of a watched file needs.
+ */
+typedef struct {
+    char **arguments; /* The file arguments, in command-line order */
+    AssemblerOptions *options; /* Pointer to the command-line options */
+} WatchSession;
+
+/**
+ * Writes the options that change the outputs or the diagnostics of a source, for its cache key.
+ * The options that only change how the work is done, such as the number of threads, are left out,
+ * so an entry stored by one run is found by another with different ones.
  *
- * @param head_of_symbol_table Pointer to the head of the symbol table
- * @return int TRUE if there is a symbol with the entry flag set to 1, FALSE otherwise.
+ * @param options Pointer to the command-line options
+ * @param flags The buffer to write the options to, MAX_LINE characters long
+ * @return void
  */
-static int is_entry_exist(SymbolNode *head_of_symbol_table) {
-    SymbolNode *current = head_of_symbol_table;
+static void write_cache_flags(AssemblerOptions *options, char flags[MAX_LINE]) {
+    flags[0] = '\0';
 
-    /* Traverse the symbol table */
-    while (current != NULL) {
+    /* The memo counts depend on how the first pass is split */
+    if (options->memo_stats) {
+        sprintf(flags, "--memo-stats --fp-threads %d",
+                options->first_pass_threads > 1 ? options->first_pass_threads : 1);
+    }
 
-        /* Check if the current symbol has the entry flag set to 1 */
-        if(current->entry_flag == 1) {
-            return TRUE;
-        }
+    /* The entry holds the binary object only when it was asked for */
+    if (options->binary_object) {
+        strcat(flags, " --binary-ob");
+    }
 
-        /* Move to the next symbol in the table */
-        current = current->next;
+    /* The diagnostics are kept as they were written */
+    if (options->diagnostic_format == JSON_DIAGNOSTICS) {
+        strcat(flags, " --diagnostics json");
+    }
+    if (options->max_repeats > 0) {
+        sprintf(flags + strlen(flags), " --max-repeats %d", options->max_repeats);
     }
-    return FALSE;
 }
 
 /**
- * Counts occurrences of an external symbol in an assembly line.
+ * Restores the outputs and the diagnostics of a source from its cache entry, as assembling it would give them.
  *
- * @param line A string representing the assembly code line
- * @param symbol_name A string representing the external symbol to check
- * @return int Number of times the external symbol appears (0, 1, or 2)
+ * @param entry Pointer to the mapped cache entry
+ * @param base_name The file name without any extension
+ * @param options Pointer to the command-line options
+ * @return AssemblyResult ASSEMBLED if the entry holds an object output, SOURCE_HAS_ERRORS if it does not,
+ *         or OUTPUT_FAILED if an output could not be written
  */
-static int count_extern_symbol_in_line(char * line, char *symbol_name) {
-    int external_symbol_count = 0;
-
-    int i = 0, j = 0;
-
-    char *input = malloc(strlen(line) + 1);
-    char *original_input;
-    char first_operand[MAX_LINE] = {0};
-    char second_operand[MAX_LINE] = {0};
-    char command[MAX_LINE] = {0};
+static AssemblyResult restore_cached_outputs(SourceFile *entry, char *base_name, AssemblerOptions *options) {
+    OutputBuffer output = {NULL, 0, 0};
+    AssemblyResult result = SOURCE_HAS_ERRORS;
+    char name[MAX_FRAME_NAME];
+    char extension[MAX_FRAME_NAME + 1];
+    char *data;
+    size_t length;
+
+    while (result != OUTPUT_FAILED && next_cache_section(entry, name, &data, &length) == TRUE) {
+        if (strcmp(name, "diagnostics") == 0) {
+            report_diagnostic_text(data, length);
+            continue;
+        }
 
-    if(check_memory_allocation(input) == FALSE) {
-        exit(1);
+        /* Every other section is an output file, named by its extension */
+        sprintf(extension, ".%s", name);
+        output_reset(&output);
+        output_append(&output, data, length);
+        if (emit_output(&output, base_name, extension, -1, options->io, NULL) == FALSE) {
+            result = OUTPUT_FAILED;
+        } else if (strcmp(name, "ob") == 0) {
+            result = ASSEMBLED;
+        }
     }
+    free_output_buffer(&output);
 
-    /* Stores the original address of input to ensure proper memory deallocation */
-    original_input = input;
-    strcpy(input, line);
-
-    /* Check if the line starts with a symbol (label) */
-    if (is_symbol(input) == TRUE) {
-
-        /* Pass the label (until ':') */
-        while (input[i] != ':') i++;
-
-        /* Pass the ':' character */
-        i++;
+    if (options->io != NULL) {
+        submit_io(options->io);
     }
+    return result;
+}
 
-    /* Skip leading spaces in input */
-    while (isspace(input[i])) i++;
-    input = input + i;
-    i = 0;
+/**
+ * Assembles one source file through the cache when one is given, unless the file is only checked.
+ * On a hit, the outputs and the diagnostics are restored from the entry of the source
+ * without preprocessing it or running either pass.
+ * On a miss, the source is assembled while its outputs and diagnostics are recorded,
+ * and the entry is stored unless an output could not be written or memory ran out.
+ *
+ * @param source Pointer to the source file
+ * @param base_name The file name without any extension
+ * @param options Pointer to the command-line options
+ * @return AssemblyResult The outcome of the assembly, see assemble_source
+ */
+static AssemblyResult assemble_cached(SourceFile *source, char *base_name, AssemblerOptions *options) {
+    OutputBuffer cache_entry = {NULL, 0, 0};
+    OutputBuffer diagnostics = {NULL, 0, 0};
+    OutputBuffer *sink;
+    SourceFile entry;
+    AssemblyResult result;
+    char key[SHA256_HEX_SIZE + 1];
+    char flags[MAX_LINE];
+
+    if (options->cache.directory == NULL || options->check_only) {
+        return assemble_source(source, base_name, options, NULL);
+    }
 
-    /* Extract the command name from input */
-    while (!isspace(input[i]) && input[i] != '\0' && input[i] != ',') {
-        command[j++] = input[i++];
+    write_cache_flags(options, flags);
+    make_cache_key(key, flags, source);
+    if (load_cache_entry(&options->cache, key, &entry) == TRUE) {
+        result = restore_cached_outputs(&entry, base_name, options);
+        close_source_file(&entry);
+        return result;
     }
-    command[j] = '\0';
-    input = input + i;
-    i = 0;
-    j = 0;
 
-    /* Skip leading spaces in input */
-    while (isspace(input[i])) i++;
-    input = input + i;
-    i = 0;
+    /* Capture the diagnostics of the source, with the counts of the errors left out, to record them,
+     * then pass them on */
+    sink = current_diagnostics_sink();
+    capture_diagnostics(&diagnostics);
+    begin_cache_entry(&cache_entry);
+    result = assemble_source(source, base_name, options, &cache_entry);
+    summarize_diagnostic_report();
+    capture_diagnostics(sink);
+    report_diagnostic_text(diagnostics.data, diagnostics.length);
+
+    if (result == ASSEMBLED || result == SOURCE_HAS_ERRORS) {
+        output_append_frame(&cache_entry, "diagnostics", diagnostics.data, diagnostics.length);
+        store_cache_entry(&options->cache, key, &cache_entry);
+    }
 
-    /* Check if it's a command line and not a directive */
-    if (is_directive(command) == FALSE) {
+    free_output_buffer(&cache_entry);
+    free_output_buffer(&diagnostics);
+    return result;
+}
 
-        /* Check if there are operands */
-        if (number_of_operands(command) != 0) {
+/**
+ * Parses the options that come before the file arguments.
+ *
+ * @param argc The number of command-line arguments
+ * @param argv An array of strings representing the command-line arguments
+ * @param options Pointer to the options structure to fill
+ * @return int The index of the first file argument, or -1 if an option is invalid
+ *         or standard input is given more than once
+ */
+static int parse_options(int argc, char *argv[], AssemblerOptions *options) {
+    int number_of_streams = 0;
+    int i = 1;
+    int j;
 
-            /* Extract the first operand from the input */
-            while (!isspace(input[i]) && input[i] != ',' && input[i] != '\0') {
-                first_operand[j++] = input[i++];
-            }
-            first_operand[j] = '\0';
-            input = input + i;
-            i = 0;
-            j = 0;
-
-            /* Check if the first operand is the external symbol */
-            if (strcmp(first_operand, symbol_name) == 0) {
-                external_symbol_count++;
-            }
+    init_assembler_options(options);
 
-            /* If there are two operands */
-            if (number_of_operands(command) == 2) {
+    while (i < argc && (strncmp(argv[i], "--", 2) == 0 || strcmp(argv[i], "-j") == 0)) {
+        int *target = NULL;
 
-                /* Skip spaces between operands */
-                while (isspace(input[i])) i++;
+        /* Options that take no number */
+        if (strcmp(argv[i], "--pipeline") == 0) {
+            options->pipeline = TRUE;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--one-pass") == 0) {
+            options->one_pass = TRUE;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--low-memory") == 0) {
+            options->low_memory = TRUE;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--binary-ob") == 0) {
+            options->binary_object = TRUE;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--verify") == 0) {
+            options->verify = TRUE;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--lsp") == 0) {
+            options->language_server = TRUE;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--watch") == 0) {
+            options->watch = TRUE;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--memo-stats") == 0) {
+            options->memo_stats = TRUE;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--check") == 0) {
+            options->check_only = TRUE;
+            i++;
+            continue;
+        }
 
-                /* +1 for skip the comma between operands */
-                input = input + i + 1;
-                i = 0;
+        /* Options that take a path */
+        if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            options->cache.directory = argv[i + 1];
+            i += 2;
+            continue;
+        }
+        if (strcmp(argv[i], "--diagnostics") == 0 && i + 1 < argc &&
+            (strcmp(argv[i + 1], "text") == 0 || strcmp(argv[i + 1], "json") == 0)) {
+            options->diagnostic_format = strcmp(argv[i + 1], "json") == 0 ? JSON_DIAGNOSTICS : TEXT_DIAGNOSTICS;
+            i += 2;
+            continue;
+        }
+        if (strcmp(argv[i], "--daemon") == 0 && i + 1 < argc) {
+            options->daemon_socket = argv[i + 1];
+            i += 2;
+            continue;
+        }
+        if (strcmp(argv[i], "--link") == 0 && i + 1 < argc) {
+            options->link_output = argv[i + 1];
+            i += 2;
+            continue;
+        }
+        if (strcmp(argv[i], "--client") == 0 && i + 1 < argc) {
+            options->client_socket = argv[i + 1];
+            i += 2;
+            continue;
+        }
 
-                /* Skip spaces before the second operand */
-                while (isspace(input[i])) i++;
-                input = input + i;
-                i = 0;
+        if (strcmp(argv[i], "--ob-fd") == 0) {
+            target = &options->object_fd;
+        } else if (strcmp(argv[i], "--ent-fd") == 0) {
+            target = &options->entries_fd;
+        } else if (strcmp(argv[i], "--ext-fd") == 0) {
+            target = &options->externals_fd;
+        } else if (strcmp(argv[i], "--ob-threads") == 0) {
+            target = &options->object_threads;
+        } else if (strcmp(argv[i], "--batch-io") == 0) {
+            target = &options->read_ahead;
+        } else if (strcmp(argv[i], "--fp-threads") == 0) {
+            target = &options->first_pass_threads;
+        } else if (strcmp(argv[i], "--check-threads") == 0) {
+            target = &options->check_threads;
+        } else if (strcmp(argv[i], "--cache-size") == 0) {
+            target = &options->cache_size;
+        } else if (strcmp(argv[i], "--max-errors") == 0) {
+            target = &options->max_errors;
+        } else if (strcmp(argv[i], "--max-repeats") == 0) {
+            target = &options->max_repeats;
+        } else if (strcmp(argv[i], "-j") == 0) {
+            target = &options->jobs;
+        }
 
-                /* Extract the second operand from the input */
-                while (!isspace(input[i]) && input[i] != ',' && input[i] != '\0') {
-                    second_operand[j++] = input[i++];
-                }
-                second_operand[j] = '\0';
+        /* Every other option takes a non-negative number */
+        if (target == NULL || i + 1 >= argc || !isdigit(argv[i + 1][0])) {
+            printf("Invalid option: %s\n", argv[i]);
+            return -1;
+        }
+        *target = atoi(argv[i + 1]);
+        i += 2;
+    }
 
-                /* Check if the second operand is the external symbol */
-                if (strcmp(second_operand, symbol_name) == 0) {
-                    external_symbol_count++;
-                }
+    options->cache.size_limit = (unsigned long)options->cache_size * 1024 * 1024;
 
-            }
+    /* Standard input can only be read once */
+    for (j = i; j < argc; j++) {
+        if (strcmp(argv[j], STREAM_ARGUMENT) == 0) {
+            number_of_streams++;
         }
     }
-    free(original_input);
-    return external_symbol_count;
+    if (number_of_streams > 1) {
+        printf("Standard input can only be given once: %s\n", STREAM_ARGUMENT);
+        return -1;
+    }
+    return i;
 }
 
 /**
- * Checks if there is any symbol in the symbol table with the type EXTERN.
- * and whether it is used in any of the assembly lines.
+ * Assembles standard input and writes the outputs as frames to standard output
+ * or to the file descriptors given on the command line. Nothing is written to the filesystem.
+ * While streaming, diagnostics are written to standard error so they do not mix with the frames,
+ * and standard output is given back to the files that follow once the stream is done.
  *
- * @param head_of_symbol_table Pointer to the head of the symbol table
- * @param head_of_lines_list Pointer to the head of the assembly lines list
- * @return int TRUE if there is a symbol with the type EXTERN that appears in at least one assembly line,
- *             FALSE otherwise
+ * @param options Pointer to the command-line options
+ * @return int ERROR_FOUND if the source could not be read or an error was found, ERROR_WAS_NOT_FOUND otherwise
  */
-static int is_extern_exist(SymbolNode *head_of_symbol_table, AssemblyLineList *head_of_lines_list) {
-    SymbolNode *current_symbol = head_of_symbol_table;
-
-    /* Traverse the symbol table */
-    while (current_symbol != NULL) {
-
-        /* Check if the current symbol is of type EXTERN */
-        if(current_symbol->type == EXTERN) {
-            AssemblyLineList *current_line = head_of_lines_list;
-
-            /* Traverse through each line in the assembly code */
-            while (current_line != NULL) {
-                int number_of_extern_symbol = 0;
-                char * line = current_line->line;
-
-                /* Count how many times the external symbol appears in the line, if it exists */
-                number_of_extern_symbol = count_extern_symbol_in_line(line, current_symbol->symbol_name);
+static int assemble_stream(AssemblerOptions *options) {
+    AssemblerOptions stream_options = *options;
+    SourceFile source;
+    DiagnosticReport report;
+    AssemblyResult result = OUTPUT_FAILED;
+    int frames_fd = -1;
+
+    /* Keep standard output for the frames and send the diagnostics to standard error until the stream is done */
+    if (options->object_fd == -1 || options->entries_fd == -1 || options->externals_fd == -1) {
+        fflush(stdout);
+        frames_fd = dup(STDOUT_FILENO);
+        if (frames_fd == -1 || dup2(STDERR_FILENO, STDOUT_FILENO) == -1) {
+            if (frames_fd != -1) {
+                close(frames_fd);
+            }
+            printf("Error redirecting the standard output.\n");
+            return ERROR_FOUND;
+        }
+        if (stream_options.object_fd == -1) stream_options.object_fd = frames_fd;
+        if (stream_options.entries_fd == -1) stream_options.entries_fd = frames_fd;
+        if (stream_options.externals_fd == -1) stream_options.externals_fd = frames_fd;
+    }
 
-                /* If the external symbol is found in the line, return TRUE */
-                if(number_of_extern_symbol != 0) {
-                    return TRUE;
-                }
+    if (read_source_stream(&source, STDIN_FILENO) == FALSE) {
+        printf("Error reading the standard input.\n");
+    } else if (source.size == 0) {
+        printf("The standard input is empty.\n");
+        close_source_file(&source);
+    } else {
+        begin_diagnostic_report(&report, STREAM_ARGUMENT, stream_options.diagnostic_format,
+                                stream_options.max_repeats);
+        result = assemble_source(&source, NULL, &stream_options, NULL);
+        end_diagnostic_report(&report);
+        close_source_file(&source);
+    }
 
-                /* Move to the next assembly line */
-                current_line = current_line->next;
-            }
+    /* Give the files that follow their standard output back */
+    fflush(stdout);
+    if (frames_fd != -1) {
+        if (dup2(frames_fd, STDOUT_FILENO) == -1) {
+            printf("Error restoring the standard output.\n");
+            result = OUTPUT_FAILED;
         }
-        /* Move to the next symbol in the table */
-        current_symbol = current_symbol->next;
+        close(frames_fd);
     }
-    return FALSE;
+    return result == ASSEMBLED ? ERROR_WAS_NOT_FOUND : ERROR_FOUND;
 }
 
 /**
- * Creates an externals file containing all external symbols names
- * and their addresses in the machine code where they are used.
+ * Assembles one source file given on the command line. The source is taken from the batched I/O backend
+ * if there is one, or mapped otherwise. Errors in the source are reported but do not count as a failure.
  *
- * @param head_of_symbol_table Pointer to the head of the symbol table
- * @param head_of_lines_list Pointer to the head of the assembly line list
- * @param file_name The file name without any extension
- * @return void
+ * @param argument The file argument, the source file name without its ".as" extension
+ * @param directory The directory a relative file argument is in, or NULL for the working directory
+ * @param options Pointer to the command-line options
+ * @param recording Pointer to the buffer to record the outputs in as frames instead of writing them,
+ *        or NULL to write the output files
+ * @return int ERROR_FOUND if the file could not be opened, was empty, or an output could not be written,
+ *         or with --check if the source has errors, ERROR_WAS_NOT_FOUND otherwise
  */
-static void create_externals_file (SymbolNode *head_of_symbol_table, AssemblyLineList *head_of_lines_list, char *file_name) {
+static int assemble_file(char *argument, char *directory, AssemblerOptions *options, OutputBuffer *recording) {
+    SourceFile original_source_file;
+    DiagnosticReport report;
+    char* expanded_to_as_file;
+    char *source_path;
+    int is_open;
+    int is_out_of_memory = FALSE;
+    int error_flag = ERROR_WAS_NOT_FOUND;
+
+    /* Concatenate the file name with ".as" extension */
+    expanded_to_as_file = make_file_name(argument, ".as");
+    if (expanded_to_as_file == NULL) {
+        return ERROR_FOUND;
+    }
 
-    /* Check if there are any external symbols in the symbol table */
-    if(is_extern_exist(head_of_symbol_table, head_of_lines_list) == TRUE) {
-        char *externals_file_name;
-        FILE *externals_output_file;
-        SymbolNode *curren_symbol;
+    /* Collect the diagnostics of the file, to pass them on in one write */
+    begin_diagnostic_report(&report, expanded_to_as_file, options->diagnostic_format, options->max_repeats);
 
-        /* create the externals file name */
-        externals_file_name = malloc(strlen(file_name) + 5);
+    /* A relative file argument of a daemon client is in the working directory of the client */
+    source_path = expanded_to_as_file;
+    if (directory != NULL && expanded_to_as_file[0] != '/') {
+        char *prefix = make_file_name(directory, "/");
 
-        /* Check if memory allocation was successful */
-        if(check_memory_allocation(externals_file_name) == FALSE) {
-            exit(1);
+        source_path = prefix != NULL ? make_file_name(prefix, expanded_to_as_file) : NULL;
+        free(prefix);
+        if (source_path == NULL) {
+            end_diagnostic_report(&report);
+            free(expanded_to_as_file);
+            return ERROR_FOUND;
         }
-        externals_file_name[0] = '\0';
-
-        /* Concatenate the file name with ".ext" extension */
-        strcat(externals_file_name, file_name);
-        strcat(externals_file_name, ".ext");
+    }
 
-        /* Open the externals file for writing */
-        externals_output_file = fopen(externals_file_name, "w");
+    /* Take the file that was read ahead, or map the original source file for reading */
+    if (options->io != NULL) {
+        is_open = take_file_read(options->io, source_path, &original_source_file);
+    } else {
+        is_open = map_source_file(&original_source_file, source_path);
+    }
 
-        if (check_file_open(externals_output_file, externals_file_name) == FALSE) {
-            exit(1);
-        }
+    if (is_open == FALSE) {
+        report_diagnostic("Error opening file: %s\n", argument);
+        error_flag = ERROR_FOUND;
+    }
 
-        /* Iterate over the symbol table to find external symbols */
-        curren_symbol = head_of_symbol_table;
-        while (curren_symbol != NULL) {
+    /* The size of the source tells if the file is empty */
+    else if(original_source_file.size == 0) {
+        report_diagnostic("File %s is empty.\n", expanded_to_as_file);
+        close_source_file(&original_source_file);
+        error_flag = ERROR_FOUND;
+    }
 
-            /* Check if the current symbol is external */
-            if(curren_symbol->type == EXTERN) {
+    else {
+        AssemblyResult result;
 
-                /* Iterate over the assembly line list to find references to the external symbol */
-                AssemblyLineList *current_line = head_of_lines_list;
-                while (current_line != NULL) {
-                    int number_of_extern_symbol = 0;
-                    char * line = current_line->line;
+        if (recording != NULL) {
+            result = assemble_source(&original_source_file, NULL, options, recording);
+        } else {
+            result = assemble_cached(&original_source_file, argument, options);
+        }
 
-                    /* Count how many times the external symbol appears in the line, if it exists */
-                    number_of_extern_symbol = count_extern_symbol_in_line(line, curren_symbol->symbol_name);
+        /* Errors in the source only fail a run that checks the files */
+        if (result == OUTPUT_FAILED || result == OUT_OF_MEMORY ||
+            (result == SOURCE_HAS_ERRORS && options->check_only)) {
+            error_flag = ERROR_FOUND;
+        }
+        is_out_of_memory = result == OUT_OF_MEMORY;
 
+        /* Release the original source file */
+        close_source_file(&original_source_file);
+    }
 
-                    /* If the external symbol appears in the line at least once */
-                    if(number_of_extern_symbol != 0) {
+    end_diagnostic_report(&report);
 
-                        /* Write to the externals file the address where the first external symbol appeared */
-                        fprintf(externals_output_file, "%s %07d\n", curren_symbol->symbol_name, current_line->code->next->address);
+    /* The collected diagnostics may have been lost with the memory, this one is reported past them */
+    if (is_out_of_memory) {
+        report_diagnostic("Memory allocation failed while assembling %s\n", expanded_to_as_file);
+    }
 
-                        /* If the external symbol appears in the line two times */
-                        if (number_of_extern_symbol == 2) {
+    /* Free memory allocated for expanded file name */
+    if (source_path != expanded_to_as_file) {
+        free(source_path);
+    }
+    free(expanded_to_as_file);
+    return error_flag;
+}
 
-                            /* Write to the externals file the address where the second external symbol appeared */
-                            fprintf(externals_output_file, "%s %07d\n", curren_symbol->symbol_name, current_line->code->next->next->address);
-                        }
-                    }
+/**
+ * Runs one job of a concurrent run: assembles one file, capturing its diagnostics.
+ * Standard input is left to the main thread, which assembles it in its command-line position.
+ *
+ * @param job_index The index of the file among the file arguments
+ * @param worker_index The index of the worker thread running the job
+ * @param context Pointer to the ParallelAssembly
+ * @return void
+ */
+static void assemble_job(int job_index, int worker_index, void *context) {
+    ParallelAssembly *assembly = (ParallelAssembly *) context;
+    AssemblerOptions options = *assembly->options;
+    char *argument = assembly->arguments[job_index];
 
-                    /* Move to the next assembly line */
-                    current_line = current_line->next;
-                }
-            }
+    if (strcmp(argument, STREAM_ARGUMENT) == 0) {
+        return;
+    }
 
-            /* Move to the next symbol in the symbol table */
-            curren_symbol = curren_symbol->next;
-        }
+    capture_diagnostics(&assembly->diagnostics[job_index]);
+    if (assembly->backends != NULL) {
+        options.io = &assembly->backends[worker_index];
+    }
 
-        /* Close the externals file */
-        fclose(externals_output_file);
+    assembly->error_flags[job_index] = assemble_file(argument, NULL, &options, NULL);
 
-        /* Free the memory allocated for the externals file name */
-        free(externals_file_name);
+    /* Wait for the writes of the file, so that a failed write is reported with its own file */
+    if (options.io != NULL && finish_io(options.io) == ERROR_FOUND) {
+        assembly->error_flags[job_index] = ERROR_FOUND;
     }
+    capture_diagnostics(NULL);
 }
 
 /**
- * Creates an entries file containing the names and addresses of all entry symbols.
+ * Assembles files one after another on the calling thread, standard input in its command-line position.
  *
- * @param head_of_symbol_tabl Pointer to the head of the symbol table
- * @param file_name The file name without any extension
- * @return void
+ * @param arguments The file arguments
+ * @param number_of_files The number of file arguments
+ * @param options Pointer to the command-line options
+ * @return int ERROR_FOUND if any file could not be opened, was empty, or an output could not be written,
+ *         ERROR_WAS_NOT_FOUND otherwise
  */
-static void create_entries_file (SymbolNode *head_of_symbol_table, char *file_name) {
+static int assemble_files_sequentially(char **arguments, int number_of_files, AssemblerOptions *options) {
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    int i;
 
-    /* Check if there are any entry symbols in the symbol table */
-    if(is_entry_exist(head_of_symbol_table) == TRUE) {
-        char *entries_file_name;
-        FILE *entries_output_file;
-        SymbolNode *current;
+    for (i = 0; i < number_of_files; i++) {
+        if (strcmp(arguments[i], STREAM_ARGUMENT) == 0) {
+            if (assemble_stream(options) == ERROR_FOUND) {
+                error_flag = ERROR_FOUND;
+            }
+        } else if (assemble_file(arguments[i], NULL, options, NULL) == ERROR_FOUND) {
+            error_flag = ERROR_FOUND;
+        }
+    }
+    return error_flag;
+}
 
-        /* create the entries file name */
-        entries_file_name = malloc(strlen(file_name) + 5);
+/**
+ * Assembles several files concurrently on a work-stealing pool of options->jobs threads.
+ * The diagnostics of every file are collected while it is assembled, then printed in command-line order,
+ * so the output is the same as assembling the files one after another.
+ * If the memory of the concurrent run cannot be allocated, the files are assembled one after another instead,
+ * and if that of the I/O backends cannot, the workers read and write their files directly.
+ *
+ * @param arguments The file arguments
+ * @param number_of_files The number of file arguments
+ * @param options Pointer to the command-line options
+ * @return int ERROR_FOUND if any file could not be opened, was empty, or an output could not be written,
+ *         ERROR_WAS_NOT_FOUND otherwise
+ */
+static int assemble_files_concurrently(char **arguments, int number_of_files, AssemblerOptions *options) {
+    ParallelAssembly assembly;
+    WorkStealingPool pool;
+    long *file_sizes = (long *) malloc(number_of_files * sizeof(long));
+    int number_of_workers = options->jobs < number_of_files ? options->jobs : number_of_files;
+    int is_pool_started;
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    int i;
 
-        /* Check if memory allocation was successful */
-        if(check_memory_allocation(entries_file_name) == FALSE) {
-            exit(1);
-        }
-        entries_file_name[0] = '\0';
+    assembly.arguments = arguments;
+    assembly.options = options;
+    assembly.backends = NULL;
+    assembly.diagnostics = (OutputBuffer *) calloc(number_of_files, sizeof(OutputBuffer));
+    assembly.error_flags = (int *) calloc(number_of_files, sizeof(int));
+
+    /* Check if memory allocation was successful */
+    if (check_memory_allocation(file_sizes) == FALSE || check_memory_allocation(assembly.diagnostics) == FALSE ||
+        check_memory_allocation(assembly.error_flags) == FALSE) {
+        free(assembly.diagnostics);
+        free(assembly.error_flags);
+        free(file_sizes);
+        return assemble_files_sequentially(arguments, number_of_files, options);
+    }
 
-        /* Concatenate the file name with ".ent" extension */
-        strcat(entries_file_name, file_name);
-        strcat(entries_file_name, ".ent");
+    /* The size of every source estimates how long it takes to assemble */
+    for (i = 0; i < number_of_files; i++) {
+        struct stat file_status;
+        char *file_name = make_file_name(arguments[i], ".as");
 
-        /* Open the entries file for writing */
-        entries_output_file = fopen(entries_file_name, "w");
-        if (check_file_open(entries_output_file, entries_file_name) == FALSE) {
-            exit(1);
-        }
+        file_sizes[i] = file_name != NULL && stat(file_name, &file_status) == 0 ? (long)file_status.st_size : 0;
+        free(file_name);
+    }
 
-        /* Iterate over the symbol table to find entry symbols */
-        current = head_of_symbol_table;
-        while (current != NULL) {
+    /* Every worker batches the I/O of its files on its own backend */
+    if (options->read_ahead > 0) {
+        assembly.backends = (IoBackend *) malloc(number_of_workers * sizeof(IoBackend));
+        if (check_memory_allocation(assembly.backends) == TRUE) {
+            for (i = 0; i < number_of_workers; i++) {
+                init_io_backend(&assembly.backends[i]);
+            }
+        }
+    }
 
-            /* Check if the symbol has entry flag set to 1 */
-            if(current->entry_flag == 1) {
+    is_pool_started = start_work_stealing_pool(&pool, number_of_files, file_sizes, number_of_workers,
+                                               assemble_job, &assembly);
 
-                /* Write to the entries file the name and address of the symbol */
-                fprintf(entries_output_file, "%s %07d\n", current->symbol_name, current->address);
+    /* Print the diagnostics of every file in order as soon as it is done */
+    for (i = 0; i < number_of_files; i++) {
+        if (strcmp(arguments[i], STREAM_ARGUMENT) == 0) {
+            if (assemble_stream(options) == ERROR_FOUND) {
+                error_flag = ERROR_FOUND;
             }
+            continue;
+        }
 
-            /* Move to the next symbol in the table */
-            current = current->next;
+        /* Without threads, the main thread assembles the file itself */
+        if (is_pool_started) {
+            wait_for_job(&pool, i);
+        } else {
+            assemble_job(i, 0, &assembly);
         }
 
-        /* Close the entries file */
-        fclose(entries_output_file);
+        if (assembly.diagnostics[i].length > 0) {
+            fwrite(assembly.diagnostics[i].data, 1, assembly.diagnostics[i].length, stdout);
+        }
+        free_output_buffer(&assembly.diagnostics[i]);
+        if (assembly.error_flags[i] == ERROR_FOUND) {
+            error_flag = ERROR_FOUND;
+        }
+    }
 
-        /* Free the memory allocated for the entries file name */
-        free(entries_file_name);
+    if (is_pool_started) {
+        join_work_stealing_pool(&pool);
     }
+    if (assembly.backends != NULL) {
+        for (i = 0; i < number_of_workers; i++) {
+            close_io_backend(&assembly.backends[i]);
+        }
+        free(assembly.backends);
+    }
+    free(assembly.diagnostics);
+    free(assembly.error_flags);
+    free(file_sizes);
+    return error_flag;
 }
 
 /**
- * Compares the addresses of two BinaryMachineCode structures
+ * Checks if two modules hold the same words and the same records in the same order.
  *
- * @param x Pointer to the first BinaryMachineCode structure
- * @param y Pointer to the second BinaryMachineCode structure
- * @return int the difference between the addresses.
- *             a positive number if the address of 'x' is greater,
- *             a negative number if 'x' is smaller, and zero if the addresses are equal.
+ * @param first Pointer to the first module
+ * @param second Pointer to the second module
+ * @return int TRUE if the modules are the same, FALSE otherwise
  */
-static int compare_addresses(const void *x, const void *y) {
-    return ((BinaryMachineCode *)x)->address - ((BinaryMachineCode *)y)->address;
+static int is_same_module(ObjectModule *first, ObjectModule *second) {
+    int i;
+
+    if (first->number_of_code_words != second->number_of_code_words ||
+        first->number_of_data_words != second->number_of_data_words ||
+        first->number_of_entries != second->number_of_entries ||
+        first->number_of_externals != second->number_of_externals ||
+        memcmp(first->words, second->words,
+               (first->number_of_code_words + first->number_of_data_words) * sizeof(unsigned long)) != 0) {
+        return FALSE;
+    }
+    for (i = 0; i < first->number_of_entries; i++) {
+        if (first->entries[i].address != second->entries[i].address ||
+            strcmp(first->entries[i].symbol_name, second->entries[i].symbol_name) != 0) {
+            return FALSE;
+        }
+    }
+    for (i = 0; i < first->number_of_externals; i++) {
+        if (first->externals[i].address != second->externals[i].address ||
+            strcmp(first->externals[i].symbol_name, second->externals[i].symbol_name) != 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
 }
 
 /**
- * Sorts a linked list of machine code words by their addressess.
+ * Reads back the outputs of every file argument and verifies them: the header counts and the addresses
+ * of the object file, and the entries and externals against its words. A binary object next to them
+ * is verified too, and must hold the same program.
  *
- * @param head_of_lines_list Pointer to the head of the assembly line list
- * @param ICF The instruction counter value
- * @param DCF The data counter value
- * @return BinaryMachineCode A pointer to the sorted array of BinaryMachineCode
+ * @param arguments The file arguments, file names without extension
+ * @param number_of_files The number of file arguments
+ * @return int ERROR_FOUND if any output could not be read or is inconsistent, ERROR_WAS_NOT_FOUND otherwise
  */
-static BinaryMachineCode *sort_machine_code_list(AssemblyLineList *head_of_lines_list, int ICF, int DCF) {
+static int verify_objects(char **arguments, int number_of_files) {
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    int i;
 
-    /* Calculate the total number of words in the list based on ICF and DCF */
-    size_t word_count = (ICF - 100) + DCF;
+    for (i = 0; i < number_of_files; i++) {
+        ObjectModule module, binary_module;
+        char *binary_name = make_file_name(arguments[i], ".obx");
+        int module_flag = read_object_module(arguments[i], &module);
 
-    BinaryMachineCode *array;
-    AssemblyLineList *current;
+        if (module_flag == ERROR_WAS_NOT_FOUND && binary_name == NULL) {
+            module_flag = ERROR_OUT_OF_MEMORY;
+        }
+        if (module_flag == ERROR_OUT_OF_MEMORY) {
+            report_diagnostic("Memory allocation failed!\n");
+        }
+        if (module_flag == ERROR_WAS_NOT_FOUND && access(binary_name, F_OK) == 0) {
+            module_flag = read_binary_object_module(binary_name, &binary_module);
+            if (module_flag == ERROR_OUT_OF_MEMORY) {
+                report_diagnostic("Memory allocation failed!\n");
+            } else if (module_flag == ERROR_WAS_NOT_FOUND && is_same_module(&module, &binary_module) == FALSE) {
+                report_diagnostic("Error in %s: it does not hold the program of the text outputs.\n", binary_name);
+                module_flag = ERROR_FOUND;
+            }
+            free_object_module(&binary_module);
+        }
+        if (module_flag != ERROR_WAS_NOT_FOUND) {
+            error_flag = ERROR_FOUND;
+        }
+        free_object_module(&module);
+        free(binary_name);
+    }
+    return error_flag;
+}
 
-    int i;
-    int array_index = 0;
+/**
+ * Queues a read ahead of a source file, unless the argument selects standard input.
+ *
+ * @param io Pointer to the batched I/O backend
+ * @param argument The file argument, a file name without extension or "-"
+ * @return void
+ */
+static void read_ahead_source(IoBackend *io, char *argument) {
+    if (strcmp(argument, STREAM_ARGUMENT) != 0) {
+        char *file_name = make_file_name(argument, ".as");
 
-    array = malloc(word_count * sizeof(BinaryMachineCode));
-    if(check_memory_allocation(array) == FALSE) {
-        exit(1);
+        if (file_name != NULL) {
+            queue_file_read(io, file_name);
+        }
+        free(file_name);
     }
+}
 
-    current = head_of_lines_list;
-
-    /* Traverse the assembly line list */
-    while (current != NULL) {
-        BinaryMachineCode *current_code = current->code;
+/**
+ * Reassembles a watched file whose content changed, and reports how long it took.
+ *
+ * @param file_index The index of the file among the file arguments
+ * @param context Pointer to the WatchSession
+ * @return void
+ */
+static void reassemble_watched_file(int file_index, void *context) {
+    WatchSession *session = (WatchSession *) context;
+    struct timespec start, end;
+    double milliseconds;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assemble_file(session->arguments[file_index], NULL, session->options, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    milliseconds = (double)(end.tv_sec - start.tv_sec) * 1000.0 + (double)(end.tv_nsec - start.tv_nsec) / 1000000.0;
+    printf("Reassembled %s in %.3f ms\n", session->arguments[file_index], milliseconds);
+    fflush(stdout);
+}
 
-        /* Traverse the machine code linked list for the current assembly line */
-        while (current_code != NULL) {
+/**
+ * Assembles the files, then keeps running and reassembles every file whose content changes.
+ * Only the files that changed are assembled again, in the same process, so each edit costs
+ * neither a process start nor the assembly of the other files.
+ *
+ * @param arguments The file arguments
+ * @param number_of_files The number of file arguments
+ * @param options Pointer to the command-line options
+ * @return int ERROR_FOUND, once the files cannot be watched any more
+ */
+static int assemble_and_watch(char **arguments, int number_of_files, AssemblerOptions *options) {
+    WatchSession session;
+    char **file_names;
+    int i;
 
-            array[array_index].word = malloc(strlen(current_code->word) + 1);
-            if(check_memory_allocation(array[array_index].word) == FALSE) {
-                free(array);
-                exit(1);
-            }
+    for (i = 0; i < number_of_files; i++) {
+        if (strcmp(arguments[i], STREAM_ARGUMENT) == 0) {
+            printf("Standard input cannot be watched.\n");
+            return ERROR_FOUND;
+        }
+    }
 
-            /* Copy the current machine code word into the array */
-            strcpy(array[array_index].word, current_code->word);
-            array[array_index].address = current_code->address;
-            array[array_index].next = NULL;
+    /* Assemble every file once */
+    if (options->jobs > 1 && number_of_files > 1) {
+        assemble_files_concurrently(arguments, number_of_files, options);
+    } else {
+        assemble_files_sequentially(arguments, number_of_files, options);
+    }
+    fflush(stdout);
 
-            /* Link the current node in the array to the previous one (if it's not the first node) */
-            if (array_index > 0) {
-                array[array_index - 1].next = &array[array_index];
+    file_names = (char **) malloc(number_of_files * sizeof(char *));
+    if (check_memory_allocation(file_names) == FALSE) {
+        return ERROR_FOUND;
+    }
+    for (i = 0; i < number_of_files; i++) {
+        file_names[i] = make_file_name(arguments[i], ".as");
+        if (file_names[i] == NULL) {
+            while (i > 0) {
+                free(file_names[--i]);
             }
-
-            array_index++;
-
-            /* Move to the next machine code word */
-            current_code = current_code->next;
+            free(file_names);
+            return ERROR_FOUND;
         }
-        current = current->next;
     }
 
-    /* Sort the array based on the address field of the BinaryMachineCode */
-    qsort(array, word_count, sizeof(BinaryMachineCode), compare_addresses);
+    session.arguments = arguments;
+    session.options = options;
+    watch_files(file_names, number_of_files, reassemble_watched_file, &session);
 
-    /* After sorting, rebuild the linked list structure by linking the array elements */
-    for (i = 0; i < word_count - 1; i++) {
-
-        /* Link the current array node */
-        array[i].next = &array[i + 1];
+    for (i = 0; i < number_of_files; i++) {
+        free(file_names[i]);
     }
-
-    /* Set the last node to NULL */
-    array[word_count - 1].next = NULL;
-
-    return array;
+    free(file_names);
+    return ERROR_FOUND;
 }
 
 /**
- * Creates an object file containing the assembled machine code and their matching addresses.
+ * Handles one request of a daemon client: assembles the file or the source bytes of the request,
+ * recording the outputs instead of writing them. The reply holds a "diagnostics" frame, the frames
+ * of the outputs ("am", "ob", "ent", "ext"), and a "result" frame holding "1" if the request failed
+ * the way the same file argument would make the assembler fail, or "0" otherwise.
  *
- * @param head_of_lines_list Pointer to the head of the assembly line list
- * @param file_name The file name without any extension
- * @param ICF The instruction counter value
- * @param DCF The data counter value
+ * @param request_kind "path" or "source"
+ * @param request Pointer to the file argument or the source bytes
+ * @param directory The working directory of the client, or NULL
+ * @param reply Pointer to the output buffer to build the reply in
+ * @param context Pointer to the command-line options of the daemon
  * @return void
  */
-static void create_object_file(AssemblyLineList *head_of_lines_list, char *file_name, int ICF, int DCF) {
-    char *object_file_name;
-    FILE *object_output_file;
+static void serve_assembly_request(char *request_kind, OutputBuffer *request, char *directory, OutputBuffer *reply,
+                                   void *context) {
+    AssemblerOptions options = *(AssemblerOptions *) context;
+    OutputBuffer recording = {NULL, 0, 0};
+    OutputBuffer diagnostics = {NULL, 0, 0};
+    int error_flag = ERROR_WAS_NOT_FOUND;
+
+    options.io = NULL;
+    capture_diagnostics(&diagnostics);
+
+    if (strcmp(request_kind, "path") == 0) {
+        error_flag = assemble_file(request->data, directory, &options, &recording);
+    } else if (request->length == 0) {
+        report_diagnostic("The standard input is empty.\n");
+        error_flag = ERROR_FOUND;
+    } else {
+        SourceFile source;
+        DiagnosticReport report;
+
+        /* Source bytes are assembled as standard input is, so their errors fail the request */
+        view_source_buffer(&source, request->data, request->length);
+        begin_diagnostic_report(&report, STREAM_ARGUMENT, options.diagnostic_format, options.max_repeats);
+        if (assemble_source(&source, NULL, &options, &recording) != ASSEMBLED) {
+            error_flag = ERROR_FOUND;
+        }
+        end_diagnostic_report(&report);
+        close_source_file(&source);
+    }
+    capture_diagnostics(NULL);
 
-    BinaryMachineCode *sorted_code;
-    BinaryMachineCode *current_code;
+    output_append_frame(reply, "diagnostics", diagnostics.data, diagnostics.length);
+    if (recording.length > 0) {
+        output_append(reply, recording.data, recording.length);
+    }
+    output_append_frame(reply, "result", error_flag == ERROR_FOUND ? "1" : "0", 1);
 
-    /* create the object file name */
-    object_file_name = malloc(strlen(file_name) + 4);
+    free_output_buffer(&recording);
+    free_output_buffer(&diagnostics);
+}
 
-    if(check_memory_allocation(object_file_name) == FALSE) {
-        exit(1);
-    }
-    object_file_name[0] = '\0';
+/**
+ * Serves assembly requests on a Unix domain socket until the daemon is stopped.
+ *
+ * @param options Pointer to the command-line options, -j sets the number of clients served at once
+ * @return int ERROR_FOUND, once the daemon has stopped
+ */
+static int run_assembly_daemon(AssemblerOptions *options) {
+    int listen_fd = listen_on_socket(options->daemon_socket);
 
-    /* Concatenate the file name with ".ob" extension */
-    strcat(object_file_name, file_name);
-    strcat(object_file_name, ".ob");
+    if (listen_fd == -1) {
+        return ERROR_FOUND;
+    }
+    run_daemon(listen_fd, options->jobs >= 1 ? options->jobs : DEFAULT_DAEMON_THREADS, serve_assembly_request,
+               options);
+    close(listen_fd);
+    return ERROR_FOUND;
+}
 
-    /* Open the object file for writing */
-    object_output_file = fopen(object_file_name, "w");
-    if (check_file_open(object_output_file, object_file_name) == FALSE) {
-        exit(1);
+/**
+ * Sends one file argument to a daemon and writes what it replies: the output files next to the source,
+ * or the output frames for standard input, and the diagnostics.
+ *
+ * @param fd The socket connected to the daemon
+ * @param argument The file argument, a file name without extension or "-"
+ * @param options Pointer to the command-line options
+ * @return int ERROR_FOUND if the daemon reported a failure, an output could not be written,
+ *         or the connection was lost, ERROR_WAS_NOT_FOUND otherwise
+ */
+static int assemble_through_daemon(int fd, char *argument, AssemblerOptions *options) {
+    OutputBuffer frame = {NULL, 0, 0};
+    char name[MAX_FRAME_NAME];
+    int is_stream = strcmp(argument, STREAM_ARGUMENT) == 0;
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    int is_sent;
+
+    if (is_stream) {
+        SourceFile source;
+
+        if (read_source_stream(&source, STDIN_FILENO) == FALSE) {
+            fprintf(stderr, "Error reading the standard input.\n");
+            return ERROR_FOUND;
+        }
+        if (source.size > 0) {
+            output_append(&frame, source.data, source.size);
+        }
+        close_source_file(&source);
+        is_sent = write_output_frame(fd, "source", &frame);
+    } else {
+        output_append_string(&frame, argument);
+        is_sent = write_output_frame(fd, "path", &frame);
     }
 
-    /* Write the instruction and data counters (ICF - 100 and DCF) to the object file */
-    fprintf(object_output_file, "    %d %d\n", ICF-100, DCF);
+    /* Every reply ends with its result frame */
+    while (is_sent && read_output_frame(fd, name, &frame) == TRUE) {
+        if (strcmp(name, "result") == 0) {
+            if (frame.length != 1 || frame.data[0] != '0') {
+                error_flag = ERROR_FOUND;
+            }
+            free_output_buffer(&frame);
+            return error_flag;
+        }
+        if (strcmp(name, "diagnostics") == 0) {
+            if (frame.length > 0) {
+                fwrite(frame.data, 1, frame.length, is_stream ? stderr : stdout);
+            }
+        } else if (is_stream && strcmp(name, "am") != 0) {
+            int output_fd = strcmp(name, "ob") == 0 || strcmp(name, "obx") == 0 ? options->object_fd :
+                            strcmp(name, "ent") == 0 ? options->entries_fd : options->externals_fd;
+
+            fflush(stdout);
+            if (write_output_frame(output_fd == -1 ? STDOUT_FILENO : output_fd, name, &frame) == FALSE) {
+                fprintf(stderr, "Error writing the %s output.\n", name);
+                error_flag = ERROR_FOUND;
+            }
+        } else if (!is_stream) {
+            char extension[MAX_FRAME_NAME + 1];
+            char *file_name;
+
+            sprintf(extension, ".%s", name);
+            file_name = make_file_name(argument, extension);
+            if (file_name == NULL || write_output_file(&frame, file_name) == FALSE) {
+                error_flag = ERROR_FOUND;
+            }
+            free(file_name);
+        }
+    }
 
-    /* Sort the machine code linked list */
-    sorted_code = sort_machine_code_list(head_of_lines_list, ICF, DCF);
-    current_code = sorted_code;
+    printf("Lost the connection to the assembler daemon.\n");
+    free_output_buffer(&frame);
+    return ERROR_FOUND;
+}
 
-    while (current_code != NULL) {
-        /* Convert the binary word to a decimal value */
-        long decimal_value = strtol(current_code->word, NULL, 2);
+/**
+ * Assembles the files through the daemon listening on options->client_socket, keeping the contract
+ * of assembling them in this process: the same output files, diagnostics and exit status.
+ * The relative file arguments are resolved in the working directory of this process.
+ *
+ * @param arguments The file arguments
+ * @param number_of_files The number of file arguments
+ * @param options Pointer to the command-line options
+ * @param is_connected Pointer to set to FALSE if no daemon accepts connections, so the files are not assembled
+ * @return int ERROR_FOUND if any file failed as it would in this process, ERROR_WAS_NOT_FOUND otherwise
+ */
+static int assemble_files_through_daemon(char **arguments, int number_of_files, AssemblerOptions *options,
+                                         int *is_connected) {
+    OutputBuffer directory = {NULL, 0, 0};
+    char *working_directory = output_reserve(&directory, 4096);
+    int fd = connect_to_socket(options->client_socket);
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    int i;
 
-        /* Write the machine code address and its corresponding decimal value to the object file */
-        fprintf(object_output_file, "%07d %06lx\n", current_code->address, decimal_value);
-        current_code = current_code->next;
+    *is_connected = fd != -1;
+    if (fd == -1) {
+        free_output_buffer(&directory);
+        return ERROR_FOUND;
     }
+    signal(SIGPIPE, SIG_IGN);
 
-   /* Close the object file */
-    fclose(object_output_file);
-
-    /* Free the memory allocated for the object file name */
-    free(object_file_name);
+    /* Send the working directory, unless it cannot be found, in which case the daemon uses its own */
+    if (working_directory != NULL && getcwd(working_directory, directory.length) != NULL) {
+        directory.length = strlen(working_directory);
+        write_output_frame(fd, "cwd", &directory);
+    }
+    free_output_buffer(&directory);
 
-    /* Free the machine code list */
-    free_machine_code_list(sorted_code, ICF, DCF);
+    for (i = 0; i < number_of_files; i++) {
+        if (assemble_through_daemon(fd, arguments[i], options) == ERROR_FOUND) {
+            error_flag = ERROR_FOUND;
+        }
+    }
+    fflush(stdout);
+    close(fd);
+    return error_flag;
 }
 
 /**
@@ -482,138 +993,144 @@ static void create_object_file(AssemblyLineList *head_of_lines_list, char *file_
  *              This file is only created if there are entry symbols.
  *   .ext file: Lists all symbols defined as external and the machine code addresses where these symbols are referenced.
  *              This file is only created if there are external symbols.
+ * A file argument of "-" assembles standard input instead, see assemble_stream.
+ * With --batch-io, the upcoming source files are read ahead and the output files are written
+ * in batches through the I/O backend, overlapping the I/O with the assembly of the next file.
+ * With -j, the files are assembled concurrently, see assemble_files_concurrently.
+ * With --watch, the assembler keeps running and reassembles the files that change, see assemble_and_watch.
+ * With --lsp, it serves the Language Server Protocol to an editor instead, see run_language_server.
+ * With --daemon, it serves assembly requests on a Unix domain socket instead, see serve_assembly_request,
+ * and with --client, the files are assembled by such a daemon, see assemble_files_through_daemon.
+ * The diagnostics of every file are collected in a report and written in one write once the file is done,
+ * see begin_diagnostic_report.
+ * With --check, the files are only checked for errors and no output is written, see check_source in assembly.c.
+ * With --cache, a file whose content was already assembled has its outputs restored from the cache,
+ * see assemble_cached.
+ * A file that cannot be opened or written does not stop the remaining files.
  *
  * @param argc The number of command-line arguments
  * @param argv An array of strings representing the command-line arguments
- *             Each argument after the program name is expected to be an assembly source file name (without extension)
+ *             Optional --ob-fd, --ent-fd and --ext-fd options come first, each followed by a file descriptor,
+ *             --ob-threads followed by the number of threads formatting the object file,
+ *             --batch-io followed by the number of source files to read ahead,
+ *             -j followed by the number of files assembled concurrently,
+ *             --fp-threads followed by the number of threads the first pass of every file is split into,
+ *             --check-threads followed by the number of threads the line checks of every file are split into,
+ *             --pipeline to run the front end of every file as concurrent stages,
+ *             --one-pass to assemble every file in a single traversal (--pipeline takes precedence),
+ *             --low-memory to do so keeping only the symbol table and the packed words (it takes
+ *             precedence over --one-pass, and --pipeline over it),
+ *             --binary-ob to also write a binary object of packed words, the .obx file,
+ *             --lsp to publish the diagnostics of the documents an editor has open as they are edited,
+ *             --daemon followed by the socket path to serve assembly requests on (-j clients at once),
+ *             --client followed by the socket path of the daemon to assemble the files with,
+ *             --watch to reassemble every file that changes until interrupted,
+ *             --check to only check the files for errors, without encoding them or writing any output,
+ *             --verify to read back and verify the outputs of the files instead of assembling them,
+ *             --link followed by the name of a program to link the assembled files into, on -j threads,
+ *             --max-errors followed by the number of diagnostics after which a checked file is no longer scanned,
+ *             --diagnostics followed by "text" or "json", the form the diagnostics are written in,
+ *             --max-repeats followed by the number of errors of one code written for a file before the rest
+ *             are only counted,
+ *             --memo-stats to report how many instruction lines of every file reused the words of an earlier line,
+ *             --cache followed by the directory of the cache of assembly results,
+ *             and --cache-size followed by its size limit in megabytes.
+ *             Each following argument is expected to be an assembly source file name (without extension),
+ *             or "-" for standard input.
  *
- * @return 0 (indicating successful execution)
+ * @return 0 (indicating successful execution), 1 if a file could not be opened or written, or streaming failed,
+ *         or with --check if a file has errors, with --verify if an output is inconsistent,
+ *         or with --link if the files could not be linked
  */
 int main(int argc, char *argv[]) {
+    AssemblerOptions options;
+    IoBackend io;
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    int first_file;
     int i;
 
-    /* Iterate over all the files passed as arguments */
-    for (i = 1; i < argc; i++) {
-        FILE *original_source_file;
-        char* expanded_to_as_file;
-        MacroNode *head_of_macro_table = NULL;
-
-        expanded_to_as_file = malloc(strlen(argv[i]) + 5);
-
-        if(check_memory_allocation(expanded_to_as_file) == FALSE) {
-            exit(1);
-        }
-
-        /* Concatenate the file name with ".as" extension */
-        strcpy(expanded_to_as_file, argv[i]);
-        strcat(expanded_to_as_file, ".as");
-
-        /* Open the original source file for reading */
-        original_source_file = fopen(expanded_to_as_file, "r");
-        if (original_source_file == NULL) {
-            free(expanded_to_as_file);
-            printf("Error opening file: %s\n", argv[i]);
-            return 1;
-        }
-
-        if(fgetc(original_source_file) == EOF) {
-            printf("File %s is empty.\n", expanded_to_as_file);
-            fclose(original_source_file);
-            free(expanded_to_as_file);
-            return 1;
-        }
-
-        rewind(original_source_file);
-
-        /* Check if there are errors in the preprocessing, if no errors found continue with preprocessing */
-        if(check_preprocessing_errors(original_source_file) == ERROR_WAS_NOT_FOUND) {
-            char *am_file_name;
-            FILE *am_output_file;
-
-            am_file_name = malloc(strlen(argv[i]) + 5);
-            if(check_memory_allocation(am_file_name) == FALSE) {
-                exit(1);
-            }
-
-            /* Concatenate the file name with ".am" extension */
-            strcpy(am_file_name, argv[i]);
-            strcat(am_file_name, ".am");
-
-            /* Rewind the original source file to start over */
-            rewind(original_source_file);
-
-            /* create the file preprocessing function and get the macro table */
-            head_of_macro_table = file_preprocessing(original_source_file, am_file_name);
-
-            /* Open the expanded source file for reading */
-            am_output_file = fopen(am_file_name, "r");
-            if (check_file_open(am_output_file, am_file_name) == FALSE) {
-                exit(1);
-            }
+    first_file = parse_options(argc, argv, &options);
+    if (first_file == -1) {
+        return 1;
+    }
 
-            /* Check if there are errors in the first pass, if no errors found continue with first pass */
-            if(check_errors_in_first_pass(am_output_file, head_of_macro_table) == ERROR_WAS_NOT_FOUND) {
-                FirstPassResult result_of_first_pass;
-                AssemblyLineList *head_of_lines_list;
-                SymbolNode *head_of_symbol_table;
-                int ICF = 0, DCF = 0;
+    /* Serve the diagnostics of the documents an editor has open instead of assembling files */
+    if (options.language_server) {
+        return run_language_server() == ERROR_FOUND;
+    }
 
-                /* Rewind the expanded source file to start over */
-                rewind(am_output_file);
+    /* Serve assembly requests instead of assembling files */
+    if (options.daemon_socket != NULL) {
+        return run_assembly_daemon(&options) == ERROR_FOUND;
+    }
 
-                /* Perform the first pass and get the result,
-                 * which includes the assembly line list, symbol table,
-                 * and the values for ICF (instruction count) and DCF (data count) */
-                result_of_first_pass = first_pass(am_output_file);
-                head_of_lines_list = result_of_first_pass.head_of_lines_list;
-                head_of_symbol_table = result_of_first_pass.head_of_symbol_table;
-                ICF = result_of_first_pass.ICF;
-                DCF = result_of_first_pass.DCF;
+    /* Verify the outputs of the files instead of assembling them */
+    if (options.verify) {
+        return verify_objects(argv + first_file, argc - first_file) == ERROR_FOUND;
+    }
 
-                /* Rewind the expanded source file to start over */
-                rewind(am_output_file);
+    /* Link the assembled files into one program instead of assembling them */
+    if (options.link_output != NULL) {
+        return link_object_files(argv + first_file, argc - first_file, options.link_output, options.jobs) ==
+               ERROR_FOUND;
+    }
 
+    /* Let the daemon assemble the files, or assemble them here if no daemon is running or they are only checked */
+    if (options.client_socket != NULL && !options.check_only) {
+        int is_connected;
 
-                /* Check if there are errors in the second pass, if no errors found continue with second pass */
-                if(check_errors_in_second_pass(am_output_file, head_of_symbol_table) == ERROR_WAS_NOT_FOUND) {
-                    SecondPassResult result_of_second_pass;
+        error_flag = assemble_files_through_daemon(argv + first_file, argc - first_file, &options, &is_connected);
+        if (is_connected) {
+            return error_flag == ERROR_FOUND;
+        }
+        error_flag = ERROR_WAS_NOT_FOUND;
+    }
 
-                    /* Perform the second pass and get the result,
-                     * which includes the updated assembly line list and symbol table */
-                    result_of_second_pass = second_pass(head_of_symbol_table, &head_of_lines_list);
+    /* Keep reassembling the files as they change */
+    if (options.watch) {
+        return assemble_and_watch(argv + first_file, argc - first_file, &options) == ERROR_FOUND;
+    }
 
-                    /* Update the line list and symbol table with the result of the second pass */
-                    head_of_lines_list = result_of_second_pass.head_of_lines_list;
-                    head_of_symbol_table = result_of_second_pass.head_of_symbol_table;
+    /* Assemble several files concurrently */
+    if (options.jobs > 1 && argc - first_file > 1) {
+        return assemble_files_concurrently(argv + first_file, argc - first_file, &options) == ERROR_FOUND;
+    }
 
-                    create_object_file(head_of_lines_list, argv[i], ICF, DCF);
-                    create_entries_file(head_of_symbol_table, argv[i]);
-                    create_externals_file(head_of_symbol_table, head_of_lines_list, argv[i]);
+    /* Start reading the first files ahead */
+    if (options.read_ahead > 0) {
+        init_io_backend(&io);
+        options.io = &io;
+        for (i = first_file; i < argc && i < first_file + options.read_ahead; i++) {
+            read_ahead_source(&io, argv[i]);
+        }
+        submit_io(&io);
+    }
 
-                }
+    /* Iterate over all the files passed as arguments */
+    for (i = first_file; i < argc; i++) {
 
-                /* Free the assembly line list and symbol table after processing */
-                free_line_list(head_of_lines_list);
-                free_symbol_table(head_of_symbol_table);
+        /* Keep the read-ahead window full */
+        if (options.io != NULL && i + options.read_ahead < argc) {
+            read_ahead_source(&io, argv[i + options.read_ahead]);
+            submit_io(&io);
+        }
 
+        /* Assemble standard input into frames, or the source file */
+        if (strcmp(argv[i], STREAM_ARGUMENT) == 0) {
+            if (assemble_stream(&options) == ERROR_FOUND) {
+                error_flag = ERROR_FOUND;
             }
-
-            /* Close the expanded source file */
-            fclose(am_output_file);
-
-            /* Free memory allocated for expanded file name */
-            free(am_file_name);
-
-            /* Free the macro table */
-            free_macro_nodes(head_of_macro_table);
+        } else if (assemble_file(argv[i], NULL, &options, NULL) == ERROR_FOUND) {
+            error_flag = ERROR_FOUND;
         }
+    }
 
-        /* Close the original source file */
-        fclose(original_source_file);
-
-        /* Free memory allocated for expanded file name */
-        free(expanded_to_as_file);
-
+    /* Wait for the batched writes before exiting */
+    if (options.io != NULL) {
+        if (finish_io(&io) == ERROR_FOUND) {
+            error_flag = ERROR_FOUND;
+        }
+        close_io_backend(&io);
     }
-    return 0;
+    return error_flag == ERROR_FOUND;
 }
@@ -0,0 +1,224 @@
+#include <stdlib.h>
+#include <string.h>
+#include "diagnostics.h"
+#include "assembly.h"
+#include "assembler_library.h"
+
+/**
+ * Allocates a block with malloc, for the results of a caller that gives no allocator.
+ *
+ * @param size The number of bytes
+ * @param context Unused
+ * @return void* The block, or NULL if memory ran out
+ */
+static void *allocate_with_malloc(size_t size, void *context) {
+    (void) context;
+    return malloc(size);
+}
+
+/**
+ * Releases a block with free, for the results of a caller that gives no allocator.
+ *
+ * @param block The block
+ * @param context Unused
+ * @return void
+ */
+static void release_with_free(void *block, void *context) {
+    (void) context;
+    free(block);
+}
+
+static const AssemblerAllocator default_allocator = {allocate_with_malloc, release_with_free, NULL};
+
+/**
+ * Copies bytes into a block of the caller's allocator, followed by a null character.
+ *
+ * @param allocator Pointer to the allocator
+ * @param data The bytes
+ * @param length The number of bytes
+ * @param output Pointer to the output to set to the copy
+ * @return int TRUE if the bytes were copied, FALSE if the allocator had no block
+ */
+static int copy_output(const AssemblerAllocator *allocator, const char *data, size_t length, AssemblerOutput *output) {
+    output->data = (char *) allocator->allocate(length + 1, allocator->context);
+    if (output->data == NULL) {
+        return FALSE;
+    }
+    if (length > 0) {
+        memcpy(output->data, data, length);
+    }
+    output->data[length] = '\0';
+    output->length = length;
+    return TRUE;
+}
+
+/**
+ * Reads the next frame of a recording, as output_append_frame writes it: its name and length on a line,
+ * then its payload.
+ *
+ * @param recording Pointer to the output buffer holding the recording
+ * @param position Pointer to the position of the frame in the recording, advanced past it
+ * @param name The buffer to copy the name of the frame to, MAX_FRAME_NAME characters long
+ * @param data Pointer to set to the payload of the frame
+ * @param length Pointer to set to the length of the payload
+ * @return int TRUE if a frame was read, FALSE at the end of the recording
+ */
+static int next_recorded_frame(OutputBuffer *recording, size_t *position, char name[MAX_FRAME_NAME], char **data,
+                               size_t *length) {
+    char *header = recording->data + *position;
+    char *separator, *newline;
+
+    if (*position >= recording->length) {
+        return FALSE;
+    }
+    separator = memchr(header, ' ', recording->length - *position);
+    newline = memchr(header, '\n', recording->length - *position);
+    memcpy(name, header, (size_t)(separator - header));
+    name[separator - header] = '\0';
+    *length = (size_t) strtoul(separator + 1, NULL, 10);
+    *data = newline + 1;
+    *position = (size_t)(newline + 1 - recording->data) + *length;
+    return TRUE;
+}
+
+/**
+ * Hands the diagnostics of an assembly to the caller, from the records the report wrote.
+ * The file name and the messages are copied into one block, the text of the results.
+ *
+ * @param allocator Pointer to the allocator of the results
+ * @param records Pointer to the output buffer holding the diagnostics in the RECORDED_DIAGNOSTICS format
+ * @param name The name the source was given
+ * @param results Pointer to the results to fill
+ * @return int TRUE if the diagnostics were copied, FALSE if the allocator had no block
+ */
+static int copy_diagnostics(const AssemblerAllocator *allocator, const OutputBuffer *records, const char *name,
+                            AssemblerResults *results) {
+    DiagnosticRecord record;
+    char *text;
+    size_t position = 0;
+    size_t text_length = strlen(name) + 1;
+    int count = 0;
+
+    while (next_diagnostic_record(records, &position, &record) == TRUE) {
+        text_length += strlen(record.message) + 1;
+        count++;
+    }
+    if (count == 0) {
+        return TRUE;
+    }
+
+    results->diagnostics = (AssemblerDiagnostic *) allocator->allocate(count * sizeof(AssemblerDiagnostic),
+                                                                       allocator->context);
+    results->diagnostic_text = (char *) allocator->allocate(text_length, allocator->context);
+    if (results->diagnostics == NULL || results->diagnostic_text == NULL) {
+        return FALSE;
+    }
+    strcpy(results->diagnostic_text, name);
+    text = results->diagnostic_text + strlen(name) + 1;
+
+    for (position = 0; next_diagnostic_record(records, &position, &record) == TRUE; results->number_of_diagnostics++) {
+        AssemblerDiagnostic *diagnostic = &results->diagnostics[results->number_of_diagnostics];
+
+        diagnostic->file = results->diagnostic_text;
+        diagnostic->line_number = record.line_number;
+        diagnostic->code = record.code;
+        diagnostic->column_start = record.column_start;
+        diagnostic->column_end = record.column_end;
+        diagnostic->message = text;
+        strcpy(text, record.message);
+        text += strlen(text) + 1;
+    }
+    return TRUE;
+}
+
+AssemblyStatus assemble_buffer(const char *source, size_t length, const char *name,
+                               const AssemblerAllocator *allocator, AssemblerResults *results) {
+    AssemblerOptions options;
+    DiagnosticReport report;
+    OutputBuffer recording = {NULL, 0, 0};
+    OutputBuffer diagnostics = {NULL, 0, 0};
+    OutputBuffer *sink = current_diagnostics_sink();
+    AssemblyResult result = SOURCE_HAS_ERRORS;
+    char extension[MAX_FRAME_NAME];
+    char *data;
+    size_t frame_length;
+    size_t position = 0;
+    int is_copied = TRUE;
+    int is_report_short;
+
+    if (allocator == NULL) {
+        allocator = &default_allocator;
+    }
+    if (name == NULL) {
+        name = STREAM_ARGUMENT;
+    }
+    memset(results, 0, sizeof(AssemblerResults));
+    init_assembler_options(&options);
+
+    /* Assemble the source as a daemon request is, recording the outputs and the records of the diagnostics */
+    capture_diagnostics(&diagnostics);
+    begin_diagnostic_report(&report, name, RECORDED_DIAGNOSTICS, 0);
+    if (length == 0) {
+        report_diagnostic("The source is empty.\n");
+    } else {
+        SourceFile source_file;
+
+        view_source_buffer(&source_file, (char *) source, length);
+        result = assemble_source(&source_file, NULL, &options, &recording);
+        close_source_file(&source_file);
+    }
+    is_report_short = report.records.is_out_of_memory;
+    end_diagnostic_report(&report);
+    capture_diagnostics(sink);
+
+    /* Diagnostics that could not all be captured are as lost as outputs that could not be recorded */
+    if (is_report_short || diagnostics.is_out_of_memory) {
+        result = OUT_OF_MEMORY;
+    }
+
+    /* Hand every recorded output to the caller, named by its extension */
+    while (result != OUT_OF_MEMORY && is_copied &&
+           next_recorded_frame(&recording, &position, extension, &data, &frame_length) == TRUE) {
+        AssemblerOutput *output = strcmp(extension, "am") == 0 ? &results->expanded :
+                                  strcmp(extension, "ob") == 0 ? &results->object :
+                                  strcmp(extension, "ent") == 0 ? &results->entries : &results->externals;
+
+        is_copied = copy_output(allocator, data, frame_length, output);
+    }
+    if (result != OUT_OF_MEMORY && is_copied) {
+        is_copied = copy_diagnostics(allocator, &diagnostics, name, results);
+    }
+    free_output_buffer(&recording);
+    free_output_buffer(&diagnostics);
+
+    if (result == OUT_OF_MEMORY || !is_copied) {
+        free_assembler_results(results, allocator);
+        return ASSEMBLY_OUT_OF_MEMORY;
+    }
+    return result == ASSEMBLED ? ASSEMBLY_SUCCEEDED : ASSEMBLY_HAS_ERRORS;
+}
+
+void free_assembler_results(AssemblerResults *results, const AssemblerAllocator *allocator) {
+    AssemblerOutput *outputs[4];
+    int i;
+
+    if (allocator == NULL) {
+        allocator = &default_allocator;
+    }
+    outputs[0] = &results->expanded;
+    outputs[1] = &results->object;
+    outputs[2] = &results->entries;
+    outputs[3] = &results->externals;
+    for (i = 0; i < 4; i++) {
+        if (outputs[i]->data != NULL) {
+            allocator->release(outputs[i]->data, allocator->context);
+        }
+    }
+    if (results->diagnostics != NULL) {
+        allocator->release(results->diagnostics, allocator->context);
+    }
+    if (results->diagnostic_text != NULL) {
+        allocator->release(results->diagnostic_text, allocator->context);
+    }
+    memset(results, 0, sizeof(AssemblerResults));
+}
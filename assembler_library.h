@@ -0,0 +1,85 @@
+#ifndef ASSEMBLER_LIBRARY_H
+#define ASSEMBLER_LIBRARY_H
+
+#include <stddef.h>
+
+/**
+ * Allocates and releases the memory of the results handed to the caller.
+ * The working memory of an assembly (the passes, the intermediate outputs and the diagnostics being captured)
+ * is allocated with malloc and released within the call, it does not go through this allocator.
+ */
+typedef struct {
+    void *(*allocate)(size_t size, void *context); /* Returns a block of size bytes, or NULL if there is none */
+    void (*release)(void *block, void *context); /* Releases a block the allocate function returned */
+    void *context; /* Passed to both functions */
+} AssemblerAllocator;
+
+/**
+ * Holds the content of one output of an assembly, the bytes the assembler would write to the file.
+ */
+typedef struct {
+    char *data; /* The content followed by a null character, or NULL if the output is not produced */
+    size_t length; /* The length of the content, without the null character */
+} AssemblerOutput;
+
+/**
+ * Holds one diagnostic of an assembly, with the fields the JSON diagnostics of the assembler give.
+ */
+typedef struct {
+    const char *file; /* The name the source was given */
+    int line_number; /* The line the diagnostic is about, or 0 if it is not about a line */
+    int code; /* The ErrorCode of an error in a source line, or -1 if the diagnostic is not one */
+    int column_start; /* The byte offset in the line where the statement the error is about starts */
+    int column_end; /* The byte offset where it ends, equal to column_start if the span is not known */
+    const char *message; /* The message, null-terminated, without its line number */
+} AssemblerDiagnostic;
+
+/**
+ * Holds everything an assembly gives, in memory allocated by the caller's allocator.
+ */
+typedef struct {
+    AssemblerOutput expanded; /* The source after macro expansion, the .am output */
+    AssemblerOutput object; /* The .ob output, produced only if the source has no errors */
+    AssemblerOutput entries; /* The .ent output, produced only if the program has entry symbols */
+    AssemblerOutput externals; /* The .ext output, produced only if the program uses external symbols */
+    AssemblerDiagnostic *diagnostics; /* The diagnostics, in the order they were found, or NULL if there are none */
+    int number_of_diagnostics; /* The number of diagnostics */
+    char *diagnostic_text; /* The file name and the messages of the diagnostics, which point into it */
+} AssemblerResults;
+
+/**
+ * Represents the outcome of assembling a source buffer.
+ */
+typedef enum {
+    ASSEMBLY_SUCCEEDED, /* The source was assembled into its outputs */
+    ASSEMBLY_HAS_ERRORS, /* Errors were found in the source, they are in the diagnostics */
+    ASSEMBLY_OUT_OF_MEMORY /* Memory ran out, the results are empty */
+} AssemblyStatus;
+
+/**
+ * Assembles a source held in memory, as the assembler does a source file, without touching the filesystem
+ * or the standard streams. The diagnostics are returned instead of printed, and they are the same ones
+ * the assembler prints for the same source. Several threads may assemble buffers at the same time.
+ * Running out of memory, whether in the working memory or in the allocator, never ends the process:
+ * the call returns ASSEMBLY_OUT_OF_MEMORY with empty results.
+ *
+ * @param source The bytes of the source
+ * @param length The number of bytes
+ * @param name The name the diagnostics give the source, or NULL for "-", the name of standard input
+ * @param allocator Pointer to the allocator of the results, or NULL to use malloc and free
+ * @param results Pointer to the results to fill, to be released with free_assembler_results
+ * @return AssemblyStatus The outcome of the assembly
+ */
+AssemblyStatus assemble_buffer(const char *source, size_t length, const char *name,
+                               const AssemblerAllocator *allocator, AssemblerResults *results);
+
+/**
+ * Releases the results of an assembly, leaving them empty.
+ *
+ * @param results Pointer to the results
+ * @param allocator Pointer to the allocator the results were allocated with, or NULL for malloc and free
+ * @return void
+ */
+void free_assembler_results(AssemblerResults *results, const AssemblerAllocator *allocator);
+
+#endif
@@ -0,0 +1,623 @@
+#include <stdlib.h>
+#include <string.h>
+#include "first_second_pass_data.h"
+#include "macro_data.h"
+#include "object_output.h"
+#include "binary_object.h"
+#include "diagnostics.h"
+#include "front_end_pipeline.h"
+#include "parallel_first_pass.h"
+#include "parallel_validation.h"
+#include "one_pass.h"
+#include "assembly.h"
+
+void init_assembler_options(AssemblerOptions *options) {
+    options->object_fd = -1;
+    options->entries_fd = -1;
+    options->externals_fd = -1;
+    options->object_threads = 0;
+    options->read_ahead = 0;
+    options->io = NULL;
+    options->jobs = 0;
+    options->pipeline = FALSE;
+    options->first_pass_threads = 1;
+    options->check_threads = 1;
+    options->one_pass = FALSE;
+    options->low_memory = FALSE;
+    options->memo_stats = FALSE;
+    options->binary_object = FALSE;
+    options->check_only = FALSE;
+    options->verify = FALSE;
+    options->link_output = NULL;
+    options->diagnostic_format = TEXT_DIAGNOSTICS;
+    options->max_repeats = 0;
+    options->max_errors = 0;
+    options->watch = FALSE;
+    options->language_server = FALSE;
+    options->daemon_socket = NULL;
+    options->client_socket = NULL;
+    options->cache_size = DEFAULT_CACHE_SIZE;
+    options->cache.directory = NULL;
+}
+
+char *make_file_name(char *base_name, char *extension) {
+    char *file_name = malloc(strlen(base_name) + strlen(extension) + 1);
+
+    /* Check if memory allocation was successful */
+    if(check_memory_allocation(file_name) == FALSE) {
+        return NULL;
+    }
+
+    /* Concatenate the file name with the extension */
+    strcpy(file_name, base_name);
+    strcat(file_name, extension);
+    return file_name;
+}
+
+int emit_output(OutputBuffer *output, char *base_name, char *extension, int fd, IoBackend *io,
+                OutputBuffer *recording) {
+    int is_written;
+
+    /* Record the content before a queued write takes it over */
+    if (recording != NULL) {
+        output_append_frame(recording, extension + 1, output->data, output->length);
+    }
+
+    /* Without a file name, the recording of a daemon request is the only destination */
+    if (base_name == NULL && recording != NULL) {
+        return TRUE;
+    }
+
+    if (base_name != NULL) {
+        char *file_name = make_file_name(base_name, extension);
+
+        if (file_name == NULL) {
+            return FALSE;
+        }
+        if (io != NULL) {
+            is_written = queue_file_write(io, file_name, output);
+        } else {
+            is_written = write_output_file(output, file_name);
+        }
+        free(file_name);
+    } else {
+        is_written = write_output_frame(fd, extension + 1, output);
+        if (is_written == FALSE) {
+            report_diagnostic("Error writing the %s output.\n", extension + 1);
+        }
+    }
+    return is_written;
+}
+
+/**
+ * Builds and emits the object, entries and externals outputs of an assembled program.
+ * The entries output is only emitted if there are entry symbols,
+ * and the externals output only if external symbols are used.
+ * The binary object follows them when the options ask for it.
+ *
+ * @param base_name The file name without any extension, or NULL when streaming
+ * @param options Pointer to the command-line options
+ * @param head_of_lines_list Pointer to the head of the assembly line list
+ * @param head_of_symbol_table Pointer to the head of the symbol table
+ * @param data_image Pointer to the data image holding the .data and .string words
+ * @param ICF The instruction counter value
+ * @param DCF The data counter value
+ * @param recording Pointer to the buffer recording the outputs as frames, or NULL when not recording
+ * @return AssemblyResult ASSEMBLED if every output was written or queued, OUTPUT_FAILED if one could not be,
+ *         or OUT_OF_MEMORY if memory ran out while building one
+ */
+static AssemblyResult emit_outputs(char *base_name, AssemblerOptions *options, AssemblyLineList *head_of_lines_list,
+                                   SymbolNode *head_of_symbol_table, DataImage *data_image, int ICF, int DCF,
+                                   OutputBuffer *recording) {
+    OutputBuffer output = {NULL, 0, 0};
+    AssemblyResult result = ASSEMBLED;
+    int status;
+
+    /* Format a mapped object file in parallel when asked to and every record has the same width,
+     * unless the object output is being recorded */
+    if (base_name != NULL && options->object_threads > 0 && ICF + DCF - 1 <= MAX_FIXED_WIDTH_ADDRESS &&
+        recording == NULL) {
+        char *file_name = make_file_name(base_name, ".ob");
+
+        if (file_name == NULL) {
+            result = OUT_OF_MEMORY;
+        } else if (write_object_file_parallel(file_name, head_of_lines_list, data_image, ICF, DCF,
+                                              options->object_threads) == FALSE) {
+            result = OUTPUT_FAILED;
+        }
+        free(file_name);
+    } else if (build_object_output(&output, head_of_lines_list, data_image, ICF, DCF) == ERROR_OUT_OF_MEMORY) {
+        result = OUT_OF_MEMORY;
+    } else if (emit_output(&output, base_name, ".ob", options->object_fd, options->io, recording) == FALSE) {
+        result = OUTPUT_FAILED;
+    }
+
+    output_reset(&output);
+    if (result == ASSEMBLED) {
+        status = build_entries_output(&output, head_of_symbol_table);
+        if (status == ERROR_OUT_OF_MEMORY) {
+            result = OUT_OF_MEMORY;
+        } else if (status == TRUE &&
+                   emit_output(&output, base_name, ".ent", options->entries_fd, options->io, recording) == FALSE) {
+            result = OUTPUT_FAILED;
+        }
+    }
+
+    output_reset(&output);
+    if (result == ASSEMBLED) {
+        status = build_externals_output(&output, head_of_symbol_table, head_of_lines_list);
+        if (status == ERROR_OUT_OF_MEMORY) {
+            result = OUT_OF_MEMORY;
+        } else if (status == TRUE &&
+                   emit_output(&output, base_name, ".ext", options->externals_fd, options->io, recording) == FALSE) {
+            result = OUTPUT_FAILED;
+        }
+    }
+
+    /* The binary object holds the same program, when asked for */
+    if (result == ASSEMBLED && options->binary_object) {
+        unsigned long *code_words = collect_code_words(head_of_lines_list, ICF);
+        ExternalUse *external_uses = NULL;
+        int number_of_external_uses = code_words == NULL ? -1 :
+                                      collect_line_external_uses(head_of_symbol_table, head_of_lines_list,
+                                                                 &external_uses);
+
+        output_reset(&output);
+        if (number_of_external_uses < 0 ||
+            build_binary_object_output(&output, code_words, data_image, head_of_symbol_table, external_uses,
+                                       number_of_external_uses, ICF, DCF) == ERROR_OUT_OF_MEMORY) {
+            result = OUT_OF_MEMORY;
+        } else if (emit_output(&output, base_name, ".obx", options->object_fd, options->io, recording) == FALSE) {
+            result = OUTPUT_FAILED;
+        }
+        free(code_words);
+        free(external_uses);
+    }
+
+    free_output_buffer(&output);
+
+    /* Hand the queued writes to the kernel while the next file is assembled */
+    if (options->io != NULL) {
+        submit_io(options->io);
+    }
+    return result;
+}
+
+/**
+ * Builds and emits the object, entries and externals outputs of a program assembled in the low-memory mode,
+ * and the binary object when asked for, with the same content emit_outputs gives for the same program.
+ *
+ * @param base_name The file name without any extension, or NULL when streaming
+ * @param options Pointer to the command-line options
+ * @param program Pointer to the compact program
+ * @param recording Pointer to the buffer recording the outputs as frames, or NULL when not recording
+ * @return AssemblyResult ASSEMBLED if every output was written or queued, OUTPUT_FAILED if one could not be,
+ *         or OUT_OF_MEMORY if memory ran out while building one
+ */
+static AssemblyResult emit_compact_outputs(char *base_name, AssemblerOptions *options, CompactProgram *program,
+                                           OutputBuffer *recording) {
+    OutputBuffer output = {NULL, 0, 0};
+    int ICF = program->ICF, DCF = program->DCF;
+    AssemblyResult result = ASSEMBLED;
+    int status;
+
+    /* Format a mapped object file in parallel when asked to and every record has the same width,
+     * unless the object output is being recorded */
+    if (base_name != NULL && options->object_threads > 0 && ICF + DCF - 1 <= MAX_FIXED_WIDTH_ADDRESS &&
+        recording == NULL) {
+        char *file_name = make_file_name(base_name, ".ob");
+
+        if (file_name == NULL) {
+            result = OUT_OF_MEMORY;
+        } else if (write_image_object_file_parallel(file_name, &program->code_image, &program->data_image,
+                                                    ICF, DCF, options->object_threads) == FALSE) {
+            result = OUTPUT_FAILED;
+        }
+        free(file_name);
+    } else if (build_image_object_output(&output, &program->code_image, &program->data_image, ICF, DCF) ==
+               ERROR_OUT_OF_MEMORY) {
+        result = OUT_OF_MEMORY;
+    } else if (emit_output(&output, base_name, ".ob", options->object_fd, options->io, recording) == FALSE) {
+        result = OUTPUT_FAILED;
+    }
+
+    output_reset(&output);
+    if (result == ASSEMBLED) {
+        status = build_entries_output(&output, program->head_of_symbol_table);
+        if (status == ERROR_OUT_OF_MEMORY) {
+            result = OUT_OF_MEMORY;
+        } else if (status == TRUE &&
+                   emit_output(&output, base_name, ".ent", options->entries_fd, options->io, recording) == FALSE) {
+            result = OUTPUT_FAILED;
+        }
+    }
+
+    output_reset(&output);
+    if (result == ASSEMBLED) {
+        status = build_external_uses_output(&output, program->external_uses, program->number_of_external_uses);
+        if (status == ERROR_OUT_OF_MEMORY) {
+            result = OUT_OF_MEMORY;
+        } else if (status == TRUE &&
+                   emit_output(&output, base_name, ".ext", options->externals_fd, options->io, recording) == FALSE) {
+            result = OUTPUT_FAILED;
+        }
+    }
+
+    output_reset(&output);
+    if (result == ASSEMBLED && options->binary_object) {
+        if (build_binary_object_output(&output, program->code_image.words, &program->data_image,
+                                       program->head_of_symbol_table, program->external_uses,
+                                       program->number_of_external_uses, ICF, DCF) == ERROR_OUT_OF_MEMORY) {
+            result = OUT_OF_MEMORY;
+        } else if (emit_output(&output, base_name, ".obx", options->object_fd, options->io, recording) == FALSE) {
+            result = OUTPUT_FAILED;
+        }
+    }
+
+    free_output_buffer(&output);
+
+    /* Hand the queued writes to the kernel while the next file is assembled */
+    if (options->io != NULL) {
+        submit_io(options->io);
+    }
+    return result;
+}
+
+/**
+ * Reports how many instruction lines of a source had their words copied from the encoding memo of the first pass.
+ *
+ * @param base_name The file name without any extension, or NULL when streaming
+ * @param hits The number of instruction lines copied from the memo
+ * @param misses The number of instruction lines encoded
+ * @return void
+ */
+static void report_memo_stats(char *base_name, unsigned long hits, unsigned long misses) {
+    unsigned long lines = hits + misses;
+
+    report_diagnostic("Encoding memo of %s: %lu of %lu instruction lines reused (%lu%%)\n",
+                      base_name != NULL ? base_name : STREAM_ARGUMENT, hits, lines, lines > 0 ? hits * 100 / lines : 0);
+}
+
+/**
+ * Assembles an expanded source in the low-memory mode and emits its outputs.
+ *
+ * @param source Pointer to the expanded source
+ * @param base_name The file name without any extension, or NULL when streaming
+ * @param head_of_macro_table Pointer to the head of the macro table
+ * @param options Pointer to the command-line options
+ * @param recording Pointer to the buffer recording the outputs as frames, or NULL when not recording
+ * @return AssemblyResult The outcome of the assembly
+ */
+static AssemblyResult assemble_low_memory(SourceFile *source, char *base_name, MacroNode *head_of_macro_table,
+                                          AssemblerOptions *options, OutputBuffer *recording) {
+    CompactProgram program;
+    int error_flag = one_pass_compact(source, head_of_macro_table, &program);
+    AssemblyResult result;
+
+    if (error_flag == ERROR_OUT_OF_MEMORY) {
+        return OUT_OF_MEMORY;
+    }
+    if (error_flag == ERROR_FOUND) {
+        return SOURCE_HAS_ERRORS;
+    }
+    if (options->memo_stats) {
+        report_memo_stats(base_name, program.memo_hits, program.memo_misses);
+    }
+
+    result = emit_compact_outputs(base_name, options, &program, recording);
+    free_compact_program(&program);
+    return result;
+}
+
+/**
+ * Checks the expanded source for first pass errors, on several threads when asked to.
+ *
+ * @param source Pointer to the expanded source
+ * @param head_of_macro_table Pointer to the head of the macro table
+ * @param options Pointer to the command-line options
+ * @return int ERROR_FOUND if any error was found, ERROR_WAS_NOT_FOUND otherwise
+ */
+static int check_first_pass(SourceFile *source, MacroNode *head_of_macro_table, AssemblerOptions *options) {
+    if (options->check_threads > 1) {
+        return check_errors_in_first_pass_parallel(source, head_of_macro_table, options->check_threads);
+    }
+    return check_errors_in_first_pass(source, head_of_macro_table);
+}
+
+/**
+ * Checks the expanded source for second pass errors, on several threads when asked to.
+ *
+ * @param source Pointer to the expanded source
+ * @param head_of_symbol_table Pointer to the head of the symbol table
+ * @param options Pointer to the command-line options
+ * @return int ERROR_FOUND if any error was found, ERROR_WAS_NOT_FOUND otherwise
+ */
+static int check_second_pass(SourceFile *source, SymbolNode *head_of_symbol_table, AssemblerOptions *options) {
+    if (options->check_threads > 1) {
+        return check_errors_in_second_pass_parallel(source, head_of_symbol_table, options->check_threads);
+    }
+    return check_errors_in_second_pass(source, head_of_symbol_table);
+}
+
+/**
+ * Checks a source for errors without encoding it or emitting any output. The source is expanded in memory,
+ * the first pass checks run over the expansion, and the second pass checks run against a table of the names
+ * of the defined symbols. The checks stop as soon as one of them finds errors, as they do when assembling,
+ * or once max_errors diagnostics were reported.
+ *
+ * @param source Pointer to the source file
+ * @param options Pointer to the command-line options
+ * @return AssemblyResult ASSEMBLED if no errors were found, SOURCE_HAS_ERRORS if errors were found,
+ *         or OUT_OF_MEMORY if memory ran out
+ */
+static AssemblyResult check_source(SourceFile *source, AssemblerOptions *options) {
+    MacroNode *head_of_macro_table = NULL;
+    SymbolNode *head_of_symbol_table = NULL;
+    OutputBuffer expanded = {NULL, 0, 0};
+    SourceFile am_source;
+    DiagnosticLimit limit;
+    AssemblyResult result = SOURCE_HAS_ERRORS;
+
+    limit.maximum = options->max_errors;
+    limit.count = 0;
+    if (options->max_errors > 0) {
+        limit_diagnostics(&limit);
+    }
+
+    if (check_preprocessing_errors(source) == ERROR_WAS_NOT_FOUND) {
+        rewind_source_file(source);
+        if (file_preprocessing(source, &expanded, &head_of_macro_table) == FALSE) {
+            result = OUT_OF_MEMORY;
+        } else {
+            view_source_buffer(&am_source, expanded.data, expanded.length);
+            if (check_first_pass(&am_source, head_of_macro_table, options) == ERROR_WAS_NOT_FOUND) {
+                rewind_source_file(&am_source);
+                if (collect_defined_symbols(&am_source, &head_of_symbol_table) == FALSE) {
+                    result = OUT_OF_MEMORY;
+                } else {
+                    int error_flag;
+
+                    rewind_source_file(&am_source);
+                    error_flag = check_second_pass(&am_source, head_of_symbol_table, options);
+                    result = error_flag == ERROR_WAS_NOT_FOUND ? ASSEMBLED :
+                             error_flag == ERROR_OUT_OF_MEMORY ? OUT_OF_MEMORY : SOURCE_HAS_ERRORS;
+                }
+                free_symbol_table(head_of_symbol_table);
+            }
+            close_source_file(&am_source);
+            free_macro_nodes(head_of_macro_table);
+        }
+    }
+
+    limit_diagnostics(NULL);
+    free_output_buffer(&expanded);
+    return result;
+}
+
+/**
+ * Expands a source straight into its .am file and maps the file back, so that the expansion
+ * is never held in memory as a whole, for the low-memory mode.
+ *
+ * @param source Pointer to the source file
+ * @param base_name The file name without any extension
+ * @param am_source Pointer to the source file to map the .am file into, closed by the caller if expanded
+ * @param head_of_macro_table Pointer to set to the head of the macro table, NULL on failure
+ * @return AssemblyResult ASSEMBLED if the .am file was written and mapped, OUTPUT_FAILED if it could not be,
+ *         or OUT_OF_MEMORY if memory ran out
+ */
+static AssemblyResult stream_expansion(SourceFile *source, char *base_name, SourceFile *am_source,
+                                       MacroNode **head_of_macro_table) {
+    char *am_file_name = make_file_name(base_name, ".am");
+    AssemblyResult result = ASSEMBLED;
+    int status;
+
+    *head_of_macro_table = NULL;
+    if (am_file_name == NULL) {
+        return OUT_OF_MEMORY;
+    }
+
+    status = stream_file_preprocessing(source, am_file_name, head_of_macro_table);
+    if (status == ERROR_OUT_OF_MEMORY) {
+        result = OUT_OF_MEMORY;
+    } else if (status == FALSE) {
+        result = OUTPUT_FAILED;
+    } else if (map_source_file(am_source, am_file_name) == FALSE) {
+        report_diagnostic("Error opening file: %s\n", am_file_name);
+        free_macro_nodes(*head_of_macro_table);
+        *head_of_macro_table = NULL;
+        result = OUTPUT_FAILED;
+    }
+
+    free(am_file_name);
+    return result;
+}
+
+AssemblyResult assemble_source(SourceFile *source, char *base_name, AssemblerOptions *options,
+                               OutputBuffer *recording) {
+    MacroNode *head_of_macro_table = NULL;
+    OutputBuffer expanded = {NULL, 0, 0};
+    FirstPassResult result_of_first_pass;
+    PipelineResult front_end = PIPELINE_UNAVAILABLE;
+    AssemblyResult result = SOURCE_HAS_ERRORS;
+    SourceFile am_output_file;
+    int is_expanded = FALSE, is_mapped = FALSE, is_first_pass_done = FALSE, is_resolved = FALSE;
+    int error_flag;
+
+    if (options->check_only) {
+        return check_source(source, options);
+    }
+
+    /* Run preprocessing, the first pass checks and the first pass as concurrent stages when asked to */
+    if (options->pipeline) {
+        front_end = run_front_end_pipeline(source, &expanded, &head_of_macro_table, &result_of_first_pass);
+        is_expanded = front_end == PIPELINE_FIRST_PASS_ERRORS || front_end == PIPELINE_FIRST_PASS_DONE;
+        is_first_pass_done = front_end == PIPELINE_FIRST_PASS_DONE;
+        if (front_end == PIPELINE_OUT_OF_MEMORY) {
+            result = OUT_OF_MEMORY;
+        }
+    }
+
+    /* Check if there are errors in the preprocessing, if no errors found continue with preprocessing */
+    if(front_end == PIPELINE_UNAVAILABLE && check_preprocessing_errors(source) == ERROR_WAS_NOT_FOUND) {
+
+        /* Rewind the original source file to start over */
+        rewind_source_file(source);
+
+        /* In the low-memory mode, expand straight into the .am file and read the expansion back from it */
+        if (options->low_memory && base_name != NULL && options->io == NULL) {
+            result = stream_expansion(source, base_name, &am_output_file, &head_of_macro_table);
+            is_expanded = result == ASSEMBLED;
+            is_mapped = is_expanded;
+        } else {
+
+            /* create the file preprocessing function and get the macro table */
+            is_expanded = file_preprocessing(source, &expanded, &head_of_macro_table);
+            if (!is_expanded) {
+                result = OUT_OF_MEMORY;
+            }
+        }
+    }
+
+    if (is_expanded) {
+        int is_am_written = TRUE;
+
+        if (recording != NULL && is_mapped) {
+            output_append_frame(recording, "am", am_output_file.data, am_output_file.size);
+        } else if (recording != NULL) {
+            output_append_frame(recording, "am", expanded.data, expanded.length);
+        }
+
+        /* Write the expanded source to the .am file, unless it is already there, streaming or batching the writes */
+        if (!is_mapped && base_name != NULL && options->io == NULL) {
+            char *am_file_name = make_file_name(base_name, ".am");
+
+            if (am_file_name == NULL) {
+                result = OUT_OF_MEMORY;
+                is_am_written = FALSE;
+            } else if (write_output_file(&expanded, am_file_name) == FALSE) {
+                result = OUTPUT_FAILED;
+                is_am_written = FALSE;
+            }
+
+            /* Free memory allocated for expanded file name */
+            free(am_file_name);
+        }
+
+        /* The remaining stages read the expanded source straight from memory */
+        if (!is_mapped) {
+            view_source_buffer(&am_output_file, expanded.data, expanded.length);
+        }
+
+        /* Check if there are errors in the first pass, if no errors found continue with first pass,
+         * unless the pipeline already did */
+        error_flag = ERROR_FOUND;
+        if (front_end == PIPELINE_UNAVAILABLE && is_am_written && options->low_memory) {
+
+            /* Check, assemble and emit the expanded source keeping only the packed words */
+            result = assemble_low_memory(&am_output_file, base_name, head_of_macro_table, options, recording);
+        } else if (front_end == PIPELINE_UNAVAILABLE && is_am_written && options->one_pass) {
+
+            /* Check and assemble the expanded source in a single traversal, resolving the symbols as it goes */
+            error_flag = one_pass(&am_output_file, head_of_macro_table, &result_of_first_pass);
+            is_resolved = error_flag == ERROR_WAS_NOT_FOUND;
+            is_first_pass_done = is_resolved;
+        } else if (front_end == PIPELINE_UNAVAILABLE && is_am_written) {
+            error_flag = check_first_pass(&am_output_file, head_of_macro_table, options);
+        }
+        if (error_flag == ERROR_WAS_NOT_FOUND && !is_resolved) {
+
+            /* Rewind the expanded source file to start over */
+            rewind_source_file(&am_output_file);
+
+            /* Perform the first pass and get the result,
+             * which includes the assembly line list, symbol table,
+             * and the values for ICF (instruction count) and DCF (data count) */
+            if (options->first_pass_threads > 1) {
+                is_first_pass_done = parallel_first_pass(&am_output_file, options->first_pass_threads,
+                                                         &result_of_first_pass);
+            } else {
+                is_first_pass_done = first_pass(&am_output_file, &result_of_first_pass);
+            }
+            error_flag = is_first_pass_done ? ERROR_WAS_NOT_FOUND : ERROR_OUT_OF_MEMORY;
+        }
+        if (error_flag == ERROR_OUT_OF_MEMORY) {
+            result = OUT_OF_MEMORY;
+        }
+
+        if (is_first_pass_done) {
+            AssemblyLineList *head_of_lines_list = result_of_first_pass.head_of_lines_list;
+            SymbolNode *head_of_symbol_table = result_of_first_pass.head_of_symbol_table;
+            int ICF = result_of_first_pass.ICF, DCF = result_of_first_pass.DCF;
+
+            if (options->memo_stats) {
+                report_memo_stats(base_name, result_of_first_pass.memo_hits, result_of_first_pass.memo_misses);
+            }
+
+            /* Rewind the expanded source file to start over */
+            rewind_source_file(&am_output_file);
+
+            /* Check if there are errors in the second pass, if no errors found continue with second pass,
+             * unless the one pass already did both */
+            error_flag = is_resolved ? ERROR_WAS_NOT_FOUND : ERROR_FOUND;
+            if (!is_resolved && is_am_written) {
+                error_flag = check_second_pass(&am_output_file, head_of_symbol_table, options);
+            }
+            if (error_flag == ERROR_OUT_OF_MEMORY) {
+                result = OUT_OF_MEMORY;
+            } else if (error_flag == ERROR_WAS_NOT_FOUND) {
+                SecondPassResult result_of_second_pass;
+                int is_second_pass_done = TRUE;
+
+                /* Perform the second pass and get the result,
+                 * which includes the updated assembly line list and symbol table */
+                result_of_second_pass.head_of_lines_list = head_of_lines_list;
+                result_of_second_pass.head_of_symbol_table = head_of_symbol_table;
+                if (!is_resolved) {
+                    is_second_pass_done = second_pass(head_of_symbol_table, &head_of_lines_list,
+                                                      &result_of_second_pass);
+                }
+                if (is_second_pass_done == FALSE) {
+                    result = OUT_OF_MEMORY;
+                } else {
+
+                    /* Update the line list and symbol table with the result of the second pass */
+                    head_of_lines_list = result_of_second_pass.head_of_lines_list;
+                    head_of_symbol_table = result_of_second_pass.head_of_symbol_table;
+
+                    result = emit_outputs(base_name, options, head_of_lines_list, head_of_symbol_table,
+                                          &result_of_first_pass.data_image, ICF, DCF, recording);
+                }
+            }
+
+            /* Free the assembly line list and symbol table after processing */
+            free_line_list(head_of_lines_list);
+            free_symbol_table(head_of_symbol_table);
+            free_data_image(&result_of_first_pass.data_image);
+
+        }
+
+        /* Release the expanded source, a batched .am write takes it over once the passes are done with it */
+        close_source_file(&am_output_file);
+        if (base_name != NULL && options->io != NULL) {
+            char *am_file_name = make_file_name(base_name, ".am");
+
+            if (am_file_name == NULL) {
+                result = OUT_OF_MEMORY;
+            } else if (queue_file_write(options->io, am_file_name, &expanded) == FALSE) {
+                result = OUTPUT_FAILED;
+            }
+            submit_io(options->io);
+            free(am_file_name);
+        }
+
+        /* Free the macro table */
+        free_macro_nodes(head_of_macro_table);
+    }
+    free_output_buffer(&expanded);
+
+    /* A recording that ran out of memory lost some of the outputs */
+    if (recording != NULL && recording->is_out_of_memory) {
+        result = OUT_OF_MEMORY;
+    }
+    return result;
+}
@@ -0,0 +1,104 @@
+#ifndef ASSEMBLY_H
+#define ASSEMBLY_H
+
+#include "first_second_pass.h"
+#include "io_backend.h"
+#include "assembly_cache.h"
+#include "diagnostics.h"
+
+#define STREAM_ARGUMENT "-" /* The file argument that selects reading from standard input */
+
+/**
+ * Holds the options given on the command line.
+ */
+typedef struct {
+    int object_fd; /* File descriptor for the object frame in streaming mode, -1 for standard output */
+    int entries_fd; /* File descriptor for the entries frame in streaming mode, -1 for standard output */
+    int externals_fd; /* File descriptor for the externals frame in streaming mode, -1 for standard output */
+    int object_threads; /* Number of threads formatting a mapped object file, 0 to build it in memory */
+    int read_ahead; /* Number of upcoming source files read ahead through the batched I/O backend, 0 for plain I/O */
+    IoBackend *io; /* The batched I/O backend, NULL for plain synchronous I/O */
+    int jobs; /* Number of files assembled concurrently, 0 if -j was not given */
+    int pipeline; /* TRUE to run the front end of every file as concurrent stages */
+    int first_pass_threads; /* Number of threads the first pass is split into, 1 or less for a sequential first pass */
+    int check_threads; /* Number of threads the line checks are split into, 1 or less for sequential checks */
+    int one_pass; /* TRUE to assemble every file in a single traversal with backpatch chains */
+    int binary_object; /* TRUE to write a binary object of packed words alongside the text outputs */
+    int low_memory; /* TRUE to assemble every file in a single traversal that keeps only the packed words */
+    char *daemon_socket; /* The socket to serve assembly requests on as a daemon, NULL to assemble the files */
+    char *client_socket; /* The socket of the daemon to send the files to, NULL to assemble them in this process */
+    int language_server; /* TRUE to serve the Language Server Protocol on standard input and output */
+    int watch; /* TRUE to keep running after the files are assembled and reassemble every file that changes */
+    DiagnosticFormat diagnostic_format; /* The form the diagnostics of every file are written in */
+    int max_repeats; /* The number of errors of one code written for a file before the rest are counted, 0 for all */
+    int verify; /* TRUE to read back and verify the outputs of every file instead of assembling it */
+    char *link_output; /* The program to link the assembled files into instead of assembling them, or NULL */
+    int check_only; /* TRUE to only check every file for errors, without encoding it or writing any output */
+    int max_errors; /* The number of diagnostics after which a checked file is no longer scanned, 0 for no limit */
+    int memo_stats; /* TRUE to report how many instruction lines of every file were copied from the encoding memo */
+    int cache_size; /* The size limit of the cache directory, in megabytes */
+    AssemblyCache cache; /* The cache of assembly results, its directory is NULL when caching is off */
+} AssemblerOptions;
+
+/**
+ * Represents the outcome of assembling one source.
+ */
+typedef enum {
+    ASSEMBLED, /* The outputs were emitted */
+    SOURCE_HAS_ERRORS, /* Errors were found in the source, so no outputs were emitted */
+    OUTPUT_FAILED, /* An output could not be written */
+    OUT_OF_MEMORY /* Memory ran out, so the source was abandoned */
+} AssemblyResult;
+
+/**
+ * Sets every option to its default: one file at a time, on one thread, with plain I/O and no cache.
+ *
+ * @param options Pointer to the options structure to fill
+ * @return void
+ */
+void init_assembler_options(AssemblerOptions *options);
+
+/**
+ * Creates a file name by concatenating a base name and an extension.
+ *
+ * @param base_name The file name without any extension
+ * @param extension The extension to append, including its leading '.'
+ * @return char* A dynamically allocated string holding the file name, or NULL if memory ran out
+ */
+char *make_file_name(char *base_name, char *extension);
+
+/**
+ * Emits the content of one output file. When assembling a file, the content is written
+ * next to the source as base_name + extension, or queued on the batched I/O backend if there is one.
+ * When streaming, it is written as a frame to the given file descriptor.
+ * When recording without a file name, for a daemon request or a library call, it is only recorded.
+ *
+ * @param output Pointer to the output buffer holding the content, left empty if the write was queued
+ * @param base_name The file name without any extension, or NULL when streaming
+ * @param extension The extension of the output file, including its leading '.'
+ * @param fd The file descriptor to write the frame to when streaming
+ * @param io Pointer to the batched I/O backend, or NULL to write synchronously
+ * @param recording Pointer to the buffer recording the outputs as frames, or NULL when not recording
+ * @return int TRUE if the output was written or queued, FALSE otherwise
+ */
+int emit_output(OutputBuffer *output, char *base_name, char *extension, int fd, IoBackend *io,
+                OutputBuffer *recording);
+
+/**
+ * Performs the full assembly process on one source: preprocessing, a first pass and a second pass,
+ * checking for errors along the way, and emits the outputs if no errors were found.
+ * With check_only, the source is only checked: it is expanded in memory and goes through the preprocessing,
+ * first pass and second pass checks, and nothing is encoded or emitted.
+ *
+ * @param source Pointer to the source file
+ * @param base_name The file name without any extension, or NULL when streaming
+ * @param options Pointer to the command-line options
+ * @param recording Pointer to the buffer recording the outputs as frames, or NULL when not recording
+ * @return AssemblyResult ASSEMBLED if the outputs were emitted, or with check_only if no errors were found,
+ *         SOURCE_HAS_ERRORS if errors were found in the source,
+ *         OUTPUT_FAILED if an output could not be written, or OUT_OF_MEMORY if memory ran out
+ */
+AssemblyResult assemble_source(SourceFile *source, char *base_name, AssemblerOptions *options,
+                               OutputBuffer *recording);
+
+#endif
@@ -0,0 +1,362 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <utime.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "assembly_cache.h"
+#include "macro_data.h"
+
+#define LOCK_FILE_NAME "lock" /* The file locked while the cache directory is being evicted */
+#define TEMPORARY_PREFIX "tmp." /* The start of the names of the files entries are written to before the rename */
+#define STALE_TEMPORARY_AGE 3600 /* The age in seconds after which a temporary file left by a store is removed */
+
+/**
+ * Holds what the eviction needs to know about one entry of the cache directory.
+ */
+typedef struct {
+    char name[SHA256_HEX_SIZE + 1]; /* The file name of the entry, its key */
+    unsigned long size; /* The size of the entry in bytes */
+    time_t last_used; /* The modification time of the entry, refreshed on every hit */
+} CachedFile;
+
+/* Serializes the evictions and the temporary file names of the threads of this process */
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Counts the temporary files created by this process, so concurrent stores never share one */
+static unsigned long temporary_counter = 0;
+
+/* The total size of the entries, as counted by the last scan of the cache directory and updated by every store
+ * of this process since, so that the directory is only scanned again once the size limit is exceeded */
+static unsigned long total_size = 0;
+static int is_total_size_known = FALSE;
+
+/**
+ * Creates the name of a file in the cache directory.
+ *
+ * @param cache Pointer to the cache
+ * @param name The name of the file within the directory
+ * @return char* A dynamically allocated string holding the path, or NULL if memory ran out
+ */
+static char *make_cache_path(AssemblyCache *cache, const char *name) {
+    char *path = malloc(strlen(cache->directory) + strlen(name) + 2);
+
+    if (path != NULL) {
+        sprintf(path, "%s/%s", cache->directory, name);
+    }
+    return path;
+}
+
+/**
+ * Checks if a file name is the name of an entry: exactly SHA256_HEX_SIZE lowercase hexadecimal digits.
+ *
+ * @param name The file name
+ * @return int TRUE if the name is the name of an entry, FALSE otherwise
+ */
+static int is_entry_name(const char *name) {
+    int i;
+
+    for (i = 0; i < SHA256_HEX_SIZE; i++) {
+        if (!((name[i] >= '0' && name[i] <= '9') || (name[i] >= 'a' && name[i] <= 'f'))) {
+            return FALSE;
+        }
+    }
+    return name[SHA256_HEX_SIZE] == '\0';
+}
+
+/**
+ * Parses the header of the section starting at the position of a mapped entry.
+ *
+ * @param entry Pointer to the mapped entry
+ * @param name The buffer to write the section name to
+ * @param length Pointer to set to the length of the section content
+ * @return size_t The offset of the section content, or 0 if the header is not well formed
+ *         or the content runs past the end of the entry
+ */
+static size_t parse_section_header(SourceFile *entry, char name[MAX_FRAME_NAME], size_t *length) {
+    size_t position = entry->position;
+    size_t name_length = 0;
+    unsigned long value = 0;
+    int digits = 0;
+
+    while (position < entry->size && entry->data[position] != ' ' && name_length < MAX_FRAME_NAME - 1) {
+        name[name_length++] = entry->data[position++];
+    }
+    name[name_length] = '\0';
+    if (name_length == 0 || position >= entry->size || entry->data[position] != ' ') {
+        return 0;
+    }
+    position++;
+
+    while (position < entry->size && entry->data[position] >= '0' && entry->data[position] <= '9' && digits < 10) {
+        value = value * 10 + (unsigned long)(entry->data[position++] - '0');
+        digits++;
+    }
+    if (digits == 0 || position >= entry->size || entry->data[position] != '\n') {
+        return 0;
+    }
+    position++;
+
+    if (value > entry->size - position) {
+        return 0;
+    }
+    *length = (size_t)value;
+    return position;
+}
+
+/**
+ * Checks that a mapped entry starts with the current format line and is made of whole sections,
+ * leaving its position at the first section.
+ *
+ * @param entry Pointer to the mapped entry
+ * @return int TRUE if the entry is well formed, FALSE otherwise
+ */
+static int check_cache_entry(SourceFile *entry) {
+    size_t header_length = strlen(CACHE_FORMAT);
+    char name[MAX_FRAME_NAME];
+    size_t length;
+
+    if (entry->size <= header_length || memcmp(entry->data, CACHE_FORMAT, header_length) != 0 ||
+        entry->data[header_length] != '\n') {
+        return FALSE;
+    }
+
+    entry->position = header_length + 1;
+    while (entry->position < entry->size) {
+        size_t content = parse_section_header(entry, name, &length);
+
+        if (content == 0) {
+            return FALSE;
+        }
+        entry->position = content + length;
+    }
+
+    entry->position = header_length + 1;
+    return TRUE;
+}
+
+/**
+ * Compares two cached files by the time they were last used, the oldest first.
+ *
+ * @param first Pointer to the first cached file
+ * @param second Pointer to the second cached file
+ * @return int A negative number, zero or a positive number as the first was used before, with or after the second
+ */
+static int compare_last_used(const void *first, const void *second) {
+    const CachedFile *a = (const CachedFile *) first;
+    const CachedFile *b = (const CachedFile *) second;
+
+    if (a->last_used != b->last_used) {
+        return a->last_used < b->last_used ? -1 : 1;
+    }
+    return strcmp(a->name, b->name);
+}
+
+/**
+ * Scans the cache directory, counting the total size of the entries and removing the stale temporary files,
+ * then evicts the least recently used entries until their total size is down to EVICTION_TARGET percent
+ * of the size limit, if it exceeds the limit. The caller holds the locks of the cache.
+ *
+ * @param cache Pointer to the cache
+ * @return void
+ */
+static void evict_cache_entries(AssemblyCache *cache) {
+    DIR *directory = opendir(cache->directory);
+    CachedFile *files = NULL;
+    int number_of_files = 0, capacity = 0;
+    int is_listed = TRUE;
+    unsigned long target_size = cache->size_limit / 100 * EVICTION_TARGET;
+    time_t now = time(NULL);
+    struct dirent *directory_entry;
+    int i;
+
+    if (directory == NULL) {
+        return;
+    }
+
+    /* List the entries with their sizes and the time they were last used */
+    total_size = 0;
+    while ((directory_entry = readdir(directory)) != NULL) {
+        int is_temporary = strncmp(directory_entry->d_name, TEMPORARY_PREFIX, strlen(TEMPORARY_PREFIX)) == 0;
+        struct stat file_status;
+        char *path;
+
+        if (!is_temporary && !is_entry_name(directory_entry->d_name)) {
+            continue;
+        }
+        path = make_cache_path(cache, directory_entry->d_name);
+        if (path == NULL || stat(path, &file_status) != 0) {
+            free(path);
+            continue;
+        }
+
+        /* A temporary file this old was left by a store that never finished */
+        if (is_temporary) {
+            if (now - file_status.st_mtime > STALE_TEMPORARY_AGE) {
+                unlink(path);
+            }
+            free(path);
+            continue;
+        }
+        free(path);
+
+        if (number_of_files == capacity) {
+            int new_capacity = capacity == 0 ? 64 : capacity * 2;
+            CachedFile *new_files = (CachedFile *) realloc(files, new_capacity * sizeof(CachedFile));
+
+            if (new_files == NULL) {
+                is_listed = FALSE;
+                break;
+            }
+            files = new_files;
+            capacity = new_capacity;
+        }
+        strcpy(files[number_of_files].name, directory_entry->d_name);
+        files[number_of_files].size = (unsigned long)file_status.st_size;
+        files[number_of_files].last_used = file_status.st_mtime;
+        total_size += files[number_of_files].size;
+        number_of_files++;
+    }
+    closedir(directory);
+
+    /* Remove the oldest entries first */
+    if (total_size > cache->size_limit) {
+        qsort(files, number_of_files, sizeof(CachedFile), compare_last_used);
+        for (i = 0; i < number_of_files && total_size > target_size; i++) {
+            char *path = make_cache_path(cache, files[i].name);
+
+            if (path != NULL && unlink(path) == 0) {
+                total_size -= files[i].size;
+            }
+            free(path);
+        }
+    }
+
+    /* A directory that could not be listed whole is scanned again on the next store */
+    is_total_size_known = is_listed;
+    free(files);
+}
+
+void make_cache_key(char key[SHA256_HEX_SIZE + 1], const char *flags, SourceFile *source) {
+    Sha256 hash;
+
+    /* Every part but the source ends with a newline, so no two different inputs hash the same bytes */
+    sha256_begin(&hash);
+    sha256_update(&hash, CACHE_FORMAT "\n" ASSEMBLER_VERSION "\n", strlen(CACHE_FORMAT "\n" ASSEMBLER_VERSION "\n"));
+    sha256_update(&hash, flags, strlen(flags));
+    sha256_update(&hash, "\n", 1);
+    sha256_update(&hash, source->data, source->size);
+    sha256_end_hex(&hash, key);
+}
+
+int load_cache_entry(AssemblyCache *cache, const char *key, SourceFile *entry) {
+    char *path = make_cache_path(cache, key);
+    int is_hit = FALSE;
+
+    if (path == NULL) {
+        return FALSE;
+    }
+
+    if (map_source_file(entry, path) == TRUE) {
+        is_hit = check_cache_entry(entry);
+        if (is_hit) {
+
+            /* Mark the entry as recently used, so the eviction keeps it */
+            utime(path, NULL);
+        } else {
+            close_source_file(entry);
+        }
+    }
+    free(path);
+    return is_hit;
+}
+
+int next_cache_section(SourceFile *entry, char name[MAX_FRAME_NAME], char **data, size_t *length) {
+    size_t content;
+
+    if (entry->position >= entry->size) {
+        return FALSE;
+    }
+
+    /* The entry was checked when it was loaded, so every section is whole */
+    content = parse_section_header(entry, name, length);
+    *data = entry->data + content;
+    entry->position = content + *length;
+    return TRUE;
+}
+
+void begin_cache_entry(OutputBuffer *entry) {
+    output_append_string(entry, CACHE_FORMAT "\n");
+}
+
+int store_cache_entry(AssemblyCache *cache, const char *key, OutputBuffer *entry) {
+    char temporary_name[SHA256_HEX_SIZE + 64];
+    char *temporary_path, *path, *lock_path;
+    unsigned long replaced_size = 0;
+    int is_stored = FALSE;
+    int lock_fd;
+
+    /* Create the cache directory on first use, another process may be creating it too */
+    mkdir(cache->directory, 0777);
+
+    pthread_mutex_lock(&cache_lock);
+    sprintf(temporary_name, TEMPORARY_PREFIX "%s.%ld.%lu", key, (long)getpid(), temporary_counter++);
+    pthread_mutex_unlock(&cache_lock);
+
+    temporary_path = make_cache_path(cache, temporary_name);
+    path = make_cache_path(cache, key);
+    lock_path = make_cache_path(cache, LOCK_FILE_NAME);
+
+    /* Write the whole entry aside, then rename it into place */
+    if (temporary_path != NULL && path != NULL && lock_path != NULL && !entry->is_out_of_memory &&
+        write_output_file(entry, temporary_path) == TRUE) {
+        struct stat file_status;
+
+        /* An entry that is not well formed, or stored by another thread or process meanwhile, is replaced */
+        if (stat(path, &file_status) == 0) {
+            replaced_size = (unsigned long)file_status.st_size;
+        }
+        is_stored = rename(temporary_path, path) == 0;
+        if (!is_stored) {
+            unlink(temporary_path);
+        }
+    }
+
+    /* Count the entry, and scan and evict the directory on the first store or once the limit is exceeded,
+     * under a lock of this process's threads and a lock file shared with the other processes */
+    if (is_stored) {
+        pthread_mutex_lock(&cache_lock);
+        if (is_total_size_known) {
+            total_size += entry->length;
+            total_size = replaced_size < total_size ? total_size - replaced_size : 0;
+        }
+        if (!is_total_size_known || total_size > cache->size_limit) {
+            lock_fd = open(lock_path, O_RDWR | O_CREAT, 0666);
+            if (lock_fd != -1) {
+                struct flock lock;
+
+                memset(&lock, 0, sizeof(lock));
+                lock.l_type = F_WRLCK;
+                lock.l_whence = SEEK_SET;
+                if (fcntl(lock_fd, F_SETLKW, &lock) == 0) {
+                    evict_cache_entries(cache);
+                }
+
+                /* Closing the file releases the lock */
+                close(lock_fd);
+            }
+        }
+        pthread_mutex_unlock(&cache_lock);
+    }
+
+    free(temporary_path);
+    free(path);
+    free(lock_path);
+    return is_stored;
+}
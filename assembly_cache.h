@@ -0,0 +1,81 @@
+#ifndef ASSEMBLY_CACHE_H
+#define ASSEMBLY_CACHE_H
+
+#include <stddef.h>
+#include "output_buffer.h"
+#include "source_file.h"
+#include "sha256.h"
+
+#define ASSEMBLER_VERSION "1.5.1" /* The version of the assembler, part of every cache key */
+#define CACHE_FORMAT "asm-cache 1" /* The first line of every cache entry, changed whenever the entry layout changes */
+#define DEFAULT_CACHE_SIZE 256 /* The default size limit of a cache directory, in megabytes */
+#define EVICTION_TARGET 90 /* The percentage of the size limit an eviction brings the entries down to */
+
+/**
+ * Describes an on-disk cache of assembly results. Every entry is a file in the cache directory
+ * named by the key of the source it was assembled from, holding the outputs and the diagnostics of that source.
+ */
+typedef struct {
+    char *directory; /* The cache directory, NULL when caching is off */
+    unsigned long size_limit; /* The total size of the entries kept, in bytes */
+} AssemblyCache;
+
+/**
+ * Computes the key of a source: the SHA-256 of the cache format, the assembler version,
+ * the flags that change the outputs and the bytes of the source.
+ *
+ * @param key The buffer to write the key to, as SHA256_HEX_SIZE hexadecimal digits and a null character
+ * @param flags The options that change the outputs, written as a string
+ * @param source Pointer to the source
+ * @return void
+ */
+void make_cache_key(char key[SHA256_HEX_SIZE + 1], const char *flags, SourceFile *source);
+
+/**
+ * Looks up the entry of a key and maps it for reading. A hit marks the entry as recently used.
+ * An entry that is not well formed counts as a miss, and is replaced by the next store.
+ *
+ * @param cache Pointer to the cache
+ * @param key The key of the source
+ * @param entry Pointer to the source file structure to map the entry into, closed by the caller after a hit
+ * @return int TRUE on a hit, FALSE on a miss
+ */
+int load_cache_entry(AssemblyCache *cache, const char *key, SourceFile *entry);
+
+/**
+ * Reads the next section of a mapped entry.
+ *
+ * @param entry Pointer to the mapped entry, its position is advanced past the section
+ * @param name The buffer to write the section name to
+ * @param data Pointer to set to the first byte of the section content
+ * @param length Pointer to set to the length of the section content
+ * @return int TRUE if a section was read, FALSE at the end of the entry
+ */
+int next_cache_section(SourceFile *entry, char name[MAX_FRAME_NAME], char **data, size_t *length);
+
+/**
+ * Starts recording an entry in an output buffer. The sections of the entry are then appended
+ * with output_append_frame.
+ *
+ * @param entry Pointer to the empty output buffer to record the entry in
+ * @return void
+ */
+void begin_cache_entry(OutputBuffer *entry);
+
+/**
+ * Stores a recorded entry under its key. The entry is written to a temporary file and renamed into place,
+ * so concurrent readers see either the whole entry or none. The cache directory is scanned on the first store
+ * of the process, and again whenever the entries stored since make it exceed its size limit; the scan removes
+ * temporary files left by stores that never finished, and evicts the least recently used entries down to
+ * EVICTION_TARGET percent of the limit. The entries other processes store are counted at the next scan.
+ * The scan is serialized across the threads and the processes sharing the cache directory.
+ * The cache directory is created if it does not exist.
+ *
+ * @param cache Pointer to the cache
+ * @param key The key of the source
+ * @param entry Pointer to the output buffer holding the recorded entry
+ * @return int TRUE if the entry was stored, FALSE otherwise
+ */
+int store_cache_entry(AssemblyCache *cache, const char *key, OutputBuffer *entry);
+
+#endif
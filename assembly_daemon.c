@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "macro_data.h"
+#include "source_chunks.h"
+#include "assembly_daemon.h"
+
+/**
+ * Holds what every serving thread of a daemon shares.
+ */
+typedef struct {
+    int listen_fd; /* The listening socket */
+    RequestHandler handler; /* The function that handles a request */
+    void *context; /* The context pointer passed to the handler */
+} DaemonServer;
+
+/**
+ * Holds one serving thread of a daemon.
+ */
+typedef struct {
+    DaemonServer *server; /* The daemon the thread serves */
+} DaemonWorker;
+
+/**
+ * Fills the address of a Unix domain socket.
+ *
+ * @param address Pointer to the address to fill
+ * @param socket_path The path of the socket
+ * @return int TRUE if the path fits in the address, FALSE otherwise
+ */
+static int make_socket_address(struct sockaddr_un *address, char *socket_path) {
+    if (strlen(socket_path) >= sizeof(address->sun_path)) {
+        return FALSE;
+    }
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, socket_path);
+    return TRUE;
+}
+
+/**
+ * Serves the requests of one client until it closes the connection or sends a frame that is not a request.
+ *
+ * @param server Pointer to the daemon
+ * @param fd The connected socket, closed when the client is done
+ * @return void
+ */
+static void serve_connection(DaemonServer *server, int fd) {
+    OutputBuffer request = {NULL, 0, 0};
+    OutputBuffer reply = {NULL, 0, 0};
+    OutputBuffer directory = {NULL, 0, 0};
+    char name[MAX_FRAME_NAME];
+    int has_directory = FALSE;
+
+    while (read_output_frame(fd, name, &request) == TRUE) {
+
+        /* Keep the payload a string, without counting the null character */
+        output_append(&request, "", 1);
+        if (request.is_out_of_memory) {
+            break;
+        }
+        request.length--;
+
+        if (strcmp(name, "cwd") == 0) {
+            output_reset(&directory);
+            output_append(&directory, request.data, request.length + 1);
+            has_directory = !directory.is_out_of_memory;
+            continue;
+        }
+        if (strcmp(name, "path") != 0 && strcmp(name, "source") != 0) {
+            break;
+        }
+
+        output_reset(&reply);
+        server->handler(name, &request, has_directory ? directory.data : NULL, &reply, server->context);
+        if (write_output_bytes(fd, &reply) == FALSE) {
+            break;
+        }
+    }
+
+    close(fd);
+    free_output_buffer(&request);
+    free_output_buffer(&reply);
+    free_output_buffer(&directory);
+}
+
+/**
+ * Accepts and serves connections, one at a time, until accepting fails.
+ *
+ * @param argument Pointer to the DaemonWorker
+ * @return void* Always NULL
+ */
+static void *serve_connections(void *argument) {
+    DaemonServer *server = ((DaemonWorker *) argument)->server;
+
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+
+        if (fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        serve_connection(server, fd);
+    }
+    return NULL;
+}
+
+/**
+ * Finds out whether a daemon still accepts connections at a socket path.
+ *
+ * @param address Pointer to the address of the socket
+ * @return int FALSE if nothing is at the path or nothing listens on it any more, TRUE otherwise
+ */
+static int is_socket_in_use(struct sockaddr_un *address) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    int is_in_use;
+
+    /* Without a socket to try with, assume the path is in use rather than remove it */
+    if (fd == -1) {
+        return TRUE;
+    }
+    is_in_use = connect(fd, (struct sockaddr *) address, sizeof(*address)) == 0 ||
+                (errno != ECONNREFUSED && errno != ENOENT);
+    close(fd);
+    return is_in_use;
+}
+
+int listen_on_socket(char *socket_path) {
+    struct sockaddr_un address;
+    int fd;
+
+    if (make_socket_address(&address, socket_path) == FALSE) {
+        printf("The socket path is too long: %s\n", socket_path);
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        printf("Error creating the socket %s\n", socket_path);
+        return -1;
+    }
+
+    /* A socket file left by a daemon that is gone would make the bind fail, one still in use is left alone */
+    if (is_socket_in_use(&address)) {
+        printf("A daemon is already running on the socket %s\n", socket_path);
+        close(fd);
+        return -1;
+    }
+    unlink(socket_path);
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) == -1 || listen(fd, SOMAXCONN) == -1) {
+        printf("Error listening on the socket %s\n", socket_path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connect_to_socket(char *socket_path) {
+    struct sockaddr_un address;
+    int fd;
+
+    if (make_socket_address(&address, socket_path) == FALSE) {
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *) &address, sizeof(address)) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int run_daemon(int listen_fd, int number_of_threads, RequestHandler handler, void *context) {
+    DaemonServer server;
+    DaemonWorker *workers;
+    int i;
+
+    if (number_of_threads < 1) {
+        number_of_threads = 1;
+    }
+
+    workers = (DaemonWorker *) malloc(number_of_threads * sizeof(DaemonWorker));
+    if (check_memory_allocation(workers) == FALSE) {
+        return ERROR_FOUND;
+    }
+
+    /* A client that goes away must not stop the daemon while the reply is written */
+    signal(SIGPIPE, SIG_IGN);
+
+    server.listen_fd = listen_fd;
+    server.handler = handler;
+    server.context = context;
+    for (i = 0; i < number_of_threads; i++) {
+        workers[i].server = &server;
+    }
+    run_on_threads(serve_connections, workers, sizeof(DaemonWorker), number_of_threads);
+
+    free(workers);
+    return ERROR_FOUND;
+}
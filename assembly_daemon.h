@@ -0,0 +1,59 @@
+#ifndef ASSEMBLY_DAEMON_H
+#define ASSEMBLY_DAEMON_H
+
+#include "output_buffer.h"
+
+#define DEFAULT_DAEMON_THREADS 4 /* The number of clients a daemon serves at once unless told otherwise */
+
+/*
+ * A daemon connection carries frames, as write_output_frame writes them, both ways.
+ * The client may send a "cwd" frame with its working directory, then any number of requests,
+ * each a "path" frame holding a file argument or a "source" frame holding source bytes.
+ * The daemon answers every request with the frames the request handler builds, in order.
+ */
+
+/**
+ * A function that handles one request of a daemon client.
+ *
+ * @param request_kind "path" or "source", the section name of the request frame
+ * @param request Pointer to the payload of the request frame, followed by a null character
+ * @param directory The working directory the client sent, or NULL if it sent none
+ * @param reply Pointer to the empty output buffer to build the reply frames in
+ * @param context The context pointer given to run_daemon
+ */
+typedef void (*RequestHandler)(char *request_kind, OutputBuffer *request, char *directory, OutputBuffer *reply,
+                               void *context);
+
+/**
+ * Creates a Unix domain socket listening at a path, replacing a stale socket left at the path.
+ * A socket a daemon still accepts connections on is not replaced.
+ *
+ * @param socket_path The path of the socket
+ * @return int The listening socket, or -1 if it could not be created or a daemon is already running at the path,
+ *         in which case an error is printed
+ */
+int listen_on_socket(char *socket_path);
+
+/**
+ * Connects to a daemon listening at a path.
+ *
+ * @param socket_path The path of the socket
+ * @return int The connected socket, or -1 if no daemon accepts connections at the path
+ */
+int connect_to_socket(char *socket_path);
+
+/**
+ * Serves the clients of a listening socket on a pool of threads, each one accepting and serving
+ * one connection at a time, so up to number_of_threads clients are served at once.
+ * A connection is closed when the client closes it or sends a frame that is not a request.
+ * The function only returns if the threads cannot be started or every one of them fails to accept.
+ *
+ * @param listen_fd The listening socket
+ * @param number_of_threads The number of threads serving clients
+ * @param handler The function that handles a request
+ * @param context The context pointer passed to the handler
+ * @return int ERROR_FOUND, once the daemon has stopped
+ */
+int run_daemon(int listen_fd, int number_of_threads, RequestHandler handler, void *context);
+
+#endif
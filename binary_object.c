@@ -0,0 +1,147 @@
+#include <string.h>
+#include "binary_object.h"
+
+#define FNV_OFFSET_BASIS 2166136261UL /* The starting value of a 32-bit FNV-1a hash */
+#define FNV_PRIME 16777619UL /* The multiplier of a 32-bit FNV-1a hash */
+
+/**
+ * Writes a 32-bit value as four little-endian bytes.
+ *
+ * @param destination Pointer to the four bytes to write
+ * @param value The value, only its low 32 bits are written
+ * @return void
+ */
+static void write_binary_field(unsigned char *destination, unsigned long value) {
+    destination[0] = (unsigned char)(value & 0xFF);
+    destination[1] = (unsigned char)((value >> 8) & 0xFF);
+    destination[2] = (unsigned char)((value >> 16) & 0xFF);
+    destination[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
+/**
+ * Appends words packed into 3 little-endian bytes each.
+ *
+ * @param output Pointer to the output buffer
+ * @param words The packed 24-bit words
+ * @param count The number of words
+ * @return void
+ */
+static void append_binary_words(OutputBuffer *output, unsigned long *words, int count) {
+    unsigned char *slot = (unsigned char *) output_reserve(output, (size_t) count * BINARY_OBJECT_WORD_SIZE);
+    int i;
+
+    for (i = 0; slot != NULL && i < count; i++) {
+        slot[0] = (unsigned char)(words[i] & 0xFF);
+        slot[1] = (unsigned char)((words[i] >> 8) & 0xFF);
+        slot[2] = (unsigned char)((words[i] >> 16) & 0xFF);
+        slot += BINARY_OBJECT_WORD_SIZE;
+    }
+}
+
+/**
+ * Appends one entry or external record. A name that is the same string as the name of the previous record
+ * is not added to the names again, so the uses of one external symbol share it.
+ *
+ * @param output Pointer to the output buffer holding the object
+ * @param names Pointer to the output buffer holding the names
+ * @param symbol_name The name of the symbol
+ * @param address The address of the record
+ * @param previous_name Pointer to the name of the previous record, updated
+ * @param previous_offset Pointer to the offset of the name of the previous record among the names, updated
+ * @return void
+ */
+static void append_symbol_record(OutputBuffer *output, OutputBuffer *names, char *symbol_name, int address,
+                                 char **previous_name, unsigned long *previous_offset) {
+    unsigned char *record = (unsigned char *) output_reserve(output, BINARY_OBJECT_SYMBOL_SIZE);
+
+    if (symbol_name != *previous_name) {
+        *previous_name = symbol_name;
+        *previous_offset = (unsigned long) names->length;
+        output_append(names, symbol_name, strlen(symbol_name) + 1);
+    }
+    if (record != NULL) {
+        write_binary_field(record, (unsigned long) address);
+        write_binary_field(record + 4, *previous_offset);
+    }
+}
+
+unsigned long binary_object_checksum(const unsigned char *bytes, size_t length) {
+    unsigned long hash = FNV_OFFSET_BASIS;
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        hash = ((hash ^ bytes[i]) * FNV_PRIME) & 0xFFFFFFFFUL;
+    }
+    return hash;
+}
+
+unsigned long read_binary_field(const unsigned char *bytes) {
+    return (unsigned long) bytes[0] | ((unsigned long) bytes[1] << 8) | ((unsigned long) bytes[2] << 16) |
+           ((unsigned long) bytes[3] << 24);
+}
+
+int build_binary_object_output(OutputBuffer *output, unsigned long *code_words, DataImage *data_image,
+                               SymbolNode *head_of_symbol_table, ExternalUse *external_uses,
+                               int number_of_external_uses, int ICF, int DCF) {
+    OutputBuffer names = {NULL, 0, 0};
+    unsigned long fields[BINARY_HEADER_FIELDS];
+    size_t start = output->length;
+    unsigned char *header;
+    SymbolNode *current;
+    char *previous_name = NULL;
+    unsigned long previous_offset = 0;
+    int i;
+
+    /* The header is filled in last, once the offsets of the sections are known */
+    memset(fields, 0, sizeof(fields));
+    output_reserve(output, BINARY_OBJECT_HEADER_SIZE);
+    fields[BINARY_CODE_WORDS] = (unsigned long)(ICF - 100);
+    fields[BINARY_DATA_WORDS] = (unsigned long) DCF;
+
+    /* The code and data images, in address order, padded so the records that follow are aligned */
+    append_binary_words(output, code_words, ICF - 100);
+    append_binary_words(output, data_image->words, data_image->count);
+    while ((output->length - start) % BINARY_OBJECT_ALIGNMENT != 0) {
+        output_append(output, "", 1);
+    }
+
+    /* The entry records, in the order of the symbol table as in the entries file */
+    fields[BINARY_ENTRIES_OFFSET] = (unsigned long)(output->length - start);
+    for (current = head_of_symbol_table; current != NULL; current = current->next) {
+        if (current->entry_flag == 1) {
+            append_symbol_record(output, &names, current->symbol_name, current->address, &previous_name,
+                                 &previous_offset);
+            fields[BINARY_ENTRIES]++;
+        }
+    }
+
+    /* The external records, in the order of the externals file */
+    fields[BINARY_EXTERNALS_OFFSET] = (unsigned long)(output->length - start);
+    fields[BINARY_EXTERNALS] = (unsigned long) number_of_external_uses;
+    for (i = 0; i < number_of_external_uses; i++) {
+        append_symbol_record(output, &names, external_uses[i].symbol_name, external_uses[i].address,
+                             &previous_name, &previous_offset);
+    }
+
+    /* The names the records point to, offsets in the records are counted from their start */
+    fields[BINARY_STRINGS_OFFSET] = (unsigned long)(output->length - start);
+    if (names.length > 0) {
+        output_append(output, names.data, names.length);
+    }
+    if (names.is_out_of_memory || output->is_out_of_memory) {
+        free_output_buffer(&names);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    free_output_buffer(&names);
+    fields[BINARY_TOTAL_SIZE] = (unsigned long)(output->length - start);
+
+    /* The checksum covers every byte after the header */
+    header = (unsigned char *) output->data + start;
+    fields[BINARY_CHECKSUM] = binary_object_checksum(header + BINARY_OBJECT_HEADER_SIZE,
+                                                     output->length - start - BINARY_OBJECT_HEADER_SIZE);
+    memcpy(header, BINARY_OBJECT_MAGIC, 4);
+    for (i = 0; i < BINARY_HEADER_FIELDS; i++) {
+        write_binary_field(header + 4 + 4 * i, fields[i]);
+    }
+    return TRUE;
+}
@@ -0,0 +1,68 @@
+#ifndef BINARY_OBJECT_H
+#define BINARY_OBJECT_H
+
+#include <stddef.h>
+#include "first_second_pass_data.h"
+#include "output_buffer.h"
+
+#define BINARY_OBJECT_MAGIC "AOB1" /* The first four bytes of a binary object */
+#define BINARY_OBJECT_HEADER_SIZE 40 /* The header: the magic, then nine 32-bit little-endian fields */
+#define BINARY_OBJECT_WORD_SIZE 3 /* Every code and data word is packed into 3 little-endian bytes */
+#define BINARY_OBJECT_SYMBOL_SIZE 8 /* An entry or external record: its address and the offset of its name */
+#define BINARY_OBJECT_ALIGNMENT 4 /* The symbol sections start at a multiple of 4 bytes */
+
+/**
+ * The 32-bit fields of the binary object header, in the order they follow the magic.
+ * Every offset is counted from the start of the object.
+ */
+typedef enum {
+    BINARY_CODE_WORDS, /* The number of code words, ICF - 100 */
+    BINARY_DATA_WORDS, /* The number of data words, DCF */
+    BINARY_ENTRIES, /* The number of entry records */
+    BINARY_EXTERNALS, /* The number of external records */
+    BINARY_ENTRIES_OFFSET, /* The offset of the entry records */
+    BINARY_EXTERNALS_OFFSET, /* The offset of the external records */
+    BINARY_STRINGS_OFFSET, /* The offset of the null-terminated symbol names */
+    BINARY_TOTAL_SIZE, /* The size of the whole object */
+    BINARY_CHECKSUM, /* The FNV-1a checksum of every byte after the header */
+    BINARY_HEADER_FIELDS
+} BinaryObjectField;
+
+/**
+ * Computes the 32-bit FNV-1a checksum that the header of a binary object holds.
+ *
+ * @param bytes Pointer to the bytes
+ * @param length The number of bytes
+ * @return unsigned long The checksum
+ */
+unsigned long binary_object_checksum(const unsigned char *bytes, size_t length);
+
+/**
+ * Reads a 32-bit little-endian field.
+ *
+ * @param bytes Pointer to the four bytes of the field
+ * @return unsigned long The value of the field
+ */
+unsigned long read_binary_field(const unsigned char *bytes);
+
+/**
+ * Builds a binary object holding the same program as the object, entries and externals outputs:
+ * the header, the code words and the data words packed into 3 bytes each, then the entry records
+ * in the order of the entries file, the external records in the order of the externals file,
+ * and the names the records point to.
+ *
+ * @param output Pointer to the output buffer to append the object to
+ * @param code_words The packed instruction words, indexed by their address - 100
+ * @param data_image Pointer to the data image holding the .data and .string words
+ * @param head_of_symbol_table Pointer to the head of the symbol table, for the entry symbols
+ * @param external_uses The uses of external symbols, in the order of the externals file
+ * @param number_of_external_uses The number of uses
+ * @param ICF The instruction counter value
+ * @param DCF The data counter value
+ * @return int TRUE if the object was built, ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int build_binary_object_output(OutputBuffer *output, unsigned long *code_words, DataImage *data_image,
+                                SymbolNode *head_of_symbol_table, ExternalUse *external_uses,
+                                int number_of_external_uses, int ICF, int DCF);
+
+#endif
@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
@@ -108,6 +110,7 @@ int number_of_operands (char *command) {
 int number_of_words(char* line, char* command) {
     char *first_operator;
     char *second_operator;
+    char *save_pointer;
 
     /* Every instruction requires at least one word */
     int counter_of_words = 1;
@@ -116,7 +119,7 @@ int number_of_words(char* line, char* command) {
     if(number_of_operands(command) == 2 || number_of_operands(command) == 1) {
 
         /* Extract the first operand from the line */
-        first_operator = strtok(line, " ,");
+        first_operator = strtok_r(line, " ,", &save_pointer);
 
         /* If the first (or the single) operand is not a register, it requires an extra word */
         if (get_operand_addressing_mode(first_operator) != REGISTER_DIRECT_ADDRESSING) {
@@ -127,7 +130,7 @@ int number_of_words(char* line, char* command) {
         if (number_of_operands(command) == 2) {
 
             /* Extract the second operand from the line */
-            second_operator = strtok(NULL, " \n\t");
+            second_operator = strtok_r(NULL, " \n\t", &save_pointer);
 
             /* If the second operand is not a register, it requires an extra word */
             if (get_operand_addressing_mode(second_operator) != REGISTER_DIRECT_ADDRESSING) {
@@ -154,39 +157,37 @@ void to_binary(char* array, int number, int number_of_bits) {
     }
 }
 
-char* create_first_word(char* line, int is_symbol) {
+int write_first_word(char *line, int is_symbol, char word[WORD_SIZE + 1]) {
     char *src_operand;
     char *dest_operand;
     int addressing_mode_src;
     int adressing_mode_dest;
 
     char *command;
+    char *save_pointer;
 
-    char *opcode;
+    char *opcode = NULL;
     char *src_addresing = "00";
     char *src_register = "000";
     char *dest_adrresing = "00";
     char *dest_register = "000";
-    char *funct;
+    char *funct = NULL;
     char *A = "1";
     char *R = "0";
     char *E = "0";
     int i;
 
-    char* result = (char*) malloc((WORD_SIZE + 1) * sizeof(char));
-    if(check_memory_allocation(result) == FALSE) {
-        exit(1);
-    }
-
-
     /* If the line contains a symbol, skip it and process the command */
     if (is_symbol == TRUE) {
-        line = strtok(line, ":");
-        line = strtok(NULL, "");
+        line = strtok_r(line, ":", &save_pointer);
+        line = strtok_r(NULL, "", &save_pointer);
     }
 
     /* Extract the command from the line */
-    command =strtok(line, " \n\t");
+    command =strtok_r(line, " \n\t", &save_pointer);
+    if (command == NULL) {
+        return FALSE;
+    }
 
     /* Iterate over the commands table */
     for(i = 0; i<= 15; i++) {
@@ -198,11 +199,16 @@ char* create_first_word(char* line, int is_symbol) {
         }
     }
 
+    /* A command the table does not hold has no first word */
+    if (opcode == NULL) {
+        return FALSE;
+    }
+
     /* If the command has two operands, process the source operand */
     if (number_of_operands(command) == 2) {
 
         /* Extract the source operand */
-        src_operand = strtok(NULL, " ,\t");
+        src_operand = strtok_r(NULL, " ,\t", &save_pointer);
 
         /* Determine its addressing mode */
         addressing_mode_src = get_operand_addressing_mode(src_operand);
@@ -238,7 +244,7 @@ char* create_first_word(char* line, int is_symbol) {
     if(number_of_operands(command) == 2 || number_of_operands(command) == 1) {
 
         /* Extract the destination operand */
-        dest_operand = strtok(NULL, " ,\n\t");
+        dest_operand = strtok_r(NULL, " ,\n\t", &save_pointer);
 
         /* Determine its addressing mode */
         adressing_mode_dest = get_operand_addressing_mode(dest_operand);
@@ -272,30 +278,38 @@ char* create_first_word(char* line, int is_symbol) {
     }
 
     /* Concatenates all the binary components to the result string. */
-    result[0] = '\0';
-    strcat(result, opcode);
-    strcat(result, src_addresing);
-    strcat(result, src_register);
-    strcat(result, dest_adrresing);
-    strcat(result, dest_register);
-    strcat(result, funct);
-    strcat(result, A);
-    strcat(result, R);
-    strcat(result, E);
+    word[0] = '\0';
+    strcat(word, opcode);
+    strcat(word, src_addresing);
+    strcat(word, src_register);
+    strcat(word, dest_adrresing);
+    strcat(word, dest_register);
+    strcat(word, funct);
+    strcat(word, A);
+    strcat(word, R);
+    strcat(word, E);
+    return TRUE;
+}
+
+char* create_first_word(char* line, int is_symbol) {
+    char* result = (char*) malloc((WORD_SIZE + 1) * sizeof(char));
 
+    if(check_memory_allocation(result) == FALSE) {
+        return NULL;
+    }
+    if (write_first_word(line, is_symbol, result) == FALSE) {
+        free(result);
+        return NULL;
+    }
     return result;
 }
 
-char* create_extra_word(char* operator, AssemblyElementType type) {
-    char* result = (char*) malloc((WORD_SIZE + 1) * sizeof(char));
+void write_extra_word(char *operator, AssemblyElementType type, char word[WORD_SIZE + 1]) {
+    char *result = word;
     int addressing_mode;
     int number;
     int i;
 
-    if(check_memory_allocation(result) == FALSE) {
-        exit(1);
-    }
-
     /* Initialize the binary extra word with all zeros */
     for(i = 0; i <= WORD_SIZE; i++) {
         result[i] = '0';
@@ -317,7 +331,7 @@ char* create_extra_word(char* operator, AssemblyElementType type) {
 
         /* Convert the number to binary */
         to_binary(result, number, BINARY_BITS - 1);
-        return result;
+        return;
 
     }
     else {
@@ -334,34 +348,32 @@ char* create_extra_word(char* operator, AssemblyElementType type) {
 
             /* Convert the number to binary */
             to_binary(result, number, BINARY_BITS - 4);
-            return result;
+            return;
         }
 
         /* Handle direct addressing or relative addressing modes */
         if(addressing_mode == DIRECT_ADDRESSING || addressing_mode == RELATIVE_ADDRESSING) {
 
-            /* Free the allocated memory */
-            free(result);
-            result = (char*) malloc(2 * sizeof(char));
-            if(check_memory_allocation(result) == FALSE) {
-                exit(1);
-            }
             /* Placeholder, the word will be completed in second pass */
             result[0] = '?';
             result[1] = '\0';
-            return result;
         }
     }
-    return result;
 }
 
-char* build_word_second_pass(int address, AddressingCase addressing_mode, int external_flag) {
+char* create_extra_word(char* operator, AssemblyElementType type) {
     char* result = (char*) malloc((WORD_SIZE + 1) * sizeof(char));
-    int i;
 
     if(check_memory_allocation(result) == FALSE) {
-        exit(1);
+        return NULL;
     }
+    write_extra_word(operator, type, result);
+    return result;
+}
+
+void write_word_second_pass(int address, AddressingCase addressing_mode, int external_flag, char word[WORD_SIZE + 1]) {
+    char *result = word;
+    int i;
 
     /* Initialize the binary word with all zeros */
     for(i = 0; i <= WORD_SIZE; i++) {
@@ -392,7 +404,15 @@ char* build_word_second_pass(int address, AddressingCase addressing_mode, int ex
 
         to_binary(result, address, BINARY_BITS - 4);
     }
+}
+
+char* build_word_second_pass(int address, AddressingCase addressing_mode, int external_flag) {
+    char* result = (char*) malloc((WORD_SIZE + 1) * sizeof(char));
 
+    if(check_memory_allocation(result) == FALSE) {
+        return NULL;
+    }
+    write_word_second_pass(address, addressing_mode, external_flag, result);
     return result;
 }
 
@@ -403,9 +423,9 @@ char* build_word_second_pass(int address, AddressingCase addressing_mode, int ex
 * @line Pointer to the assembly line list node
 * @operand Pointer to the string representing the operand to process
 * @head_of_symbol_table Pointer to the head of the symbol table
-* @return void
+* @return int TRUE if the missing word was built, FALSE if memory ran out
 */
-static void process_operand(AssemblyLineList *line, char *operand, SymbolNode *head_of_symbol_table) {
+static int process_operand(AssemblyLineList *line, char *operand, SymbolNode *head_of_symbol_table) {
     AddressingCase addressing_mode;
     int address;
     int external_flag;
@@ -425,6 +445,9 @@ static void process_operand(AssemblyLineList *line, char *operand, SymbolNode *h
 
         /* Build the additional word with the symbol's address */
         missing_word = build_word_second_pass(address, addressing_mode, external_flag);
+        if (missing_word == NULL) {
+            return FALSE;
+        }
 
         /* Add the missing word to the line's machine code */
         add_missing_word(line->code, missing_word);
@@ -441,52 +464,71 @@ static void process_operand(AssemblyLineList *line, char *operand, SymbolNode *h
 
         /* Build the additional word with the relative address */
         missing_word = build_word_second_pass(address, addressing_mode, FALSE);
+        if (missing_word == NULL) {
+            return FALSE;
+        }
 
         /* Add the missing word to the line's machine code */
         add_missing_word(line->code, missing_word);
     }
+    return TRUE;
 }
 
-void create_missing_word_second_pass(AssemblyLineList *line, SymbolNode *head_of_symbol_table) {
-    char *string_line = line->line;
+int split_instruction_operands(char *line, char line_copy[MAX_LINE], char *operands[MAX_OPERANDS]) {
     char *command;
-    char *first_operand;
-    char *second_operand;
+    char *save_pointer;
+    int count;
 
-    char *line_copy = (char *)malloc(strlen(string_line) + 1);
-    if(check_memory_allocation(line_copy) == FALSE) {
-        exit(1);
-    }
-
-    strcpy(line_copy, string_line);
+    strcpy(line_copy, line);
 
     /* Check if the line starts with a symbol (label) */
     if (is_symbol(line_copy) == TRUE) {
 
         /* Extract the command after the label */
-        strtok(line_copy, ":");
-        command = strtok(NULL, " \n\t");
+        strtok_r(line_copy, ":", &save_pointer);
+        command = strtok_r(NULL, " \n\t", &save_pointer);
     } else {
 
         /* Extract the command from the beginning of the line */
-        command = strtok(line_copy, " \n\t");
+        command = strtok_r(line_copy, " \n\t", &save_pointer);
+
+    }
+
+    count = number_of_operands(command);
+
+    /* Extract the first operand of commands that have 1 or 2 operands */
+    if(count == 1 || count == 2) {
+        operands[0] = strtok_r(NULL, " ,\n\t", &save_pointer);
+    }
 
+    /* Extract the second operand if the command has 2 operands */
+    if(count == 2) {
+        operands[1] = strtok_r(NULL, " \n\t", &save_pointer);
     }
+    return count;
+}
 
-    /* Process commands that have 1 or 2 operands */
-    if(number_of_operands(command) == 1 || number_of_operands(command) == 2) {
+int create_missing_word_second_pass(AssemblyLineList *line, SymbolNode *head_of_symbol_table) {
+    char line_copy[MAX_LINE] = {0};
+    char *operands[MAX_OPERANDS];
+    int number_of_operands_in_line = split_instruction_operands(line->line, line_copy, operands);
+    int i;
 
-        /* Extract the first operand */
-        first_operand = strtok(NULL, " ,\n\t");
-        process_operand(line, first_operand, head_of_symbol_table);
+    /* Process the operands in order, each one fills the next missing word */
+    for (i = 0; i < number_of_operands_in_line; i++) {
+        if (process_operand(line, operands[i], head_of_symbol_table) == FALSE) {
+            return FALSE;
+        }
     }
+    return TRUE;
+}
 
-    /* Process the second operand if the command has 2 operands */
-    if(number_of_operands(command) == 2) {
+unsigned long binary_word_value(const char *word) {
+    unsigned long value = 0;
+    int i;
 
-        /* Extract the second operand */
-        second_operand = strtok(NULL, " \n\t");
-        process_operand(line, second_operand, head_of_symbol_table);
+    for (i = 0; word[i] != '\0'; i++) {
+        value = (value << 1) | (unsigned long)(word[i] == '1');
     }
-    free(line_copy);
+    return value;
 }
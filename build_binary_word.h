@@ -5,6 +5,7 @@
 
 #define WORD_SIZE 24
 #define BINARY_BITS 24
+#define MAX_OPERANDS 2 /* Maximum number of operands of an instruction */
 
 /**
  * Represents a command with its name and his binary code and binary funct code.
@@ -75,41 +76,93 @@ int number_of_words(char* line, char* command);
  */
 void to_binary(char* array, int number, int number_of_bits);
 
+/**
+ * Writes the binary representation of the first word of an assembly instruction into a buffer.
+ *
+ * @param line Pointer to the string representing the assembly instruction line to be processed, it is modified
+ * @param is_symbol Flag indicating if the line contains a symbol (label)
+ * @param word The buffer to write the word to, as a null-terminated string of '0' and '1' characters
+ * @return int TRUE if the word was written, FALSE if the line has no command or its command is not an instruction
+ */
+int write_first_word(char *line, int is_symbol, char word[WORD_SIZE + 1]);
+
 /**
  * Creates the binary representation of the first word of an assembly instruction.
  *
  * @param line Pointer to the string representing the assembly instruction line to be processed
  * @param is_symbol Flag indicating if the line contains a symbol (label)
- * @return Pointer to a string containing the binary representation of the first word of the assembly instruction
+ * @return Pointer to a string containing the binary representation of the first word of the assembly instruction,
+ *         or NULL if memory ran out or the command is not an instruction
  */
 char* create_first_word(char* line, int is_symbol);
 
+/**
+ * Writes the binary representation of an extra word for assembly elements (instructions, data values, and strings)
+ * into a buffer.
+ *
+ * @param operator The operand string to be converted to binary representation
+ * @param type The type of assembly element (STRING, DATA, or INSTRUCTION)
+ * @param word The buffer to write the word to, or "?" for a word to be resolved later
+ * @return void
+ */
+void write_extra_word(char *operator, AssemblyElementType type, char word[WORD_SIZE + 1]);
+
 /**
  * Creates a binary representation of an extra word for assembly elements (instructions, data values, and strings)
  *
  * @param operator The operand string to be converted to binary representation
  * @param type The type of assembly element (STRING, DATA, or INSTRUCTION)
- * @return A string containing the binary representation of the extra word, or "?" for words to be resolved later
+ * @return A string containing the binary representation of the extra word, or "?" for words to be resolved later,
+ *         or NULL if memory ran out
  */
 char* create_extra_word(char* operator, AssemblyElementType type);
 
+/**
+ * Writes a missing binary word for the second pass of the assembler into a buffer.
+ *
+ * @param address The address value to encode
+ * @param addressing_mode The addressing mode (DIRECT or RELATIVE)
+ * @param external_flag Indicates if the symbol is external (TRUE or FALSE)
+ * @param word The buffer to write the word to
+ * @return void
+ */
+void write_word_second_pass(int address, AddressingCase addressing_mode, int external_flag, char word[WORD_SIZE + 1]);
+
 /**
  * Builds a missing binary word for the second pass of the assembler.
  *
  * @param address The address value to encode
  * @param addressing_mode The addressing mode (DIRECT or RELATIVE)
  * @param external_flag Indicates if the symbol is external (TRUE or FALSE)
- * @return A string representing the binary word of the missing word
+ * @return A string representing the binary word of the missing word, or NULL if memory ran out
  */
 char* build_word_second_pass(int address, AddressingCase addressing_mode, int external_flag);
 
+/**
+ * Splits the operands of an instruction line the way the second pass reads them.
+ *
+ * @param line The instruction line
+ * @param line_copy Buffer that receives a copy of the line, the operands point into it
+ * @param operands Array that receives the operands, the first count of them are set (some may be NULL)
+ * @return int The number of operands of the command of the line
+ */
+int split_instruction_operands(char *line, char line_copy[MAX_LINE], char *operands[MAX_OPERANDS]);
+
 /**
  * Creates additional words during the second pass for operands that reference symbols
  *
  * @line Pointer to the current assembly line list node
  * @head_of_symbol_table Pointer to the head of the symbol table
- * @return void
+ * @return int TRUE if the missing words were built, FALSE if memory ran out
+ */
+int create_missing_word_second_pass(AssemblyLineList *line, SymbolNode *head_of_symbol_table);
+
+/**
+ * Converts a machine word held as a string of '0' and '1' characters to its packed value.
+ *
+ * @param word A string representing the binary word
+ * @return unsigned long The packed value of the word
  */
-void create_missing_word_second_pass(AssemblyLineList *line, SymbolNode *head_of_symbol_table);
+unsigned long binary_word_value(const char *word);
 
 #endif
@@ -0,0 +1,353 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "macro_data.h"
+#include "json_text.h"
+#include "diagnostics.h"
+
+/* The keys of the per-thread diagnostic sink, report and limit, created on first use */
+static pthread_key_t sink_key;
+static pthread_key_t report_key;
+static pthread_key_t limit_key;
+static pthread_once_t sink_key_once = PTHREAD_ONCE_INIT;
+
+/* Serializes appends to the sinks, which the threads of one job share */
+static pthread_mutex_t sink_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Creates the keys of the per-thread diagnostic sink, report and limit.
+ *
+ * @return void
+ */
+static void create_sink_key(void) {
+    pthread_key_create(&sink_key, NULL);
+    pthread_key_create(&report_key, NULL);
+    pthread_key_create(&limit_key, NULL);
+}
+
+/**
+ * Appends text to a sink, or writes it to standard output if there is no sink.
+ *
+ * @param sink Pointer to the output buffer that collects the diagnostics, or NULL for standard output
+ * @param text Pointer to the text
+ * @param length The length of the text
+ * @return void
+ */
+static void write_to_sink(OutputBuffer *sink, const char *text, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    if (sink == NULL) {
+        fwrite(text, 1, length, stdout);
+    } else {
+        pthread_mutex_lock(&sink_lock);
+        output_append(sink, text, length);
+        pthread_mutex_unlock(&sink_lock);
+    }
+}
+
+/**
+ * Writes a record as one line of JSON: the file, and for an error in a source line its line, code
+ * and column span, then the message.
+ *
+ * @param output Pointer to the output buffer to append the line to
+ * @param file_name The name of the file the record is about
+ * @param record Pointer to the record
+ * @return void
+ */
+static void append_json_record(OutputBuffer *output, const char *file_name, const DiagnosticRecord *record) {
+    char numbers[64];
+
+    output_append_string(output, "{\"file\":");
+    json_append_string(output, file_name, strlen(file_name));
+    if (record->line_number > 0) {
+        sprintf(numbers, ",\"line\":%d", record->line_number);
+        output_append_string(output, numbers);
+    }
+    if (record->code != NO_DIAGNOSTIC_CODE) {
+        sprintf(numbers, ",\"code\":%d,\"columns\":[%d,%d]", record->code, record->column_start,
+                record->column_end);
+        output_append_string(output, numbers);
+    }
+    output_append_string(output, ",\"message\":");
+    json_append_string(output, record->message, strlen(record->message));
+    output_append_string(output, "}\n");
+}
+
+/**
+ * Writes a record as one frame named "diagnostic": its line, code and column span on a line,
+ * then its message followed by a null character, so it can be read back in place.
+ *
+ * @param output Pointer to the output buffer to append the frame to
+ * @param record Pointer to the record
+ * @return void
+ */
+static void append_recorded_record(OutputBuffer *output, const DiagnosticRecord *record) {
+    OutputBuffer payload = {NULL, 0, 0};
+    char numbers[64];
+
+    sprintf(numbers, "%d %d %d %d\n", record->line_number, record->code, record->column_start, record->column_end);
+    output_append_string(&payload, numbers);
+    output_append(&payload, record->message, strlen(record->message) + 1);
+    if (payload.is_out_of_memory) {
+        output->is_out_of_memory = TRUE;
+    } else {
+        output_append_frame(output, "diagnostic", payload.data, payload.length);
+    }
+    free_output_buffer(&payload);
+}
+
+/**
+ * Counts an error against the repeat limit of a report.
+ *
+ * @param report Pointer to the report
+ * @param record Pointer to the record of the error
+ * @return int TRUE if the error is to be written, FALSE if it passed the repeat limit
+ */
+static int count_repeat(DiagnosticReport *report, const DiagnosticRecord *record) {
+    int is_written;
+
+    if (report->repeat_limit <= 0 || record->code < 0 || record->code >= MAX_DIAGNOSTIC_CODES) {
+        return TRUE;
+    }
+    pthread_mutex_lock(&sink_lock);
+    report->messages[record->code] = record->message;
+    is_written = report->repeats[record->code]++ < report->repeat_limit;
+    pthread_mutex_unlock(&sink_lock);
+    return is_written;
+}
+
+void capture_diagnostics(OutputBuffer *sink) {
+    pthread_once(&sink_key_once, create_sink_key);
+    pthread_setspecific(sink_key, sink);
+}
+
+OutputBuffer *current_diagnostics_sink(void) {
+    pthread_once(&sink_key_once, create_sink_key);
+    return (OutputBuffer *) pthread_getspecific(sink_key);
+}
+
+void begin_diagnostic_report(DiagnosticReport *report, const char *file_name, DiagnosticFormat format,
+                             int repeat_limit) {
+    report->file_name = file_name;
+    report->format = format;
+    report->repeat_limit = repeat_limit;
+    memset(report->repeats, 0, sizeof(report->repeats));
+    memset(report->messages, 0, sizeof(report->messages));
+    report->records.data = NULL;
+    report->records.length = 0;
+    report->records.capacity = 0;
+    report->records.is_out_of_memory = FALSE;
+    report->outer_sink = current_diagnostics_sink();
+    report->outer_report = current_diagnostic_report();
+
+    use_diagnostic_report(report);
+    capture_diagnostics(&report->records);
+}
+
+DiagnosticReport *current_diagnostic_report(void) {
+    pthread_once(&sink_key_once, create_sink_key);
+    return (DiagnosticReport *) pthread_getspecific(report_key);
+}
+
+void use_diagnostic_report(DiagnosticReport *report) {
+    pthread_once(&sink_key_once, create_sink_key);
+    pthread_setspecific(report_key, report);
+}
+
+void summarize_diagnostic_report(void) {
+    DiagnosticReport *report = current_diagnostic_report();
+    OutputBuffer *sink = current_diagnostics_sink();
+    int code;
+
+    if (report == NULL) {
+        return;
+    }
+    for (code = 0; code < MAX_DIAGNOSTIC_CODES; code++) {
+        int left_out = report->repeats[code] - report->repeat_limit;
+
+        if (report->repeat_limit > 0 && left_out > 0) {
+            OutputBuffer summary = {NULL, 0, 0};
+            char numbers[64];
+
+            /* The count is written whatever the limit of the thread, it stands for errors already counted */
+            if (report->format == JSON_DIAGNOSTICS) {
+                output_append_string(&summary, "{\"file\":");
+                json_append_string(&summary, report->file_name, strlen(report->file_name));
+                sprintf(numbers, ",\"code\":%d,\"left_out\":%d,\"message\":", code, left_out);
+                output_append_string(&summary, numbers);
+                json_append_string(&summary, report->messages[code], strlen(report->messages[code]));
+                output_append_string(&summary, "}\n");
+            } else if (report->format == RECORDED_DIAGNOSTICS) {
+                DiagnosticRecord record;
+                char message[MAX_DIAGNOSTIC];
+
+                sprintf(numbers, "%d more errors of \"", left_out);
+                strcpy(message, numbers);
+                strncat(message, report->messages[code], MAX_DIAGNOSTIC - 64);
+                strcat(message, "\" were left out.");
+                record.line_number = 0;
+                record.code = code;
+                record.column_start = 0;
+                record.column_end = 0;
+                record.message = message;
+                record.text = message;
+                append_recorded_record(&summary, &record);
+            } else {
+                sprintf(numbers, "%d more errors of \"", left_out);
+                output_append_string(&summary, numbers);
+                output_append_string(&summary, report->messages[code]);
+                output_append_string(&summary, "\" were left out.\n");
+            }
+            write_to_sink(sink, summary.data, summary.length);
+            free_output_buffer(&summary);
+        }
+        report->repeats[code] = 0;
+    }
+}
+
+void end_diagnostic_report(DiagnosticReport *report) {
+    summarize_diagnostic_report();
+    use_diagnostic_report(report->outer_report);
+    capture_diagnostics(report->outer_sink);
+
+    /* Pass the diagnostics on whole, in a single write when they go to standard output */
+    if (report->outer_sink == NULL && report->records.length > 0) {
+        fflush(stdout);
+        write_output_bytes(STDOUT_FILENO, &report->records);
+    } else {
+        report_diagnostic_text(report->records.data, report->records.length);
+    }
+    free_output_buffer(&report->records);
+}
+
+void report_diagnostic_record(const DiagnosticRecord *record) {
+    OutputBuffer *sink;
+    DiagnosticReport *report;
+    DiagnosticLimit *limit;
+
+    pthread_once(&sink_key_once, create_sink_key);
+    sink = (OutputBuffer *) pthread_getspecific(sink_key);
+    report = (DiagnosticReport *) pthread_getspecific(report_key);
+    limit = (DiagnosticLimit *) pthread_getspecific(limit_key);
+
+    /* Count the errors past the repeat limit instead of writing them */
+    if (report != NULL && count_repeat(report, record) == FALSE) {
+        return;
+    }
+
+    /* Drop the record once the limit is reached */
+    if (limit != NULL) {
+        if (limit->count >= limit->maximum) {
+            return;
+        }
+        limit->count++;
+    }
+
+    if (report != NULL && report->format == JSON_DIAGNOSTICS) {
+        OutputBuffer line = {NULL, 0, 0};
+
+        append_json_record(&line, report->file_name, record);
+        write_to_sink(sink, line.data, line.length);
+        free_output_buffer(&line);
+    } else if (report != NULL && report->format == RECORDED_DIAGNOSTICS) {
+        OutputBuffer frame = {NULL, 0, 0};
+
+        /* A record that could not be written leaves the sink as short of memory as a failed append would */
+        append_recorded_record(&frame, record);
+        if (frame.is_out_of_memory && sink != NULL) {
+            pthread_mutex_lock(&sink_lock);
+            sink->is_out_of_memory = TRUE;
+            pthread_mutex_unlock(&sink_lock);
+        }
+        write_to_sink(sink, frame.data, frame.length);
+        free_output_buffer(&frame);
+    } else {
+        write_to_sink(sink, record->text, strlen(record->text));
+    }
+}
+
+void limit_diagnostics(DiagnosticLimit *limit) {
+    pthread_once(&sink_key_once, create_sink_key);
+    pthread_setspecific(limit_key, limit);
+}
+
+int is_diagnostic_limit_reached(void) {
+    DiagnosticLimit *limit;
+
+    pthread_once(&sink_key_once, create_sink_key);
+    limit = (DiagnosticLimit *) pthread_getspecific(limit_key);
+    return limit != NULL && limit->count >= limit->maximum;
+}
+
+void report_diagnostic(const char *format, ...) {
+    DiagnosticRecord record;
+    char text[MAX_DIAGNOSTIC];
+    char message[MAX_DIAGNOSTIC];
+    va_list arguments;
+    int length;
+
+    va_start(arguments, format);
+    length = vsnprintf(text, sizeof(text), format, arguments);
+    va_end(arguments);
+
+    /* Keep the part of a truncated message that fit */
+    if (length >= (int)sizeof(text)) {
+        length = (int)sizeof(text) - 1;
+    }
+    if (length <= 0) {
+        return;
+    }
+
+    /* The message of the record is the text without its newline */
+    strcpy(message, text);
+    if (message[length - 1] == '\n') {
+        message[length - 1] = '\0';
+    }
+    record.line_number = 0;
+    record.code = NO_DIAGNOSTIC_CODE;
+    record.column_start = 0;
+    record.column_end = 0;
+    record.message = message;
+    record.text = text;
+    report_diagnostic_record(&record);
+}
+
+void report_diagnostic_text(const char *text, size_t length) {
+    OutputBuffer *sink;
+
+    pthread_once(&sink_key_once, create_sink_key);
+    sink = (OutputBuffer *) pthread_getspecific(sink_key);
+
+    if (length == 0) {
+        return;
+    }
+    write_to_sink(sink, text, length);
+}
+
+int next_diagnostic_record(const OutputBuffer *records, size_t *position, DiagnosticRecord *record) {
+    char *header = records->data + *position;
+    char *fields, *end;
+    size_t length;
+
+    if (*position >= records->length) {
+        return FALSE;
+    }
+
+    /* The frame header gives the length of the payload, which ends with the null character of the message */
+    fields = strchr(header, '\n') + 1;
+    length = (size_t) strtoul(strchr(header, ' ') + 1, NULL, 10);
+    record->line_number = (int) strtol(fields, &end, 10);
+    record->code = (int) strtol(end, &end, 10);
+    record->column_start = (int) strtol(end, &end, 10);
+    record->column_end = (int) strtol(end, &end, 10);
+    record->message = end + 1;
+    record->text = record->message;
+    *position = (size_t)(fields - records->data) + length;
+    return TRUE;
+}
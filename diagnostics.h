@@ -0,0 +1,176 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "output_buffer.h"
+
+#define MAX_DIAGNOSTIC 4096 /* Maximum length of a single diagnostic message */
+#define MAX_DIAGNOSTIC_CODES 64 /* Maximum number of error codes a report counts the repeats of */
+#define NO_DIAGNOSTIC_CODE (-1) /* The code of a diagnostic that is not an error in a source line */
+
+/**
+ * Represents the form the diagnostics of a report are written in.
+ */
+typedef enum {
+    TEXT_DIAGNOSTICS, /* Lines of text, such as "Error in line N: message" */
+    JSON_DIAGNOSTICS, /* One JSON object per line, holding the file, line, code, column span and message */
+    RECORDED_DIAGNOSTICS /* One frame per record, holding its fields, to be read back by next_diagnostic_record */
+} DiagnosticFormat;
+
+/**
+ * Holds one diagnostic as it is reported, before it is written in the format of the report.
+ */
+typedef struct {
+    int line_number; /* The line the diagnostic is about, or 0 if it is not about a line */
+    int code; /* The ErrorCode of an error in a source line, or NO_DIAGNOSTIC_CODE */
+    int column_start; /* The byte offset in the line of the first character the diagnostic is about */
+    int column_end; /* The byte offset past the last one, equal to column_start if the span is not known */
+    const char *message; /* The message, without the line number and the newline */
+    const char *text; /* The diagnostic as a line of text, with its newline, as the text format writes it */
+} DiagnosticRecord;
+
+/**
+ * Collects the diagnostics of one source file in memory, written in the format of the report,
+ * until the report ends and they are passed on in one write.
+ * Past the repeat limit, the errors of a code are counted instead of written.
+ */
+typedef struct DiagnosticReport {
+    const char *file_name; /* The name of the file the diagnostics are about */
+    DiagnosticFormat format; /* The form the diagnostics are written in */
+    int repeat_limit; /* The number of errors of one code written before the rest are counted, 0 for no limit */
+    int repeats[MAX_DIAGNOSTIC_CODES]; /* The number of errors of every code reported */
+    const char *messages[MAX_DIAGNOSTIC_CODES]; /* The message of every code reported, for the counts */
+    OutputBuffer records; /* The diagnostics written so far */
+    OutputBuffer *outer_sink; /* The sink of the thread before the report began */
+    struct DiagnosticReport *outer_report; /* The report of the thread before the report began */
+} DiagnosticReport;
+
+/**
+ * Holds how many diagnostics a thread may still report before the rest are dropped.
+ */
+typedef struct {
+    int maximum; /* The number of diagnostics to report */
+    int count; /* The number of diagnostics reported so far */
+} DiagnosticLimit;
+
+/**
+ * Sets where the diagnostics reported by the calling thread are written.
+ * Each thread has its own sink, so concurrent assemblies keep their diagnostics apart.
+ *
+ * @param sink Pointer to the output buffer that collects the diagnostics, or NULL to print them to standard output
+ * @return void
+ */
+void capture_diagnostics(OutputBuffer *sink);
+
+/**
+ * Returns the sink of the calling thread, so the threads it starts for the same job can capture into it too.
+ *
+ * @return OutputBuffer* Pointer to the output buffer that collects the diagnostics, or NULL for standard output
+ */
+OutputBuffer *current_diagnostics_sink(void);
+
+/**
+ * Begins a report of the diagnostics of one source file on the calling thread.
+ * Until the report ends, the diagnostics of the thread are collected in it.
+ *
+ * @param report Pointer to the report to begin
+ * @param file_name The name of the file the diagnostics are about, kept until the report ends
+ * @param format The form the diagnostics are written in
+ * @param repeat_limit The number of errors of one code written before the rest are counted, 0 for no limit
+ * @return void
+ */
+void begin_diagnostic_report(DiagnosticReport *report, const char *file_name, DiagnosticFormat format,
+                             int repeat_limit);
+
+/**
+ * Returns the report of the calling thread, so the threads it starts for the same job can report into it too.
+ *
+ * @return DiagnosticReport* Pointer to the report, or NULL if no report was begun
+ */
+DiagnosticReport *current_diagnostic_report(void);
+
+/**
+ * Sets the report the calling thread reports into, for a thread started for the job of the report.
+ * Its sink must be set to the sink of the job as well.
+ *
+ * @param report Pointer to the report, or NULL for none
+ * @return void
+ */
+void use_diagnostic_report(DiagnosticReport *report);
+
+/**
+ * Reports, for every code whose errors passed the repeat limit of the report of the calling thread,
+ * how many errors of that code were left out, and starts counting them again.
+ *
+ * @return void
+ */
+void summarize_diagnostic_report(void);
+
+/**
+ * Ends a report: summarizes it, restores the sink and the report the thread had before it began,
+ * and passes the collected diagnostics on to that sink, or writes them to standard output in one write.
+ *
+ * @param report Pointer to the report
+ * @return void
+ */
+void end_diagnostic_report(DiagnosticReport *report);
+
+/**
+ * Reports a diagnostic record to the sink of the calling thread, in the format of its report,
+ * or as text if no report was begun. An error past the repeat limit of the report is only counted.
+ *
+ * @param record Pointer to the record
+ * @return void
+ */
+void report_diagnostic_record(const DiagnosticRecord *record);
+
+/**
+ * Sets the limit on the diagnostics the calling thread reports. Once the limit is reached,
+ * further diagnostics are dropped and is_diagnostic_limit_reached tells the checks to stop scanning.
+ *
+ * @param limit Pointer to the limit, its count starting at 0, or NULL to report every diagnostic
+ * @return void
+ */
+void limit_diagnostics(DiagnosticLimit *limit);
+
+/**
+ * Checks if the calling thread has reported as many diagnostics as its limit allows.
+ *
+ * @return int TRUE if the limit is reached, FALSE otherwise or if there is no limit
+ */
+int is_diagnostic_limit_reached(void);
+
+/**
+ * Reports a diagnostic message that is not about a source line, formatted like printf, to the sink
+ * of the calling thread, as report_diagnostic_record does.
+ * Messages longer than MAX_DIAGNOSTIC - 1 characters are truncated.
+ * Several threads may share a sink, each message is appended whole.
+ * The message is dropped if the limit of the calling thread is reached.
+ *
+ * @param format The printf format of the message
+ * @return void
+ */
+void report_diagnostic(const char *format, ...);
+
+/**
+ * Reports text that holds diagnostics already formatted, such as those captured from another sink,
+ * to the sink of the calling thread. The text is kept whole, however long it is,
+ * and it does not count towards the limit of the calling thread.
+ *
+ * @param text Pointer to the text
+ * @param length The length of the text
+ * @return void
+ */
+void report_diagnostic_text(const char *text, size_t length);
+
+/**
+ * Reads the next record of diagnostics written in the RECORDED_DIAGNOSTICS format.
+ * The message of the record points into the buffer, and its text is its message.
+ *
+ * @param records Pointer to the output buffer holding the diagnostics
+ * @param position Pointer to the position of the record in the buffer, advanced past it
+ * @param record Pointer to the record to fill
+ * @return int TRUE if a record was read, FALSE at the end of the buffer
+ */
+int next_diagnostic_record(const OutputBuffer *records, size_t *position, DiagnosticRecord *record);
+
+#endif
@@ -0,0 +1,189 @@
+#include <ctype.h>
+#include <string.h>
+#include "directive_encoder.h"
+
+/**
+ * Parses a single signed decimal integer and checks that it fits in a 24-bit word.
+ *
+ * @param params Pointer to the string that starts with the number
+ * @param value Pointer to store the parsed value in
+ * @param length Pointer to store the number of characters consumed
+ * @return ErrorCode - ERR_INVALID_PARA if there are no digits,
+ *                     ERR_DATA_OUT_OF_RANGE if the value does not fit in a 24-bit word,
+ *                     NO_ERROR otherwise.
+ */
+static ErrorCode parse_data_number(const char *params, long *value, int *length) {
+    int i = 0;
+    int negative = FALSE;
+    int out_of_range = FALSE;
+    long magnitude = 0;
+
+    /* Handle an optional sign */
+    if (params[i] == '+' || params[i] == '-') {
+        negative = (params[i] == '-');
+        i++;
+    }
+
+    /* A number needs at least one digit */
+    if (!isdigit(params[i])) {
+        return ERR_INVALID_PARA;
+    }
+
+    /* Accumulate the digits, stopping the accumulation once the value is surely out of range */
+    while (isdigit(params[i])) {
+        if (out_of_range == FALSE) {
+            magnitude = magnitude * 10 + (params[i] - '0');
+            if (magnitude > -MIN_DATA_VALUE) {
+                out_of_range = TRUE;
+            }
+        }
+        i++;
+    }
+
+    *length = i;
+
+    if (out_of_range == TRUE || (negative == FALSE && magnitude > MAX_DATA_VALUE)) {
+        return ERR_DATA_OUT_OF_RANGE;
+    }
+
+    *value = negative == TRUE ? -magnitude : magnitude;
+    return NO_ERROR;
+}
+
+ErrorCode encode_data_directive(char *params, DataImage *image) {
+    int i = 0;
+    int start_count = 0;
+    int last_number_flag = 0;
+
+    /* Skip spaces after the ".data" command */
+    while (isspace(params[i])) i++;
+
+    /* Check for missing parameter after the command */
+    if (params[i] == '\0') {
+        return ERR_MISSING_PARA;
+    }
+
+    /* Check for illegal comma immediately following the command */
+    if (params[i] == ',') {
+        return ERR_ILLEGAL_COMMA;
+    }
+
+    /* Every number takes at least a digit and a comma, so this is enough room for the whole list */
+    if (image != NULL) {
+        start_count = image->count;
+        if (reserve_data_image(image, (int)(strlen(params + i) + 1) / 2 + 1) == FALSE) {
+            return ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    /* Loop until the last number */
+    while (last_number_flag != 1) {
+        ErrorCode error_check;
+        long value = 0;
+        int length = 0;
+        int number_of_comma = 0;
+
+        /* Parse and range check the current number */
+        error_check = parse_data_number(params + i, &value, &length);
+        if (error_check != NO_ERROR) {
+            if (image != NULL) {
+                image->count = start_count;
+            }
+            return error_check;
+        }
+        i += length;
+
+        /* Check for illegal character after the number */
+        if (params[i] != ',' && !isspace(params[i]) && params[i] != '\0') {
+            if (image != NULL) {
+                image->count = start_count;
+            }
+            return ERR_INVALID_PARA;
+        }
+
+        /* Write the number to the data image as a 24-bit two's complement word */
+        if (image != NULL) {
+            image->words[image->count++] = (unsigned long)value & WORD_MASK;
+        }
+
+        /* Count commas until the next number */
+        while (params[i] == ',' || isspace(params[i])) {
+            if (params[i] == ',') {
+                number_of_comma++;
+            }
+            i++;
+        }
+
+        /* Check if it's the last number */
+        if (params[i] == '\0') {
+            last_number_flag = 1;
+        }
+
+        /* Check for consecutive, missing or trailing commas */
+        if ((last_number_flag == 0 && number_of_comma != 1) || (last_number_flag == 1 && number_of_comma != 0)) {
+            if (image != NULL) {
+                image->count = start_count;
+            }
+            if (number_of_comma > 1) {
+                return ERR_CONS_COMMAS;
+            }
+            if (number_of_comma == 0) {
+                return ERR_MISSING_COMMA;
+            }
+            return ERR_ILLEGAL_COMMA;
+        }
+    }
+    return NO_ERROR;
+}
+
+ErrorCode encode_string_directive(char *params, DataImage *image) {
+    char *start;
+    char *end;
+    int i = 0;
+
+    /* Skip spaces after the ".string" command */
+    while (isspace(params[i])) i++;
+
+    /* Check for missing parameter after the command */
+    if (params[i] == '\0') {
+        return ERR_MISSING_PARA;
+    }
+
+    /* Check for illegal comma immediately following the command */
+    if (params[i] == ',') {
+        return ERR_ILLEGAL_COMMA;
+    }
+
+    /* Check for opening quotation mark */
+    if (params[i] != '"') {
+        return ERR_MISSING_QUOTATION;
+    }
+    start = params + i + 1;
+
+    /* Look for the closing quotation mark, the last one in the line */
+    end = strrchr(start, '"');
+    if (end == NULL) {
+        return ERR_MISSING_QUOTATION;
+    }
+
+    /* Check for extraneous text after the closing quotation mark */
+    for (i = 1; end[i] != '\0'; i++) {
+        if (!isspace(end[i])) {
+            return ERR_EXTRANEOUS_TEXT;
+        }
+    }
+
+    /* Widen every character of the string into its own word, followed by the '\0' word */
+    if (image != NULL) {
+        int length = (int)(end - start);
+
+        if (reserve_data_image(image, length + 1) == FALSE) {
+            return ERR_OUT_OF_MEMORY;
+        }
+        for (i = 0; i < length; i++) {
+            image->words[image->count++] = (unsigned long)(long)start[i] & WORD_MASK;
+        }
+        image->words[image->count++] = 0;
+    }
+    return NO_ERROR;
+}
@@ -0,0 +1,46 @@
+#ifndef DIRECTIVE_ENCODER_H
+#define DIRECTIVE_ENCODER_H
+
+#include "first_second_pass_data.h"
+#include "error_handler.h"
+
+#define MIN_DATA_VALUE (-8388608L) /* Smallest value of a 24-bit two's complement word */
+#define MAX_DATA_VALUE 8388607L /* Largest value of a 24-bit two's complement word */
+
+/**
+ * Validates and encodes the parameters of a .data directive in a single scan.
+ * Every number is parsed, range checked and written as a packed 24-bit two's complement
+ * word straight into the data image. If an error is found, nothing is appended to the image.
+ *
+ * @param params Pointer to the string following the ".data" directive name
+ * @param image Pointer to the data image to append to, or NULL to only validate the parameters
+ * @return ErrorCode corresponding to the validation result:
+ *         - ERR_MISSING_PARA: If there are no numbers after the directive.
+ *         - ERR_ILLEGAL_COMMA: If a comma appears before the first number or after the last one.
+ *         - ERR_INVALID_PARA: If a parameter is not a valid integer.
+ *         - ERR_MISSING_COMMA: If two numbers are not separated by a comma.
+ *         - ERR_CONS_COMMAS: If there are multiple consecutive commas.
+ *         - ERR_DATA_OUT_OF_RANGE: If a number does not fit in a 24-bit word.
+ *         - ERR_OUT_OF_MEMORY: If the data image could not grow.
+ *         - NO_ERROR: If the parameters are valid.
+ */
+ErrorCode encode_data_directive(char *params, DataImage *image);
+
+/**
+ * Validates and encodes the parameter of a .string directive in a single scan.
+ * The characters between the quotation marks are widened into the data image one word per character,
+ * followed by a terminating zero word. If an error is found, nothing is appended to the image.
+ *
+ * @param params Pointer to the string following the ".string" directive name
+ * @param image Pointer to the data image to append to, or NULL to only validate the parameter
+ * @return ErrorCode corresponding to the validation result:
+ *         - ERR_MISSING_PARA: If there is no string after the directive.
+ *         - ERR_ILLEGAL_COMMA: If a comma follows the directive name.
+ *         - ERR_MISSING_QUOTATION: If the opening or closing quotation mark is missing.
+ *         - ERR_EXTRANEOUS_TEXT: If there is extra text after the closing quotation mark.
+ *         - ERR_OUT_OF_MEMORY: If the data image could not grow.
+ *         - NO_ERROR: If the parameter is valid.
+ */
+ErrorCode encode_string_directive(char *params, DataImage *image);
+
+#endif
@@ -8,6 +8,7 @@
 #include "first_second_pass.h"
 
 #define MAX_SYMBOL_NAME 31 /* Maximum symbol name length */
+#define MAX_LINE_ERRORS 2 /* Maximum number of errors reported for one line in the first pass checks */
 
 /**
  * Enum representing various error codes.
@@ -32,6 +33,14 @@ typedef enum {
     ERR_INVALID_SYMBOL_CHAR,
     ERR_INVALID_SYMBOL_START,
     ERR_EMPTY_LABEL_LINE,
+    ERR_DATA_OUT_OF_RANGE,
+    ERR_MACRO_NAME_TOO_LONG,
+    ERR_INVALID_MACRO_NAME_CHAR,
+    ERR_MACRO_COMMAND_NAME,
+    ERR_MACRO_DIRECTIVE_NAME,
+    ERR_MACRO_RESERVED_NAME,
+    ERR_MACRO_EXTRA_TEXT,
+    ERR_OUT_OF_MEMORY,
     NO_ERROR
 } ErrorCode;
 
@@ -41,7 +50,7 @@ typedef enum {
  * structure, operands, addressing modes, label definitions, and directive formatting
  * to ensure they conform to the assembly language specifications.
  *
- * @param line A pointer to the line string to be checked
+ * @param line A pointer to the line string to be checked, at most MAX_LINE - 1 characters long
  * @param head_of_macro_table Pointer to the head of the macro table
  * @return ErrorCode corresponding to the validation result:
  *         - ERR_UNDEFINED_COMMAND: If the command is not defined.
@@ -63,6 +72,7 @@ typedef enum {
  *         - ERR_INVALID_SYMBOL_CHAR: If a symbol name contains an invalid character.
  *         - ERR_INVALID_SYMBOL_START: If symbol name not start with a letter.
  *         - ERR_EMPTY_LABEL_LINE: If after a label name there is an empty line.
+ *         - ERR_DATA_OUT_OF_RANGE: If a .data value does not fit in a 24-bit word.
  *         - NO_ERROR: If no errors were found and the line is valid.
  */
 ErrorCode check_line_errors_first_pass(char *line);
@@ -70,12 +80,38 @@ ErrorCode check_line_errors_first_pass(char *line);
 /**
  * Checks if a symbol name in a given line is already a macro name in the macro table.
  *
- * @param line Pointer to the string representing the line to check
+ * @param line Pointer to the string representing the line to check, at most MAX_LINE - 1 characters long
  * @param head_of_macro_table A pointer to the head of the macro linked list
  * @return ErrorCode - ERR_LABEL_MACRO if the label is a macro name, otherwise NO_ERROR
  */
 ErrorCode is_label_macro(char *line, MacroNode *head_of_macro_table);
 
+/**
+ * Finds the first pass errors of one line: a line that is too long, a label that is a macro name,
+ * or else the error already found in the line itself by check_line_errors_first_pass.
+ * A line that is too long is reported twice, as it always was.
+ *
+ * @param line The line to check
+ * @param head_of_macro_table Pointer to the head of the macro table
+ * @param line_error The result of check_line_errors_first_pass for the line
+ * @param errors The array to fill with the errors, in the order they are printed
+ * @return int The number of errors stored in errors, 0 if the line has none
+ */
+int find_first_pass_line_errors(char *line, MacroNode *head_of_macro_table, ErrorCode line_error,
+                                ErrorCode errors[MAX_LINE_ERRORS]);
+
+/**
+ * Prints the first pass errors of one line: a line that is too long, a label that is a macro name,
+ * or else the error already found in the line itself by check_line_errors_first_pass.
+ *
+ * @param line The line to check
+ * @param line_number The number of the line, for the error messages
+ * @param head_of_macro_table Pointer to the head of the macro table
+ * @param line_error The result of check_line_errors_first_pass for the line
+ * @return int ERROR_FOUND if an error was printed, ERROR_WAS_NOT_FOUND otherwise
+ */
+int report_first_pass_line_errors(char *line, int line_number, MacroNode *head_of_macro_table, ErrorCode line_error);
+
 /**
  * Checks if a given operand is a register name (r0 to r7).
  *
@@ -93,7 +129,49 @@ int is_register(char* operand);
 int is_directive(char *command);
 
 /**
- * Prints an error message based on the given ErrorCode.
+ * Returns the message of an error, as report_error reports it after the line number.
+ *
+ * @param code The error code
+ * @return const char* The message, or NULL for NO_ERROR and ERR_OUT_OF_MEMORY, which have none
+ */
+const char *error_message(ErrorCode code);
+
+/**
+ * Finds the span of the statement of a line: from its first character that is not a space
+ * to the end of its last word, as byte offsets.
+ *
+ * @param line The line
+ * @param column_start Pointer to set to the offset of the first character of the statement
+ * @param column_end Pointer to set to the offset past its last character, equal to column_start for a blank line
+ * @return void
+ */
+void find_statement_span(const char *line, int *column_start, int *column_end);
+
+/**
+ * Reports an error in a source line as a diagnostic record, with its code and column span,
+ * which the diagnostics write as "Error in line N: message" or as a line of JSON.
+ *
+ * @param code The error code
+ * @param num_of_line The number of the line
+ * @param column_start The byte offset in the line of the first character the error is about
+ * @param column_end The byte offset past the last one, equal to column_start if the span is not known
+ * @return void
+ */
+void report_error(ErrorCode code, int num_of_line, int column_start, int column_end);
+
+/**
+ * Reports an error in a source line, spanning the statement of the line.
+ *
+ * @param code The error code
+ * @param num_of_line The number of the line
+ * @param line The line
+ * @return void
+ */
+void report_line_error(ErrorCode code, int num_of_line, const char *line);
+
+/**
+ * Prints an error message based on the given ErrorCode, for a line whose text is no longer at hand,
+ * so the error has no column span.
  * Each error code represents a specific type of error.
  *
  * @param code The error code of type `ErrorCode` that specifies the error to be printed.
@@ -107,7 +185,7 @@ void print_error(ErrorCode code, int num_of_line);
  *    also validate that the format of the line is correct.
  * 2. Operand symbols - confirms all labels used as operands exist in the symbol table
  *
- * @param line A string representing the line to be checked
+ * @param line A string representing the line to be checked, at most MAX_LINE - 1 characters long
  * @param head_of_symbol_table Pointer to the head of the symbol table
  * @return ErrorCode corresponding to the validation result:
  *         - ERR_ILLEGAL_COMMA: If a comma appears in an illegal position.
@@ -117,4 +195,14 @@ void print_error(ErrorCode code, int num_of_line);
  */
 ErrorCode check_line_errors_second_pass(char *line, SymbolNode *head_of_symbol_table);
 
+/**
+ * Finds the symbols a line uses that must exist in the symbol table for the second pass checks:
+ * the symbol of an .entry directive, and the operands that use direct or relative addressing.
+ *
+ * @param line A string representing the line, at most MAX_LINE - 1 characters long
+ * @param symbols Array that receives the symbol names, in the order they appear in the line
+ * @return int The number of symbols found
+ */
+int find_second_pass_symbols(char *line, char symbols[MAX_OPERANDS][MAX_LINE]);
+
 #endif
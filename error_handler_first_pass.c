@@ -3,69 +3,134 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "error_handler.h"
+#include "diagnostics.h"
+#include "directive_encoder.h"
 
-void print_error(ErrorCode code, int num_of_line) {
+const char *error_message(ErrorCode code) {
     switch (code) {
         case ERR_UNDEFINED_COMMAND:
-            printf("Error in line %d: Undefined command name.\n", num_of_line);
-            break;
+            return "Undefined command name.";
         case ERR_INVALID_PARA:
-            printf("Error in line %d: Invalid parameter.\n", num_of_line);
-            break;
+            return "Invalid parameter.";
         case ERR_INVALID_REG:
-            printf("Error in Line %d: Invalid register.\n", num_of_line);
-            break;
+            return "Invalid register.";
         case ERR_MISSING_PARA:
-            printf("Error in Line %d: Missing parameter.\n", num_of_line);
-            break;
+            return "Missing parameter.";
         case ERR_MISSING_COMMA:
-            printf("Error in Line %d: Missing comma.\n", num_of_line);
-            break;
+            return "Missing comma.";
         case ERR_CONS_COMMAS:
-            printf("Error in Line %d: Multiple consecutive commas.\n", num_of_line);
-            break;
+            return "Multiple consecutive commas.";
         case ERR_ILLEGAL_COMMA:
-            printf("Error in Line %d: Illegal comma.\n", num_of_line);
-            break;
+            return "Illegal comma.";
         case ERR_EXTRANEOUS_TEXT:
-            printf("Error in Line %d: Extraneous text after end of command.\n", num_of_line);
-            break;
+            return "Extraneous text after end of command.";
         case ERR_SRC_ADDRESSING:
-            printf("Error in Line %d: Illegal addressing mode for source operand.\n",num_of_line);
-            break;
+            return "Illegal addressing mode for source operand.";
         case ERR_DEST_ADDRESSING:
-            printf("Error in Line %d: Illegal addressing mode for destination operand.\n",num_of_line);
-            break;
+            return "Illegal addressing mode for destination operand.";
         case ERR_INVALID_LABEL_NAME:
-            printf("Error in Line %d: A label name cannot be a reserved assembly keyword.\n", num_of_line);
-            break;
+            return "A label name cannot be a reserved assembly keyword.";
         case ERR_LABEL_MACRO:
-            printf("Error in Line %d: A label name cannot be the same as a macro name.\n", num_of_line);
-            break;
+            return "A label name cannot be the same as a macro name.";
         case ERR_MISSING_QUOTATION:
-            printf("Error in Line %d: Missing quotation mark.\n", num_of_line);
-            break;
+            return "Missing quotation mark.";
         case ERR_SYMBOL_NOT_FOUND:
-            printf("Error in Line %d: Used symbol not found.\n", num_of_line);
-            break;
+            return "Used symbol not found.";
         case ERR_LINE_TOO_LONG:
-            printf("Error in Line %d: The length of a line is limited to 80 characters.\n", num_of_line);
-            break;
+            return "The length of a line is limited to 80 characters.";
         case ERR_SYMBOL_TOO_LONG:
-            printf("Error in Line %d: The length of a label name is limited to 31 characters.\n", num_of_line);
-            break;
+            return "The length of a label name is limited to 31 characters.";
         case ERR_INVALID_SYMBOL_CHAR:
-            printf("Error in Line %d: Symbol contains an invalid character. Only letters and digits are allowed.\n", num_of_line);
-            break;
+            return "Symbol contains an invalid character. Only letters and digits are allowed.";
         case ERR_INVALID_SYMBOL_START:
-            printf("Error in Line %d: Symbol's name must start with a letter.\n", num_of_line);
-            break;
+            return "Symbol's name must start with a letter.";
         case ERR_EMPTY_LABEL_LINE:
-            printf("Error in Line %d: No command or directive detected after the label name.\n", num_of_line);
+            return "No command or directive detected after the label name.";
+        case ERR_DATA_OUT_OF_RANGE:
+            return "Data value is out of range for a 24-bit word.";
+        case ERR_MACRO_NAME_TOO_LONG:
+            return "A macro name cannot be longer than 31 characters.";
+        case ERR_INVALID_MACRO_NAME_CHAR:
+            return "A macro name can only contain letters, digits, and underscores.";
+        case ERR_MACRO_COMMAND_NAME:
+            return "A macro name cannot be the same as a command name.";
+        case ERR_MACRO_DIRECTIVE_NAME:
+            return "A macro name cannot be the same as a directive name.";
+        case ERR_MACRO_RESERVED_NAME:
+            return "A macro name cannot be a reserved assembly keyword.";
+        case ERR_MACRO_EXTRA_TEXT:
+            return "The macro definition and termination lines must not contain extra characters.";
+        case ERR_OUT_OF_MEMORY:
+            /* Already reported where the allocation failed */
             break;
         case NO_ERROR:
             break;
     }
+    return NULL;
+}
+
+/**
+ * Checks if the message of an error has always spelled "line" in lower case after "Error in".
+ *
+ * @param code The error code
+ * @return int TRUE if "line" is in lower case, FALSE if it is capitalized
+ */
+static int is_line_in_lower_case(ErrorCode code) {
+    switch (code) {
+        case ERR_UNDEFINED_COMMAND:
+        case ERR_INVALID_PARA:
+        case ERR_MACRO_NAME_TOO_LONG:
+        case ERR_INVALID_MACRO_NAME_CHAR:
+        case ERR_MACRO_COMMAND_NAME:
+        case ERR_MACRO_DIRECTIVE_NAME:
+        case ERR_MACRO_EXTRA_TEXT:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+void find_statement_span(const char *line, int *column_start, int *column_end) {
+    int start = 0, end;
+
+    while (line[start] != '\0' && isspace((unsigned char) line[start])) {
+        start++;
+    }
+    end = start + (int) strlen(line + start);
+    while (end > start && isspace((unsigned char) line[end - 1])) {
+        end--;
+    }
+    *column_start = start;
+    *column_end = end;
+}
+
+void report_error(ErrorCode code, int num_of_line, int column_start, int column_end) {
+    DiagnosticRecord record;
+    char text[MAX_DIAGNOSTIC];
+    const char *message = error_message(code);
+
+    if (message == NULL) {
+        return;
+    }
+    sprintf(text, "Error in %s %d: %s\n", is_line_in_lower_case(code) ? "line" : "Line", num_of_line, message);
+    record.line_number = num_of_line;
+    record.code = (int) code;
+    record.column_start = column_start;
+    record.column_end = column_end;
+    record.message = message;
+    record.text = text;
+    report_diagnostic_record(&record);
+}
+
+void report_line_error(ErrorCode code, int num_of_line, const char *line) {
+    int column_start, column_end;
+
+    find_statement_span(line, &column_start, &column_end);
+    report_error(code, num_of_line, column_start, column_end);
+}
+
+void print_error(ErrorCode code, int num_of_line) {
+    report_error(code, num_of_line, 0, 0);
 }
 
 /**
@@ -208,18 +273,11 @@ static ErrorCode search_label_macro (char *symbol,MacroNode *head_of_macro_table
 }
 
 ErrorCode is_label_macro(char *line, MacroNode *head_of_macro_table) {
-    char *input = malloc(strlen(line) + 1);
-    char *original_input;
+    char input_buffer[MAX_LINE] = {0};
+    char *input = input_buffer;
     int i = 0, j = 0;
     ErrorCode error_check = NO_ERROR;
 
-    if(check_memory_allocation(input) == FALSE) {
-        exit(1);
-    }
-
-    /* Stores the original address of input and command to ensure proper memory deallocation */
-    original_input = input;
-
     strcpy(input, line);
 
     /* Skip leading spaces in input */
@@ -240,28 +298,18 @@ ErrorCode is_label_macro(char *line, MacroNode *head_of_macro_table) {
         /* Check if the symbol name is already a macro name */
         error_check = search_label_macro(symbol_name, head_of_macro_table);
 
-        free(original_input);
         return error_check;
     }
-    free(original_input);
     return error_check;
 }
 
 ErrorCode check_line_errors_first_pass(char *line) {
-    char *input = malloc(strlen(line) + 1);
-    char *command = malloc(strlen(line) + 1);
-    char *original_input;
-    char *original_command;
+    char input_buffer[MAX_LINE] = {0};
+    char *input = input_buffer;
+    char command_buffer[MAX_LINE] = {0};
+    char *command = command_buffer;
     int i=0, j=0;
 
-    if(check_memory_allocation(input) == FALSE || check_memory_allocation(command) == FALSE) {
-        exit(1);
-    }
-
-    /* Stores the original address of input and command to ensure proper memory deallocation */
-    original_input = input;
-    original_command = command;
-
     strcpy(input, line);
 
     /* Skip leading spaces in input */
@@ -286,8 +334,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
         /* Check if the symbol name is valid */
         error_check = check_symbol_name(symbol_name);
         if(error_check != NO_ERROR) {
-            free(original_input);
-            free(original_command);
             return error_check;
 
         }
@@ -299,8 +345,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
         /* Check if the input ends right after the symbol_name */
         if (input[0] == '\0') {
-            free(original_input);
-            free(original_command);
             return ERR_EMPTY_LABEL_LINE;
         }
 
@@ -313,8 +357,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
     /* Check if input starts with a comma (illegal input) */
     if (input[i] == ',') {
-        free(original_input);
-        free(original_command);
         return ERR_ILLEGAL_COMMA;
     }
 
@@ -330,165 +372,16 @@ ErrorCode check_line_errors_first_pass(char *line) {
     /* If it is a directive */
     if(is_directive(command) == TRUE) {
 
-        /* Handle string directive */
+        /* Handle string directive, validated by the same scan that encodes it */
         if(strcmp(command, ".string") == 0) {
-            int last_quote_index;
-
-            /* Skip spaces after the ".string" command */
-            while (isspace(input[i])) i++;
-
-            /* Check for missing parameter after the command */
-            if (input[i] == '\0') {
-                free(original_input);
-                free(original_command);
-                return ERR_MISSING_PARA;
-            }
-
-            /* Check for illegal comma immediately following the command */
-            if (input[i] == ',') {
-                free(original_input);
-                free(original_command);
-                return ERR_ILLEGAL_COMMA;
-            }
-            input = input + i;
-            i=0;
-
-            /* Check for opening quotation mark */
-            if (input[i] != '"') {
-                free(original_input);
-                free(original_command);
-                return ERR_MISSING_QUOTATION;
-            }
-
-            i++;
-            input = input + i;
-            i = 0;
-
-
-            /* Look for the closing quotation mark */
-            last_quote_index = -1;
-            while (input[i] != '\0') {
-                if (input[i] == '"') {
-
-                    /* Update the position of the last found quote */
-                    last_quote_index = i;
-                }
-                i++;
-            }
-
-            /* If no closing quote was found, return an error */
-            if (last_quote_index == -1) {
-                free(original_input);
-                free(original_command);
-                return ERR_MISSING_QUOTATION;
-            }
-
-
-            input = input + last_quote_index + 1;
-            i = 0;
-
-            /* Check for extraneous text after parameters the directive */
-            while (input[i] != '\0') {
-                if (!isspace(input[i])) {
-                    free(original_input);
-                    free(original_command);
-                    return ERR_EXTRANEOUS_TEXT;
-                }
-                i++;
-            }
-
-            free(original_input);
-            free(original_command);
-            return NO_ERROR;
+            ErrorCode error_check = encode_string_directive(input, NULL);
+            return error_check;
         }
 
-        /* Handle data directive */
+        /* Handle data directive, validated by the same scan that encodes it */
         if(strcmp(command, ".data") == 0) {
-            int number_of_comma = 0;
-            int temp_i;
-            int last_number_flag = 0;
-
-            /* Skip spaces after the ".data" command */
-            while (isspace(input[i])) i++;
-
-            /* Check for missing parameter after the command */
-            if (input[i] == '\0') {
-                free(original_input);
-                free(original_command);
-                return ERR_MISSING_PARA;
-            }
-
-            /* Check for illegal comma immediately following the command */
-            if (input[i] == ',') {
-                free(original_input);
-                free(original_command);
-                return ERR_ILLEGAL_COMMA;
-            }
-            input = input + i;
-            i=0;
-
-            /* Loop until the last number */
-            while (last_number_flag != 1) {
-
-                if (input[i] == '+' || input[i] == '-') {
-                    i++;
-                }
-
-                while (isdigit(input[i])) {
-                    i++;
-                }
-
-                /* Check if it's the last number */
-                temp_i = i;
-                while (isspace(input[temp_i])) temp_i++;
-                if (input[temp_i] == '\0') {
-                    last_number_flag = 1;
-                }
-
-                /* Check for illegal character after the number */
-                if((input[i] != ',') && (input[i] !=  ' ') && input[i] != '\0' && input[i] != '\n') {
-                    free(original_input);
-                    free(original_command);
-                    return ERR_INVALID_PARA;
-                }
-
-                /* If it's not the last number */
-                if(last_number_flag == 0) {
-                    while (isspace(input[i])) i++;
-                    input = input + i;
-                    i = 0;
-
-                    /* Count commas until the first alphanumeric characters */
-                    while (input[i] != '\0' && (input[i] == ' ' || input[i] == ',' || input[i] == '\t')) i++;
-
-                    for (j = 0; j < i; j++) {
-                        if (input[j] == ',') {
-                            number_of_comma++;
-                        }
-                    }
-
-                    /* Check for consecutive or missing commas */
-                    if (number_of_comma > 1 || number_of_comma == 0) {
-                        if (number_of_comma > 1) {
-                            free(original_input);
-                            free(original_command);
-                            return ERR_CONS_COMMAS;
-                        }
-                        if (number_of_comma == 0) {
-                            free(original_input);
-                            free(original_command);
-                            return ERR_MISSING_COMMA;
-                        }
-                    }
-                    number_of_comma = 0;
-
-                    input = input + i;
-                    i = 0;
-                }
-            }
-            free(original_input);
-            free(original_command);
-            return NO_ERROR;
+            ErrorCode error_check = encode_data_directive(input, NULL);
+            return error_check;
         }
 
         /* Handle extern directive */
@@ -501,15 +394,11 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
             /* Check for missing parameter after the command */
             if (input[i] == '\0') {
-                free(original_input);
-                free(original_command);
                 return ERR_MISSING_PARA;
             }
 
             /* Check for illegal comma immediately following the command */
             if (input[i] == ',') {
-                free(original_input);
-                free(original_command);
                 return ERR_ILLEGAL_COMMA;
             }
             input = input + i;
@@ -523,15 +412,11 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
             /* Check if the symbol is a command, register, or directive */
             if(is_command(symbol_name) == TRUE || is_register(symbol_name) == TRUE || is_directive(symbol_name) == TRUE) {
-                free(original_input);
-                free(original_command);
                 return ERR_INVALID_LABEL_NAME;
             }
 
             /* Check if the symbol is a valid symbol */
             if (get_operand_addressing_mode(symbol_name) == INVALID_ADDRESSING) {
-                free(original_input);
-                free(original_command);
                 return ERR_INVALID_SYMBOL_CHAR;
             }
 
@@ -541,19 +426,13 @@ ErrorCode check_line_errors_first_pass(char *line) {
             /* Check for extraneous text after directive */
             while (input[i] != '\0') {
                 if (!isspace(input[i])) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_EXTRANEOUS_TEXT;
                 }
                 i++;
             }
-            free(original_input);
-            free(original_command);
             return NO_ERROR;
         }
 
-        free(original_input);
-        free(original_command);
         return NO_ERROR;
     }
 
@@ -566,8 +445,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
         /* Check if the command is defined */
         if (is_command(command) == FALSE) {
-            free(original_input);
-            free(original_command);
             return ERR_UNDEFINED_COMMAND;
         }
 
@@ -579,8 +456,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
             /* Check for illegal comma immediately following the command */
             if (input[i] == ',') {
-                free(original_input);
-                free(original_command);
                 return ERR_ILLEGAL_COMMA;
             }
             input = input + i;
@@ -588,8 +463,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
             /* Check for missing parameter after the command */
             if (input[i] == '\0') {
-                free(original_input);
-                free(original_command);
                 return ERR_MISSING_PARA;
             }
 
@@ -606,40 +479,28 @@ ErrorCode check_line_errors_first_pass(char *line) {
                 /* Check if the first operand has a relative addressing mode,
                  * which is not allowed for the current commands */
                 if (get_operand_addressing_mode(first_operand) == RELATIVE_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_SRC_ADDRESSING;
                 }
                 if (get_operand_addressing_mode(first_operand) == INVALID_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_INVALID_PARA;
                 }
 
             } else if (strcmp(command, "lea") == 0) {
 
                 if (get_operand_addressing_mode(first_operand) == INVALID_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_INVALID_PARA;
                 }
                 /* Check if the first operand is not using direct addressing mode, which is required for "lea" */
                 if (get_operand_addressing_mode(first_operand) != DIRECT_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_SRC_ADDRESSING;
                 }
             }
 
             /* Check if the first operand is valid */
             if (check_operand(first_operand) == ERR_INVALID_PARA) {
-                free(original_input);
-                free(original_command);
                 return ERR_INVALID_PARA; /* Return error for invalid parameter */
             }
             if (check_operand(first_operand) == ERR_INVALID_REG) {
-                free(original_input);
-                free(original_command);
                 return ERR_INVALID_REG; /* Return error for invalid register */
             }
 
@@ -658,14 +519,10 @@ ErrorCode check_line_errors_first_pass(char *line) {
             /* Check for consecutive or missing commas */
             if (number_of_comma > 1 || number_of_comma == 0) {
                 if (number_of_comma > 1) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_CONS_COMMAS;
 
                 }
                 if (number_of_comma == 0) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_MISSING_COMMA;
                 }
             }
@@ -679,8 +536,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
             /* Check if the second operand is missing */
             if (input[i] == '\0') {
-                free(original_input);
-                free(original_command);
                 return ERR_MISSING_PARA;
             }
 
@@ -697,13 +552,9 @@ ErrorCode check_line_errors_first_pass(char *line) {
                 /* Check if the second operand uses relative or immediate addressing mode,
                  * which is not allowed for destination operands for the current commands*/
                 if (get_operand_addressing_mode(second_operand) == RELATIVE_ADDRESSING || get_operand_addressing_mode(second_operand) == IMMEDIATE_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_DEST_ADDRESSING;
                 }
                 if (get_operand_addressing_mode(second_operand) == INVALID_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_INVALID_PARA;
                 }
             } else if (strcmp(command, "cmp") == 0) {
@@ -711,26 +562,18 @@ ErrorCode check_line_errors_first_pass(char *line) {
                 /* Check if the second operand uses relative addressing,
                  * which is not allowed for destination operand in "cmp" */
                 if (get_operand_addressing_mode(second_operand) == RELATIVE_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_DEST_ADDRESSING;
                 }
                 if (get_operand_addressing_mode(second_operand) == INVALID_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_INVALID_PARA;
                 }
             }
 
             /* Check if the second operand is valid */
             if (check_operand(second_operand) == ERR_INVALID_PARA) {
-                free(original_input);
-                free(original_command);
                 return ERR_INVALID_PARA; /* Return error for invalid parameter */
             }
             if (check_operand(second_operand) == ERR_INVALID_REG) {
-                free(original_input);
-                free(original_command);
                 return ERR_INVALID_REG; /* Return error for invalid register */
             }
 
@@ -740,8 +583,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
             /* Check for extraneous text after the operands */
             while (input[i] != '\0') {
                 if (!isspace(input[i])) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_EXTRANEOUS_TEXT;
                 }
                 i++;
@@ -756,8 +597,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
             /* Check for illegal comma immediately following the command */
             if (input[i] == ',') {
-                free(original_input);
-                free(original_command);
                 return ERR_ILLEGAL_COMMA;
             }
 
@@ -767,8 +606,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
 
             /* Check if the operand is missing */
             if (input[i] == '\0') {
-                free(original_input);
-                free(original_command);
                 return ERR_MISSING_PARA;
             }
 
@@ -785,13 +622,9 @@ ErrorCode check_line_errors_first_pass(char *line) {
                 /* Check if the operand uses relative or immediate addressing mode,
                  * which is not allowed for destination operands for the current commands*/
                 if(get_operand_addressing_mode(first_operand) == IMMEDIATE_ADDRESSING || get_operand_addressing_mode(first_operand) == RELATIVE_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_DEST_ADDRESSING;
                 }
                 if (get_operand_addressing_mode(first_operand) == INVALID_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_INVALID_PARA;
                 }
             }
@@ -800,13 +633,9 @@ ErrorCode check_line_errors_first_pass(char *line) {
                 /* Check if the operand uses register-direct addressing or immediate addressing mode,
                  * which is not allowed for destination operands for the current commands*/
                 if(get_operand_addressing_mode(first_operand) == IMMEDIATE_ADDRESSING || get_operand_addressing_mode(first_operand) == REGISTER_DIRECT_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_DEST_ADDRESSING;
                 }
                 if (get_operand_addressing_mode(first_operand) == INVALID_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_INVALID_PARA;
                 }
             }
@@ -816,25 +645,17 @@ ErrorCode check_line_errors_first_pass(char *line) {
                 /* Check if the operand uses relative addressing,
                  * which is not allowed for destination operand in "prn" */
                 if(get_operand_addressing_mode(first_operand) == RELATIVE_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_DEST_ADDRESSING;
                 }
                 if (get_operand_addressing_mode(first_operand) == INVALID_ADDRESSING) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_INVALID_PARA;
                 }
             }
             /* Check if the operand is valid */
             if(check_operand(first_operand) == ERR_INVALID_PARA) {
-                free(original_input);
-                free(original_command);
                 return ERR_INVALID_PARA; /* Return error for invalid parameter */
             }
             if(check_operand(first_operand) == ERR_INVALID_REG) {
-                free(original_input);
-                free(original_command);
                 return ERR_INVALID_REG; /* Return error for invalid register */
             }
 
@@ -844,8 +665,6 @@ ErrorCode check_line_errors_first_pass(char *line) {
             /* Check for extraneous text after operand */
             while (input[i] != '\0') {
                 if (!isspace(input[i])) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_EXTRANEOUS_TEXT;
                 }
                 i++;
@@ -857,15 +676,50 @@ ErrorCode check_line_errors_first_pass(char *line) {
             /* Check for extraneous text after the command */
             while (input[i] != '\0') {
                 if (!isspace(input[i])) {
-                    free(original_input);
-                    free(original_command);
                     return ERR_EXTRANEOUS_TEXT;
                 }
                 i++;
             }
         }
-        free(original_input);
-        free(original_command);
         return NO_ERROR;
     }
 }
+
+int find_first_pass_line_errors(char *line, MacroNode *head_of_macro_table, ErrorCode line_error,
+                                ErrorCode errors[MAX_LINE_ERRORS]) {
+    ErrorCode error_check = NO_ERROR;
+    int number_of_errors = 0;
+
+    if (strlen(line) > MAX_LINE - 1) {
+        error_check = ERR_LINE_TOO_LONG;
+        errors[number_of_errors++] = error_check;
+    }
+
+    /* If a macro table exists, check if the line contains a macro label */
+    else if (head_of_macro_table != NULL) {
+        error_check = is_label_macro(line, head_of_macro_table);
+    }
+
+    /* If an error is found, report it */
+    if (error_check != NO_ERROR) {
+        errors[number_of_errors++] = error_check;
+    }
+
+    /* Otherwise report the error found in the line itself */
+    else if (line_error != NO_ERROR) {
+        errors[number_of_errors++] = line_error;
+    }
+    return number_of_errors;
+}
+
+int report_first_pass_line_errors(char *line, int line_number, MacroNode *head_of_macro_table, ErrorCode line_error) {
+    ErrorCode errors[MAX_LINE_ERRORS];
+    int number_of_errors = find_first_pass_line_errors(line, head_of_macro_table, line_error, errors);
+    int i;
+
+    /* Print the errors in the order they were found */
+    for (i = 0; i < number_of_errors; i++) {
+        report_line_error(errors[i], line_number, line);
+    }
+    return number_of_errors > 0 ? ERROR_FOUND : ERROR_WAS_NOT_FOUND;
+}
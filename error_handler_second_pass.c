@@ -28,21 +28,14 @@ static int is_label_in_table(char *symbol_name, SymbolNode *head_of_symbol_table
     return FALSE;
 }
 
-ErrorCode check_line_errors_second_pass(char *line, SymbolNode *head_of_symbol_table) {
-    char *input = malloc(strlen(line) + 1);
-    char *command = malloc(strlen(line) + 1);
-    char *original_input;
-    char *original_command;
+int find_second_pass_symbols(char *line, char symbols[MAX_OPERANDS][MAX_LINE]) {
+    char input_buffer[MAX_LINE] = {0};
+    char *input = input_buffer;
+    char command_buffer[MAX_LINE] = {0};
+    char *command = command_buffer;
+    int count = 0;
     int i = 0, j = 0;
 
-    if(check_memory_allocation(input) == FALSE || check_memory_allocation(command) == FALSE) {
-        exit(1);
-    }
-
-    /* Stores the original address of input and command to ensure proper memory deallocation */
-    original_input = input;
-    original_command = command;
-
     strcpy(input, line);
 
     /* Skip leading spaces in input */
@@ -73,10 +66,8 @@ ErrorCode check_line_errors_second_pass(char *line, SymbolNode *head_of_symbol_t
 
     /* Check if the command is a directive */
     if(is_directive(command) == TRUE) {
-        /* Handle entry directive (only checks if the symbol exists, syntax was verified in first pass) */
+        /* Handle entry directive (only the symbol is needed, syntax was verified in first pass) */
         if(strcmp(command, ".entry") == 0) {
-            char symbol_name[MAX_LINE] = {0};
-            int j=0;
 
             /* Skip spaces after the ".entry" command */
             while (isspace(input[i])) i++;
@@ -85,20 +76,9 @@ ErrorCode check_line_errors_second_pass(char *line, SymbolNode *head_of_symbol_t
 
             /* Extract the symbol name from input */
             while (!isspace(input[i]) && input[i] != ',' && input[i] != '\0') {
-                symbol_name[j++] = input[i++];
+                symbols[count][j++] = input[i++];
             }
-            symbol_name[j] = '\0';
-
-            /* Check if the symbol exists in the symbol table */
-            if(is_label_in_table(symbol_name, head_of_symbol_table) == FALSE) {
-                free(original_input);
-                free(original_command);
-                return ERR_SYMBOL_NOT_FOUND;
-            }
-
-            free(original_input);
-            free(original_command);
-            return NO_ERROR;
+            symbols[count++][j] = '\0';
         }
 
     } else { /* is a command line */
@@ -120,24 +100,13 @@ ErrorCode check_line_errors_second_pass(char *line, SymbolNode *head_of_symbol_t
             input = input + i;
             i = 0;
 
-            /* Check if the first operand uses direct addressing */
+            /* A first operand that uses direct addressing names a symbol */
             if (get_operand_addressing_mode(first_operand) == DIRECT_ADDRESSING) {
-                /* Check if the symbol exists in the symbol table */
-                if(is_label_in_table(first_operand, head_of_symbol_table) == FALSE) {
-                    free(original_input);
-                    free(original_command);
-                    return ERR_SYMBOL_NOT_FOUND;
-                }
-
+                strcpy(symbols[count++], first_operand);
             }
-            /* Check if the first operand uses relative addressing */
+            /* A first operand that uses relative addressing names a symbol after the '&' character */
             else if (get_operand_addressing_mode(first_operand) == RELATIVE_ADDRESSING) {
-                /* Skip the '&' character and check if the symbol exists in the symbol table */
-                if(is_label_in_table(first_operand + 1, head_of_symbol_table) == FALSE) {
-                    free(original_input);
-                    free(original_command);
-                    return ERR_SYMBOL_NOT_FOUND;
-                }
+                strcpy(symbols[count++], first_operand + 1);
             }
             /* Check if the command has two operands */
             if(number_of_operands(command) == 2) {
@@ -161,29 +130,30 @@ ErrorCode check_line_errors_second_pass(char *line, SymbolNode *head_of_symbol_t
                 }
                 second_operand[j] = '\0';
 
-                /* Check if the second operand uses direct addressing */
+                /* A second operand that uses direct addressing names a symbol */
                 if (get_operand_addressing_mode(second_operand) == DIRECT_ADDRESSING) {
-                    /* Check if the symbol exists in the symbol table */
-                    if(is_label_in_table(second_operand, head_of_symbol_table) == FALSE) {
-                        free(original_input);
-                        free(original_command);
-                        return ERR_SYMBOL_NOT_FOUND;
-                    }
-
+                    strcpy(symbols[count++], second_operand);
                 }
-                /* Check if the second operand uses relative addressing */
+                /* A second operand that uses relative addressing names a symbol after the '&' character */
                 else if (get_operand_addressing_mode(second_operand) == RELATIVE_ADDRESSING) {
-                    /* Skip the '&' character and check if the symbol exists in the symbol table */
-                    if(is_label_in_table(second_operand + 1, head_of_symbol_table) == FALSE) {
-                        free(original_input);
-                        free(original_command);
-                        return ERR_SYMBOL_NOT_FOUND;
-                    }
+                    strcpy(symbols[count++], second_operand + 1);
                 }
             }
         }
     }
-    free(original_input);
-    free(original_command);
+    return count;
+}
+
+ErrorCode check_line_errors_second_pass(char *line, SymbolNode *head_of_symbol_table) {
+    char symbols[MAX_OPERANDS][MAX_LINE];
+    int number_of_symbols = find_second_pass_symbols(line, symbols);
+    int i;
+
+    /* Check if every symbol the line uses exists in the symbol table */
+    for (i = 0; i < number_of_symbols; i++) {
+        if(is_label_in_table(symbols[i], head_of_symbol_table) == FALSE) {
+            return ERR_SYMBOL_NOT_FOUND;
+        }
+    }
     return NO_ERROR;
 }
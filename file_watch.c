@@ -0,0 +1,168 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include "macro_data.h"
+#include "source_file.h"
+#include "sha256.h"
+#include "file_watch.h"
+
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO) /* The events that leave a new version of a file in place */
+#define EVENT_BUFFER_SIZE 65536 /* The number of bytes of events read at once */
+
+/**
+ * Holds what watching needs to know about one file.
+ */
+typedef struct {
+    char *directory; /* The directory of the file, "." if the name has none */
+    char *name; /* The name of the file within its directory, part of the file name given */
+    int watch_descriptor; /* The inotify watch of the directory */
+    int is_changed; /* TRUE if an event named the file since it was last handled */
+    char content_hash[SHA256_HEX_SIZE + 1]; /* The SHA-256 of the content last seen, empty if it could not be read */
+} WatchedFile;
+
+/**
+ * Hashes the current content of a file.
+ *
+ * @param file_name The name of the file
+ * @param content_hash The buffer to write the hash to, left empty if the file cannot be read
+ * @return void
+ */
+static void hash_file_content(char *file_name, char content_hash[SHA256_HEX_SIZE + 1]) {
+    SourceFile content;
+    Sha256 hash;
+
+    content_hash[0] = '\0';
+    if (map_source_file(&content, file_name) == TRUE) {
+        sha256_begin(&hash);
+        sha256_update(&hash, content.data, content.size);
+        sha256_end_hex(&hash, content_hash);
+        close_source_file(&content);
+    }
+}
+
+/**
+ * Splits the name of a watched file into its directory and its name within the directory,
+ * and starts watching the directory.
+ *
+ * @param file Pointer to the watched file to fill
+ * @param file_name The name of the file
+ * @param inotify_fd The inotify instance
+ * @return int TRUE if the directory is watched, FALSE otherwise
+ */
+static int start_watching_file(WatchedFile *file, char *file_name, int inotify_fd) {
+    char *separator = strrchr(file_name, '/');
+
+    if (separator == NULL) {
+        file->directory = malloc(2);
+        if (check_memory_allocation(file->directory) == FALSE) {
+            return FALSE;
+        }
+        strcpy(file->directory, ".");
+        file->name = file_name;
+    } else {
+        size_t length = separator == file_name ? 1 : (size_t)(separator - file_name);
+
+        file->directory = malloc(length + 1);
+        if (check_memory_allocation(file->directory) == FALSE) {
+            return FALSE;
+        }
+        memcpy(file->directory, file_name, length);
+        file->directory[length] = '\0';
+        file->name = separator + 1;
+    }
+
+    file->is_changed = FALSE;
+    hash_file_content(file_name, file->content_hash);
+
+    /* Watching a directory twice gives back the same descriptor */
+    file->watch_descriptor = inotify_add_watch(inotify_fd, file->directory, WATCH_EVENTS);
+    if (file->watch_descriptor == -1) {
+        printf("Error watching the directory %s\n", file->directory);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Marks the watched files that a buffer of inotify events names.
+ *
+ * @param files The watched files
+ * @param number_of_files The number of watched files
+ * @param events The events read from the inotify instance
+ * @param length The number of bytes read
+ * @return void
+ */
+static void mark_changed_files(WatchedFile *files, int number_of_files, char *events, size_t length) {
+    size_t offset = 0;
+    int i;
+
+    while (offset + sizeof(struct inotify_event) <= length) {
+        struct inotify_event *event = (struct inotify_event *)(events + offset);
+
+        if (event->len > 0) {
+            for (i = 0; i < number_of_files; i++) {
+                if (files[i].watch_descriptor == event->wd && strcmp(files[i].name, event->name) == 0) {
+                    files[i].is_changed = TRUE;
+                }
+            }
+        }
+        offset += sizeof(struct inotify_event) + event->len;
+    }
+}
+
+int watch_files(char **file_names, int number_of_files, FileChangeHandler handler, void *context) {
+    WatchedFile *files = (WatchedFile *) calloc(number_of_files, sizeof(WatchedFile));
+    char *events = malloc(EVENT_BUFFER_SIZE);
+    int inotify_fd = inotify_init();
+    int is_watching = inotify_fd != -1;
+    int i;
+
+    if (check_memory_allocation(files) == FALSE || check_memory_allocation(events) == FALSE) {
+        is_watching = FALSE;
+    }
+
+    for (i = 0; is_watching && i < number_of_files; i++) {
+        is_watching = start_watching_file(&files[i], file_names[i], inotify_fd);
+    }
+
+    while (is_watching) {
+        ssize_t length = read(inotify_fd, events, EVENT_BUFFER_SIZE);
+
+        if (length <= 0) {
+            printf("Error reading the file events.\n");
+            break;
+        }
+        mark_changed_files(files, number_of_files, events, (size_t)length);
+
+        /* Handle the files whose content changed, in order */
+        for (i = 0; i < number_of_files; i++) {
+            char content_hash[SHA256_HEX_SIZE + 1];
+
+            if (!files[i].is_changed) {
+                continue;
+            }
+            files[i].is_changed = FALSE;
+            hash_file_content(file_names[i], content_hash);
+            if (content_hash[0] != '\0' && strcmp(content_hash, files[i].content_hash) != 0) {
+                strcpy(files[i].content_hash, content_hash);
+                handler(i, context);
+            }
+        }
+    }
+
+    if (inotify_fd != -1) {
+        close(inotify_fd);
+    }
+    if (files != NULL) {
+        for (i = 0; i < number_of_files; i++) {
+            free(files[i].directory);
+        }
+    }
+    free(files);
+    free(events);
+    return ERROR_FOUND;
+}
@@ -0,0 +1,27 @@
+#ifndef FILE_WATCH_H
+#define FILE_WATCH_H
+
+/**
+ * A function that handles a change of one watched file.
+ *
+ * @param file_index The index of the file that changed among the watched files
+ * @param context The context pointer given to watch_files
+ */
+typedef void (*FileChangeHandler)(int file_index, void *context);
+
+/**
+ * Watches files through inotify and calls a handler whenever the content of one of them changes.
+ * The directories of the files are watched rather than the files themselves, so a file that an editor
+ * replaces by renaming a new file over it keeps being watched. A file written with the same content
+ * it had does not count as changed. The files that change together are handled once each, in order.
+ * The function only returns if the files cannot be watched or the events cannot be read.
+ *
+ * @param file_names The names of the files to watch
+ * @param number_of_files The number of files
+ * @param handler The function that handles a change
+ * @param context The context pointer passed to the handler
+ * @return int ERROR_FOUND, once watching has failed
+ */
+int watch_files(char **file_names, int number_of_files, FileChangeHandler handler, void *context);
+
+#endif
@@ -1,13 +1,22 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "first_second_pass.h"
+#include "directive_encoder.h"
+#include "diagnostics.h"
 
 int is_symbol (char *line) {
     int i=0;
     int find_space = 0;
 
+    /* Skip the blanks before the label, as the line checks do */
+    while (line[i] == ' ' || line[i] == '\t') {
+        i++;
+    }
+
     /* Traverse through the characters in the line */
     while (line[i] != '\n' && line[i] != '\0') {
 
@@ -25,268 +34,410 @@ int is_symbol (char *line) {
     return FALSE;
 }
 
-int check_errors_in_first_pass(FILE *fd, MacroNode *head_of_macro_table) {
-    char line[MAX_LINE] = {0};
-    int line_number = 0; /* Tracks the current line number in the file */
-    int error_flag = ERROR_WAS_NOT_FOUND; /* Flag to indicate if errors are found */
-
-    /* Read line by line from the file until the end */
-    while (fgets(line, sizeof(line), fd)) {
-        ErrorCode error_check = NO_ERROR;
-        line_number++;
-
-        if (strlen(line) > MAX_LINE - 1) {
-            error_check = ERR_LINE_TOO_LONG;
-            print_error(error_check, line_number);
+/**
+ * Finds the instruction of a line, the text its words depend on: the part after the label
+ * and the blanks that follow it, or the whole line if it has no label.
+ *
+ * @param line The instruction line
+ * @param symbol_flag 1 if the line starts with a label, 0 otherwise
+ * @return char* Pointer to the instruction within the line
+ */
+static char *find_instruction_text(char *line, int symbol_flag) {
+    char *text = line;
+
+    if (symbol_flag == 1) {
+        text = strchr(line, ':') + 1;
+        while (*text == ' ' || *text == '\t') {
+            text++;
         }
+    }
+    return text;
+}
 
-        /* If a macro table exists, check if the line contains a macro label */
-        else if (head_of_macro_table != NULL) {
-            error_check = is_label_macro(line, head_of_macro_table);
+/**
+ * Writes the memo key of an instruction text: the text up to its newline or a comment, with every run of blanks
+ * collapsed to one space and the blanks at both ends and around commas removed. The words of an instruction
+ * only depend on its tokens, so instructions spelled with different spacing share one slot.
+ *
+ * @param text The instruction text
+ * @param key The buffer to write the key to, at most as long as the text
+ * @return void
+ */
+static void make_memo_key(const char *text, char key[MAX_LINE]) {
+    int length = 0;
+    int is_blank_pending = FALSE;
+
+    for (; *text != '\0' && *text != '\n' && *text != ';'; text++) {
+        if (*text == ' ' || *text == '\t') {
+            is_blank_pending = length > 0;
+            continue;
         }
 
-        /* If an error is found, print it and update the error flag */
-        if (error_check != NO_ERROR) {
-            print_error(error_check, line_number);
-            error_flag = ERROR_FOUND;
-        }
-        else {
-            /* Check for error in the current line */
-            error_check = check_line_errors_first_pass(line);
-
-            /* If an error is found, print it and update the error flag */
-            if (error_check != NO_ERROR) {
-                print_error(error_check, line_number);
-                error_flag = ERROR_FOUND;
-            }
+        /* A blank is kept only between two tokens */
+        if (is_blank_pending && *text != ',' && key[length - 1] != ',') {
+            key[length++] = ' ';
         }
+        is_blank_pending = FALSE;
+        key[length++] = *text;
     }
-    return error_flag;
+    key[length] = '\0';
 }
 
-FirstPassResult first_pass(FILE *fd) {
-
-    /* Initialize instruction counter (IC) to 100 and data counter (DC) to 0 */
-    int IC = 100, DC = 0;
+/**
+ * Finds the slot of an instruction key in the encoding memo.
+ *
+ * @param memo Pointer to the encoding memo
+ * @param text The memo key of the instruction, see make_memo_key
+ * @return EncodingMemoSlot* Pointer to the only slot that may hold the words of the instruction
+ */
+static EncodingMemoSlot *find_memo_slot(EncodingMemo *memo, const char *text) {
+    unsigned long hash = 5381;
+
+    while (*text != '\0') {
+        hash = hash * 33 + (unsigned char)*text++;
+    }
+    return &memo->slots[hash & (ENCODING_MEMO_SLOTS - 1)];
+}
 
-    /* Buffers for line manipulation */
-    char line[MAX_LINE] = {0}, first_copy_line[MAX_LINE] = {0}, second_copy_line[MAX_LINE] = {0};
+/**
+ * Records one encoded word of the instruction being memoized.
+ * A slot that would take more words than it holds is left unused.
+ *
+ * @param slot Pointer to the memo slot of the instruction
+ * @param word The encoded word
+ * @return void
+ */
+static void remember_memo_word(EncodingMemoSlot *slot, const char *word) {
+    if (slot->number_of_codes < MAX_INSTRUCTION_WORDS && strlen(word) <= MEMO_WORD_LENGTH) {
+        strcpy(slot->words[slot->number_of_codes], word);
+    } else {
+        slot->number_of_codes = MAX_INSTRUCTION_WORDS;
+    }
+    slot->number_of_codes++;
+}
 
-    /* Initialize the result structure */
-    FirstPassResult result = {NULL, NULL};
+/**
+ * Adds the memoized words of an instruction to its machine code at the current IC address, advancing IC.
+ * The words are copied into a single block, see create_word_block.
+ *
+ * @param state Pointer to the first pass state
+ * @param slot Pointer to the memo slot holding the words
+ * @param head_of_binary_code Double pointer to the head of the machine code list of the line, empty on entry
+ * @return int TRUE if the words were added, FALSE if memory ran out
+ */
+static int copy_memo_words(FirstPassState *state, EncodingMemoSlot *slot, BinaryMachineCode **head_of_binary_code) {
+    *head_of_binary_code = create_word_block(slot->words, slot->number_of_codes, state->IC);
+    if (*head_of_binary_code == NULL) {
+        return FALSE;
+    }
+    state->IC += slot->number_of_codes;
+    state->L = slot->number_of_words;
+    return TRUE;
+}
 
-    char *symbol = NULL, *command = NULL, *remaining_line = NULL;
-    char *first_word = NULL, *extra_word = NULL;
+int find_defined_symbol(char *line, char symbol[MAX_LINE]) {
+    char copy_line[MAX_LINE] = {0};
+    char *label = NULL, *command;
+    char *save_pointer;
 
-    int symbol_flag=0;
-    int L;
+    strcpy(copy_line, line);
 
-    /* Read the file line by line */
-    while (fgets(line, sizeof(line), fd)) {
-        strcpy(first_copy_line, line);
-        strcpy(second_copy_line, line);
+    /* Split the label and the command as first_pass_line does */
+    if (is_symbol(line) == TRUE) {
+        label = strtok_r(copy_line + strspn(copy_line, " \t"), ":", &save_pointer);
+        command = strtok_r(NULL, " \n\t", &save_pointer);
+    } else {
+        command = strtok_r(copy_line, " \n\t", &save_pointer);
+    }
+    if (command == NULL || strcmp(command, ".entry") == 0) {
+        return FALSE;
+    }
 
-        /* Check if line starts with a symbol (label) */
-        if (is_symbol(line) == TRUE) {
+    /* An external symbol is the rest of the line, and a label before .extern is ignored */
+    if (strcmp(command, ".extern") == 0) {
+        label = strtok_r(NULL, "", &save_pointer);
+        if (label != NULL) {
+            label[strcspn(label, "\n")] = '\0';
+        }
+    }
+    if (label == NULL) {
+        return FALSE;
+    }
+    strcpy(symbol, label);
+    return TRUE;
+}
 
-            /* Set the symbol flag */
-            symbol_flag = 1;
+int collect_defined_symbols(SourceFile *source, SymbolNode **head_of_symbol_table) {
+    char line[MAX_LINE] = {0};
+    char symbol[MAX_LINE];
 
-            /* Extract symbol name */
-            symbol = strtok(first_copy_line, ":");
+    *head_of_symbol_table = NULL;
 
-            /* Extract command after symbol */
-            command = strtok(NULL, " \n\t");
-        } else {
+    /* Only the names matter to the second pass checks, so the symbols are pushed on the front without addresses */
+    while (read_source_line(line, sizeof(line), source)) {
+        if (find_defined_symbol(line, symbol) == TRUE) {
+            SymbolNode *rest = *head_of_symbol_table;
 
-            /* Extract command when no symbol */
-            command = strtok(first_copy_line, " \nֿ");
+            *head_of_symbol_table = NULL;
+            if (insert_to_symbol_table(head_of_symbol_table, symbol, INSTRUCTION, 0) == FALSE) {
+                *head_of_symbol_table = rest;
+                return FALSE;
+            }
+            (*head_of_symbol_table)->next = rest;
         }
+    }
+    return TRUE;
+}
 
-        /* Get the rest of the line after the command */
-        if ((strcmp(command, "stop") != 0 ) && (strcmp(command, "rts") != 0) ) {
-
-            /* For "stop" and "rts" command, no operands */
-            remaining_line = strtok(NULL, "");
-        } else {
-            remaining_line = command;
-        }
+int check_errors_in_first_pass(SourceFile *source, MacroNode *head_of_macro_table) {
+    char line[MAX_LINE] = {0};
+    int line_number = 0; /* Tracks the current line number in the file */
+    int error_flag = ERROR_WAS_NOT_FOUND; /* Flag to indicate if errors are found */
 
-        /* Process data and string directives */
-        if (strcmp(command, ".data") == 0 || strcmp(command, ".string") == 0) {
+    /* Read line by line from the file until the end, or until the diagnostics reach their limit */
+    while (!is_diagnostic_limit_reached() && read_source_line(line, sizeof(line), source)) {
+        line_number++;
 
-            /* If there is a symbol, add it to symbol table as DATA type */
-            if (symbol_flag == 1) {
-                insert_to_symbol_table(&result.head_of_symbol_table, symbol, DATA, DC);
-            }
+        /* Check for errors in the current line, print them and update the error flag */
+        if (report_first_pass_line_errors(line, line_number, head_of_macro_table,
+                                          check_line_errors_first_pass(line)) == ERROR_FOUND) {
+            error_flag = ERROR_FOUND;
+        }
+    }
+    return error_flag;
+}
 
-            /* Process .data directive - create machine code for numbers */
-            if (strcmp(command, ".data") == 0) {
-                BinaryMachineCode *head_of_binary_code = NULL;
-                char *operator = strtok(remaining_line, " ,\n");
+void begin_first_pass(FirstPassState *state) {
+    FirstPassResult empty_result = {NULL, NULL, 0, 0, {NULL, 0, 0}, 0, 0};
+    int i;
 
-                /* Iterate through all numbers in the directive */
-                while (operator != NULL) {
+    /* Initialize instruction counter (IC) to 100 and data counter (DC) to 0 */
+    state->IC = 100;
+    state->DC = 0;
+    state->L = 0;
 
-                    /* Create a binary machine code word for the current number */
-                    extra_word = create_extra_word(operator, DATA);
+    /* Initialize the result structure */
+    state->result = empty_result;
 
-                    /* Insert the word into the binary machine code linked list */
-                    insert_word(&head_of_binary_code, extra_word, DC);
+    /* Start with an empty encoding memo */
+    for (i = 0; i < ENCODING_MEMO_SLOTS; i++) {
+        state->memo.slots[i].is_used = FALSE;
+    }
+    state->memo.hits = 0;
+    state->memo.misses = 0;
+}
 
-                    /* Advance the data counter */
-                    DC++;
+int first_pass_line(FirstPassState *state, char *line) {
 
-                    /* Get next number */
-                    operator = strtok(NULL, " ,\n");
+    /* Buffers for line manipulation */
+    char first_copy_line[MAX_LINE] = {0}, second_copy_line[MAX_LINE] = {0};
 
-                }
+    char *symbol = NULL, *command = NULL, *remaining_line = NULL;
+    char *first_word = NULL;
+    char *save_pointer;
 
-                /* Insert the processed .data line into the assembly lines list */
-                insert_line(&result.head_of_lines_list, 0, line, DATA, head_of_binary_code);
-            }
+    int symbol_flag=0;
 
-            /* Process .string directive - create machine code for string characters */
-            if (strcmp(command, ".string") == 0) {
-                BinaryMachineCode *head_of_binary_code = NULL;
-                char *binary_word;
+    strcpy(first_copy_line, line);
+    strcpy(second_copy_line, line);
 
-                /* Find the first quotation mark */
-                char *start = strchr(line, '"');
+    /* Check if line starts with a symbol (label) */
+    if (is_symbol(line) == TRUE) {
 
-                /* Find the last quotation mark */
-                char *end = strrchr(line, '"');
+        /* Set the symbol flag */
+        symbol_flag = 1;
 
-                int i;
+        /* Extract symbol name, after the blanks before it */
+        symbol = strtok_r(first_copy_line + strspn(first_copy_line, " \t"), ":", &save_pointer);
 
+        /* Extract command after symbol */
+        command = strtok_r(NULL, " \n\t", &save_pointer);
+    } else {
 
-                if (start != NULL && end != NULL && start != end) {
-                    /* Move past the opening quotation mark */
-                    start++;
+        /* Extract command when no symbol */
+        command = strtok_r(first_copy_line, " \nֿ", &save_pointer);
+    }
 
-                    /* Terminate the string before the closing quotation mark */
-                    *end = '\0';
-                }
+    /* Get the rest of the line after the command */
+    if ((strcmp(command, "stop") != 0 ) && (strcmp(command, "rts") != 0) ) {
 
-                /* Iterate over each character in the extracted string */
-                for (i = 0; start[i] != '\0'; i++) {
-                    char *binary_word;
+        /* For "stop" and "rts" command, no operands */
+        remaining_line = strtok_r(NULL, "", &save_pointer);
+    } else {
+        remaining_line = command;
+    }
 
-                    /* Convert the character to a string format */
-                    char operator_char[2];
-                    operator_char[0] = start[i];
-                    operator_char[1] = '\0';
+    /* Process data and string directives */
+    if (strcmp(command, ".data") == 0 || strcmp(command, ".string") == 0) {
 
-                    /* Create binary word for the character */
-                    binary_word = create_extra_word(operator_char, STRING);
+        /* If there is a symbol, add it to symbol table as DATA type */
+        if (symbol_flag == 1 &&
+            insert_to_symbol_table(&state->result.head_of_symbol_table, symbol, DATA, state->DC) == FALSE) {
+            return FALSE;
+        }
 
-                    /* Insert the character into the binary machine code list */
-                    insert_word(&head_of_binary_code, binary_word, DC);
+        /* Process .data directive - encode the numbers straight into the data image */
+        if (strcmp(command, ".data") == 0 &&
+            encode_data_directive(remaining_line, &state->result.data_image) == ERR_OUT_OF_MEMORY) {
+            return FALSE;
+        }
 
-                    /* Advance the data counter */
-                    DC++;
-                }
+        /* Process .string directive - widen the string characters straight into the data image */
+        if (strcmp(command, ".string") == 0 &&
+            encode_string_directive(remaining_line, &state->result.data_image) == ERR_OUT_OF_MEMORY) {
+            return FALSE;
+        }
 
-                /* Create binary word for '\0' end-of-string character */
-                binary_word = create_extra_word("", STRING);
+        /* Insert the processed directive line into the assembly lines list, its words live in the data image */
+        if (insert_line(&state->result.head_of_lines_list, state->result.data_image.count - state->DC,
+                        line, DATA, NULL) == FALSE) {
+            return FALSE;
+        }
 
-                /* Insert the binary word into the binary code linked list */
-                insert_word(&head_of_binary_code, binary_word, DC);
+        /* Advance the data counter past the encoded words */
+        state->DC = state->result.data_image.count;
 
-                /* Advance the data counter */
-                DC++;
+    /* Process extern directive - add external symbol to table */
+    } else if (strcmp(command, ".extern") == 0) {
 
-                /* Insert the processed .string directive into the assembly lines list */
-                insert_line(&result.head_of_lines_list, 0, line, DATA, head_of_binary_code);
-            }
+        /* Remove newline character from the remaining line */
+        remaining_line[strcspn(remaining_line, "\n")] = '\0';
+        symbol = remaining_line;
 
-        /* Process extern directive - add external symbol to table */
-        } else if (strcmp(command, ".extern") == 0) {
+        /* Insert the external symbol into the symbol table with a value of 0 */
+        if (insert_to_symbol_table(&state->result.head_of_symbol_table, symbol, EXTERN, 0) == FALSE) {
+            return FALSE;
+        }
 
-            /* Remove newline character from the remaining line */
-            remaining_line[strcspn(remaining_line, "\n")] = '\0';
-            symbol = remaining_line;
+    /* Process entry directive */
+    } else if (strcmp(command, ".entry") == 0) {
+        BinaryMachineCode *head_of_binary_code = NULL;
+        char *empty_word = malloc(1);
+        /* Check if memory allocation was successful */
+        if (check_memory_allocation(empty_word) == FALSE) {
+            return FALSE;
+        }
+        empty_word[0] = '\0';
 
-            /* Insert the external symbol into the symbol table with a value of 0 */
-            insert_to_symbol_table(&result.head_of_symbol_table, symbol, EXTERN, 0);
 
-        /* Process entry directive */
-        } else if (strcmp(command, ".entry") == 0) {
-            BinaryMachineCode *head_of_binary_code = NULL;
-            char *empty_word = malloc(1);
-            /* Check if memory allocation was successful */
-            if (check_memory_allocation(empty_word) == FALSE) {
-                exit(1);
-            }
-            empty_word[0] = '\0';
+        /* Insert a placeholder word into the binary machine code list (empty string, since it's an entry) */
+        if (insert_word(&head_of_binary_code, empty_word, state->DC) == FALSE) {
+            free(empty_word);
+            return FALSE;
+        }
 
+        /*  Insert the processed .entry line into the assembly lines list */
+        if (insert_line(&state->result.head_of_lines_list, 0, line, ENTRY, head_of_binary_code) == FALSE) {
+            free_word_list(head_of_binary_code);
+            return FALSE;
+        }
 
-            /* Insert a placeholder word into the binary machine code list (empty string, since it's an entry) */
-            insert_word(&head_of_binary_code, empty_word, DC);
+    /* Process instruction commands */
+    } else {
+        BinaryMachineCode *head_of_binary_code = NULL;
+        char key[MAX_LINE];
+        EncodingMemoSlot *slot;
 
-            /*  Insert the processed .entry line into the assembly lines list */
-            insert_line(&result.head_of_lines_list, 0, line, ENTRY, head_of_binary_code);
+        make_memo_key(find_instruction_text(line, symbol_flag), key);
+        slot = find_memo_slot(&state->memo, key);
 
-        /* Process instruction commands */
-        } else {
-            BinaryMachineCode *head_of_binary_code;
+        /* If there is a symbol, add it to symbol table as CODE type */
+        if (symbol_flag == 1 &&
+            insert_to_symbol_table(&state->result.head_of_symbol_table, symbol, CODE, state->IC) == FALSE) {
+            return FALSE;
+        }
 
-            /* If there is a symbol, add it to symbol table as CODE type */
-            if (symbol_flag == 1) {
-                insert_to_symbol_table(&result.head_of_symbol_table, symbol, CODE, IC);
+        /* Copy the words of the same instruction encoded before, they do not depend on IC or on the label */
+        if (slot->is_used && strcmp(slot->text, key) == 0) {
+            state->memo.hits++;
+            if (copy_memo_words(state, slot, &head_of_binary_code) == FALSE) {
+                return FALSE;
+            }
+            if (insert_line(&state->result.head_of_lines_list, state->L, line, CODE, head_of_binary_code) == FALSE) {
+                free_word_list(head_of_binary_code);
+                return FALSE;
             }
+            return TRUE;
+        }
 
-            /* Create the first word of the instruction */
-            first_word = create_first_word(second_copy_line, symbol_flag);
-            head_of_binary_code = NULL;
+        /* Encode the instruction, recording its words in its slot */
+        state->memo.misses++;
+        slot->is_used = FALSE;
+        slot->number_of_codes = 0;
+        strcpy(slot->text, key);
 
-            /* Add the first word to the binary machine code list at the current IC address */
-            insert_word(&head_of_binary_code, first_word, IC);
-            IC++;
+        /* Create the first word of the instruction */
+        first_word = create_first_word(second_copy_line, symbol_flag);
+        if (first_word == NULL) {
+            return FALSE;
+        }
+        remember_memo_word(slot, first_word);
 
-            /* Calculate how many words are needed */
-            if (remaining_line != NULL) {
-                char temp_copy[MAX_LINE] = {0};
-                strcpy(temp_copy, remaining_line);
-                L = number_of_words(temp_copy, command);
-            }
+        /* Add the first word to the binary machine code list at the current IC address */
+        if (insert_word(&head_of_binary_code, first_word, state->IC) == FALSE) {
+            free(first_word);
+            return FALSE;
+        }
+        state->IC++;
 
-            /* If there are more than one word that are nedded */
-            if (L > 1) {
-                char *operator = NULL;
-                operator = strtok(remaining_line, " ,\n");
+        /* Calculate how many words are needed */
+        if (remaining_line != NULL) {
+            char temp_copy[MAX_LINE] = {0};
+            strcpy(temp_copy, remaining_line);
+            state->L = number_of_words(temp_copy, command);
+        }
 
-                /* Loop through each operator */
-                while (operator != NULL) {
-                    /* If the operator is not a register */
-                    if (is_register(operator) == FALSE) {
+        /* If there are more than one word that are nedded */
+        if (state->L > 1) {
+            char *operator = NULL;
+            operator = strtok_r(remaining_line, " ,\n", &save_pointer);
 
-                        /* Create the binary word for the operator */
-                        char *binary_word = create_extra_word(operator, INSTRUCTION);
+            /* Loop through each operator */
+            while (operator != NULL) {
+                /* If the operator is not a register */
+                if (is_register(operator) == FALSE) {
 
-                        /* Insert the binary word to the binary machine code list at the current IC address */
-                        insert_word(&head_of_binary_code, binary_word, IC);
-                        IC++;
+                    /* Create the binary word for the operator */
+                    char *binary_word = create_extra_word(operator, INSTRUCTION);
 
+                    /* Insert the binary word to the binary machine code list at the current IC address */
+                    if (binary_word == NULL || insert_word(&head_of_binary_code, binary_word, state->IC) == FALSE) {
+                        free(binary_word);
+                        free_word_list(head_of_binary_code);
+                        return FALSE;
                     }
+                    remember_memo_word(slot, binary_word);
+                    state->IC++;
 
-                    /* Move to the next operator */
-                    operator = strtok(NULL, " ,\n");
                 }
 
+                /* Move to the next operator */
+                operator = strtok_r(NULL, " ,\n", &save_pointer);
             }
 
-            /* Insert the processed instruction line into the lines list */
-            insert_line(&result.head_of_lines_list, L, line, CODE, head_of_binary_code);
         }
 
-        /* Reset the symbol flag */
-        symbol_flag = 0;
+        /* The words are only memoized when L was computed for this line */
+        slot->is_used = remaining_line != NULL && slot->number_of_codes <= MAX_INSTRUCTION_WORDS;
+        slot->number_of_words = state->L;
+
+        /* Insert the processed instruction line into the lines list */
+        if (insert_line(&state->result.head_of_lines_list, state->L, line, CODE, head_of_binary_code) == FALSE) {
+            free_word_list(head_of_binary_code);
+            return FALSE;
+        }
     }
+    return TRUE;
+}
+
+FirstPassResult end_first_pass(FirstPassState *state) {
+    FirstPassResult result = state->result;
 
     /* Store the final instruction and data counter values in the result structure */
-    result.ICF = IC;
-    result.DCF = DC;
+    result.ICF = state->IC;
+    result.DCF = state->DC;
+    result.memo_hits = state->memo.hits;
+    result.memo_misses = state->memo.misses;
 
     /* Update addresses of data lines, shifting them after the code section */
     update_data_line_list_addresses(result.head_of_lines_list, result.ICF);
@@ -298,3 +449,20 @@ FirstPassResult first_pass(FILE *fd) {
 
 }
 
+int first_pass(SourceFile *source, FirstPassResult *result) {
+    FirstPassState state;
+    char line[MAX_LINE] = {0};
+
+    begin_first_pass(&state);
+
+    /* Read the file line by line */
+    while (read_source_line(line, sizeof(line), source)) {
+        if (first_pass_line(&state, line) == FALSE) {
+            free_first_pass_result(&state.result);
+            return FALSE;
+        }
+    }
+
+    *result = end_first_pass(&state);
+    return TRUE;
+}
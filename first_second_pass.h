@@ -12,26 +12,76 @@
  * (without fully processing them). The function processes instruction commands,
  * identifies symbols (labels), and creates the initial machine code.
  *
- * @param fd File pointer to the assembly source code
- * @return FirstPassResult structure containing:
+ * @param source Pointer to the mapped assembly source code
+ * @param result Pointer to the FirstPassResult structure to fill with:
  *         - head_of_lines_list: The list of all lines processed
  *         - head_of_symbol_table: The symbol table with all symbols
  *         - ICF: Final Instruction Counter value after the first pass
  *         - DCF: Final Data Counter value after the first pass
+ * @return int TRUE if the pass was completed, FALSE if memory ran out, in which case nothing is left to free
  */
-FirstPassResult first_pass(FILE *fd);
+int first_pass(SourceFile *source, FirstPassResult *result);
+
+/**
+ * Starts a first pass that is fed one line at a time, with IC at 100 and DC at 0.
+ *
+ * @param state Pointer to the first pass state to initialize
+ * @return void
+ */
+void begin_first_pass(FirstPassState *state);
+
+/**
+ * Processes one line of the first pass: adds its symbol to the symbol table,
+ * encodes its words and advances IC or DC past them.
+ *
+ * @param state Pointer to the first pass state
+ * @param line The line to process, it must have passed the first pass checks
+ * @return int TRUE if the line was processed, FALSE if memory ran out, in which case the state only holds
+ *         the earlier lines and should be freed with free_first_pass_result
+ */
+int first_pass_line(FirstPassState *state, char *line);
+
+/**
+ * Ends a first pass that was fed one line at a time, moving the data after the code.
+ *
+ * @param state Pointer to the first pass state
+ * @return FirstPassResult The same result first_pass returns for the same lines
+ */
+FirstPassResult end_first_pass(FirstPassState *state);
+
+/**
+ * Finds the symbol first_pass_line would add to the symbol table for a line: the label of an instruction,
+ * a .data or a .string line, or the operand of an .extern line. Unlike first_pass_line,
+ * it accepts any line, including lines that fail the first pass checks.
+ *
+ * @param line The line
+ * @param symbol The buffer to write the symbol name to
+ * @return int TRUE if the line defines a symbol, FALSE otherwise
+ */
+int find_defined_symbol(char *line, char symbol[MAX_LINE]);
+
+/**
+ * Builds a symbol table holding the name of every symbol the expanded source defines, as find_defined_symbol
+ * finds them, without encoding any line. The addresses are left 0, so the table only serves
+ * the second pass checks of a source that passed the first pass checks.
+ *
+ * @param source Pointer to the expanded source
+ * @param head_of_symbol_table Pointer to set to the head of the symbol table, to be freed with free_symbol_table
+ * @return int TRUE if the table was built, FALSE if memory ran out, leaving the symbols added so far in the table
+ */
+int collect_defined_symbols(SourceFile *source, SymbolNode **head_of_symbol_table);
 
 /**
  * Checks for errors in each line of an assembly file during the first pass.
  *
- * @param fd Pointer to the file for reading
+ * @param source Pointer to the mapped file for reading
  * @param head_of_macro_table Pointer to the head of the macro table
  * @return int ERROR_FOUND if an error found, ERROR_WAS_NOT_FOUND if no error is found.
  */
-int check_errors_in_first_pass(FILE *fd, MacroNode * head_of_macro_table);
+int check_errors_in_first_pass(SourceFile *source, MacroNode * head_of_macro_table);
 
 /**
- * Checks if the line contains a symbol (label).
+ * Checks if the line contains a symbol (label). Blanks before the label are skipped.
  *
  * @param line Pointer to the string representing the line to check
  * @return int TRUE if the line contains a symbol, False otherwise
@@ -46,20 +96,22 @@ int is_symbol (char *line);
  *
  * @param head_of_symbol_table Pointer to the head of the symbol table
  * @param head_of_line_list Double pointer to the head of the assembly line list
- * @return  SecondPassResult structure containing:
+ * @param result Pointer to the SecondPassResult structure to fill with:
  *         - head_of_lines_list: The list of all lines processed.
  *         - head_of_symbol_table: The symbol table with all symbols.
+ * @return int TRUE if the pass was completed, FALSE if memory ran out,
+ *         in which case *head_of_line_list still holds every line to free
  */
-SecondPassResult second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList **head_of_line_list);
+int second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList **head_of_line_list, SecondPassResult *result);
 
 /**
  * Checks for errors in each line of an assembly file during the second pass.
  *
- * @param fd Pointer to the file for reading
+ * @param source Pointer to the mapped file for reading
  * @param head_of_symbol_table Pointer to the head of the symbol table
  * @return int ERROR_FOUND if errors are found, NO_ERROR if no errors are found.
  */
-int check_errors_in_second_pass(FILE *fd, SymbolNode * head_of_symbol_table);
+int check_errors_in_second_pass(SourceFile *source, SymbolNode * head_of_symbol_table);
 
 /**
 * Replaces the first incomplete word in the binary machine code list with a given word.
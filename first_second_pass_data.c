@@ -22,7 +22,7 @@ void generic_insert_node(void **head, void *new_node, size_t next_offset) {
 }
 
 
-void insert_word(BinaryMachineCode **head, char* word, int address) {
+int insert_word(BinaryMachineCode **head, char* word, int address) {
     BinaryMachineCode *new_node;
 
     /* Allocate memory for the new node */
@@ -30,19 +30,52 @@ void insert_word(BinaryMachineCode **head, char* word, int address) {
 
     /* Check if memory allocation was successful */
     if (check_memory_allocation(new_node) == FALSE) {
-        exit(1);
+        return FALSE;
     }
 
     /* Allocate memory for the binary machine code and copy it */
     new_node->word =word;
     new_node->address = address; /* Copy the address of the word */
+    new_node->is_in_block = FALSE;
     new_node->next = NULL; /* Initialize next pointer to NULL */
 
     generic_insert_node((void **)head, (void *)new_node, offsetof(BinaryMachineCode, next));
+    return TRUE;
+}
+
+BinaryMachineCode *create_word_block(char words[][MEMO_WORD_LENGTH + 1], int number_of_words, int address) {
+    BinaryMachineCode *block;
+    char *word_storage;
+    int i;
+
+    /* The nodes come first, then the words */
+    block = (BinaryMachineCode *) malloc(number_of_words * (sizeof(BinaryMachineCode) + MEMO_WORD_LENGTH + 1));
+    if (check_memory_allocation(block) == FALSE) {
+        return NULL;
+    }
+    word_storage = (char *)(block + number_of_words);
+
+    for (i = 0; i < number_of_words; i++) {
+        block[i].word = word_storage + i * (MEMO_WORD_LENGTH + 1);
+        strcpy(block[i].word, words[i]);
+        block[i].address = address + i;
+        block[i].is_in_block = TRUE;
+        block[i].next = i + 1 < number_of_words ? &block[i + 1] : NULL;
+    }
+    return block;
+}
 
+void replace_word(BinaryMachineCode *code, char *word) {
+    if (code->is_in_block) {
+        strcpy(code->word, word);
+        free(word);
+    } else {
+        free(code->word);
+        code->word = word;
+    }
 }
 
-void insert_line(AssemblyLineList **head, int number_of_words, char* line, AssemblyElementType type, BinaryMachineCode *code) {
+int insert_line(AssemblyLineList **head, int number_of_words, char* line, AssemblyElementType type, BinaryMachineCode *code) {
     AssemblyLineList *new_node;
     AssemblyLineList *current;
 
@@ -51,14 +84,14 @@ void insert_line(AssemblyLineList **head, int number_of_words, char* line, Assem
 
     /* Check if memory allocation was successful */
     if (check_memory_allocation(new_node) == FALSE) {
-        exit(1);
+        return FALSE;
     }
 
     /* Allocate memory for the line and copy it */
     new_node->line = (char *) malloc(strlen(line) + 1);
     if (check_memory_allocation(new_node->line) == FALSE) {
         free(new_node);
-        exit(1);
+        return FALSE;
     }
 
     strcpy(new_node->line, line); /* Copy the line string */
@@ -83,9 +116,10 @@ void insert_line(AssemblyLineList **head, int number_of_words, char* line, Assem
         current->next = new_node;
         new_node->prev = current;
     }
+    return TRUE;
 }
 
-void insert_to_symbol_table(SymbolNode **head, char* symbol, AssemblyElementType type, int address) {
+int insert_to_symbol_table(SymbolNode **head, char* symbol, AssemblyElementType type, int address) {
     SymbolNode *new_node;
 
     /* Allocate memory for the new node */
@@ -93,14 +127,14 @@ void insert_to_symbol_table(SymbolNode **head, char* symbol, AssemblyElementType
 
     /* Check if memory allocation was successful */
     if (check_memory_allocation(new_node) == FALSE) {
-        exit(1);
+        return FALSE;
     }
 
     /* Allocate memory for the symbol name and copy it */
     new_node->symbol_name = (char *)malloc(strlen(symbol) + 1);
     if (check_memory_allocation(new_node->symbol_name) == FALSE) {
         free(new_node);
-        exit(1);
+        return FALSE;
     }
     strcpy(new_node->symbol_name, symbol); /* Copy the symbol name string */
     new_node->type = type; /* Set the type of the symbol */
@@ -110,6 +144,7 @@ void insert_to_symbol_table(SymbolNode **head, char* symbol, AssemblyElementType
 
     /* Insert the new node at the end of the list using the generic insert function */
     generic_insert_node((void**)head, (void*)new_node, offsetof(SymbolNode, next));
+    return TRUE;
 }
 
 void update_data_symbol_addresses(SymbolNode *head_of_symbol_table, int ICF) {
@@ -178,43 +213,100 @@ void free_line_list(AssemblyLineList *head) {
     AssemblyLineList *next_line;
 
     while (current_line != NULL) {
-        BinaryMachineCode *current_code = current_line->code;
-        BinaryMachineCode *next_code;
-
         next_line = current_line->next;
 
         if (current_line->line != NULL) {
             free(current_line->line);
         }
 
-        while (current_code != NULL) {
-            next_code = current_code->next;
+        free_word_list(current_line->code);
+        free(current_line);
+        current_line = next_line;
+    }
+}
+
+void free_word_list(BinaryMachineCode *head) {
+    BinaryMachineCode *current_code = head;
+    BinaryMachineCode *next_code;
+    int is_block = head != NULL && head->is_in_block;
 
-            if (current_code->word != NULL) {
-                free(current_code->word);
-            }
+    while (current_code != NULL) {
+        next_code = current_code->next;
 
+        /* The nodes of the block and their words are freed with the block */
+        if (!current_code->is_in_block) {
+            free(current_code->word);
             free(current_code);
-            current_code = next_code;
         }
+        current_code = next_code;
+    }
 
-        free(current_line);
-        current_line = next_line;
+    /* A block always starts its list */
+    if (is_block) {
+        free(head);
     }
 }
 
-void free_machine_code_list(BinaryMachineCode *array, int ICF, int DCF) {
-    size_t num_elements = (ICF - 100) + DCF;
+void free_first_pass_result(FirstPassResult *result) {
+    free_line_list(result->head_of_lines_list);
+    free_symbol_table(result->head_of_symbol_table);
+    free_data_image(&result->data_image);
+    result->head_of_lines_list = NULL;
+    result->head_of_symbol_table = NULL;
+}
+
+void free_compact_program(CompactProgram *program) {
+    free_symbol_table(program->head_of_symbol_table);
+    free_data_image(&program->code_image);
+    free_data_image(&program->data_image);
+    free(program->external_uses);
+    program->head_of_symbol_table = NULL;
+    program->external_uses = NULL;
+    program->number_of_external_uses = 0;
+}
+
+int reserve_data_image(DataImage *image, int extra_words) {
+    unsigned long *new_words;
+    int new_capacity;
+
+    /* Nothing to do if the image is already big enough */
+    if (image->count + extra_words <= image->capacity) {
+        return TRUE;
+    }
+
+    /* Grow geometrically so that appending stays linear over the whole file */
+    new_capacity = image->capacity == 0 ? 64 : image->capacity * 2;
+    while (new_capacity < image->count + extra_words) {
+        new_capacity *= 2;
+    }
+
+    new_words = (unsigned long *) realloc(image->words, new_capacity * sizeof(unsigned long));
+
+    /* Check if memory allocation was successful */
+    if (check_memory_allocation(new_words) == FALSE) {
+        return FALSE;
+    }
+
+    image->words = new_words;
+    image->capacity = new_capacity;
+    return TRUE;
+}
+
+void free_data_image(DataImage *image) {
+    free(image->words);
+    image->words = NULL;
+    image->count = 0;
+    image->capacity = 0;
+}
+
+void free_machine_code_list(BinaryMachineCode *array, size_t number_of_words) {
     size_t i;
 
-    for (i = 0; i < num_elements; i++) {
+    for (i = 0; i < number_of_words; i++) {
         /* Free the string allocated for each element's 'word' */
         free(array[i].word);
     }
 
     /* Free the entire array of BinaryMachineCode structures */
     free(array);
-}
-
-
-
+}
\ No newline at end of file
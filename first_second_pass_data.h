@@ -1,8 +1,14 @@
 #ifndef FIRST_SECOND_PASS_DATA_H
 #define FIRST_SECOND_PASS_DATA_H
 
+#include <stddef.h>
 #include "macro_data.h"
 
+#define WORD_MASK 0xFFFFFFUL /* Mask of a single 24-bit machine word */
+#define ENCODING_MEMO_SLOTS 256 /* Number of slots of the encoding memo of a first pass, a power of two */
+#define MAX_INSTRUCTION_WORDS 3 /* The first word of an instruction and a word for each of its two operands */
+#define MEMO_WORD_LENGTH 24 /* Number of characters of a memoized word, one per bit */
+
 /**
  * Enum representing the type of assembly elements
  */
@@ -44,6 +50,7 @@ typedef struct BinaryMachineCode {
     struct BinaryMachineCode *next; /* Pointer to the next machine code in the list */
     char* word; /* The binary word representing the machine code */
     int address; /* The address of the machine word */
+    int is_in_block; /* TRUE if the node and its word live in the block of its list, see create_word_block */
 } BinaryMachineCode;
 
 /**
@@ -58,6 +65,15 @@ typedef struct AssemblyLineList{
     struct AssemblyLineList *prev; /* Pointer to the previous assembly line */
 } AssemblyLineList;
 
+/**
+ * Struct representing the data image, the contiguous memory image of all .data and .string words.
+ */
+typedef struct {
+    unsigned long *words; /* Packed 24-bit words, indexed by their data counter value */
+    int count; /* The number of words in the image */
+    int capacity; /* The number of words allocated */
+} DataImage;
+
 /**
  * Struct holding the results from the first pass of the assembler.
  */
@@ -66,8 +82,44 @@ typedef struct {
     SymbolNode *head_of_symbol_table;
     int ICF;
     int DCF;
+    DataImage data_image;
+    unsigned long memo_hits; /* The number of instruction lines whose words were taken from the encoding memo */
+    unsigned long memo_misses; /* The number of instruction lines that were encoded */
 } FirstPassResult;
 
+/**
+ * Struct representing the words of one instruction text in the encoding memo.
+ * The words of symbol operands are the "?" placeholders the second pass completes, so they fit any address.
+ */
+typedef struct {
+    char text[MAX_LINE]; /* The instruction after its label, the key of the slot */
+    int is_used; /* TRUE if the slot holds the words of its text */
+    int number_of_words; /* The number of words of the instruction, L */
+    int number_of_codes; /* The number of words encoded: the first word and the words of non-register operands */
+    char words[MAX_INSTRUCTION_WORDS][MEMO_WORD_LENGTH + 1]; /* The encoded words, in address order */
+} EncodingMemoSlot;
+
+/**
+ * Struct representing the encoding memo of a first pass: the words of recently encoded instruction texts,
+ * one text per slot, so a repeated instruction is copied instead of encoded again.
+ */
+typedef struct {
+    EncodingMemoSlot slots[ENCODING_MEMO_SLOTS];
+    unsigned long hits; /* The number of instruction lines copied from a slot */
+    unsigned long misses; /* The number of instruction lines encoded */
+} EncodingMemo;
+
+/**
+ * Struct holding the state of a first pass between the lines it processes.
+ */
+typedef struct {
+    FirstPassResult result; /* The lines, symbols and data built so far */
+    int IC; /* The instruction counter */
+    int DC; /* The data counter */
+    int L; /* The number of words of the last instruction line */
+    EncodingMemo memo; /* The words of the instructions encoded recently */
+} FirstPassState;
+
 /**
  * Struct holding the results from the second pass of the assembler.
  */
@@ -76,6 +128,29 @@ typedef struct {
     SymbolNode *head_of_symbol_table;
 } SecondPassResult;
 
+/**
+ * Struct representing one use of an external symbol, a record of the externals file.
+ */
+typedef struct {
+    char *symbol_name; /* The name of the external symbol, owned by the symbol table */
+    int address; /* The address written for the use */
+} ExternalUse;
+
+/**
+ * Struct holding a program assembled without a line list: the symbol table and the packed words.
+ */
+typedef struct {
+    SymbolNode *head_of_symbol_table;
+    DataImage code_image; /* Packed instruction words, indexed by their address - 100 */
+    DataImage data_image;
+    ExternalUse *external_uses; /* The records of the externals file, in order */
+    int number_of_external_uses;
+    int ICF;
+    int DCF;
+    unsigned long memo_hits; /* The number of instruction lines whose words were taken from the encoding memo */
+    unsigned long memo_misses; /* The number of instruction lines that were encoded */
+} CompactProgram;
+
 
 /**
  * Inserts a new node at the end of a generic linked list,
@@ -94,9 +169,31 @@ void generic_insert_node(void **head, void *new_node, size_t node_offset);
  * @param head Double pointer to the head of the binary machine code linked list
  * @param word A string representing the binary word to insert
  * @param address The address associated with this word
- * @return NULL
+ * @return int TRUE if the word was inserted, FALSE if memory ran out, in which case the caller still owns the word
+ */
+int insert_word(BinaryMachineCode **head, char* word, int address);
+
+/**
+ * Creates a machine code list in a single block holding its nodes and their words, for a line whose words
+ * are known up front. The words are copied in, at consecutive addresses. Words inserted into the list later
+ * are allocated on their own, and the whole list is freed with free_word_list.
+ *
+ * @param words The words of the list, in address order
+ * @param number_of_words The number of words, at least 1
+ * @param address The address of the first word
+ * @return BinaryMachineCode* Pointer to the head of the list, or NULL if memory ran out
  */
-void insert_word(BinaryMachineCode **head, char* word, int address);
+BinaryMachineCode *create_word_block(char words[][MEMO_WORD_LENGTH + 1], int number_of_words, int address);
+
+/**
+ * Replaces the word of a machine code node. The node takes over the new word, or copies it into its block
+ * and frees it.
+ *
+ * @param code Pointer to the node
+ * @param word The new word, at most MEMO_WORD_LENGTH characters
+ * @return void
+ */
+void replace_word(BinaryMachineCode *code, char *word);
 
 /**
  * Inserts a new assembly line node at the end of a doubly-linked list.
@@ -106,9 +203,9 @@ void insert_word(BinaryMachineCode **head, char* word, int address);
  * @param line A string representing the line
  * @param type The type of the line (CODE, DATA, ENTRY, EXTERN)
  * @param code Pointer to binary machine code representation of this line
- * @return void
+ * @return int TRUE if the line was inserted, FALSE if memory ran out, in which case the caller still owns the code
  */
-void insert_line(AssemblyLineList **head, int number_of_words, char* line, AssemblyElementType type, BinaryMachineCode *code);
+int insert_line(AssemblyLineList **head, int number_of_words, char* line, AssemblyElementType type, BinaryMachineCode *code);
 
 /**
  * Inserts a new symbol (label) node at the end of the linked-list symbol table.
@@ -117,9 +214,9 @@ void insert_line(AssemblyLineList **head, int number_of_words, char* line, Assem
  * @param symbol The name of the symbol (label) to be added
  * @param type The type of the assembly element
  * @param address The address associated with the symbol.
- * @return void
+ * @return int TRUE if the symbol was inserted, FALSE if memory ran out
  */
-void insert_to_symbol_table(SymbolNode **head, char* symbol, AssemblyElementType type, int address);
+int insert_to_symbol_table(SymbolNode **head, char* symbol, AssemblyElementType type, int address);
 
 /**
  * Updates the addresses of DATA symbols in the symbol table after the first pass.
@@ -159,5 +256,53 @@ void free_symbol_table(SymbolNode *head);
  */
 void free_line_list(AssemblyLineList *head);
 
-void free_machine_code_list(BinaryMachineCode *array, int ICF, int DCF);
+/**
+ * Frees all memory allocated for a binary machine code linked list, including its words and its block.
+ *
+ * @param head Pointer to the head of the binary machine code list
+ * @return void
+ */
+void free_word_list(BinaryMachineCode *head);
+
+/**
+ * Frees the line list, symbol table and data image of a first pass result.
+ *
+ * @param result Pointer to the first pass result
+ * @return void
+ */
+void free_first_pass_result(FirstPassResult *result);
+
+/**
+ * Frees the symbol table, word images and external uses of a compact program.
+ *
+ * @param program Pointer to the compact program
+ * @return void
+ */
+void free_compact_program(CompactProgram *program);
+
+/**
+ * Makes room in the data image for at least the given number of additional words.
+ *
+ * @param image Pointer to the data image
+ * @param extra_words The number of words that are about to be appended
+ * @return int TRUE if there is room for the words, FALSE if memory ran out
+ */
+int reserve_data_image(DataImage *image, int extra_words);
+
+/**
+ * Frees the memory allocated for the data image and resets it to an empty image.
+ *
+ * @param image Pointer to the data image
+ * @return void
+ */
+void free_data_image(DataImage *image);
+
+/**
+ * Frees an array of machine code words, including the word strings.
+ *
+ * @param array Pointer to the array of machine code words
+ * @param number_of_words The number of elements in the array
+ * @return void
+ */
+void free_machine_code_list(BinaryMachineCode *array, size_t number_of_words);
 #endif
@@ -0,0 +1,252 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "front_end_pipeline.h"
+#include "line_ring.h"
+#include "diagnostics.h"
+
+/**
+ * Holds the state of the stage that checks every expanded line.
+ */
+typedef struct {
+    LineRing *input; /* The expanded lines */
+    LineRing *output; /* The lines passed on to the first pass, up to the first error */
+    ErrorCode *line_errors; /* The result of check_line_errors_first_pass for every line */
+    int number_of_lines; /* The number of lines checked */
+    int capacity; /* The number of results line_errors has room for */
+    int is_out_of_memory; /* TRUE if the results could not grow */
+    OutputBuffer *sink; /* The diagnostic sink of the job */
+    DiagnosticReport *report; /* The diagnostic report of the job */
+} ValidationStage;
+
+/**
+ * Holds the state of the stage that runs the first pass.
+ */
+typedef struct {
+    LineRing *input; /* The checked lines */
+    FirstPassResult result; /* The result of the first pass over them */
+    int is_out_of_memory; /* TRUE if the first pass ran out of memory */
+    OutputBuffer *sink; /* The diagnostic sink of the job */
+    DiagnosticReport *report; /* The diagnostic report of the job */
+} EncodingStage;
+
+/**
+ * The main function of the validation stage. It checks every line, and passes the lines on
+ * to the first pass until the first error, since the first pass only accepts valid lines.
+ *
+ * @param argument Pointer to the ValidationStage
+ * @return void* Always NULL
+ */
+static void *run_validation_stage(void *argument) {
+    ValidationStage *stage = (ValidationStage *) argument;
+    LineRecord record;
+    int error_flag = ERROR_WAS_NOT_FOUND;
+
+    capture_diagnostics(stage->sink);
+    use_diagnostic_report(stage->report);
+
+    /* Once memory runs out, the lines are only drained so the expansion does not block */
+    while (pop_line(stage->input, &record)) {
+        ErrorCode line_error;
+
+        if (stage->is_out_of_memory) {
+            continue;
+        }
+        line_error = check_line_errors_first_pass(record.line);
+
+        /* Grow the results geometrically */
+        if (stage->number_of_lines == stage->capacity) {
+            int new_capacity = stage->capacity == 0 ? 1024 : stage->capacity * 2;
+            ErrorCode *new_errors = (ErrorCode *) realloc(stage->line_errors, new_capacity * sizeof(ErrorCode));
+
+            if (check_memory_allocation(new_errors) == FALSE) {
+                stage->is_out_of_memory = TRUE;
+                continue;
+            }
+            stage->line_errors = new_errors;
+            stage->capacity = new_capacity;
+        }
+        stage->line_errors[stage->number_of_lines++] = line_error;
+
+        if (line_error != NO_ERROR) {
+            error_flag = ERROR_FOUND;
+        }
+        if (error_flag == ERROR_WAS_NOT_FOUND) {
+            push_line(stage->output, record.line, record.line_number);
+        }
+    }
+    close_line_ring(stage->output);
+    return NULL;
+}
+
+/**
+ * The main function of the encoding stage. It runs the first pass over every line it receives.
+ *
+ * @param argument Pointer to the EncodingStage
+ * @return void* Always NULL
+ */
+static void *run_encoding_stage(void *argument) {
+    EncodingStage *stage = (EncodingStage *) argument;
+    FirstPassState state;
+    LineRecord record;
+
+    capture_diagnostics(stage->sink);
+    use_diagnostic_report(stage->report);
+    begin_first_pass(&state);
+
+    /* Once memory runs out, the lines are only drained so the validation does not block */
+    while (pop_line(stage->input, &record)) {
+        if (!stage->is_out_of_memory && first_pass_line(&state, record.line) == FALSE) {
+            stage->is_out_of_memory = TRUE;
+        }
+    }
+    stage->result = end_first_pass(&state);
+    return NULL;
+}
+
+/**
+ * Pushes the expanded lines that are complete to a ring, split exactly as read_source_line splits them.
+ * A line is complete once its newline was expanded or it reached the maximum line length.
+ *
+ * @param ring Pointer to the ring to push the lines to
+ * @param expanded Pointer to the output buffer holding the expanded content
+ * @param position Pointer to the offset of the first line not pushed yet, advanced past the pushed lines
+ * @param line_number Pointer to the number of the last pushed line, advanced for every pushed line
+ * @param is_end TRUE if the expansion is done, so the last line is complete even without a newline
+ * @return void
+ */
+static void push_expanded_lines(LineRing *ring, OutputBuffer *expanded, size_t *position, int *line_number, int is_end) {
+    char line[MAX_LINE];
+
+    while (*position < expanded->length) {
+        SourceFile view;
+        size_t remaining = expanded->length - *position;
+        size_t window = remaining < MAX_LINE - 1 ? remaining : MAX_LINE - 1;
+
+        /* Wait for the rest of a partial line */
+        if (!is_end && window == remaining && memchr(expanded->data + *position, '\n', window) == NULL) {
+            return;
+        }
+
+        view_source_buffer(&view, expanded->data, expanded->length);
+        view.position = *position;
+        read_source_line(line, sizeof(line), &view);
+        *position = view.position;
+
+        push_line(ring, line, ++*line_number);
+    }
+}
+
+PipelineResult run_front_end_pipeline(SourceFile *source, OutputBuffer *expanded, MacroNode **head_of_macro_table,
+                                      FirstPassResult *result) {
+    LineRing expanded_lines, checked_lines;
+    ValidationStage validation;
+    EncodingStage encoding;
+    pthread_t validation_thread, encoding_thread;
+    MacroExpansion expansion;
+    SourceFile expanded_source;
+    char line[MAX_LINE] = {0};
+    size_t pushed = 0;
+    int number_of_line = 0, expanded_line_number = 0;
+    int preprocessing_error = ERROR_WAS_NOT_FOUND, first_pass_error = ERROR_WAS_NOT_FOUND;
+    int is_out_of_memory = FALSE;
+    int i;
+
+    /* Without the rings, the stages run one after another instead */
+    if (init_line_ring(&expanded_lines) == FALSE) {
+        return PIPELINE_UNAVAILABLE;
+    }
+    if (init_line_ring(&checked_lines) == FALSE) {
+        free_line_ring(&expanded_lines);
+        return PIPELINE_UNAVAILABLE;
+    }
+    validation.input = &expanded_lines;
+    validation.output = &checked_lines;
+    validation.line_errors = NULL;
+    validation.number_of_lines = 0;
+    validation.capacity = 0;
+    validation.is_out_of_memory = FALSE;
+    validation.sink = current_diagnostics_sink();
+    validation.report = current_diagnostic_report();
+    encoding.input = &checked_lines;
+    encoding.is_out_of_memory = FALSE;
+    encoding.sink = current_diagnostics_sink();
+    encoding.report = current_diagnostic_report();
+
+    /* Start the stages that consume the expanded lines */
+    if (pthread_create(&encoding_thread, NULL, run_encoding_stage, &encoding) != 0) {
+        free_line_ring(&expanded_lines);
+        free_line_ring(&checked_lines);
+        return PIPELINE_UNAVAILABLE;
+    }
+    if (pthread_create(&validation_thread, NULL, run_validation_stage, &validation) != 0) {
+        close_line_ring(&checked_lines);
+        pthread_join(encoding_thread, NULL);
+        free_first_pass_result(&encoding.result);
+        free_line_ring(&expanded_lines);
+        free_line_ring(&checked_lines);
+        return PIPELINE_UNAVAILABLE;
+    }
+
+    /* Check and expand the source line by line, feeding the expanded lines to the next stage.
+     * Once a preprocessing error is found, the remaining lines are only checked */
+    begin_macro_expansion(&expansion);
+    while (!is_out_of_memory && read_source_line(line, sizeof(line), source)) {
+        number_of_line++;
+        if (check_preprocessing_line(line, number_of_line) == ERROR_FOUND) {
+            preprocessing_error = ERROR_FOUND;
+        }
+        if (preprocessing_error == ERROR_WAS_NOT_FOUND) {
+            is_out_of_memory = expand_macro_line(&expansion, line, expanded) == FALSE;
+            push_expanded_lines(&expanded_lines, expanded, &pushed, &expanded_line_number, FALSE);
+        }
+    }
+    if (preprocessing_error == ERROR_WAS_NOT_FOUND && !is_out_of_memory) {
+        push_expanded_lines(&expanded_lines, expanded, &pushed, &expanded_line_number, TRUE);
+    }
+    close_line_ring(&expanded_lines);
+
+    pthread_join(validation_thread, NULL);
+    pthread_join(encoding_thread, NULL);
+    free_line_ring(&expanded_lines);
+    free_line_ring(&checked_lines);
+
+    /* Abandon the source if any stage ran out of memory */
+    if (is_out_of_memory || validation.is_out_of_memory || encoding.is_out_of_memory) {
+        free(validation.line_errors);
+        free_first_pass_result(&encoding.result);
+        free_macro_nodes(expansion.head_of_macro_table);
+        return PIPELINE_OUT_OF_MEMORY;
+    }
+
+    /* Report the first pass errors in line order, now that the macro table is complete */
+    if (preprocessing_error == ERROR_WAS_NOT_FOUND) {
+        view_source_buffer(&expanded_source, expanded->data, expanded->length);
+        for (i = 0; i < validation.number_of_lines && read_source_line(line, sizeof(line), &expanded_source); i++) {
+            if (report_first_pass_line_errors(line, i + 1, expansion.head_of_macro_table,
+                                              validation.line_errors[i]) == ERROR_FOUND) {
+                first_pass_error = ERROR_FOUND;
+            }
+        }
+    }
+    free(validation.line_errors);
+
+    /* The first pass result only counts if every line was valid */
+    if (preprocessing_error == ERROR_FOUND || first_pass_error == ERROR_FOUND) {
+        free_first_pass_result(&encoding.result);
+    }
+
+    if (preprocessing_error == ERROR_FOUND) {
+        free_macro_nodes(expansion.head_of_macro_table);
+        return PIPELINE_PREPROCESSING_ERRORS;
+    }
+
+    *head_of_macro_table = expansion.head_of_macro_table;
+    if (first_pass_error == ERROR_FOUND) {
+        return PIPELINE_FIRST_PASS_ERRORS;
+    }
+    *result = encoding.result;
+    return PIPELINE_FIRST_PASS_DONE;
+}
@@ -0,0 +1,34 @@
+#ifndef FRONT_END_PIPELINE_H
+#define FRONT_END_PIPELINE_H
+
+#include "first_second_pass.h"
+
+/**
+ * Represents how far the front end of the assembly got.
+ */
+typedef enum {
+    PIPELINE_UNAVAILABLE, /* The stage threads could not be started, nothing was done */
+    PIPELINE_PREPROCESSING_ERRORS, /* Errors were found in the preprocessing */
+    PIPELINE_FIRST_PASS_ERRORS, /* The source was expanded, and errors were found in the first pass checks */
+    PIPELINE_FIRST_PASS_DONE, /* The source was expanded and the first pass is done */
+    PIPELINE_OUT_OF_MEMORY /* Memory ran out, nothing is left to free */
+} PipelineResult;
+
+/**
+ * Runs the front end of the assembly of one source - preprocessing, the first pass checks and the first pass -
+ * as three concurrent stages connected by lock-free rings of lines. The calling thread checks and expands
+ * the macros, a second thread checks every expanded line, and a third thread runs the first pass over the
+ * lines checked so far, until the first error is found. The checks that need the complete macro table
+ * are made once the expansion is done, so the diagnostics are the same as running the stages one after another.
+ * The stage threads report their diagnostics to the sink of the calling thread.
+ *
+ * @param source Pointer to the source file
+ * @param expanded Pointer to the output buffer to store the expanded content
+ * @param head_of_macro_table Pointer to where the head of the macro table is stored, unless preprocessing errors were found
+ * @param result Pointer to where the result of the first pass is stored, if it is done
+ * @return PipelineResult How far the front end got
+ */
+PipelineResult run_front_end_pipeline(SourceFile *source, OutputBuffer *expanded, MacroNode **head_of_macro_table,
+                                      FirstPassResult *result);
+
+#endif
@@ -0,0 +1,164 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <string.h>
+#include "first_second_pass.h"
+#include "build_binary_word.h"
+#include "instruction_encoder.h"
+
+/**
+ * Finds the command of a line, after its label if it has one.
+ *
+ * @param line The line
+ * @param line_copy Buffer that receives a copy of the line, the command points into it
+ * @param operands Pointer to set to the text after the command, or NULL if there is none
+ * @return char* Pointer to the command, or NULL if the line has none
+ */
+static char *find_command(const char *line, char line_copy[MAX_LINE], char **operands) {
+    char *command;
+    char *save_pointer;
+
+    strcpy(line_copy, line);
+    if (is_symbol(line_copy) == TRUE) {
+        strtok_r(line_copy, ":", &save_pointer);
+        command = strtok_r(NULL, " \n\t", &save_pointer);
+    } else {
+        command = strtok_r(line_copy, " \n\t", &save_pointer);
+    }
+    *operands = command != NULL ? strtok_r(NULL, "", &save_pointer) : NULL;
+    return command;
+}
+
+/**
+ * Checks the symbols a line uses against the resolver, as check_line_errors_second_pass does
+ * with the symbol table.
+ *
+ * @param line The line
+ * @param resolver The function resolving the symbols
+ * @param context Passed to the resolver
+ * @return ErrorCode ERR_SYMBOL_NOT_FOUND if the resolver does not define a symbol the line uses, NO_ERROR otherwise
+ */
+static ErrorCode check_symbols_resolved(const char *line, SymbolResolver resolver, void *context) {
+    char symbols[MAX_OPERANDS][MAX_LINE];
+    int number_of_symbols = find_second_pass_symbols((char *) line, symbols);
+    int address, is_external;
+    int i;
+
+    for (i = 0; i < number_of_symbols; i++) {
+        if (resolver(symbols[i], context, &address, &is_external) == FALSE) {
+            return ERR_SYMBOL_NOT_FOUND;
+        }
+    }
+    return NO_ERROR;
+}
+
+/**
+ * Resolves the symbol words of an instruction in operand order, the way create_missing_word_second_pass does.
+ * The words of the symbols the resolver does not define are left unresolved.
+ *
+ * @param line The instruction line
+ * @param address The address of the first word of the instruction
+ * @param resolver The function resolving the symbols
+ * @param context Passed to the resolver
+ * @param encoded Pointer to the encoded instruction, its symbol words are unresolved
+ * @return void
+ */
+static void resolve_symbol_words(const char *line, int address, SymbolResolver resolver, void *context,
+                                 EncodedInstruction *encoded) {
+    char line_copy[MAX_LINE] = {0};
+    char *operands[MAX_OPERANDS];
+    char word[WORD_SIZE + 1];
+    int number_of_operands_in_line = split_instruction_operands((char *) line, line_copy, operands);
+    int slot = 1;
+    int i;
+
+    for (i = 0; i < number_of_operands_in_line; i++) {
+        AddressingCase addressing_mode = get_operand_addressing_mode(operands[i]);
+        char *symbol_name = addressing_mode == RELATIVE_ADDRESSING ? operands[i] + 1 : operands[i];
+        int symbol_address, is_external;
+
+        if (addressing_mode != DIRECT_ADDRESSING && addressing_mode != RELATIVE_ADDRESSING) {
+            continue;
+        }
+
+        /* Every symbol operand fills the next unresolved word */
+        while (slot < encoded->number_of_words && !encoded->is_unresolved[slot]) {
+            slot++;
+        }
+        if (slot == encoded->number_of_words) {
+            return;
+        }
+
+        if (resolver(symbol_name, context, &symbol_address, &is_external) == FALSE) {
+            slot++;
+            continue;
+        }
+        if (addressing_mode == DIRECT_ADDRESSING) {
+            write_word_second_pass(symbol_address, DIRECT_ADDRESSING, is_external, word);
+        } else {
+            write_word_second_pass(symbol_address - address, RELATIVE_ADDRESSING, FALSE, word);
+        }
+        encoded->words[slot] = binary_word_value(word);
+        encoded->is_unresolved[slot++] = FALSE;
+    }
+}
+
+int encode_instruction(const char *line, int address, SymbolResolver resolver, void *context,
+                       EncodedInstruction *encoded) {
+    char line_copy[MAX_LINE] = {0};
+    char word[WORD_SIZE + 1];
+    char *command, *operands, *operator;
+    char *save_pointer;
+
+    encoded->number_of_words = 0;
+    encoded->number_of_errors = 0;
+
+    /* Check the line as the first pass does, a line that is too long is not checked further */
+    if (strlen(line) > MAX_LINE - 1) {
+        encoded->errors[encoded->number_of_errors++] = ERR_LINE_TOO_LONG;
+        return FALSE;
+    }
+    strcpy(line_copy, line);
+    encoded->number_of_errors = find_first_pass_line_errors(line_copy, NULL, check_line_errors_first_pass(line_copy),
+                                                            encoded->errors);
+    if (encoded->number_of_errors > 0) {
+        return FALSE;
+    }
+
+    /* Check the symbols the line uses as the second pass does, once the line itself is valid */
+    if (resolver != NULL && check_symbols_resolved(line, resolver, context) == ERR_SYMBOL_NOT_FOUND) {
+        encoded->errors[encoded->number_of_errors++] = ERR_SYMBOL_NOT_FOUND;
+    }
+
+    command = find_command(line, line_copy, &operands);
+    if (command == NULL || command[0] == ';' || is_directive(command) == TRUE) {
+        return encoded->number_of_errors == 0;
+    }
+
+    /* The first word, then a word for every operand that is not a register, as the first pass builds them */
+    strcpy(line_copy, line);
+    if (write_first_word(line_copy, is_symbol(line_copy), word) == FALSE) {
+        encoded->errors[encoded->number_of_errors++] = ERR_UNDEFINED_COMMAND;
+        return FALSE;
+    }
+    encoded->words[encoded->number_of_words] = binary_word_value(word);
+    encoded->is_unresolved[encoded->number_of_words++] = FALSE;
+
+    command = find_command(line, line_copy, &operands);
+    if (number_of_operands(command) > 0 && operands != NULL) {
+        for (operator = strtok_r(operands, " ,\n", &save_pointer);
+             operator != NULL && encoded->number_of_words < MAX_INSTRUCTION_WORDS;
+             operator = strtok_r(NULL, " ,\n", &save_pointer)) {
+            if (is_register(operator) == TRUE) {
+                continue;
+            }
+            write_extra_word(operator, INSTRUCTION, word);
+            encoded->is_unresolved[encoded->number_of_words] = word[0] == '?';
+            encoded->words[encoded->number_of_words++] = word[0] == '?' ? 0 : binary_word_value(word);
+        }
+    }
+
+    if (resolver != NULL) {
+        resolve_symbol_words(line, address, resolver, context, encoded);
+    }
+    return encoded->number_of_errors == 0;
+}
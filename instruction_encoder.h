@@ -0,0 +1,47 @@
+#ifndef INSTRUCTION_ENCODER_H
+#define INSTRUCTION_ENCODER_H
+
+#include "error_handler.h"
+
+/**
+ * Resolves a symbol an instruction uses, the way the symbol table does in the second pass.
+ *
+ * @param symbol_name The name of the symbol
+ * @param context The context given to encode_instruction
+ * @param address Pointer to set to the address of the symbol
+ * @param is_external Pointer to set to TRUE if the symbol is external, FALSE otherwise
+ * @return int TRUE if the symbol is defined, FALSE otherwise
+ */
+typedef int (*SymbolResolver)(const char *symbol_name, void *context, int *address, int *is_external);
+
+/**
+ * Holds the words and the errors of one encoded instruction.
+ */
+typedef struct {
+    unsigned long words[MAX_INSTRUCTION_WORDS]; /* The packed 24-bit words, the first word first */
+    int number_of_words; /* The number of words, 0 for a line that is not an instruction */
+    int is_unresolved[MAX_INSTRUCTION_WORDS]; /* TRUE for a word naming a symbol that was not resolved, left 0 */
+    ErrorCode errors[MAX_LINE_ERRORS]; /* The errors the assembler reports for the line */
+    int number_of_errors; /* The number of errors */
+} EncodedInstruction;
+
+/**
+ * Encodes one instruction line into its packed words, with the rules of the first and second pass
+ * (write_first_word, write_extra_word and write_word_second_pass), without allocating memory.
+ * The line is checked first, as the first pass checks it, and is only encoded if it has no error.
+ * An empty line, a comment or a directive encodes to no words, and a command that is not an instruction
+ * is reported as ERR_UNDEFINED_COMMAND.
+ * A symbol the resolver does not define is reported as ERR_SYMBOL_NOT_FOUND, as the second pass does,
+ * and its word is left unresolved; without a resolver, every symbol word is left unresolved without an error.
+ *
+ * @param line The line, at most MAX_LINE - 1 characters long
+ * @param address The address of the first word of the instruction, which relative addressing counts from
+ * @param resolver The function resolving the symbols of the line, or NULL to leave them unresolved
+ * @param context Passed to the resolver
+ * @param encoded Pointer to the encoded instruction to fill
+ * @return int TRUE if the line has no error, FALSE otherwise
+ */
+int encode_instruction(const char *line, int address, SymbolResolver resolver, void *context,
+                       EncodedInstruction *encoded);
+
+#endif
@@ -0,0 +1,690 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "macro_data.h"
+#include "io_backend.h"
+#include "diagnostics.h"
+
+/* io_uring is only used when the kernel headers describe it */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IO_URING_AVAILABLE
+#endif
+#endif
+
+#ifdef IO_URING_AVAILABLE
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+/**
+ * Transfers the rest of a request synchronously with plain POSIX calls,
+ * retrying after partial transfers and interrupts.
+ *
+ * @param request Pointer to the request to complete
+ * @return void
+ */
+static void transfer_synchronously(IoRequest *request) {
+    /* A request whose bytes could not be moved away from the kernel stays failed */
+    if (request->status == IO_FAILED) {
+        return;
+    }
+
+    while (request->done < request->size) {
+        size_t chunk = request->size - request->done;
+        ssize_t transferred;
+
+        if (chunk > IO_MAX_TRANSFER) {
+            chunk = IO_MAX_TRANSFER;
+        }
+
+        if (request->is_write) {
+            transferred = pwrite(request->fd, request->data + request->done, chunk, (off_t)request->done);
+        } else {
+            transferred = pread(request->fd, request->data + request->done, chunk, (off_t)request->done);
+        }
+
+        if (transferred < 0 && errno == EINTR) {
+            continue;
+        }
+        /* A read that ends early means the file shrank while it was read */
+        if (transferred <= 0) {
+            request->status = IO_FAILED;
+            return;
+        }
+        request->done += (size_t)transferred;
+    }
+    request->status = IO_DONE;
+}
+
+/**
+ * Creates a request and appends it to the end of the backend queue.
+ *
+ * @param backend Pointer to the I/O backend
+ * @param file_name The name of the file, copied into the request
+ * @param is_write TRUE for a write, FALSE for a read
+ * @return IoRequest* Pointer to the new request, or NULL if memory ran out
+ */
+static IoRequest *append_request(IoBackend *backend, char *file_name, int is_write) {
+    IoRequest *request = (IoRequest *) malloc(sizeof(IoRequest));
+    IoRequest **last = &backend->head;
+
+    /* Check if memory allocation was successful */
+    if (check_memory_allocation(request) == FALSE) {
+        return NULL;
+    }
+
+    request->file_name = (char *) malloc(strlen(file_name) + 1);
+    if (check_memory_allocation(request->file_name) == FALSE) {
+        free(request);
+        return NULL;
+    }
+    strcpy(request->file_name, file_name);
+
+    request->is_write = is_write;
+    request->fd = -1;
+    request->data = NULL;
+    request->size = 0;
+    request->done = 0;
+    request->status = IO_PENDING;
+    request->in_flight = FALSE;
+    request->next = NULL;
+
+    while (*last != NULL) {
+        last = &(*last)->next;
+    }
+    *last = request;
+    return request;
+}
+
+/**
+ * Closes the file of a request and removes the request from the backend queue.
+ * The bytes of the request are freed unless free_data is FALSE.
+ *
+ * @param backend Pointer to the I/O backend
+ * @param request Pointer to the request to remove
+ * @param free_data TRUE to free the bytes of the request, FALSE if they were handed over
+ * @return void
+ */
+static void remove_request(IoBackend *backend, IoRequest *request, int free_data) {
+    IoRequest **link = &backend->head;
+
+    while (*link != request) {
+        link = &(*link)->next;
+    }
+    *link = request->next;
+
+    if (request->fd != -1) {
+        close(request->fd);
+    }
+    if (free_data) {
+        free(request->data);
+    }
+    free(request->file_name);
+    free(request);
+}
+
+/**
+ * Closes a finished write, recording and reporting a failure.
+ *
+ * @param backend Pointer to the I/O backend
+ * @param request Pointer to the finished write
+ * @return void
+ */
+static void complete_write(IoBackend *backend, IoRequest *request) {
+    int close_result = close(request->fd);
+
+    request->fd = -1;
+    if (request->status == IO_FAILED || close_result != 0) {
+        report_diagnostic("Error writing file: %s\n", request->file_name);
+        backend->error_flag = ERROR_FOUND;
+    }
+    remove_request(backend, request, TRUE);
+}
+
+#ifdef IO_URING_AVAILABLE
+
+/**
+ * Sets up an io_uring instance and maps its submission and completion rings.
+ *
+ * @param backend Pointer to the I/O backend to set up
+ * @return int TRUE if the ring is ready, FALSE if the kernel does not provide io_uring
+ */
+static int setup_ring(IoBackend *backend) {
+    struct io_uring_params params;
+    char *submission_ring, *completion_ring;
+    int ring_fd;
+
+    memset(&params, 0, sizeof(params));
+    ring_fd = (int)syscall(__NR_io_uring_setup, IO_QUEUE_DEPTH, &params);
+    if (ring_fd < 0) {
+        return FALSE;
+    }
+
+    backend->submission_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    backend->completion_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    backend->submission_entries_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    /* Newer kernels share one mapping between both rings */
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (backend->completion_ring_size > backend->submission_ring_size) {
+            backend->submission_ring_size = backend->completion_ring_size;
+        }
+        backend->completion_ring_size = 0;
+    }
+
+    submission_ring = mmap(NULL, backend->submission_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                           ring_fd, IORING_OFF_SQ_RING);
+    if (submission_ring == MAP_FAILED) {
+        close(ring_fd);
+        return FALSE;
+    }
+
+    if (backend->completion_ring_size == 0) {
+        completion_ring = submission_ring;
+    } else {
+        completion_ring = mmap(NULL, backend->completion_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                               ring_fd, IORING_OFF_CQ_RING);
+        if (completion_ring == MAP_FAILED) {
+            munmap(submission_ring, backend->submission_ring_size);
+            close(ring_fd);
+            return FALSE;
+        }
+    }
+
+    backend->submission_entries = mmap(NULL, backend->submission_entries_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                       ring_fd, IORING_OFF_SQES);
+    if (backend->submission_entries == MAP_FAILED) {
+        if (completion_ring != submission_ring) {
+            munmap(completion_ring, backend->completion_ring_size);
+        }
+        munmap(submission_ring, backend->submission_ring_size);
+        close(ring_fd);
+        return FALSE;
+    }
+
+    backend->ring_fd = ring_fd;
+    backend->submission_ring = submission_ring;
+    backend->completion_ring = completion_ring;
+    backend->submission_head = (unsigned *)(submission_ring + params.sq_off.head);
+    backend->submission_tail = (unsigned *)(submission_ring + params.sq_off.tail);
+    backend->submission_mask = (unsigned *)(submission_ring + params.sq_off.ring_mask);
+    backend->submission_array = (unsigned *)(submission_ring + params.sq_off.array);
+    backend->completion_head = (unsigned *)(completion_ring + params.cq_off.head);
+    backend->completion_tail = (unsigned *)(completion_ring + params.cq_off.tail);
+    backend->completion_mask = (unsigned *)(completion_ring + params.cq_off.ring_mask);
+    backend->completion_entries = completion_ring + params.cq_off.cqes;
+    return TRUE;
+}
+
+/**
+ * Adds the next chunk of a request to the submission ring. The kernel sees it on the next io_uring_enter.
+ *
+ * @param backend Pointer to the I/O backend
+ * @param request Pointer to the request to submit
+ * @return void
+ */
+static void push_request(IoBackend *backend, IoRequest *request) {
+    struct io_uring_sqe *entry;
+    size_t chunk = request->size - request->done;
+    unsigned tail = *backend->submission_tail;
+    unsigned index = tail & *backend->submission_mask;
+
+    if (chunk > IO_MAX_TRANSFER) {
+        chunk = IO_MAX_TRANSFER;
+    }
+
+    entry = (struct io_uring_sqe *)backend->submission_entries + index;
+    memset(entry, 0, sizeof(*entry));
+    entry->opcode = request->is_write ? IORING_OP_WRITE : IORING_OP_READ;
+    entry->fd = request->fd;
+    entry->addr = (unsigned long)(request->data + request->done);
+    entry->len = (unsigned)chunk;
+    entry->off = request->done;
+    entry->user_data = (unsigned long)request;
+    backend->submission_array[index] = index;
+
+    /* Publish the entry before the new tail */
+    __atomic_store_n(backend->submission_tail, tail + 1, __ATOMIC_RELEASE);
+
+    request->in_flight = TRUE;
+    backend->in_flight++;
+    backend->to_submit++;
+}
+
+/**
+ * Adds every queued request that is not in flight yet to the submission ring, as long as there is room.
+ *
+ * @param backend Pointer to the I/O backend
+ * @return void
+ */
+static void push_pending_requests(IoBackend *backend) {
+    IoRequest *request;
+
+    for (request = backend->head; request != NULL && backend->in_flight < IO_QUEUE_DEPTH; request = request->next) {
+        if (request->status == IO_PENDING && !request->in_flight) {
+            push_request(backend, request);
+        }
+    }
+}
+
+/**
+ * Unmaps the rings of the io_uring instance and closes it, leaving the backend on the POSIX fallback.
+ * The kernel must not hold any request any more, see drain_ring: every request is left pending
+ * for its remaining bytes to be transferred the plain way.
+ *
+ * @param backend Pointer to the I/O backend
+ * @return void
+ */
+static void release_ring(IoBackend *backend) {
+    IoRequest *request;
+
+    munmap(backend->submission_entries, backend->submission_entries_size);
+    if (backend->completion_ring != backend->submission_ring) {
+        munmap(backend->completion_ring, backend->completion_ring_size);
+    }
+    munmap(backend->submission_ring, backend->submission_ring_size);
+    close(backend->ring_fd);
+    backend->ring_fd = -1;
+
+    for (request = backend->head; request != NULL; request = request->next) {
+        request->in_flight = FALSE;
+    }
+    backend->in_flight = 0;
+    backend->to_submit = 0;
+}
+
+/**
+ * Takes back the entries of the submission ring the kernel has not consumed. Their requests never reached
+ * the kernel and are left pending.
+ *
+ * @param backend Pointer to the I/O backend
+ * @return void
+ */
+static void retract_submissions(IoBackend *backend) {
+    unsigned head = __atomic_load_n(backend->submission_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *backend->submission_tail;
+    unsigned position;
+
+    for (position = head; position != tail; position++) {
+        unsigned index = backend->submission_array[position & *backend->submission_mask];
+        struct io_uring_sqe *entry = (struct io_uring_sqe *)backend->submission_entries + index;
+        IoRequest *request = (IoRequest *)(unsigned long)entry->user_data;
+
+        /* Cancellations have no request */
+        if (request != NULL) {
+            request->in_flight = FALSE;
+            backend->in_flight--;
+        }
+    }
+    __atomic_store_n(backend->submission_tail, head, __ATOMIC_RELEASE);
+    backend->to_submit = 0;
+}
+
+/**
+ * Adds a cancellation of every request in flight to the submission ring, so that the kernel gives them
+ * back sooner. A cancelled request completes with -ECANCELED and is left pending.
+ *
+ * @param backend Pointer to the I/O backend
+ * @return void
+ */
+static void push_cancellations(IoBackend *backend) {
+    IoRequest *request;
+
+    for (request = backend->head; request != NULL; request = request->next) {
+        struct io_uring_sqe *entry;
+        unsigned tail = *backend->submission_tail;
+        unsigned index = tail & *backend->submission_mask;
+
+        if (!request->in_flight) {
+            continue;
+        }
+        if (tail - __atomic_load_n(backend->submission_head, __ATOMIC_ACQUIRE) > *backend->submission_mask) {
+            return;
+        }
+
+        entry = (struct io_uring_sqe *)backend->submission_entries + index;
+        memset(entry, 0, sizeof(*entry));
+        entry->opcode = IORING_OP_ASYNC_CANCEL;
+        entry->fd = -1;
+        entry->addr = (unsigned long)request;
+        entry->user_data = 0;
+        backend->submission_array[index] = index;
+        __atomic_store_n(backend->submission_tail, tail + 1, __ATOMIC_RELEASE);
+        backend->to_submit++;
+    }
+}
+
+/**
+ * Moves the bytes of a request the kernel may still hold to a buffer of its own, so that they can be
+ * transferred the plain way. The old buffer is left to the kernel for good, as it may still read or fill it.
+ *
+ * @param request Pointer to the request
+ * @return void
+ */
+static void abandon_request_data(IoRequest *request) {
+    char *data = (char *) malloc(request->size);
+
+    if (check_memory_allocation(data) == FALSE) {
+        request->status = IO_FAILED;
+    } else {
+        memcpy(data, request->data, request->is_write ? request->size : request->done);
+    }
+    request->data = data;
+}
+
+/**
+ * Handles every completion in the completion ring. A partial transfer is pushed again for its remaining bytes,
+ * and a finished write is closed and released.
+ *
+ * @param backend Pointer to the I/O backend
+ * @return void
+ */
+static void reap_completions(IoBackend *backend) {
+    unsigned head = *backend->completion_head;
+
+    while (head != __atomic_load_n(backend->completion_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe *completion = (struct io_uring_cqe *)backend->completion_entries
+                                          + (head & *backend->completion_mask);
+        IoRequest *request = (IoRequest *)(unsigned long)completion->user_data;
+        int result = completion->res;
+
+        head++;
+
+        /* A cancellation has no request, the request it cancels completes on its own */
+        if (request == NULL) {
+            continue;
+        }
+        request->in_flight = FALSE;
+        backend->in_flight--;
+
+        if (result == -EINVAL || result == -EOPNOTSUPP) {
+            /* The kernel has io_uring but not these operations, finish the request the plain way */
+            transfer_synchronously(request);
+        } else if (result == -EINTR || result == -EAGAIN || result == -ECANCELED) {
+            /* Left pending to be pushed again, or transferred the plain way once the ring is released */
+        } else if (result <= 0) {
+            request->status = IO_FAILED;
+        } else {
+            request->done += (size_t)result;
+            if (request->done == request->size) {
+                request->status = IO_DONE;
+            }
+        }
+
+        if (request->is_write && request->status != IO_PENDING) {
+            complete_write(backend, request);
+        }
+    }
+    __atomic_store_n(backend->completion_head, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * Gets back every request the kernel holds before the ring is released: the entries it has not consumed
+ * are taken back, the requests in flight are cancelled, and their completions are waited for.
+ * If the kernel cannot even be waited on, the bytes of the requests it still holds are moved away from it,
+ * see abandon_request_data.
+ *
+ * @param backend Pointer to the I/O backend
+ * @return void
+ */
+static void drain_ring(IoBackend *backend) {
+    IoRequest *request;
+    int is_waiting = TRUE;
+
+    retract_submissions(backend);
+    push_cancellations(backend);
+    reap_completions(backend);
+    while (backend->in_flight > 0 && is_waiting) {
+        if (syscall(__NR_io_uring_enter, backend->ring_fd, backend->to_submit, 1, IORING_ENTER_GETEVENTS,
+                    NULL, 0) >= 0) {
+            backend->to_submit = 0;
+        } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            is_waiting = FALSE;
+        }
+        reap_completions(backend);
+    }
+
+    for (request = backend->head; request != NULL; request = request->next) {
+        if (request->in_flight) {
+            abandon_request_data(request);
+        }
+    }
+}
+
+/**
+ * Hands the new submission entries to the kernel and optionally waits for completions.
+ * If the kernel refuses the ring for good, the requests are drained from it, the ring is released
+ * and the backend falls back to POSIX calls.
+ *
+ * @param backend Pointer to the I/O backend
+ * @param wait_for The number of completions to wait for
+ * @return int TRUE if the ring is still in use, FALSE if the backend fell back to POSIX calls
+ */
+static int enter_ring(IoBackend *backend, unsigned wait_for) {
+    unsigned flags = wait_for > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+    while (syscall(__NR_io_uring_enter, backend->ring_fd, backend->to_submit, wait_for, flags, NULL, 0) < 0) {
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            drain_ring(backend);
+            release_ring(backend);
+            return FALSE;
+        }
+    }
+    backend->to_submit = 0;
+    return TRUE;
+}
+
+#endif
+
+void init_io_backend(IoBackend *backend) {
+    memset(backend, 0, sizeof(*backend));
+    backend->ring_fd = -1;
+    backend->head = NULL;
+    backend->error_flag = ERROR_WAS_NOT_FOUND;
+
+#ifdef IO_URING_AVAILABLE
+    /* Without io_uring the backend stays on the POSIX fallback */
+    setup_ring(backend);
+#endif
+}
+
+/**
+ * Queues a read of a whole file. A file that cannot be opened, or whose bytes do not fit in memory,
+ * gives a request that already failed.
+ *
+ * @param backend Pointer to the I/O backend
+ * @param file_name The name of the file to read
+ * @return IoRequest* Pointer to the new request, or NULL if memory ran out
+ */
+static IoRequest *queue_read(IoBackend *backend, char *file_name) {
+    IoRequest *request = append_request(backend, file_name, FALSE);
+    struct stat file_status;
+
+    if (request == NULL) {
+        return NULL;
+    }
+
+    request->fd = open(file_name, O_RDONLY);
+    if (request->fd == -1 || fstat(request->fd, &file_status) == -1) {
+        request->status = IO_FAILED;
+        return request;
+    }
+
+    request->size = (size_t)file_status.st_size;
+    if (request->size == 0) {
+        request->status = IO_DONE;
+        return request;
+    }
+
+    request->data = (char *) malloc(request->size);
+    if (check_memory_allocation(request->data) == FALSE) {
+        request->status = IO_FAILED;
+    }
+    return request;
+}
+
+void queue_file_read(IoBackend *backend, char *file_name) {
+    /* A read that could not be queued is queued again when the file is taken */
+    queue_read(backend, file_name);
+}
+
+int take_file_read(IoBackend *backend, char *file_name, SourceFile *source) {
+    IoRequest *request;
+    int is_read;
+
+    source->data = NULL;
+    source->size = 0;
+    source->position = 0;
+    source->storage = SOURCE_HEAP;
+
+    /* Find the oldest read of the file, queue it now if it was not read ahead */
+    for (request = backend->head; request != NULL; request = request->next) {
+        if (!request->is_write && strcmp(request->file_name, file_name) == 0) {
+            break;
+        }
+    }
+    if (request == NULL) {
+        request = queue_read(backend, file_name);
+        if (request == NULL) {
+            return FALSE;
+        }
+    }
+
+    /* Wait for the read, while the other requests keep moving */
+    while (request->status == IO_PENDING) {
+#ifdef IO_URING_AVAILABLE
+        if (backend->ring_fd != -1) {
+            push_pending_requests(backend);
+            if (enter_ring(backend, backend->in_flight > 0 ? 1 : 0)) {
+                reap_completions(backend);
+            }
+            continue;
+        }
+#endif
+        transfer_synchronously(request);
+    }
+
+    is_read = request->status == IO_DONE;
+    if (is_read) {
+        source->data = request->data;
+        source->size = request->size;
+    }
+    remove_request(backend, request, !is_read);
+    return is_read;
+}
+
+int queue_file_write(IoBackend *backend, char *file_name, OutputBuffer *buffer) {
+    IoRequest *request;
+    int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (fd == -1) {
+        report_diagnostic("Error opening file: %s\n", file_name);
+        return FALSE;
+    }
+
+    /* Take over the bytes of the buffer, leaving it empty */
+    request = append_request(backend, file_name, TRUE);
+    if (request == NULL) {
+        close(fd);
+        return FALSE;
+    }
+    request->fd = fd;
+    request->data = buffer->data;
+    request->size = buffer->length;
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+
+    if (request->size == 0) {
+        request->status = IO_DONE;
+        complete_write(backend, request);
+    }
+    return TRUE;
+}
+
+void submit_io(IoBackend *backend) {
+    IoRequest *request, *next;
+
+#ifdef IO_URING_AVAILABLE
+    if (backend->ring_fd != -1) {
+        push_pending_requests(backend);
+        if (backend->to_submit == 0 || enter_ring(backend, 0)) {
+            reap_completions(backend);
+            return;
+        }
+    }
+#endif
+
+    /* The fallback performs the writes right away and leaves the reads for take_file_read */
+    for (request = backend->head; request != NULL; request = next) {
+        next = request->next;
+        if (request->is_write) {
+            transfer_synchronously(request);
+            complete_write(backend, request);
+        }
+    }
+}
+
+int finish_io(IoBackend *backend) {
+    IoRequest *request;
+    int writes_pending = TRUE;
+    int error_flag;
+
+    submit_io(backend);
+
+    /* Wait until no write is left in the queue */
+    while (writes_pending) {
+        writes_pending = FALSE;
+        for (request = backend->head; request != NULL; request = request->next) {
+            if (request->is_write) {
+                writes_pending = TRUE;
+            }
+        }
+#ifdef IO_URING_AVAILABLE
+        if (writes_pending && backend->ring_fd != -1) {
+            push_pending_requests(backend);
+            if (enter_ring(backend, backend->in_flight > 0 ? 1 : 0)) {
+                reap_completions(backend);
+            }
+            continue;
+        }
+#endif
+
+        /* Once the ring was released, the remaining writes are performed right away */
+        if (writes_pending) {
+            submit_io(backend);
+        }
+    }
+
+    /* Report every failure once */
+    error_flag = backend->error_flag;
+    backend->error_flag = ERROR_WAS_NOT_FOUND;
+    return error_flag;
+}
+
+void close_io_backend(IoBackend *backend) {
+    finish_io(backend);
+
+    /* The unclaimed reads must leave the kernel before their buffers are freed */
+#ifdef IO_URING_AVAILABLE
+    while (backend->ring_fd != -1 && backend->in_flight > 0) {
+        if (enter_ring(backend, 1)) {
+            reap_completions(backend);
+        }
+    }
+    if (backend->ring_fd != -1) {
+        release_ring(backend);
+    }
+#endif
+    while (backend->head != NULL) {
+        remove_request(backend, backend->head, TRUE);
+    }
+}
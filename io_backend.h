@@ -0,0 +1,121 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <stddef.h>
+#include "source_file.h"
+#include "output_buffer.h"
+
+#define IO_QUEUE_DEPTH 64 /* The largest number of requests in flight at once */
+#define IO_MAX_TRANSFER 1073741824 /* The largest number of bytes moved by a single request */
+
+/**
+ * Represents the state of a single file read or write.
+ */
+typedef enum {
+    IO_PENDING, /* Queued, not transferred yet */
+    IO_DONE, /* All the bytes were transferred */
+    IO_FAILED /* The transfer failed */
+} IoStatus;
+
+/**
+ * Represents a whole-file read or write that is queued on the I/O backend.
+ */
+typedef struct IoRequest {
+    int is_write; /* TRUE for a write, FALSE for a read */
+    char *file_name; /* The name of the file */
+    int fd; /* The open file descriptor */
+    char *data; /* The bytes to write, or the buffer being read into */
+    size_t size; /* The number of bytes to transfer */
+    size_t done; /* The number of bytes transferred so far */
+    IoStatus status; /* The state of the request */
+    int in_flight; /* TRUE while the request is submitted to the kernel */
+    struct IoRequest *next; /* Pointer to the next request in the queue */
+} IoRequest;
+
+/**
+ * Represents an I/O backend that reads input files ahead and writes output files in batches.
+ * It uses io_uring when the kernel provides it and falls back to plain POSIX reads and writes otherwise.
+ */
+typedef struct {
+    int ring_fd; /* The io_uring file descriptor, -1 for the POSIX fallback */
+    void *submission_ring; /* The mapped submission queue ring */
+    size_t submission_ring_size; /* The size of the submission queue ring mapping */
+    void *completion_ring; /* The mapped completion queue ring */
+    size_t completion_ring_size; /* The size of the completion queue ring mapping */
+    void *submission_entries; /* The mapped array of submission queue entries */
+    size_t submission_entries_size; /* The size of the submission queue entries mapping */
+    unsigned *submission_head, *submission_tail, *submission_mask, *submission_array;
+    unsigned *completion_head, *completion_tail, *completion_mask;
+    void *completion_entries; /* The array of completion queue entries inside the completion ring */
+    unsigned to_submit; /* The number of entries added to the ring since the last submit */
+    int in_flight; /* The number of requests submitted to the kernel */
+    IoRequest *head; /* The first request in the queue */
+    int error_flag; /* ERROR_FOUND once a write has failed */
+} IoBackend;
+
+/**
+ * Initializes an I/O backend, using io_uring if the kernel provides it.
+ *
+ * @param backend Pointer to the backend to initialize
+ * @return void
+ */
+void init_io_backend(IoBackend *backend);
+
+/**
+ * Queues a read of a whole file, so that it is read ahead while other files are assembled.
+ * The read is handed to the kernel on the next submit_io.
+ *
+ * @param backend Pointer to the I/O backend
+ * @param file_name The name of the file to read
+ * @return void
+ */
+void queue_file_read(IoBackend *backend, char *file_name);
+
+/**
+ * Waits for a queued read of a file to complete and hands its bytes over to a source file.
+ * The file is queued first if it was not queued before.
+ *
+ * @param backend Pointer to the I/O backend
+ * @param file_name The name of the file
+ * @param source Pointer to the source file to fill, its bytes are then owned by the source
+ * @return int TRUE if the file was read successfully, FALSE otherwise
+ */
+int take_file_read(IoBackend *backend, char *file_name, SourceFile *source);
+
+/**
+ * Queues a write of a whole file, replacing the file if it exists. The bytes of the buffer are
+ * taken over by the backend and the buffer is left empty. The write is handed to the kernel on the next submit_io.
+ *
+ * @param backend Pointer to the I/O backend
+ * @param file_name The name of the file to write
+ * @param buffer Pointer to the output buffer holding the content
+ * @return int TRUE if the file was created and the write was queued, FALSE otherwise
+ */
+int queue_file_write(IoBackend *backend, char *file_name, OutputBuffer *buffer);
+
+/**
+ * Hands all the queued requests to the kernel as a single batch, without waiting for them.
+ * With the POSIX fallback, the queued writes are performed right away.
+ *
+ * @param backend Pointer to the I/O backend
+ * @return void
+ */
+void submit_io(IoBackend *backend);
+
+/**
+ * Waits for all the queued writes to complete.
+ *
+ * @param backend Pointer to the I/O backend
+ * @return int ERROR_FOUND if any write failed since the previous call, ERROR_WAS_NOT_FOUND otherwise
+ */
+int finish_io(IoBackend *backend);
+
+/**
+ * Waits for all the queued requests, then releases the I/O backend and every unclaimed read.
+ *
+ * @param backend Pointer to the I/O backend
+ * @return void
+ */
+void close_io_backend(IoBackend *backend);
+
+#endif
@@ -0,0 +1,357 @@
+#include <string.h>
+#include "macro_data.h"
+#include "json_text.h"
+
+/**
+ * Skips the blanks of a text.
+ *
+ * @param data The text
+ * @param length The length of the text
+ * @param position The position to start from
+ * @return size_t The position of the first character that is not a blank, or length
+ */
+static size_t skip_blanks(const char *data, size_t length, size_t position) {
+    while (position < length &&
+           (data[position] == ' ' || data[position] == '\t' || data[position] == '\n' || data[position] == '\r')) {
+        position++;
+    }
+    return position;
+}
+
+/**
+ * Skips one JSON value of a text: a string, an object or an array with everything nested in it,
+ * or a number or a literal.
+ *
+ * @param data The text
+ * @param length The length of the text
+ * @param position Pointer to the position of the first character of the value, advanced past the value
+ * @return int TRUE if a whole value was skipped, FALSE if the text ends inside it or no value starts there
+ */
+static int skip_value(const char *data, size_t length, size_t *position) {
+    size_t i = *position;
+    int depth = 0;
+    int is_in_string = FALSE;
+
+    if (i >= length) {
+        return FALSE;
+    }
+
+    /* Numbers and literals run up to the next separator */
+    if (data[i] != '"' && data[i] != '{' && data[i] != '[') {
+        while (i < length && strchr(",:]} \t\r\n", data[i]) == NULL) {
+            i++;
+        }
+        if (i == *position) {
+            return FALSE;
+        }
+        *position = i;
+        return TRUE;
+    }
+
+    /* Strings, objects and arrays end where the brackets opened outside strings are closed */
+    for (; i < length; i++) {
+        char c = data[i];
+
+        if (is_in_string) {
+            if (c == '\\') {
+                i++;
+            } else if (c == '"') {
+                is_in_string = FALSE;
+                if (depth == 0) {
+                    *position = i + 1;
+                    return TRUE;
+                }
+            }
+        } else if (c == '"') {
+            is_in_string = TRUE;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            depth--;
+            if (depth == 0) {
+                *position = i + 1;
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+void json_view(JsonValue *value, const char *text, size_t length) {
+    size_t first = skip_blanks(text, length, 0);
+
+    while (length > first && strchr(" \t\r\n", text[length - 1]) != NULL) {
+        length--;
+    }
+    value->data = text + first;
+    value->length = length - first;
+}
+
+int json_member(JsonValue object, const char *key, JsonValue *member) {
+    const char *data = object.data;
+    size_t length = object.length;
+    size_t key_length = strlen(key);
+    size_t position;
+
+    if (length == 0 || data[0] != '{') {
+        return FALSE;
+    }
+
+    /* Every member is a string key, a colon and a value, and the members are separated by commas */
+    position = skip_blanks(data, length, 1);
+    while (position < length && data[position] == '"') {
+        size_t key_start = position + 1;
+        size_t value_start;
+        int is_key;
+
+        if (skip_value(data, length, &position) == FALSE) {
+            return FALSE;
+        }
+        is_key = position - 1 - key_start == key_length && memcmp(data + key_start, key, key_length) == 0;
+
+        position = skip_blanks(data, length, position);
+        if (position >= length || data[position] != ':') {
+            return FALSE;
+        }
+        value_start = skip_blanks(data, length, position + 1);
+        position = value_start;
+        if (skip_value(data, length, &position) == FALSE) {
+            return FALSE;
+        }
+        if (is_key) {
+            member->data = data + value_start;
+            member->length = position - value_start;
+            return TRUE;
+        }
+
+        position = skip_blanks(data, length, position);
+        if (position >= length || data[position] != ',') {
+            return FALSE;
+        }
+        position = skip_blanks(data, length, position + 1);
+    }
+    return FALSE;
+}
+
+int json_next_element(JsonValue array, size_t *position, JsonValue *element) {
+    const char *data = array.data;
+    size_t length = array.length;
+    size_t i = *position;
+    size_t start;
+
+    if (length == 0 || data[0] != '[') {
+        return FALSE;
+    }
+
+    /* The elements after the first one follow a comma */
+    if (i == 0) {
+        i = skip_blanks(data, length, 1);
+    } else {
+        i = skip_blanks(data, length, i);
+        if (i >= length || data[i] != ',') {
+            return FALSE;
+        }
+        i = skip_blanks(data, length, i + 1);
+    }
+    if (i >= length || data[i] == ']') {
+        return FALSE;
+    }
+
+    start = i;
+    if (skip_value(data, length, &i) == FALSE) {
+        return FALSE;
+    }
+    element->data = data + start;
+    element->length = i - start;
+    *position = i;
+    return TRUE;
+}
+
+/**
+ * Reads the four hexadecimal digits of a \u escape.
+ *
+ * @param digits The digits
+ * @param code Pointer to set to the code unit
+ * @return int TRUE if the four characters are hexadecimal digits, FALSE otherwise
+ */
+static int read_code_unit(const char *digits, unsigned long *code) {
+    int i;
+
+    *code = 0;
+    for (i = 0; i < 4; i++) {
+        char c = digits[i];
+
+        if (c >= '0' && c <= '9') {
+            *code = *code * 16 + (unsigned long)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            *code = *code * 16 + (unsigned long)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            *code = *code * 16 + (unsigned long)(c - 'A' + 10);
+        } else {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Appends a code point to an output buffer as UTF-8.
+ *
+ * @param text Pointer to the output buffer
+ * @param code The code point
+ * @return void
+ */
+static void append_utf8(OutputBuffer *text, unsigned long code) {
+    char bytes[4];
+    size_t length;
+
+    if (code < 0x80) {
+        bytes[0] = (char) code;
+        length = 1;
+    } else if (code < 0x800) {
+        bytes[0] = (char)(0xC0 | (code >> 6));
+        bytes[1] = (char)(0x80 | (code & 0x3F));
+        length = 2;
+    } else if (code < 0x10000) {
+        bytes[0] = (char)(0xE0 | (code >> 12));
+        bytes[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        bytes[2] = (char)(0x80 | (code & 0x3F));
+        length = 3;
+    } else {
+        bytes[0] = (char)(0xF0 | (code >> 18));
+        bytes[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+        bytes[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+        bytes[3] = (char)(0x80 | (code & 0x3F));
+        length = 4;
+    }
+    output_append(text, bytes, length);
+}
+
+int json_string(JsonValue value, OutputBuffer *text) {
+    const char *data = value.data;
+    size_t length = value.length;
+    size_t i;
+
+    if (length < 2 || data[0] != '"' || data[length - 1] != '"') {
+        return FALSE;
+    }
+
+    for (i = 1; i < length - 1; i++) {
+        size_t run = i;
+        unsigned long code, low;
+
+        /* Copy the characters up to the next escape at once */
+        while (run < length - 1 && data[run] != '\\') {
+            run++;
+        }
+        if (run > i) {
+            output_append(text, data + i, run - i);
+            i = run;
+            if (i == length - 1) {
+                break;
+            }
+        }
+        if (++i >= length - 1) {
+            return FALSE;
+        }
+        switch (data[i]) {
+            case 'b':
+                output_append(text, "\b", 1);
+                break;
+            case 'f':
+                output_append(text, "\f", 1);
+                break;
+            case 'n':
+                output_append(text, "\n", 1);
+                break;
+            case 'r':
+                output_append(text, "\r", 1);
+                break;
+            case 't':
+                output_append(text, "\t", 1);
+                break;
+            case 'u':
+                if (i + 4 >= length - 1 || read_code_unit(data + i + 1, &code) == FALSE) {
+                    return FALSE;
+                }
+                i += 4;
+
+                /* A character beyond the first plane is escaped as a pair of surrogates */
+                if (code >= 0xD800 && code < 0xDC00 && i + 6 < length - 1 && data[i + 1] == '\\' &&
+                    data[i + 2] == 'u' && read_code_unit(data + i + 3, &low) == TRUE && low >= 0xDC00 &&
+                    low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                append_utf8(text, code);
+                break;
+            default:
+                output_append(text, data + i, 1);
+                break;
+        }
+    }
+    return text->is_out_of_memory ? FALSE : TRUE;
+}
+
+int json_integer(JsonValue value, long *number) {
+    size_t i = 0;
+    int is_negative = FALSE;
+
+    if (value.length > 0 && value.data[0] == '-') {
+        is_negative = TRUE;
+        i++;
+    }
+    if (i == value.length) {
+        return FALSE;
+    }
+
+    *number = 0;
+    for (; i < value.length; i++) {
+        if (value.data[i] < '0' || value.data[i] > '9') {
+            return FALSE;
+        }
+        *number = *number * 10 + (value.data[i] - '0');
+    }
+    if (is_negative) {
+        *number = -*number;
+    }
+    return TRUE;
+}
+
+void json_append_string(OutputBuffer *buffer, const char *text, size_t length) {
+    static const char hex_digits[] = "0123456789abcdef";
+    size_t start = 0;
+    size_t i;
+
+    output_append(buffer, "\"", 1);
+    for (i = 0; i < length; i++) {
+        unsigned char c = (unsigned char) text[i];
+        char escape[6];
+
+        if (c != '"' && c != '\\' && c >= 0x20) {
+            continue;
+        }
+
+        /* Copy the characters that need no escape at once */
+        output_append(buffer, text + start, i - start);
+        start = i + 1;
+
+        escape[0] = '\\';
+        if (c == '"' || c == '\\') {
+            escape[1] = (char) c;
+            output_append(buffer, escape, 2);
+        } else if (c == '\n' || c == '\t' || c == '\r') {
+            escape[1] = c == '\n' ? 'n' : c == '\t' ? 't' : 'r';
+            output_append(buffer, escape, 2);
+        } else {
+            escape[1] = 'u';
+            escape[2] = '0';
+            escape[3] = '0';
+            escape[4] = hex_digits[c >> 4];
+            escape[5] = hex_digits[c & 0xF];
+            output_append(buffer, escape, 6);
+        }
+    }
+    output_append(buffer, text + start, length - start);
+    output_append(buffer, "\"", 1);
+}
@@ -0,0 +1,73 @@
+#ifndef JSON_TEXT_H
+#define JSON_TEXT_H
+
+#include <stddef.h>
+#include "output_buffer.h"
+
+/**
+ * Refers to one JSON value within a text, without copying or decoding it.
+ */
+typedef struct {
+    const char *data; /* The first character of the value */
+    size_t length; /* The number of characters of the value, 0 if there is no value */
+} JsonValue;
+
+/**
+ * Refers to the JSON value a text holds, without the blanks around it.
+ *
+ * @param value Pointer to the value to set
+ * @param text The text
+ * @param length The length of the text
+ * @return void
+ */
+void json_view(JsonValue *value, const char *text, size_t length);
+
+/**
+ * Finds a member of a JSON object by its key. Keys are compared as written, without decoding escapes.
+ *
+ * @param object The object
+ * @param key The key of the member
+ * @param member Pointer to set to the value of the member
+ * @return int TRUE if the object has the member, FALSE if it does not or is not a well-formed object
+ */
+int json_member(JsonValue object, const char *key, JsonValue *member);
+
+/**
+ * Steps to the next element of a JSON array.
+ *
+ * @param array The array
+ * @param position Pointer to the position in the array, 0 before the first element, advanced past the element
+ * @param element Pointer to set to the element
+ * @return int TRUE if an element was found, FALSE at the end of the array or if it is not a well-formed array
+ */
+int json_next_element(JsonValue array, size_t *position, JsonValue *element);
+
+/**
+ * Decodes a JSON string, appending its characters to an output buffer as UTF-8.
+ *
+ * @param value The value
+ * @param text Pointer to the output buffer to append the characters to
+ * @return int TRUE if the value is a well-formed string and was decoded, FALSE otherwise or if memory ran out
+ */
+int json_string(JsonValue value, OutputBuffer *text);
+
+/**
+ * Reads a JSON number that is an integer.
+ *
+ * @param value The value
+ * @param number Pointer to set to the integer
+ * @return int TRUE if the value is an integer, FALSE otherwise
+ */
+int json_integer(JsonValue value, long *number);
+
+/**
+ * Appends text to an output buffer as a JSON string, quoted and escaped.
+ *
+ * @param buffer Pointer to the output buffer
+ * @param text The text
+ * @param length The length of the text
+ * @return void
+ */
+void json_append_string(OutputBuffer *buffer, const char *text, size_t length);
+
+#endif
@@ -0,0 +1,473 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "diagnostics.h"
+#include "json_text.h"
+#include "live_document.h"
+#include "language_server.h"
+
+#define MAX_HEADER_LINE 1024 /* Maximum length of a header line of a message */
+
+/**
+ * Represents a document the client has open.
+ */
+typedef struct OpenDocument {
+    char *uri; /* The URI of the document */
+    LiveDocument document; /* The lines of the document and their checks */
+    struct OpenDocument *next; /* Pointer to the next open document */
+} OpenDocument;
+
+/**
+ * Holds the state of a language server between messages.
+ */
+typedef struct {
+    OpenDocument *head_of_documents; /* The open documents */
+    int is_shut_down; /* TRUE once the client sent the shutdown request */
+    int is_exited; /* TRUE once the client sent the exit notification */
+} LanguageServer;
+
+/**
+ * Reads one message: its headers, up to an empty line, and the content their Content-Length gives.
+ *
+ * @param input The stream to read from
+ * @param content Pointer to the output buffer to read the content into, replacing what it held
+ * @return int TRUE if a message was read, FALSE if the input ended, a message has no Content-Length or memory ran out
+ */
+static int read_message(FILE *input, OutputBuffer *content) {
+    char header[MAX_HEADER_LINE];
+    long content_length = -1;
+
+    while (fgets(header, sizeof(header), input) != NULL) {
+        if (strcmp(header, "\r\n") == 0 || strcmp(header, "\n") == 0) {
+            if (content_length < 0) {
+                return FALSE;
+            }
+            output_reset(content);
+            if (content_length > 0) {
+                char *destination = output_reserve(content, (size_t) content_length);
+
+                if (destination == NULL ||
+                    fread(destination, 1, (size_t) content_length, input) != (size_t) content_length) {
+                    return FALSE;
+                }
+            }
+            return TRUE;
+        }
+        if (strncmp(header, "Content-Length:", 15) == 0) {
+            content_length = strtol(header + 15, NULL, 10);
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Writes one message with its Content-Length header.
+ *
+ * @param content Pointer to the output buffer holding the content
+ * @return void
+ */
+static void write_message(OutputBuffer *content) {
+    printf("Content-Length: %lu\r\n\r\n", (unsigned long) content->length);
+    fwrite(content->data, 1, content->length, stdout);
+    fflush(stdout);
+}
+
+/**
+ * Appends a string member value, read from a JSON object, to an output buffer.
+ *
+ * @param object The object
+ * @param path The keys leading to the member, one per nesting level, ending with NULL
+ * @param text Pointer to the output buffer to append the decoded string to
+ * @return int TRUE if the member is a string and was decoded, FALSE otherwise or if memory ran out
+ */
+static int read_string_member(JsonValue object, const char **path, OutputBuffer *text) {
+    JsonValue value = object;
+
+    for (; *path != NULL; path++) {
+        if (json_member(value, *path, &value) == FALSE) {
+            return FALSE;
+        }
+    }
+    return json_string(value, text);
+}
+
+/**
+ * Reads the line and the character of a position object of the protocol.
+ *
+ * @param position The position object
+ * @param line Pointer to set to the line
+ * @param character Pointer to set to the character
+ * @return int TRUE if the position is well formed, FALSE otherwise
+ */
+static int read_position(JsonValue position, int *line, int *character) {
+    JsonValue value;
+    long number;
+
+    if (json_member(position, "line", &value) == FALSE || json_integer(value, &number) == FALSE) {
+        return FALSE;
+    }
+    *line = (int) number;
+    if (json_member(position, "character", &value) == FALSE || json_integer(value, &number) == FALSE) {
+        return FALSE;
+    }
+    *character = (int) number;
+    return TRUE;
+}
+
+/**
+ * Finds an open document by its URI.
+ *
+ * @param server Pointer to the server
+ * @param uri The URI
+ * @return OpenDocument* Pointer to the document, or NULL if it is not open
+ */
+static OpenDocument *find_document(LanguageServer *server, const char *uri) {
+    OpenDocument *current;
+
+    for (current = server->head_of_documents; current != NULL; current = current->next) {
+        if (strcmp(current->uri, uri) == 0) {
+            return current;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Closes an open document and forgets it.
+ *
+ * @param server Pointer to the server
+ * @param uri The URI of the document
+ * @return void
+ */
+static void forget_document(LanguageServer *server, const char *uri) {
+    OpenDocument **link = &server->head_of_documents;
+
+    while (*link != NULL) {
+        if (strcmp((*link)->uri, uri) == 0) {
+            OpenDocument *removed = *link;
+
+            *link = removed->next;
+            close_live_document(&removed->document);
+            free(removed->uri);
+            free(removed);
+            return;
+        }
+        link = &(*link)->next;
+    }
+}
+
+/**
+ * Appends one diagnostic of a document line to the diagnostics array of a notification.
+ *
+ * @param notification Pointer to the output buffer holding the notification
+ * @param is_first TRUE if it is the first diagnostic of the array
+ * @param line_number The line of the diagnostic, from 0
+ * @param line Pointer to the document line
+ * @param message The message
+ * @param length The length of the message
+ * @return void
+ */
+static void append_diagnostic(OutputBuffer *notification, int is_first, int line_number, DocumentLine *line,
+                              const char *message, size_t length) {
+    size_t end = line->length > 0 && line->text[line->length - 1] == '\n' ? line->length - 1 : line->length;
+
+    if (!is_first) {
+        output_append_string(notification, ",");
+    }
+    output_append_string(notification, "{\"range\":{\"start\":{\"line\":");
+    output_append_decimal(notification, (unsigned long) line_number, 1);
+    output_append_string(notification, ",\"character\":0},\"end\":{\"line\":");
+    output_append_decimal(notification, (unsigned long) line_number, 1);
+    output_append_string(notification, ",\"character\":");
+    output_append_decimal(notification, (unsigned long) end, 1);
+    output_append_string(notification, "}},\"severity\":1,\"source\":\"assembler\",\"message\":");
+    json_append_string(notification, message, length);
+    output_append_string(notification, "}");
+}
+
+/**
+ * Publishes the diagnostics of a document: the preprocessing errors of every line,
+ * and the first and second pass errors of the lines it expands to.
+ *
+ * @param uri The URI of the document
+ * @param document Pointer to the document, or NULL to clear its diagnostics
+ * @return void
+ */
+static void publish_diagnostics(const char *uri, LiveDocument *document) {
+    OutputBuffer notification = {NULL, 0, 0};
+    int remaining = document != NULL ? document->number_of_diagnostics : 0;
+    int is_first = TRUE;
+    int i, j, k;
+
+    output_append_string(&notification,
+                         "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+    json_append_string(&notification, uri, strlen(uri));
+    output_append_string(&notification, ",\"diagnostics\":[");
+
+    /* The lines after the last diagnostic are not visited */
+    for (i = 0; remaining > 0 && i < document->number_of_lines; i++) {
+        DocumentLine *line = &document->lines[i];
+        OutputBuffer *reported = &line->preprocessing_errors;
+        size_t position = 0;
+
+        /* The preprocessing diagnostics are kept as reported, one per line, each after its line number */
+        while (position < reported->length) {
+            char *start = reported->data + position;
+            char *newline = memchr(start, '\n', reported->length - position);
+            size_t length = newline == NULL ? reported->length - position : (size_t)(newline - start);
+            char *message = start;
+            char *separator = memchr(start, ':', length);
+
+            if (separator != NULL && separator + 2 <= start + length) {
+                message = separator + 2;
+            }
+            append_diagnostic(&notification, is_first, i, line, message, length - (size_t)(message - start));
+            is_first = FALSE;
+            remaining--;
+            position += length + 1;
+        }
+
+        for (j = 0; j < line->number_of_checked; j++) {
+            CheckedLine *checked = &line->checked[j];
+
+            remaining -= checked->number_of_errors + (checked->second_pass_error != NO_ERROR);
+            for (k = 0; k < checked->number_of_errors; k++) {
+                const char *message = error_message(checked->errors[k]);
+
+                if (message != NULL) {
+                    append_diagnostic(&notification, is_first, i, line, message, strlen(message));
+                    is_first = FALSE;
+                }
+            }
+            if (checked->second_pass_error != NO_ERROR) {
+                const char *message = error_message(checked->second_pass_error);
+
+                if (message != NULL) {
+                    append_diagnostic(&notification, is_first, i, line, message, strlen(message));
+                    is_first = FALSE;
+                }
+            }
+        }
+    }
+
+    output_append_string(&notification, "]}}");
+    write_message(&notification);
+    free_output_buffer(&notification);
+}
+
+/**
+ * Opens a document, or reopens it with new text if it is open already.
+ *
+ * @param server Pointer to the server
+ * @param uri The URI of the document
+ * @param text Pointer to the output buffer holding the text
+ * @return OpenDocument* Pointer to the document, or NULL if memory ran out
+ */
+static OpenDocument *open_document(LanguageServer *server, const char *uri, OutputBuffer *text) {
+    OpenDocument *document;
+
+    forget_document(server, uri);
+    document = (OpenDocument *) malloc(sizeof(OpenDocument));
+    if (check_memory_allocation(document) == FALSE) {
+        return NULL;
+    }
+    document->uri = malloc(strlen(uri) + 1);
+    if (check_memory_allocation(document->uri) == FALSE) {
+        free(document);
+        return NULL;
+    }
+    strcpy(document->uri, uri);
+    if (open_live_document(&document->document, text->data, text->length) == FALSE) {
+        free(document->uri);
+        free(document);
+        return NULL;
+    }
+    document->next = server->head_of_documents;
+    server->head_of_documents = document;
+    return document;
+}
+
+/**
+ * Applies the content changes of a didChange notification to an open document, in order.
+ * A change with a range replaces that range, and a change without one replaces the whole text.
+ *
+ * @param server Pointer to the server
+ * @param uri The URI of the document
+ * @param document Pointer to the document
+ * @param changes The contentChanges array
+ * @return OpenDocument* Pointer to the document, or NULL if memory ran out and it was closed
+ */
+static OpenDocument *change_document(LanguageServer *server, const char *uri, OpenDocument *document,
+                                     JsonValue changes) {
+    OutputBuffer text = {NULL, 0, 0};
+    JsonValue change, range, start, end, value;
+    size_t position = 0;
+
+    while (document != NULL && json_next_element(changes, &position, &change)) {
+        int start_line, start_character, end_line, end_character;
+        int is_changed;
+
+        output_reset(&text);
+        if (json_member(change, "text", &value) == FALSE || json_string(value, &text) == FALSE) {
+            continue;
+        }
+        if (json_member(change, "range", &range) == FALSE) {
+            document = open_document(server, uri, &text);
+            continue;
+        }
+        if (json_member(range, "start", &start) == FALSE || json_member(range, "end", &end) == FALSE ||
+            read_position(start, &start_line, &start_character) == FALSE ||
+            read_position(end, &end_line, &end_character) == FALSE) {
+            continue;
+        }
+        is_changed = edit_live_document(&document->document, start_line, start_character, end_line, end_character,
+                                        text.data, text.length);
+        if (!is_changed) {
+            forget_document(server, uri);
+            document = NULL;
+        }
+    }
+    free_output_buffer(&text);
+    return document;
+}
+
+/**
+ * Sends the response to a request.
+ *
+ * @param id The id of the request, as it was written
+ * @param result The result, as JSON, or NULL to send an error that the method is not handled
+ * @return void
+ */
+static void respond(JsonValue id, const char *result) {
+    OutputBuffer response = {NULL, 0, 0};
+
+    output_append_string(&response, "{\"jsonrpc\":\"2.0\",\"id\":");
+    output_append(&response, id.data, id.length);
+    if (result != NULL) {
+        output_append_string(&response, ",\"result\":");
+        output_append_string(&response, result);
+    } else {
+        output_append_string(&response, ",\"error\":{\"code\":-32601,\"message\":\"Method not found\"}");
+    }
+    output_append_string(&response, "}");
+    write_message(&response);
+    free_output_buffer(&response);
+}
+
+/**
+ * Handles the notifications about the documents: didOpen, didChange and didClose,
+ * publishing the diagnostics of the document after each one.
+ *
+ * @param server Pointer to the server
+ * @param method The method of the notification
+ * @param params The params of the notification
+ * @return void
+ */
+static void handle_document_notification(LanguageServer *server, const char *method, JsonValue params) {
+    static const char *uri_path[] = {"textDocument", "uri", NULL};
+    static const char *text_path[] = {"textDocument", "text", NULL};
+    OutputBuffer uri = {NULL, 0, 0};
+    OutputBuffer text = {NULL, 0, 0};
+    OpenDocument *document;
+    JsonValue changes;
+
+    if (read_string_member(params, uri_path, &uri) == FALSE) {
+        free_output_buffer(&uri);
+        return;
+    }
+    output_append(&uri, "", 1);
+    if (uri.is_out_of_memory) {
+        free_output_buffer(&uri);
+        return;
+    }
+
+    if (strcmp(method, "textDocument/didOpen") == 0) {
+        if (read_string_member(params, text_path, &text) == TRUE) {
+            document = open_document(server, uri.data, &text);
+            publish_diagnostics(uri.data, document != NULL ? &document->document : NULL);
+        }
+    } else if (strcmp(method, "textDocument/didChange") == 0) {
+        document = find_document(server, uri.data);
+        if (document != NULL && json_member(params, "contentChanges", &changes) == TRUE) {
+            document = change_document(server, uri.data, document, changes);
+            publish_diagnostics(uri.data, document != NULL ? &document->document : NULL);
+        }
+    } else if (strcmp(method, "textDocument/didClose") == 0) {
+        forget_document(server, uri.data);
+        publish_diagnostics(uri.data, NULL);
+    }
+    free_output_buffer(&uri);
+    free_output_buffer(&text);
+}
+
+/**
+ * Handles one message from the client. Responses from the client and unknown notifications are ignored.
+ *
+ * @param server Pointer to the server
+ * @param content Pointer to the output buffer holding the content of the message
+ * @return void
+ */
+static void handle_message(LanguageServer *server, OutputBuffer *content) {
+    OutputBuffer method = {NULL, 0, 0};
+    JsonValue message, value, id, params;
+    int has_id;
+
+    json_view(&message, content->data, content->length);
+    has_id = json_member(message, "id", &id);
+    if (json_member(message, "method", &value) == FALSE || json_string(value, &method) == FALSE) {
+        free_output_buffer(&method);
+        return;
+    }
+    output_append(&method, "", 1);
+    if (method.is_out_of_memory) {
+        free_output_buffer(&method);
+        return;
+    }
+    if (json_member(message, "params", &params) == FALSE) {
+        params.data = NULL;
+        params.length = 0;
+    }
+
+    if (strcmp(method.data, "initialize") == 0 && has_id) {
+        respond(id, "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2}},"
+                    "\"serverInfo\":{\"name\":\"assembler\"}}");
+    } else if (strcmp(method.data, "shutdown") == 0 && has_id) {
+        server->is_shut_down = TRUE;
+        respond(id, "null");
+    } else if (strcmp(method.data, "exit") == 0) {
+        server->is_exited = TRUE;
+    } else if (strncmp(method.data, "textDocument/did", 16) == 0) {
+        handle_document_notification(server, method.data, params);
+    } else if (has_id) {
+        respond(id, NULL);
+    }
+    free_output_buffer(&method);
+}
+
+int run_language_server(void) {
+    LanguageServer server;
+    OutputBuffer content = {NULL, 0, 0};
+    OutputBuffer stray_diagnostics = {NULL, 0, 0};
+
+    server.head_of_documents = NULL;
+    server.is_shut_down = FALSE;
+    server.is_exited = FALSE;
+
+    /* Standard output carries the protocol, any other diagnostic goes to standard error */
+    capture_diagnostics(&stray_diagnostics);
+    while (!server.is_exited && read_message(stdin, &content) == TRUE) {
+        handle_message(&server, &content);
+        if (stray_diagnostics.length > 0) {
+            fwrite(stray_diagnostics.data, 1, stray_diagnostics.length, stderr);
+            output_reset(&stray_diagnostics);
+        }
+    }
+    capture_diagnostics(NULL);
+    free_output_buffer(&stray_diagnostics);
+
+    while (server.head_of_documents != NULL) {
+        forget_document(&server, server.head_of_documents->uri);
+    }
+    free_output_buffer(&content);
+    return server.is_exited && server.is_shut_down ? ERROR_WAS_NOT_FOUND : ERROR_FOUND;
+}
@@ -0,0 +1,17 @@
+#ifndef LANGUAGE_SERVER_H
+#define LANGUAGE_SERVER_H
+
+/**
+ * Serves the Language Server Protocol over standard input and standard output, publishing the diagnostics
+ * of every open document as it changes. Every document is kept open as a LiveDocument, so an edit only
+ * checks again the lines it changes and the lines using the symbols it defines or removes.
+ * Unlike the assembler, the first and the second pass checks of a document are all published at once,
+ * each on the line of the document it comes from, a macro call standing for the lines it expands to.
+ * Positions are counted in bytes, which are the characters of an assembly source.
+ *
+ * @return int ERROR_WAS_NOT_FOUND if the client sent the exit notification after a shutdown request,
+ *         ERROR_FOUND if it exited without one or the input ended
+ */
+int run_language_server(void);
+
+#endif
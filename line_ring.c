@@ -0,0 +1,68 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "line_ring.h"
+
+int init_line_ring(LineRing *ring) {
+    ring->records = (LineRecord *) malloc(LINE_RING_CAPACITY * sizeof(LineRecord));
+
+    /* Check if memory allocation was successful */
+    if (check_memory_allocation(ring->records) == FALSE) {
+        return FALSE;
+    }
+    ring->head = 0;
+    ring->tail = 0;
+    ring->is_closed = FALSE;
+    return TRUE;
+}
+
+void push_line(LineRing *ring, char *line, int line_number) {
+    unsigned long tail = ring->tail;
+    LineRecord *record;
+
+    /* Wait for the consumer to make room */
+    while (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == LINE_RING_CAPACITY) {
+        sched_yield();
+    }
+
+    record = &ring->records[tail & (LINE_RING_CAPACITY - 1)];
+    strcpy(record->line, line);
+    record->line_number = line_number;
+
+    /* Publish the record */
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+void close_line_ring(LineRing *ring) {
+    __atomic_store_n(&ring->is_closed, TRUE, __ATOMIC_RELEASE);
+}
+
+int pop_line(LineRing *ring, LineRecord *record) {
+    unsigned long head = ring->head;
+
+    /* Wait for the producer to add a record or close the ring */
+    while (head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) {
+        if (__atomic_load_n(&ring->is_closed, __ATOMIC_ACQUIRE)) {
+
+            /* The producer may have added its last records right before closing */
+            if (head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) {
+                return FALSE;
+            }
+            break;
+        }
+        sched_yield();
+    }
+
+    *record = ring->records[head & (LINE_RING_CAPACITY - 1)];
+
+    /* Hand the slot back to the producer */
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return TRUE;
+}
+
+void free_line_ring(LineRing *ring) {
+    free(ring->records);
+    ring->records = NULL;
+}
@@ -0,0 +1,72 @@
+#ifndef LINE_RING_H
+#define LINE_RING_H
+
+#include "macro_data.h"
+
+#define LINE_RING_CAPACITY 1024 /* Number of line records a ring holds, a power of 2 */
+
+/**
+ * Represents one line passed between the stages of a pipeline.
+ */
+typedef struct {
+    char line[MAX_LINE]; /* The text of the line */
+    int line_number; /* The number of the line in the expanded source */
+} LineRecord;
+
+/**
+ * Represents a lock-free ring buffer of line records between exactly one producer thread
+ * and exactly one consumer thread. Each side only writes its own index, and publishes it
+ * with release ordering after the records it covers.
+ */
+typedef struct {
+    LineRecord *records; /* The LINE_RING_CAPACITY records of the ring */
+    unsigned long head; /* The number of records taken so far, written by the consumer */
+    unsigned long tail; /* The number of records added so far, written by the producer */
+    int is_closed; /* TRUE once the producer added its last record */
+} LineRing;
+
+/**
+ * Initializes an empty ring.
+ *
+ * @param ring Pointer to the ring to initialize
+ * @return int TRUE if the ring was initialized, FALSE if memory ran out
+ */
+int init_line_ring(LineRing *ring);
+
+/**
+ * Adds a line to a ring, waiting while the ring is full. Only the producer thread may call it.
+ *
+ * @param ring Pointer to the ring
+ * @param line The line to add
+ * @param line_number The number of the line in the expanded source
+ * @return void
+ */
+void push_line(LineRing *ring, char *line, int line_number);
+
+/**
+ * Marks that the producer added its last line. Only the producer thread may call it.
+ *
+ * @param ring Pointer to the ring
+ * @return void
+ */
+void close_line_ring(LineRing *ring);
+
+/**
+ * Takes the next line from a ring, waiting while the ring is empty and not closed.
+ * Only the consumer thread may call it.
+ *
+ * @param ring Pointer to the ring
+ * @param record Pointer to the record to copy the line into
+ * @return int TRUE if a line was taken, FALSE if the ring is closed and empty
+ */
+int pop_line(LineRing *ring, LineRecord *record);
+
+/**
+ * Frees the memory allocated for a ring.
+ *
+ * @param ring Pointer to the ring
+ * @return void
+ */
+void free_line_ring(LineRing *ring);
+
+#endif
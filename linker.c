@@ -0,0 +1,504 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "macro_data.h"
+#include "diagnostics.h"
+#include "output_buffer.h"
+#include "object_output.h"
+#include "work_stealing_pool.h"
+#include "assembly.h"
+#include "linker.h"
+
+#define MIN_ENTRY_BUCKETS 16 /* The smallest number of buckets of the entry table, a power of two */
+
+/**
+ * Represents one entry in the global table of entries, chained with the others of its bucket.
+ */
+typedef struct {
+    char *symbol_name; /* The name of the entry, owned by its module */
+    int address; /* The linked address of the entry */
+    int module_index; /* The index of the module defining the entry */
+    int next; /* The index of the next entry of the bucket, or -1 */
+} LinkerEntry;
+
+/**
+ * Holds the state shared by the jobs of a link.
+ */
+typedef struct {
+    ObjectModule *modules; /* The modules */
+    char **module_names; /* The names of the modules */
+    int number_of_modules; /* The number of modules */
+    int *code_bases; /* The linked address of the first code word of every module */
+    int *data_bases; /* The linked address of the first data word of every module */
+    LinkerEntry *entries; /* The entries of every module */
+    int *buckets; /* The index of the first entry of every bucket, or -1 */
+    int number_of_buckets; /* The number of buckets, a power of two */
+    int *unresolved_uses; /* The number of external uses of every module no entry resolves */
+    int *outside_words; /* The number of words of every module holding an address outside the module */
+    LinkedProgram *program; /* The program being linked */
+} Linker;
+
+/**
+ * Holds the state shared by the jobs reading the modules of a link.
+ */
+typedef struct {
+    char **module_names; /* The file names of the modules, without any extension */
+    ObjectModule *modules; /* The modules being read */
+    OutputBuffer *diagnostics; /* The diagnostics of every module */
+    int *error_flags; /* The outcome of reading every module */
+} ModuleReading;
+
+/**
+ * Computes the djb2 hash of a symbol name, which picks its bucket in the entry table.
+ *
+ * @param symbol_name The name of the symbol
+ * @return unsigned long The hash of the name
+ */
+static unsigned long hash_entry_name(const char *symbol_name) {
+    unsigned long hash = 5381;
+
+    while (*symbol_name != '\0') {
+        hash = hash * 33 + (unsigned char) *symbol_name++;
+    }
+    return hash;
+}
+
+/**
+ * Finds an entry in the global table of entries.
+ *
+ * @param linker Pointer to the linker
+ * @param symbol_name The name of the entry
+ * @return int The index of the entry, or -1 if no module defines it
+ */
+static int find_entry(Linker *linker, const char *symbol_name) {
+    int index = linker->buckets[hash_entry_name(symbol_name) & (unsigned long)(linker->number_of_buckets - 1)];
+
+    while (index != -1 && strcmp(linker->entries[index].symbol_name, symbol_name) != 0) {
+        index = linker->entries[index].next;
+    }
+    return index;
+}
+
+/**
+ * Finds the linked address of an address of a module.
+ *
+ * @param linker Pointer to the linker
+ * @param module_index The index of the module
+ * @param address The address in the module, as its assembler gave it
+ * @return int The linked address, or -1 if the address is outside the module
+ */
+static int relocate_address(Linker *linker, int module_index, int address) {
+    ObjectModule *module = &linker->modules[module_index];
+    int offset = address - OBJECT_FIRST_ADDRESS;
+
+    if (offset >= 0 && offset < module->number_of_code_words) {
+        return linker->code_bases[module_index] + offset;
+    }
+    offset -= module->number_of_code_words;
+    if (offset >= 0 && offset < module->number_of_data_words) {
+        return linker->data_bases[module_index] + offset;
+    }
+    return -1;
+}
+
+/**
+ * Runs jobs on a work-stealing pool of threads, or one after another on the calling thread
+ * if there is a single thread or the pool cannot be started, and waits until all of them are done.
+ *
+ * @param number_of_jobs The number of jobs
+ * @param job_costs The estimated cost of every job
+ * @param number_of_threads The number of threads
+ * @param run_job The function that runs a job
+ * @param context The context pointer passed to run_job
+ * @return void
+ */
+static void run_jobs(int number_of_jobs, long *job_costs, int number_of_threads, JobFunction run_job, void *context) {
+    WorkStealingPool pool;
+    int i;
+
+    if (number_of_threads > number_of_jobs) {
+        number_of_threads = number_of_jobs;
+    }
+    if (number_of_threads > 1 &&
+        start_work_stealing_pool(&pool, number_of_jobs, job_costs, number_of_threads, run_job, context) == TRUE) {
+        join_work_stealing_pool(&pool);
+        return;
+    }
+    for (i = 0; i < number_of_jobs; i++) {
+        run_job(i, 0, context);
+    }
+}
+
+/**
+ * Runs one job of the patch phase: copies the code and data words of one module into place,
+ * moves the words with the R bit to their linked addresses and resolves the uses of external symbols.
+ * Every module writes its own ranges of the images, so the jobs run concurrently without locking.
+ *
+ * @param job_index The index of the module
+ * @param worker_index Unused
+ * @param context Pointer to the Linker
+ * @return void
+ */
+static void patch_module(int job_index, int worker_index, void *context) {
+    Linker *linker = (Linker *) context;
+    ObjectModule *module = &linker->modules[job_index];
+    unsigned long *code = linker->program->code_image.words + (linker->code_bases[job_index] - OBJECT_FIRST_ADDRESS);
+    int code_length = linker->program->code_image.count;
+    int i;
+
+    (void) worker_index;
+
+    /* Move every word holding an address of the module, code words and data words alike may be its target */
+    for (i = 0; i < module->number_of_code_words; i++) {
+        unsigned long word = module->words[i];
+
+        if ((word & ARE_MASK) == ARE_RELOCATABLE) {
+            int address = relocate_address(linker, job_index, (int)(word >> 3));
+
+            if (address == -1) {
+                linker->outside_words[job_index]++;
+            } else {
+                word = ((unsigned long) address << 3) | ARE_RELOCATABLE;
+            }
+        }
+        code[i] = word;
+    }
+
+    /* Every use of an external symbol holds the linked address of its entry instead */
+    for (i = 0; i < module->number_of_externals; i++) {
+        int entry = find_entry(linker, module->externals[i].symbol_name);
+
+        if (entry == -1) {
+            linker->unresolved_uses[job_index]++;
+        } else {
+            code[module->externals[i].address - OBJECT_FIRST_ADDRESS] =
+                    ((unsigned long) linker->entries[entry].address << 3) | ARE_RELOCATABLE;
+        }
+    }
+
+    if (module->number_of_data_words > 0) {
+        memcpy(linker->program->data_image.words + (linker->data_bases[job_index] - OBJECT_FIRST_ADDRESS - code_length),
+               module->words + module->number_of_code_words, module->number_of_data_words * sizeof(unsigned long));
+    }
+}
+
+/**
+ * Lays out the sections of the modules: the code sections one after another from address 100,
+ * then the data sections. The images of the program are allocated to hold them.
+ *
+ * @param linker Pointer to the linker
+ * @return int TRUE if every address fits in the address bits of a word, FALSE otherwise,
+ *         or ERROR_OUT_OF_MEMORY if the images could not be allocated
+ */
+static int lay_out_sections(Linker *linker) {
+    long code_words = 0, data_words = 0;
+    int i;
+
+    for (i = 0; i < linker->number_of_modules; i++) {
+        code_words += linker->modules[i].number_of_code_words;
+        data_words += linker->modules[i].number_of_data_words;
+    }
+    if (OBJECT_FIRST_ADDRESS + code_words + data_words - 1 > MAX_LINKED_ADDRESS) {
+        report_diagnostic("Error: the linked program of %ld words does not fit in the address bits of a word.\n",
+                          code_words + data_words);
+        return FALSE;
+    }
+
+    code_words = data_words = 0;
+    for (i = 0; i < linker->number_of_modules; i++) {
+        linker->code_bases[i] = OBJECT_FIRST_ADDRESS + (int) code_words;
+        code_words += linker->modules[i].number_of_code_words;
+    }
+    for (i = 0; i < linker->number_of_modules; i++) {
+        linker->data_bases[i] = OBJECT_FIRST_ADDRESS + (int) code_words + (int) data_words;
+        data_words += linker->modules[i].number_of_data_words;
+    }
+
+    linker->program->code_image.words = (unsigned long *) malloc((code_words + 1) * sizeof(unsigned long));
+    linker->program->data_image.words = (unsigned long *) malloc((data_words + 1) * sizeof(unsigned long));
+    if (check_memory_allocation(linker->program->code_image.words) == FALSE ||
+        check_memory_allocation(linker->program->data_image.words) == FALSE) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    linker->program->code_image.count = linker->program->code_image.capacity = (int) code_words;
+    linker->program->data_image.count = linker->program->data_image.capacity = (int) data_words;
+    return TRUE;
+}
+
+/**
+ * Builds the global table of entries at their linked addresses, in module order, reporting every entry
+ * a module defines that an earlier module already defines.
+ *
+ * @param linker Pointer to the linker
+ * @return int TRUE if every entry is defined once, FALSE otherwise, or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+static int build_entry_table(Linker *linker) {
+    int number_of_entries = 0;
+    int is_unique = TRUE;
+    int i, j;
+
+    for (i = 0; i < linker->number_of_modules; i++) {
+        number_of_entries += linker->modules[i].number_of_entries;
+    }
+    for (linker->number_of_buckets = MIN_ENTRY_BUCKETS; linker->number_of_buckets < 2 * number_of_entries;) {
+        linker->number_of_buckets *= 2;
+    }
+    linker->entries = (LinkerEntry *) malloc((number_of_entries + 1) * sizeof(LinkerEntry));
+    linker->buckets = (int *) malloc(linker->number_of_buckets * sizeof(int));
+    linker->program->entries = (ObjectSymbol *) malloc((number_of_entries + 1) * sizeof(ObjectSymbol));
+    if (check_memory_allocation(linker->entries) == FALSE || check_memory_allocation(linker->buckets) == FALSE ||
+        check_memory_allocation(linker->program->entries) == FALSE) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    for (i = 0; i < linker->number_of_buckets; i++) {
+        linker->buckets[i] = -1;
+    }
+
+    number_of_entries = 0;
+    for (i = 0; i < linker->number_of_modules; i++) {
+        ObjectModule *module = &linker->modules[i];
+
+        for (j = 0; j < module->number_of_entries; j++) {
+            char *symbol_name = module->entries[j].symbol_name;
+            int defined = find_entry(linker, symbol_name);
+            LinkerEntry *entry = &linker->entries[number_of_entries];
+            int *bucket;
+
+            if (defined != -1) {
+                report_diagnostic("Error in %s: the entry %s is already an entry of %s.\n", linker->module_names[i],
+                                  symbol_name, linker->module_names[linker->entries[defined].module_index]);
+                is_unique = FALSE;
+                continue;
+            }
+
+            /* verify_object_module keeps every entry inside its module */
+            entry->symbol_name = symbol_name;
+            entry->address = relocate_address(linker, i, module->entries[j].address);
+            entry->module_index = i;
+            bucket = &linker->buckets[hash_entry_name(symbol_name) & (unsigned long)(linker->number_of_buckets - 1)];
+            entry->next = *bucket;
+            *bucket = number_of_entries;
+
+            linker->program->entries[number_of_entries].symbol_name = symbol_name;
+            linker->program->entries[number_of_entries++].address = entry->address;
+        }
+    }
+    linker->program->number_of_entries = number_of_entries;
+    return is_unique;
+}
+
+/**
+ * Reports the problems the patch phase counted, module by module: the external symbols no module defines,
+ * each once for every run of its uses, and the words holding an address outside their module.
+ *
+ * @param linker Pointer to the linker
+ * @return int TRUE if there was no problem, FALSE otherwise
+ */
+static int report_patch_errors(Linker *linker) {
+    int is_patched = TRUE;
+    int i, j;
+
+    for (i = 0; i < linker->number_of_modules; i++) {
+        ObjectModule *module = &linker->modules[i];
+
+        if (linker->unresolved_uses[i] > 0) {
+            for (j = 0; j < module->number_of_externals; j++) {
+                char *symbol_name = module->externals[j].symbol_name;
+
+                if ((j == 0 || strcmp(symbol_name, module->externals[j - 1].symbol_name) != 0) &&
+                    find_entry(linker, symbol_name) == -1) {
+                    report_diagnostic("Error in %s: the external symbol %s is not an entry of any module.\n",
+                                      linker->module_names[i], symbol_name);
+                }
+            }
+            is_patched = FALSE;
+        }
+        if (linker->outside_words[i] > 0) {
+            report_diagnostic("Error in %s: %d words hold an address outside the module.\n", linker->module_names[i],
+                              linker->outside_words[i]);
+            is_patched = FALSE;
+        }
+    }
+    return is_patched;
+}
+
+int link_object_modules(ObjectModule *modules, char **module_names, int number_of_modules, int number_of_threads,
+                        LinkedProgram *program) {
+    Linker linker;
+    long *costs = (long *) malloc((number_of_modules + 1) * sizeof(long));
+    int status;
+    int i;
+
+    memset(program, 0, sizeof(LinkedProgram));
+    memset(&linker, 0, sizeof(Linker));
+    linker.modules = modules;
+    linker.module_names = module_names;
+    linker.number_of_modules = number_of_modules;
+    linker.program = program;
+    linker.code_bases = (int *) malloc((number_of_modules + 1) * sizeof(int));
+    linker.data_bases = (int *) malloc((number_of_modules + 1) * sizeof(int));
+    linker.unresolved_uses = (int *) calloc(number_of_modules + 1, sizeof(int));
+    linker.outside_words = (int *) calloc(number_of_modules + 1, sizeof(int));
+    if (check_memory_allocation(costs) == FALSE || check_memory_allocation(linker.code_bases) == FALSE ||
+        check_memory_allocation(linker.data_bases) == FALSE ||
+        check_memory_allocation(linker.unresolved_uses) == FALSE ||
+        check_memory_allocation(linker.outside_words) == FALSE) {
+        status = ERROR_OUT_OF_MEMORY;
+    } else {
+
+        /* Lay out the sections and resolve the entries first, the patch phase only reads them */
+        status = lay_out_sections(&linker);
+    }
+    if (status == TRUE) {
+        status = build_entry_table(&linker);
+    }
+
+    /* Relocate and patch every module on its own, the largest first */
+    if (status == TRUE) {
+        for (i = 0; i < number_of_modules; i++) {
+            costs[i] = (long) modules[i].number_of_code_words + modules[i].number_of_data_words;
+        }
+        run_jobs(number_of_modules, costs, number_of_threads, patch_module, &linker);
+        status = report_patch_errors(&linker);
+    }
+
+    free(costs);
+    free(linker.code_bases);
+    free(linker.data_bases);
+    free(linker.unresolved_uses);
+    free(linker.outside_words);
+    free(linker.entries);
+    free(linker.buckets);
+    if (status == ERROR_OUT_OF_MEMORY) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    return status == TRUE ? ERROR_WAS_NOT_FOUND : ERROR_FOUND;
+}
+
+/**
+ * Runs one job of the read phase: reads the files of one module, capturing its diagnostics.
+ *
+ * @param job_index The index of the module
+ * @param worker_index Unused
+ * @param context Pointer to the ModuleReading
+ * @return void
+ */
+static void read_module_job(int job_index, int worker_index, void *context) {
+    ModuleReading *reading = (ModuleReading *) context;
+
+    (void) worker_index;
+    capture_diagnostics(&reading->diagnostics[job_index]);
+    reading->error_flags[job_index] = read_object_module(reading->module_names[job_index],
+                                                         &reading->modules[job_index]);
+    if (reading->error_flags[job_index] == ERROR_OUT_OF_MEMORY) {
+        report_diagnostic("Memory allocation failed!\n");
+    }
+    capture_diagnostics(NULL);
+}
+
+/**
+ * Writes the object file and, if there are entries, the entries file of a linked program.
+ *
+ * @param program Pointer to the linked program
+ * @param output_name The file name of the linked program, without any extension
+ * @return int TRUE if the files were written, FALSE otherwise
+ */
+static int write_linked_program(LinkedProgram *program, char *output_name) {
+    OutputBuffer output = {NULL, 0, 0};
+    char *file_name = make_file_name(output_name, ".ob");
+    int is_written;
+    int i;
+
+    is_written = file_name != NULL &&
+                 build_image_object_output(&output, &program->code_image, &program->data_image,
+                                           OBJECT_FIRST_ADDRESS + program->code_image.count,
+                                           program->data_image.count) == TRUE &&
+                 write_output_file(&output, file_name) == TRUE;
+    free(file_name);
+
+    if (is_written && program->number_of_entries > 0) {
+        output_reset(&output);
+        for (i = 0; i < program->number_of_entries; i++) {
+            output_append_string(&output, program->entries[i].symbol_name);
+            output_append(&output, " ", 1);
+            output_append_decimal(&output, (unsigned long) program->entries[i].address, 7);
+            output_append(&output, "\n", 1);
+        }
+        file_name = make_file_name(output_name, ".ent");
+        is_written = file_name != NULL && !output.is_out_of_memory && write_output_file(&output, file_name) == TRUE;
+        free(file_name);
+    }
+    if (output.is_out_of_memory) {
+        report_diagnostic("Memory allocation failed!\n");
+    }
+    free_output_buffer(&output);
+    return is_written;
+}
+
+int link_object_files(char **module_names, int number_of_modules, char *output_name, int number_of_threads) {
+    ModuleReading reading;
+    LinkedProgram program;
+    long *costs = (long *) malloc((number_of_modules + 1) * sizeof(long));
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    int i;
+
+    reading.module_names = module_names;
+    reading.modules = (ObjectModule *) calloc(number_of_modules + 1, sizeof(ObjectModule));
+    reading.diagnostics = (OutputBuffer *) calloc(number_of_modules + 1, sizeof(OutputBuffer));
+    reading.error_flags = (int *) calloc(number_of_modules + 1, sizeof(int));
+    if (check_memory_allocation(costs) == FALSE || check_memory_allocation(reading.modules) == FALSE ||
+        check_memory_allocation(reading.diagnostics) == FALSE ||
+        check_memory_allocation(reading.error_flags) == FALSE) {
+        free(reading.modules);
+        free(reading.diagnostics);
+        free(reading.error_flags);
+        free(costs);
+        return ERROR_FOUND;
+    }
+
+    /* The size of every object file estimates how long it takes to read */
+    for (i = 0; i < number_of_modules; i++) {
+        struct stat file_status;
+        char *file_name = make_file_name(module_names[i], ".ob");
+
+        costs[i] = file_name != NULL && stat(file_name, &file_status) == 0 ? (long) file_status.st_size : 0;
+        free(file_name);
+    }
+    run_jobs(number_of_modules, costs, number_of_threads, read_module_job, &reading);
+
+    /* Report the diagnostics of the modules in order */
+    for (i = 0; i < number_of_modules; i++) {
+        report_diagnostic_text(reading.diagnostics[i].data, reading.diagnostics[i].length);
+        free_output_buffer(&reading.diagnostics[i]);
+        if (reading.error_flags[i] != ERROR_WAS_NOT_FOUND) {
+            error_flag = ERROR_FOUND;
+        }
+    }
+
+    if (error_flag == ERROR_WAS_NOT_FOUND) {
+        error_flag = link_object_modules(reading.modules, module_names, number_of_modules, number_of_threads,
+                                         &program);
+        if (error_flag == ERROR_WAS_NOT_FOUND && write_linked_program(&program, output_name) == FALSE) {
+            error_flag = ERROR_FOUND;
+        } else if (error_flag == ERROR_OUT_OF_MEMORY) {
+            error_flag = ERROR_FOUND;
+        }
+        free_linked_program(&program);
+    }
+
+    for (i = 0; i < number_of_modules; i++) {
+        free_object_module(&reading.modules[i]);
+    }
+    free(reading.modules);
+    free(reading.diagnostics);
+    free(reading.error_flags);
+    free(costs);
+    return error_flag;
+}
+
+void free_linked_program(LinkedProgram *program) {
+    free(program->code_image.words);
+    free(program->data_image.words);
+    free(program->entries);
+    memset(program, 0, sizeof(LinkedProgram));
+}
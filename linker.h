@@ -0,0 +1,62 @@
+#ifndef LINKER_H
+#define LINKER_H
+
+#include "first_second_pass_data.h"
+#include "object_reader.h"
+
+#define MAX_LINKED_ADDRESS 2097151 /* The largest address the 21 address bits of a relocated word hold */
+
+/**
+ * Holds a program linked from several modules.
+ */
+typedef struct {
+    DataImage code_image; /* The code sections of the modules one after another, indexed by address - 100 */
+    DataImage data_image; /* The data sections of the modules one after another, placed after the code */
+    ObjectSymbol *entries; /* The entries of every module at their linked addresses, in module order */
+    int number_of_entries; /* The number of entries */
+} LinkedProgram;
+
+/**
+ * Links modules read back with read_object_module into one program. The code sections of the modules
+ * are laid out one after another from address 100, and the data sections after all of them, in module order.
+ * Every word with the R bit is moved to the linked address of the code or data word it holds,
+ * and every use of an external symbol is resolved against the entries of all the modules and becomes
+ * a word with the R bit holding the linked address of the entry.
+ * Entries defined by more than one module, external symbols no module defines, words holding
+ * an address outside their module and a program too large for the address bits are reported.
+ * The modules are relocated and patched on several threads.
+ *
+ * @param modules The modules, their words are left unchanged
+ * @param module_names The names the errors of every module are reported with
+ * @param number_of_modules The number of modules
+ * @param number_of_threads The number of threads to relocate and patch the modules with
+ * @param program Pointer to the program to fill, to be released with free_linked_program even if linking failed
+ * @return int ERROR_WAS_NOT_FOUND if the modules were linked, ERROR_FOUND if errors were reported,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int link_object_modules(ObjectModule *modules, char **module_names, int number_of_modules, int number_of_threads,
+                        LinkedProgram *program);
+
+/**
+ * Reads the object, entries and externals files of several modules, links them and writes
+ * the object and entries files of the linked program. The modules are read on several threads,
+ * and their diagnostics are reported in module order. Nothing is written if any error was reported,
+ * running out of memory included.
+ *
+ * @param module_names The file names of the modules, without any extension
+ * @param number_of_modules The number of modules
+ * @param output_name The file name of the linked program, without any extension
+ * @param number_of_threads The number of threads to read, relocate and patch the modules with
+ * @return int ERROR_WAS_NOT_FOUND if the program was linked and written, ERROR_FOUND otherwise
+ */
+int link_object_files(char **module_names, int number_of_modules, char *output_name, int number_of_threads);
+
+/**
+ * Releases the memory of a linked program, leaving it empty.
+ *
+ * @param program Pointer to the program
+ * @return void
+ */
+void free_linked_program(LinkedProgram *program);
+
+#endif
@@ -0,0 +1,793 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include "diagnostics.h"
+#include "live_document.h"
+
+/**
+ * Copies bytes into a new null-terminated string.
+ *
+ * @param text The bytes
+ * @param length The number of bytes
+ * @return char* The new string, or NULL if memory ran out
+ */
+static char *copy_text(const char *text, size_t length) {
+    char *copy = malloc(length + 1);
+
+    if (check_memory_allocation(copy) == FALSE) {
+        return NULL;
+    }
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/**
+ * Counts the diagnostics reported into an output buffer, one per line.
+ *
+ * @param reported Pointer to the output buffer
+ * @return int The number of diagnostics
+ */
+static int count_reported_diagnostics(OutputBuffer *reported) {
+    int count = 0;
+    size_t position = 0;
+
+    while (position < reported->length) {
+        char *newline = memchr(reported->data + position, '\n', reported->length - position);
+
+        position = newline == NULL ? reported->length : (size_t)(newline - reported->data) + 1;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Hashes the name of a symbol.
+ *
+ * @param symbol_name The name of the symbol
+ * @return unsigned long The hash of the name
+ */
+static unsigned long hash_symbol_name(const char *symbol_name) {
+    unsigned long hash = 5381;
+
+    while (*symbol_name != '\0') {
+        hash = hash * 33 + (unsigned char)*symbol_name++;
+    }
+    return hash;
+}
+
+/**
+ * Finds the link to the entry of a symbol in the symbol table of a document.
+ *
+ * @param document Pointer to the document, its symbol table must have buckets
+ * @param symbol_name The name of the symbol
+ * @return DocumentSymbol** Pointer to the link to the entry, or to the NULL link ending its bucket if there is none
+ */
+static DocumentSymbol **find_symbol_link(LiveDocument *document, const char *symbol_name) {
+    DocumentSymbol **link = &document->symbol_buckets[hash_symbol_name(symbol_name) &
+                                                      (unsigned long)(document->number_of_buckets - 1)];
+
+    while (*link != NULL && strcmp((*link)->symbol_name, symbol_name) != 0) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+/**
+ * Doubles the number of buckets of the symbol table of a document, moving every entry to its new bucket.
+ *
+ * @param document Pointer to the document
+ * @return int TRUE if the table grew, FALSE if memory ran out, in which case it is unchanged
+ */
+static int grow_symbol_table(LiveDocument *document) {
+    int new_number_of_buckets = document->number_of_buckets == 0 ? 256 : document->number_of_buckets * 2;
+    DocumentSymbol **new_buckets = (DocumentSymbol **) calloc(new_number_of_buckets, sizeof(DocumentSymbol *));
+    int i;
+
+    if (check_memory_allocation(new_buckets) == FALSE) {
+        return FALSE;
+    }
+    for (i = 0; i < document->number_of_buckets; i++) {
+        while (document->symbol_buckets[i] != NULL) {
+            DocumentSymbol *moved = document->symbol_buckets[i];
+            unsigned long bucket = hash_symbol_name(moved->symbol_name) & (unsigned long)(new_number_of_buckets - 1);
+
+            document->symbol_buckets[i] = moved->next;
+            moved->next = new_buckets[bucket];
+            new_buckets[bucket] = moved;
+        }
+    }
+    free(document->symbol_buckets);
+    document->symbol_buckets = new_buckets;
+    document->number_of_buckets = new_number_of_buckets;
+    return TRUE;
+}
+
+/**
+ * Finds the entry of a symbol in the symbol table of a document, adding an entry without definitions
+ * or uses if there is none.
+ *
+ * @param document Pointer to the document
+ * @param symbol_name The name of the symbol
+ * @return DocumentSymbol* Pointer to the entry, or NULL if memory ran out
+ */
+static DocumentSymbol *find_or_add_symbol(LiveDocument *document, const char *symbol_name) {
+    DocumentSymbol **link;
+    DocumentSymbol *added;
+
+    /* Keep at most one symbol per bucket on average */
+    if (document->number_of_symbols >= document->number_of_buckets && grow_symbol_table(document) == FALSE) {
+        return NULL;
+    }
+
+    link = find_symbol_link(document, symbol_name);
+    if (*link != NULL) {
+        return *link;
+    }
+
+    added = (DocumentSymbol *) calloc(1, sizeof(DocumentSymbol));
+    if (check_memory_allocation(added) == FALSE) {
+        return NULL;
+    }
+    added->symbol_name = copy_text(symbol_name, strlen(symbol_name));
+    if (added->symbol_name == NULL) {
+        free(added);
+        return NULL;
+    }
+    *link = added;
+    document->number_of_symbols++;
+    return added;
+}
+
+/**
+ * Removes the entry of a symbol from the symbol table of a document once no line defines or uses it
+ * and no edit is changing it.
+ *
+ * @param document Pointer to the document
+ * @param symbol Pointer to the entry
+ * @return void
+ */
+static void release_symbol(LiveDocument *document, DocumentSymbol *symbol) {
+    DocumentSymbol **link;
+
+    if (symbol->number_of_definitions > 0 || symbol->head_of_uses != NULL || symbol->is_changed) {
+        return;
+    }
+    link = find_symbol_link(document, symbol->symbol_name);
+    *link = symbol->next;
+    free(symbol->symbol_name);
+    free(symbol);
+    document->number_of_symbols--;
+}
+
+/**
+ * Notes a symbol whose definitions an edit changes, with whether it was defined before the edit.
+ *
+ * @param symbol Pointer to the entry of the symbol, before its definitions change
+ * @param changed_symbols Pointer to the head of the list of the symbols the edit changes,
+ *        or NULL if the whole document is being checked
+ * @return void
+ */
+static void note_symbol_change(DocumentSymbol *symbol, DocumentSymbol **changed_symbols) {
+    if (changed_symbols == NULL || symbol->is_changed) {
+        return;
+    }
+    symbol->is_changed = TRUE;
+    symbol->was_defined = symbol->number_of_definitions > 0;
+    symbol->next_changed = *changed_symbols;
+    *changed_symbols = symbol;
+}
+
+/**
+ * Counts one more line defining a symbol in the symbol table of a document.
+ *
+ * @param document Pointer to the document
+ * @param symbol_name The name of the symbol
+ * @param changed_symbols Pointer to the head of the list of the symbols the edit changes,
+ *        or NULL if the whole document is being checked
+ * @return int TRUE if the definition was counted, FALSE if memory ran out
+ */
+static int add_defined_symbol(LiveDocument *document, const char *symbol_name, DocumentSymbol **changed_symbols) {
+    DocumentSymbol *symbol = find_or_add_symbol(document, symbol_name);
+
+    if (symbol == NULL) {
+        return FALSE;
+    }
+    note_symbol_change(symbol, changed_symbols);
+    symbol->number_of_definitions++;
+    return TRUE;
+}
+
+/**
+ * Counts one line less defining a symbol in the symbol table of a document.
+ *
+ * @param document Pointer to the document
+ * @param symbol_name The name of the symbol
+ * @param changed_symbols Pointer to the head of the list of the symbols the edit changes
+ * @return void
+ */
+static void remove_defined_symbol(LiveDocument *document, const char *symbol_name,
+                                  DocumentSymbol **changed_symbols) {
+    DocumentSymbol *symbol;
+
+    if (document->number_of_buckets == 0 || (symbol = *find_symbol_link(document, symbol_name)) == NULL) {
+        return;
+    }
+    note_symbol_change(symbol, changed_symbols);
+    symbol->number_of_definitions--;
+    release_symbol(document, symbol);
+}
+
+/**
+ * Links a symbol an expanded line uses to the entry of the symbol in the symbol table of a document.
+ *
+ * @param document Pointer to the document
+ * @param checked Pointer to the expanded line
+ * @param symbol_name The name of the symbol
+ * @return int TRUE if the use was linked, FALSE if memory ran out
+ */
+static int link_symbol_use(LiveDocument *document, CheckedLine *checked, const char *symbol_name) {
+    DocumentSymbol *symbol = find_or_add_symbol(document, symbol_name);
+    SymbolUse *use;
+
+    if (symbol == NULL) {
+        return FALSE;
+    }
+    use = &checked->uses[checked->number_of_uses++];
+    use->line = checked;
+    use->symbol = symbol;
+    use->previous = NULL;
+    use->next = symbol->head_of_uses;
+    if (use->next != NULL) {
+        use->next->previous = use;
+    }
+    symbol->head_of_uses = use;
+    return TRUE;
+}
+
+/**
+ * Unlinks the symbols an expanded line uses from their entries in the symbol table of a document.
+ *
+ * @param document Pointer to the document
+ * @param checked Pointer to the expanded line
+ * @return void
+ */
+static void unlink_symbol_uses(LiveDocument *document, CheckedLine *checked) {
+    int i;
+
+    for (i = 0; i < checked->number_of_uses; i++) {
+        SymbolUse *use = &checked->uses[i];
+
+        if (use->previous != NULL) {
+            use->previous->next = use->next;
+        } else {
+            use->symbol->head_of_uses = use->next;
+        }
+        if (use->next != NULL) {
+            use->next->previous = use->previous;
+        }
+        release_symbol(document, use->symbol);
+    }
+    checked->number_of_uses = 0;
+}
+
+/**
+ * Frees the symbol table of a document, leaving it without buckets.
+ * The lines must not use the symbols anymore.
+ *
+ * @param document Pointer to the document
+ * @return void
+ */
+static void free_document_symbols(LiveDocument *document) {
+    int i;
+
+    for (i = 0; i < document->number_of_buckets; i++) {
+        while (document->symbol_buckets[i] != NULL) {
+            DocumentSymbol *removed = document->symbol_buckets[i];
+
+            document->symbol_buckets[i] = removed->next;
+            free(removed->symbol_name);
+            free(removed);
+        }
+    }
+    free(document->symbol_buckets);
+    document->symbol_buckets = NULL;
+    document->number_of_buckets = 0;
+    document->number_of_symbols = 0;
+}
+
+/**
+ * Frees the expanded lines and the diagnostics of a document line, keeping its text.
+ * The symbols the expanded lines define stay in the symbol table.
+ *
+ * @param document Pointer to the document
+ * @param line Pointer to the document line
+ * @return void
+ */
+static void clear_document_line(LiveDocument *document, DocumentLine *line) {
+    int i;
+
+    for (i = 0; i < line->number_of_checked; i++) {
+        CheckedLine *checked = &line->checked[i];
+
+        unlink_symbol_uses(document, checked);
+        document->number_of_diagnostics -= checked->number_of_errors + (checked->second_pass_error != NO_ERROR);
+        free(checked->text);
+        free(checked->defined_symbol);
+    }
+    free(line->checked);
+    line->checked = NULL;
+    line->number_of_checked = 0;
+    document->number_of_diagnostics -= count_reported_diagnostics(&line->preprocessing_errors);
+    free_output_buffer(&line->preprocessing_errors);
+}
+
+/**
+ * Checks if a line expands the way a plain line does, to itself: none of its parts,
+ * as read_source_line splits it, starts with "mcro", "mcroend" or the name of a macro.
+ *
+ * @param head_of_macro_table Pointer to the head of the macro table
+ * @param text The bytes of the line
+ * @param length The number of bytes
+ * @return int TRUE if the line is plain, FALSE otherwise
+ */
+static int is_plain_text(MacroNode *head_of_macro_table, char *text, size_t length) {
+    SourceFile parts;
+    char part[MAX_LINE] = {0};
+
+    view_source_buffer(&parts, text, length);
+    while (read_source_line(part, sizeof(part), &parts)) {
+        char *save_pointer;
+        char *command = strtok_r(part, " \n\t", &save_pointer);
+
+        if (command != NULL && (strcmp(command, "mcro") == 0 || strcmp(command, "mcroend") == 0 ||
+                                is_macro_exist(head_of_macro_table, command))) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Checks a document line for preprocessing errors and expands it, splitting what it expands to
+ * into the lines of the expanded source. The expanded lines are not checked yet.
+ *
+ * @param document Pointer to the document
+ * @param line Pointer to the document line, without expanded lines
+ * @param line_number The number of the line, for the preprocessing diagnostics
+ * @param expansion Pointer to the expansion state before the line, advanced past it
+ * @return int TRUE if the line was expanded, FALSE if memory ran out
+ */
+static int expand_document_line(LiveDocument *document, DocumentLine *line, int line_number,
+                                MacroExpansion *expansion) {
+    OutputBuffer *sink = current_diagnostics_sink();
+    OutputBuffer expanded = {NULL, 0, 0};
+    SourceFile parts;
+    char part[MAX_LINE] = {0};
+    int number_of_lines = 0;
+    int is_expanded = TRUE;
+
+    line->is_plain = expansion->macro_state == MACRO_OUTSIDE &&
+                     is_plain_text(expansion->head_of_macro_table, line->text, line->length);
+
+    /* Keep the preprocessing diagnostics of the line with it */
+    capture_diagnostics(&line->preprocessing_errors);
+    view_source_buffer(&parts, line->text, line->length);
+    while (read_source_line(part, sizeof(part), &parts)) {
+        check_preprocessing_line(part, line_number);
+    }
+    capture_diagnostics(sink);
+    document->number_of_diagnostics += count_reported_diagnostics(&line->preprocessing_errors);
+
+    rewind_source_file(&parts);
+    while (is_expanded && read_source_line(part, sizeof(part), &parts)) {
+        is_expanded = expand_macro_line(expansion, part, &expanded);
+    }
+    line->state_after = expansion->macro_state;
+    line->is_plain = line->is_plain && line->state_after == MACRO_OUTSIDE;
+
+    /* Split the expansion into lines the way the expanded source is read */
+    view_source_buffer(&parts, expanded.data, expanded.length);
+    while (is_expanded && read_source_line(part, sizeof(part), &parts)) {
+        number_of_lines++;
+    }
+    if (is_expanded && number_of_lines > 0) {
+        line->checked = (CheckedLine *) calloc(number_of_lines, sizeof(CheckedLine));
+        is_expanded = check_memory_allocation(line->checked);
+    }
+
+    rewind_source_file(&parts);
+    while (is_expanded && read_source_line(part, sizeof(part), &parts)) {
+        CheckedLine *checked = &line->checked[line->number_of_checked++];
+
+        checked->text = copy_text(part, strlen(part));
+        checked->second_pass_error = NO_ERROR;
+        is_expanded = checked->text != NULL;
+    }
+
+    free_output_buffer(&expanded);
+    return is_expanded;
+}
+
+/**
+ * Checks an expanded line for first pass errors, adds the symbol it defines to the symbol table,
+ * and links the symbols it uses if it has no error.
+ *
+ * @param document Pointer to the document
+ * @param checked Pointer to the expanded line
+ * @param changed_symbols Pointer to the head of the list of the symbols the edit changes,
+ *        or NULL if the whole document is being checked
+ * @return int TRUE if the line was checked, FALSE if memory ran out
+ */
+static int check_expanded_line(LiveDocument *document, CheckedLine *checked, DocumentSymbol **changed_symbols) {
+    char symbol[MAX_LINE] = {0};
+
+    checked->number_of_errors = find_first_pass_line_errors(checked->text, document->head_of_macro_table,
+                                                            check_line_errors_first_pass(checked->text),
+                                                            checked->errors);
+    document->number_of_diagnostics += checked->number_of_errors;
+
+    if (find_defined_symbol(checked->text, symbol) == TRUE && symbol[0] != '\0') {
+        checked->defined_symbol = copy_text(symbol, strlen(symbol));
+        if (checked->defined_symbol == NULL || add_defined_symbol(document, symbol, changed_symbols) == FALSE) {
+            return FALSE;
+        }
+    }
+
+    /* The symbols of a line are only looked up once the line itself is valid, as the second pass does */
+    if (checked->number_of_errors == 0) {
+        char symbols[MAX_OPERANDS][MAX_LINE];
+        int number_of_symbols = find_second_pass_symbols(checked->text, symbols);
+        int i;
+
+        for (i = 0; i < number_of_symbols; i++) {
+            if (link_symbol_use(document, checked, symbols[i]) == FALSE) {
+                return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Checks the symbols an expanded line uses against the symbol table, as check_line_errors_second_pass does
+ * with the symbols find_second_pass_symbols finds, but through the entries the uses are linked to.
+ *
+ * @param document Pointer to the document
+ * @param checked Pointer to the expanded line
+ * @return void
+ */
+static void check_symbol_uses(LiveDocument *document, CheckedLine *checked) {
+    int i;
+
+    document->number_of_diagnostics -= checked->second_pass_error != NO_ERROR;
+    checked->second_pass_error = NO_ERROR;
+    for (i = 0; i < checked->number_of_uses && checked->second_pass_error == NO_ERROR; i++) {
+        if (checked->uses[i].symbol->number_of_definitions == 0) {
+            checked->second_pass_error = ERR_SYMBOL_NOT_FOUND;
+        }
+    }
+    document->number_of_diagnostics += checked->second_pass_error != NO_ERROR;
+}
+
+/**
+ * Checks again the symbol uses of the lines using a symbol that an edit defined or left undefined,
+ * and ends the changes of the symbols the edit changed.
+ *
+ * @param document Pointer to the document, after the edit
+ * @param changed_symbols The head of the list of the symbols the edit changed
+ * @return void
+ */
+static void check_flipped_symbol_uses(LiveDocument *document, DocumentSymbol *changed_symbols) {
+    while (changed_symbols != NULL) {
+        DocumentSymbol *symbol = changed_symbols;
+
+        changed_symbols = symbol->next_changed;
+        if (symbol->was_defined != (symbol->number_of_definitions > 0)) {
+            SymbolUse *use;
+
+            for (use = symbol->head_of_uses; use != NULL; use = use->next) {
+                check_symbol_uses(document, use->line);
+            }
+        }
+        symbol->is_changed = FALSE;
+        symbol->next_changed = NULL;
+        release_symbol(document, symbol);
+    }
+}
+
+/**
+ * Frees the lines and the tables of a document, leaving it empty.
+ *
+ * @param document Pointer to the document
+ * @return void
+ */
+static void empty_document(LiveDocument *document) {
+    int i;
+
+    for (i = 0; i < document->number_of_lines; i++) {
+        clear_document_line(document, &document->lines[i]);
+        free(document->lines[i].text);
+    }
+    free(document->lines);
+    free_macro_nodes(document->head_of_macro_table);
+    free_document_symbols(document);
+    document->lines = NULL;
+    document->number_of_lines = 0;
+    document->capacity = 0;
+    document->head_of_macro_table = NULL;
+    document->number_of_diagnostics = 0;
+}
+
+/**
+ * Checks every line of a document again, from the expansion of the macros to the symbol uses.
+ *
+ * @param document Pointer to the document
+ * @return int TRUE if the document was checked, FALSE if memory ran out, in which case it is left empty
+ */
+static int check_all_lines(LiveDocument *document) {
+    MacroExpansion expansion;
+    int is_checked = TRUE;
+    int i, j;
+
+    for (i = 0; i < document->number_of_lines; i++) {
+        clear_document_line(document, &document->lines[i]);
+    }
+    free_macro_nodes(document->head_of_macro_table);
+    free_document_symbols(document);
+    document->head_of_macro_table = NULL;
+
+    /* Expand every line first, the line checks need the whole macro table */
+    begin_macro_expansion(&expansion);
+    for (i = 0; i < document->number_of_lines && is_checked; i++) {
+        is_checked = expand_document_line(document, &document->lines[i], i + 1, &expansion);
+    }
+    document->head_of_macro_table = expansion.head_of_macro_table;
+
+    for (i = 0; i < document->number_of_lines && is_checked; i++) {
+        for (j = 0; j < document->lines[i].number_of_checked && is_checked; j++) {
+            is_checked = check_expanded_line(document, &document->lines[i].checked[j], NULL);
+        }
+    }
+
+    /* The symbol uses are checked once every line has added its symbol */
+    for (i = 0; i < document->number_of_lines && is_checked; i++) {
+        for (j = 0; j < document->lines[i].number_of_checked; j++) {
+            check_symbol_uses(document, &document->lines[i].checked[j]);
+        }
+    }
+
+    if (!is_checked) {
+        empty_document(document);
+    }
+    return is_checked;
+}
+
+/**
+ * Replaces a range of lines of a document with the lines of a text, without checking them.
+ *
+ * @param document Pointer to the document
+ * @param first_line The first line to replace
+ * @param number_of_replaced The number of lines to replace
+ * @param text The text of the new lines, each one ending after its newline
+ * @param length The length of the text
+ * @param number_of_new Pointer to set to the number of new lines
+ * @return int TRUE if the lines were replaced, FALSE if memory ran out, in which case the document
+ *         is either unchanged or holds new lines without text
+ */
+static int replace_lines(LiveDocument *document, int first_line, int number_of_replaced, char *text, size_t length,
+                         int *number_of_new) {
+    int count = 0;
+    int new_count;
+    int is_copied = TRUE;
+    size_t position;
+    int i;
+
+    /* Count the new lines, the last one may not end with a newline */
+    for (position = 0; position < length; count++) {
+        char *newline = memchr(text + position, '\n', length - position);
+
+        position = newline == NULL ? length : (size_t)(newline - text) + 1;
+    }
+
+    new_count = document->number_of_lines - number_of_replaced + count;
+    if (new_count > document->capacity) {
+        int new_capacity = document->capacity == 0 ? 64 : document->capacity;
+        DocumentLine *new_lines;
+
+        while (new_capacity < new_count) {
+            new_capacity *= 2;
+        }
+        new_lines = (DocumentLine *) realloc(document->lines, new_capacity * sizeof(DocumentLine));
+        if (check_memory_allocation(new_lines) == FALSE) {
+            return FALSE;
+        }
+        document->lines = new_lines;
+        document->capacity = new_capacity;
+    }
+
+    for (i = first_line; i < first_line + number_of_replaced; i++) {
+        clear_document_line(document, &document->lines[i]);
+        free(document->lines[i].text);
+    }
+    if (first_line + number_of_replaced < document->number_of_lines) {
+        memmove(document->lines + first_line + count, document->lines + first_line + number_of_replaced,
+                (document->number_of_lines - first_line - number_of_replaced) * sizeof(DocumentLine));
+    }
+    document->number_of_lines = new_count;
+
+    /* Fill the new lines, a line that cannot be copied is left without text */
+    position = 0;
+    for (i = first_line; i < first_line + count; i++) {
+        char *newline = memchr(text + position, '\n', length - position);
+        size_t end = newline == NULL ? length : (size_t)(newline - text) + 1;
+        DocumentLine *line = &document->lines[i];
+
+        memset(line, 0, sizeof(DocumentLine));
+        line->text = copy_text(text + position, end - position);
+        line->length = line->text == NULL ? 0 : end - position;
+        is_copied = is_copied && line->text != NULL;
+        position = end;
+    }
+    *number_of_new = count;
+    return is_copied;
+}
+
+int open_live_document(LiveDocument *document, const char *text, size_t length) {
+    int number_of_new;
+
+    document->lines = NULL;
+    document->number_of_lines = 0;
+    document->capacity = 0;
+    document->head_of_macro_table = NULL;
+    document->symbol_buckets = NULL;
+    document->number_of_buckets = 0;
+    document->number_of_symbols = 0;
+    document->number_of_diagnostics = 0;
+
+    if (replace_lines(document, 0, 0, (char *) text, length, &number_of_new) == FALSE) {
+        empty_document(document);
+        return FALSE;
+    }
+    return check_all_lines(document);
+}
+
+/**
+ * Moves a position of a document onto its text: a position past the end of a line
+ * to the end of the line, and a position past the last line to the end of the document.
+ *
+ * @param document Pointer to the document
+ * @param line Pointer to the line of the position
+ * @param character Pointer to the byte of the position within its line
+ * @return void
+ */
+static void clamp_position(LiveDocument *document, int *line, int *character) {
+    int number_of_lines = document->number_of_lines;
+    DocumentLine *last = number_of_lines > 0 ? &document->lines[number_of_lines - 1] : NULL;
+
+    if (*line < 0) {
+        *line = 0;
+        *character = 0;
+    }
+
+    /* Past the last line is after the newline of the last line, or at the end of the last line if it has none */
+    if (*line >= number_of_lines) {
+        if (last != NULL && (last->length == 0 || last->text[last->length - 1] != '\n')) {
+            *line = number_of_lines - 1;
+            *character = (int) last->length;
+        } else {
+            *line = number_of_lines;
+            *character = 0;
+        }
+    } else {
+        DocumentLine *current = &document->lines[*line];
+        int content_length = (int) current->length;
+
+        if (content_length > 0 && current->text[content_length - 1] == '\n') {
+            content_length--;
+        }
+        if (*character < 0) {
+            *character = 0;
+        } else if (*character > content_length) {
+            *character = content_length;
+        }
+    }
+}
+
+int edit_live_document(LiveDocument *document, int start_line, int start_character, int end_line,
+                       int end_character, const char *text, size_t length) {
+    OutputBuffer replacement = {NULL, 0, 0};
+    DocumentSymbol *changed_symbols = NULL;
+    MacroExpansion expansion;
+    int first_line, number_of_replaced, number_of_new;
+    int is_incremental = TRUE;
+    int is_edited = TRUE;
+    int i, j;
+
+    clamp_position(document, &start_line, &start_character);
+    clamp_position(document, &end_line, &end_character);
+    if (end_line < start_line || (end_line == start_line && end_character < start_character)) {
+        end_line = start_line;
+        end_character = start_character;
+    }
+
+    /* The edit replaces whole lines: the start of the first one, the text, and the end of the last one */
+    if (start_line < document->number_of_lines && start_character > 0) {
+        output_append(&replacement, document->lines[start_line].text, (size_t) start_character);
+    }
+    if (length > 0) {
+        output_append(&replacement, text, length);
+    }
+    if (end_line < document->number_of_lines && document->lines[end_line].length > (size_t) end_character) {
+        DocumentLine *last = &document->lines[end_line];
+
+        output_append(&replacement, last->text + end_character, last->length - (size_t) end_character);
+    }
+    if (replacement.is_out_of_memory) {
+        free_output_buffer(&replacement);
+        empty_document(document);
+        return FALSE;
+    }
+    first_line = start_line;
+    number_of_replaced = (end_line < document->number_of_lines ? end_line + 1 : end_line) - start_line;
+
+    /* Only an edit of plain lines into plain lines, outside the macro definitions, leaves the macros as they are */
+    if (first_line > 0 && document->lines[first_line - 1].state_after == MACRO_INSIDE) {
+        is_incremental = FALSE;
+    }
+    for (i = first_line; i < first_line + number_of_replaced && is_incremental; i++) {
+        is_incremental = document->lines[i].is_plain;
+    }
+    if (is_incremental) {
+        is_incremental = is_plain_text(document->head_of_macro_table, replacement.data, replacement.length);
+    }
+
+    /* The symbols the replaced lines define are removed before the new lines add theirs */
+    for (i = first_line; i < first_line + number_of_replaced && is_incremental; i++) {
+        for (j = 0; j < document->lines[i].number_of_checked; j++) {
+            char *symbol = document->lines[i].checked[j].defined_symbol;
+
+            if (symbol != NULL) {
+                remove_defined_symbol(document, symbol, &changed_symbols);
+            }
+        }
+    }
+
+    is_edited = replace_lines(document, first_line, number_of_replaced, replacement.data, replacement.length,
+                              &number_of_new);
+    free_output_buffer(&replacement);
+
+    if (is_edited && !is_incremental) {
+        return check_all_lines(document);
+    }
+
+    /* Check the new lines, expanding them with the macros of the document */
+    begin_macro_expansion(&expansion);
+    expansion.head_of_macro_table = document->head_of_macro_table;
+    for (i = first_line; i < first_line + number_of_new && is_edited; i++) {
+        DocumentLine *line = &document->lines[i];
+
+        is_edited = expand_document_line(document, line, i + 1, &expansion);
+        for (j = 0; j < line->number_of_checked && is_edited; j++) {
+            is_edited = check_expanded_line(document, &line->checked[j], &changed_symbols);
+        }
+    }
+
+    /* Check the symbol uses of the new lines, and of the other lines that use a symbol the edit defined or removed */
+    for (i = first_line; i < first_line + number_of_new && is_edited; i++) {
+        for (j = 0; j < document->lines[i].number_of_checked; j++) {
+            check_symbol_uses(document, &document->lines[i].checked[j]);
+        }
+    }
+    check_flipped_symbol_uses(document, changed_symbols);
+
+    if (!is_edited) {
+        empty_document(document);
+    }
+    return is_edited;
+}
+
+void close_live_document(LiveDocument *document) {
+    empty_document(document);
+}
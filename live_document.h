@@ -0,0 +1,108 @@
+#ifndef LIVE_DOCUMENT_H
+#define LIVE_DOCUMENT_H
+
+#include "first_second_pass.h"
+
+/**
+ * Links a symbol an expanded line uses to the entry of the symbol, so an edit that defines the symbol
+ * or leaves it undefined finds the lines to check again.
+ */
+typedef struct SymbolUse {
+    struct CheckedLine *line; /* The expanded line using the symbol */
+    struct DocumentSymbol *symbol; /* The entry of the symbol in the symbol table */
+    struct SymbolUse *previous; /* Pointer to the previous use of the same symbol */
+    struct SymbolUse *next; /* Pointer to the next use of the same symbol */
+} SymbolUse;
+
+/**
+ * Holds the checks of one line of the expanded source.
+ */
+typedef struct CheckedLine {
+    char *text; /* The line, as read_source_line reads it from the expanded source */
+    ErrorCode errors[MAX_LINE_ERRORS]; /* The errors find_first_pass_line_errors finds in the line */
+    int number_of_errors; /* The number of first pass errors */
+    char *defined_symbol; /* The symbol the line adds to the symbol table, NULL if none */
+    SymbolUse uses[MAX_OPERANDS]; /* The symbols the line uses, found only if it has no first pass error */
+    int number_of_uses; /* The number of symbols the line uses */
+    ErrorCode second_pass_error; /* The error check_line_errors_second_pass finds in the line, or NO_ERROR */
+} CheckedLine;
+
+/**
+ * Holds one symbol of a document: the lines defining it and the lines using it.
+ * The entry is kept as long as a line defines or uses the symbol.
+ */
+typedef struct DocumentSymbol {
+    char *symbol_name; /* The name of the symbol */
+    int number_of_definitions; /* The number of lines defining the symbol */
+    SymbolUse *head_of_uses; /* Pointer to the first use of the symbol */
+    int is_changed; /* TRUE while an edit changes the definitions of the symbol */
+    int was_defined; /* TRUE if the symbol was defined before the edit changing it */
+    struct DocumentSymbol *next_changed; /* Pointer to the next symbol the edit changes */
+    struct DocumentSymbol *next; /* Pointer to the next symbol in the same bucket */
+} DocumentSymbol;
+
+/**
+ * Holds one line of a document and what it expands to.
+ */
+typedef struct {
+    char *text; /* The bytes of the line, with its newline unless it is the last line of the document */
+    size_t length; /* The number of bytes of the line */
+    int is_plain; /* TRUE if the line neither defines, ends nor calls a macro, nor is inside a definition */
+    MacroState state_after; /* Whether a macro definition is open after the line */
+    OutputBuffer preprocessing_errors; /* The preprocessing diagnostics of the line, as they are reported */
+    CheckedLine *checked; /* The lines of the expanded source the line expands to */
+    int number_of_checked; /* The number of expanded lines */
+} DocumentLine;
+
+/**
+ * Holds a document kept open for editing with the checks of every line,
+ * so an edit only checks again the lines it changes and the lines using the symbols it defines or removes.
+ */
+typedef struct {
+    DocumentLine *lines; /* The lines of the document */
+    int number_of_lines; /* The number of lines */
+    int capacity; /* The number of lines allocated */
+    MacroNode *head_of_macro_table; /* The macros the document defines */
+    DocumentSymbol **symbol_buckets; /* The symbols the lines define or use, hashed by name */
+    int number_of_buckets; /* The number of buckets, a power of two */
+    int number_of_symbols; /* The number of symbols in the table */
+    int number_of_diagnostics; /* The number of diagnostics of all the lines */
+} LiveDocument;
+
+/**
+ * Opens a document and checks all of its lines.
+ *
+ * @param document Pointer to the document to fill
+ * @param text The text of the document
+ * @param length The length of the text
+ * @return int TRUE if the document was opened, FALSE if memory ran out, in which case it is left empty
+ */
+int open_live_document(LiveDocument *document, const char *text, size_t length);
+
+/**
+ * Replaces a range of the text of a document and checks it again.
+ * The lines the edit replaces are checked again, along with the lines that use a symbol that the edit defines
+ * or leaves undefined. An edit that changes a macro definition or call checks the whole document again.
+ * Positions past the end of a line or of the document are moved back to it.
+ *
+ * @param document Pointer to the document
+ * @param start_line The line of the start of the range, from 0
+ * @param start_character The byte of the start of the range within its line, from 0
+ * @param end_line The line of the end of the range
+ * @param end_character The byte of the end of the range within its line
+ * @param text The text replacing the range
+ * @param length The length of the text
+ * @return int TRUE if the document was edited, FALSE if memory ran out, in which case it is left empty
+ */
+int edit_live_document(LiveDocument *document, int start_line, int start_character, int end_line,
+                       int end_character, const char *text, size_t length);
+
+/**
+ * Closes a document, freeing its lines and checks.
+ *
+ * @param document Pointer to the document
+ * @return void
+ */
+void close_live_document(LiveDocument *document);
+
+#endif
@@ -3,30 +3,31 @@
 #include <stddef.h>
 #include "macro_data.h"
 #include "first_second_pass_data.h"
+#include "diagnostics.h"
 
 int check_memory_allocation(void *ptr) {
     if (ptr == NULL) {
-        printf("Memory allocation failed!\n");
+        report_diagnostic("Memory allocation failed!\n");
         return FALSE;
     }
     return TRUE;
 }
 
-void add_macro_name(MacroNode **mcro_list_head, char *macro_name) {
+int add_macro_name(MacroNode **mcro_list_head, char *macro_name) {
     MacroNode *new_node;
 
     new_node = (MacroNode *)malloc(sizeof(MacroNode));
 
     /* Check if memory allocation was successful */
     if(check_memory_allocation(new_node) == FALSE) {
-        exit(1);
+        return FALSE;
     }
 
     /* Allocate memory for the macro name and copy the content manually */
     new_node->data = (char *)malloc(strlen(macro_name) + 1);
     if(check_memory_allocation(new_node->data) == FALSE) {
         free(new_node);
-        exit(1);
+        return FALSE;
     }
 
     /* Initialize the new macro node */
@@ -36,9 +37,10 @@ void add_macro_name(MacroNode **mcro_list_head, char *macro_name) {
 
     /* Insert the new node into the linked list */
     generic_insert_node((void**)mcro_list_head, (void*)new_node, offsetof(MacroNode, next));
+    return TRUE;
 }
 
-void add_macro_content(MacroNode *macro_list_head, char *macro_name, char *new_line_to_add) {
+int add_macro_content(MacroNode *macro_list_head, char *macro_name, char *new_line_to_add) {
     LineNode *new_node;
     MacroNode *temp = macro_list_head;
 
@@ -46,7 +48,7 @@ void add_macro_content(MacroNode *macro_list_head, char *macro_name, char *new_l
 
     /* Check if memory allocation was successful */
     if(check_memory_allocation(new_node) == FALSE) {
-        exit(1);
+        return FALSE;
     }
 
 
@@ -54,7 +56,7 @@ void add_macro_content(MacroNode *macro_list_head, char *macro_name, char *new_l
     new_node->line = (char *)malloc(strlen(new_line_to_add) + 1);
     if(check_memory_allocation(new_node->line) == FALSE) {
         free(new_node);
-        exit(1);
+        return FALSE;
     }
 
     /* Initialize the new macro node */
@@ -68,7 +70,7 @@ void add_macro_content(MacroNode *macro_list_head, char *macro_name, char *new_l
 
     /* Insert the new line node into the macro's content list */
     generic_insert_node((void**)&temp->content_of_macro, (void*)new_node, offsetof(LineNode, next));
-
+    return TRUE;
 }
 
 char *str_combined(MacroNode *macro_list_head, char* macro_name) {
@@ -96,7 +98,7 @@ char *str_combined(MacroNode *macro_list_head, char* macro_name) {
     result = (char *)malloc(total_length + 1);
     /* Check if memory allocation was successful */
     if(check_memory_allocation(result) == FALSE) {
-        exit(1);
+        return NULL;
     }
     result[0] = '\0';
 
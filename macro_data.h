@@ -2,13 +2,17 @@
 #define MACRO_DATA_H
 
 #include <stdio.h>
+#include "source_file.h"
+#include "output_buffer.h"
 
 #define TRUE 1 /* Boolean representation of TRUE */
 #define FALSE 0 /* Boolean representation of FALSE */
 #define ERROR_FOUND 1 /* Indicates that an error was found */
 #define ERROR_WAS_NOT_FOUND 0 /* Indicates that no errors were found */
+#define ERROR_OUT_OF_MEMORY 2 /* Indicates that memory ran out, so the work was abandoned */
 #define MAX_LINE 81 /* Maximum line length */
 #define MAX_MACRO_NAME 31 /* Maximum macro name length */
+#define STREAMED_EXPANSION_SIZE 65536 /* The expanded bytes gathered before a streamed expansion writes them out */
 
 /**
  * Represents the state of macro processing.
@@ -35,15 +39,24 @@ typedef struct MacroNode {
     LineNode *content_of_macro; /* Linked list containing the macro content */
 } MacroNode;
 
+/**
+ * Represents the state of macro expansion between the lines of a source.
+ */
+typedef struct {
+    MacroNode *head_of_macro_table; /* The macros defined so far */
+    MacroState macro_state; /* Whether the last line was inside a macro definition */
+    char macro_name[MAX_LINE]; /* The name of the macro being defined */
+} MacroExpansion;
+
 /**
  * Adds a new macro name to the macro table (linked list).
  *
  * @param head Pointer to the head of the macro table linked list
  * @param macro_name The name of the macro to be added
- * @return void
+ * @return int TRUE if the macro was added, FALSE if memory ran out
  *
  */
-void add_macro_name(MacroNode **head, char *macro_name);
+int add_macro_name(MacroNode **head, char *macro_name);
 
 /**
  * Adds a new line of content to a macro definition in the macro table.
@@ -51,15 +64,15 @@ void add_macro_name(MacroNode **head, char *macro_name);
  * @param head Pointer to the head of the macro table linked list
  * @param macro_name The name of the macro to which the content will be added
  * @param new_line_to_add The line of text to append to the macro definition
- * @return void
+ * @return int TRUE if the line was added, FALSE if memory ran out
  */
-void add_macro_content(MacroNode *head, char *macro_name, char *new_line_to_add);
+int add_macro_content(MacroNode *head, char *macro_name, char *new_line_to_add);
 
 /**
  * Combines all lines of a macro (from a linked list) into a single string.
  * @param head Pointer to the head of the macro list.
  * @param macro_name The name of the macro whose content to combine.
- * @return A dynamically allocated string containing all the lines of the macro.
+ * @return A dynamically allocated string containing all the lines of the macro, or NULL if memory ran out.
  */
 char *str_combined(MacroNode *head, char* command);
 
@@ -92,18 +105,69 @@ int check_file_open(FILE *file, char *file_name);
  * Checks for preprocessing errors in a file by validating macro definitions
  * and terminations.
  *
- * @param fd Pointer to the file being checked
+ * @param source Pointer to the mapped source file being checked
  * @return int ERROR_FOUND if any preprocessing errors are found, otherwise ERROR_WAS_NOT_FOUND.
  */
-int check_preprocessing_errors(FILE *fd);
+int check_preprocessing_errors(SourceFile *source);
+
+/**
+ * Checks one line of a source for preprocessing errors, validating macro definitions and terminations.
+ *
+ * @param line The line to check
+ * @param number_of_line The number of the line in the source, for the error messages
+ * @return int ERROR_FOUND if a preprocessing error is found, otherwise ERROR_WAS_NOT_FOUND.
+ */
+int check_preprocessing_line(char *line, int number_of_line);
+
+/**
+ * Checks if a macro with a given name exists in the macro linked list.
+ *
+ * @param head Pointer to the head of the macro linked list
+ * @param macro_name The name of the macro to search for
+ * @return int TRUE if the macro exists, otherwise FALSE.
+ */
+int is_macro_exist(MacroNode *head, char *macro_name);
+
+/**
+ * Starts the macro expansion of a source, with an empty macro table.
+ *
+ * @param expansion Pointer to the expansion state to initialize
+ * @return void
+ */
+void begin_macro_expansion(MacroExpansion *expansion);
+
+/**
+ * Expands one line of a source: records macro definitions in the macro table,
+ * replaces a macro call with the macro's content, and copies any other line to the output buffer.
+ *
+ * @param expansion Pointer to the expansion state
+ * @param line The line to expand
+ * @param expanded Pointer to the output buffer to store the expanded content
+ * @return int TRUE if the line was expanded, FALSE if memory ran out
+ */
+int expand_macro_line(MacroExpansion *expansion, char *line, OutputBuffer *expanded);
 
 /**
  * This function reads an assembly file line by line, expands macros,
- * and writes the expanded content to an output assembly macro (am) file.
+ * and writes the expanded content, the content of the assembly macro (am) file, to an output buffer.
+ *
+ * @param source Pointer to the mapped assembly file
+ * @param expanded Pointer to the output buffer to store the expanded content
+ * @param head_of_macro_table Pointer to set to the head of the macro table linked list, NULL if memory ran out
+ * @return int TRUE if the source was expanded, FALSE if memory ran out
+ */
+int file_preprocessing(SourceFile *source, OutputBuffer *expanded, MacroNode **head_of_macro_table);
+
+/**
+ * Expands the macros of a source as file_preprocessing does, but writes the expanded content to the am file
+ * as it goes instead of holding all of it: the expanded lines are gathered in a buffer that is written out
+ * every STREAMED_EXPANSION_SIZE bytes.
  *
- * @param fd Pointer to the assembly file
- * @param output_filename Name of the output file to store the expanded content
- * @return Pointer to the head of the macro table linked list
+ * @param source Pointer to the mapped assembly file
+ * @param file_name The name of the am file to create
+ * @param head_of_macro_table Pointer to set to the head of the macro table linked list, NULL on failure
+ * @return int TRUE if the source was expanded and written, FALSE if the file could not be written,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
  */
-MacroNode * file_preprocessing(FILE *fd, char *output_filename);
+int stream_file_preprocessing(SourceFile *source, char *file_name, MacroNode **head_of_macro_table);
 #endif
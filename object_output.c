@@ -0,0 +1,654 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "first_second_pass.h"
+#include "object_output.h"
+#include "diagnostics.h"
+
+/**
+ * Describes a range of object file records that one thread formats into the mapped file.
+ */
+typedef struct {
+    char *records; /* Pointer to the first record of the object file, right after the header */
+    unsigned long *code_words; /* The packed instruction words, indexed by address - 100 */
+    int code_count; /* The number of instruction words */
+    DataImage *data_image; /* The data image, placed right after the instructions */
+    int first_index; /* The index of the first word to format */
+    int last_index; /* The index after the last word to format */
+} ObjectFormatJob;
+
+/**
+ * Checks if there is any symbol in the symbol table with the entry flag set to 1.
+ *
+ * @param head_of_symbol_table Pointer to the head of the symbol table
+ * @return int TRUE if there is a symbol with the entry flag set to 1, FALSE otherwise.
+ */
+static int is_entry_exist(SymbolNode *head_of_symbol_table) {
+    SymbolNode *current = head_of_symbol_table;
+
+    /* Traverse the symbol table */
+    while (current != NULL) {
+
+        /* Check if the current symbol has the entry flag set to 1 */
+        if(current->entry_flag == 1) {
+            return TRUE;
+        }
+
+        /* Move to the next symbol in the table */
+        current = current->next;
+    }
+    return FALSE;
+}
+
+/**
+ * Counts occurrences of an external symbol in an assembly line, and finds the words of the line that name it.
+ * Every operand but a register takes a word after the first word of the line, in operand order.
+ *
+ * @param line A string representing the assembly code line
+ * @param symbol_name A string representing the external symbol to check
+ * @param word_offsets The offsets from the first word of the line of the words naming the symbol, filled in order
+ * @return int Number of times the external symbol appears (0, 1, or 2)
+ */
+static int count_extern_symbol_in_line(char * line, char *symbol_name, int word_offsets[MAX_OPERANDS]) {
+    int external_symbol_count = 0;
+
+    int i = 0, j = 0;
+
+    char input_buffer[MAX_LINE] = {0};
+    char *input = input_buffer;
+    char first_operand[MAX_LINE] = {0};
+    char second_operand[MAX_LINE] = {0};
+    char command[MAX_LINE] = {0};
+
+    /* The line passed the checks of the first pass, so it fits in a line buffer */
+    strcpy(input, line);
+
+    /* Check if the line starts with a symbol (label) */
+    if (is_symbol(input) == TRUE) {
+
+        /* Pass the label (until ':') */
+        while (input[i] != ':') i++;
+
+        /* Pass the ':' character */
+        i++;
+    }
+
+    /* Skip leading spaces in input */
+    while (isspace(input[i])) i++;
+    input = input + i;
+    i = 0;
+
+    /* Extract the command name from input */
+    while (!isspace(input[i]) && input[i] != '\0' && input[i] != ',') {
+        command[j++] = input[i++];
+    }
+    command[j] = '\0';
+    input = input + i;
+    i = 0;
+    j = 0;
+
+    /* Skip leading spaces in input */
+    while (isspace(input[i])) i++;
+    input = input + i;
+    i = 0;
+
+    /* Check if it's a command line and not a directive */
+    if (is_directive(command) == FALSE) {
+
+        /* Check if there are operands */
+        if (number_of_operands(command) != 0) {
+
+            /* Extract the first operand from the input */
+            while (!isspace(input[i]) && input[i] != ',' && input[i] != '\0') {
+                first_operand[j++] = input[i++];
+            }
+            first_operand[j] = '\0';
+            input = input + i;
+            i = 0;
+            j = 0;
+
+            /* Check if the first operand is the external symbol, it is named by the word after the first word */
+            if (strcmp(first_operand, symbol_name) == 0) {
+                word_offsets[external_symbol_count++] = 1;
+            }
+
+            /* If there are two operands */
+            if (number_of_operands(command) == 2) {
+
+                /* Skip spaces between operands */
+                while (isspace(input[i])) i++;
+
+                /* +1 for skip the comma between operands */
+                input = input + i + 1;
+                i = 0;
+
+                /* Skip spaces before the second operand */
+                while (isspace(input[i])) i++;
+                input = input + i;
+                i = 0;
+
+                /* Extract the second operand from the input */
+                while (!isspace(input[i]) && input[i] != ',' && input[i] != '\0') {
+                    second_operand[j++] = input[i++];
+                }
+                second_operand[j] = '\0';
+
+                /* Check if the second operand is the external symbol, its word follows that of a first operand
+                 * that is not a register */
+                if (strcmp(second_operand, symbol_name) == 0) {
+                    word_offsets[external_symbol_count++] = is_register(first_operand) == TRUE ? 1 : 2;
+                }
+
+            }
+        }
+    }
+    return external_symbol_count;
+}
+
+/**
+ * Compares the addresses of two BinaryMachineCode structures
+ *
+ * @param x Pointer to the first BinaryMachineCode structure
+ * @param y Pointer to the second BinaryMachineCode structure
+ * @return int the difference between the addresses.
+ *             a positive number if the address of 'x' is greater,
+ *             a negative number if 'x' is smaller, and zero if the addresses are equal.
+ */
+static int compare_addresses(const void *x, const void *y) {
+    return ((BinaryMachineCode *)x)->address - ((BinaryMachineCode *)y)->address;
+}
+
+/**
+ * Sorts a linked list of instruction machine code words by their addressess.
+ * Data words are not part of the list, they are kept in the data image.
+ *
+ * @param head_of_lines_list Pointer to the head of the assembly line list
+ * @param ICF The instruction counter value
+ * @param sorted_code Pointer to set to the sorted array of BinaryMachineCode, or NULL if there are no instructions
+ * @return int TRUE if the list was sorted, FALSE if memory ran out
+ */
+static int sort_machine_code_list(AssemblyLineList *head_of_lines_list, int ICF, BinaryMachineCode **sorted_code) {
+
+    /* Calculate the total number of instruction words in the list based on ICF */
+    size_t word_count = ICF - 100;
+
+    BinaryMachineCode *array;
+    AssemblyLineList *current;
+
+    int i;
+    int array_index = 0;
+
+    /* Nothing to sort if the program has no instructions */
+    *sorted_code = NULL;
+    if (word_count == 0) {
+        return TRUE;
+    }
+
+    array = malloc(word_count * sizeof(BinaryMachineCode));
+    if(check_memory_allocation(array) == FALSE) {
+        return FALSE;
+    }
+
+    current = head_of_lines_list;
+
+    /* Traverse the assembly line list */
+    while (current != NULL) {
+        BinaryMachineCode *current_code = current->code;
+
+        /* Traverse the machine code linked list for the current assembly line */
+        while (current_code != NULL) {
+
+            array[array_index].word = malloc(strlen(current_code->word) + 1);
+            if(check_memory_allocation(array[array_index].word) == FALSE) {
+                free_machine_code_list(array, array_index);
+                return FALSE;
+            }
+
+            /* Copy the current machine code word into the array */
+            strcpy(array[array_index].word, current_code->word);
+            array[array_index].address = current_code->address;
+            array[array_index].is_in_block = FALSE;
+            array[array_index].next = NULL;
+
+            /* Link the current node in the array to the previous one (if it's not the first node) */
+            if (array_index > 0) {
+                array[array_index - 1].next = &array[array_index];
+            }
+
+            array_index++;
+
+            /* Move to the next machine code word */
+            current_code = current_code->next;
+        }
+        current = current->next;
+    }
+
+    /* Sort the array based on the address field of the BinaryMachineCode */
+    qsort(array, word_count, sizeof(BinaryMachineCode), compare_addresses);
+
+    /* After sorting, rebuild the linked list structure by linking the array elements */
+    for (i = 0; i < word_count - 1; i++) {
+
+        /* Link the current array node */
+        array[i].next = &array[i + 1];
+    }
+
+    /* Set the last node to NULL */
+    array[word_count - 1].next = NULL;
+
+    *sorted_code = array;
+    return TRUE;
+}
+
+
+/**
+ * Appends one record of the object file: the address as 7 decimal digits and the word as 6 hexadecimal digits.
+ *
+ * @param output Pointer to the output buffer
+ * @param address The address of the word
+ * @param word The packed machine word
+ * @return void
+ */
+static void append_word_record(OutputBuffer *output, int address, unsigned long word) {
+    output_append_decimal(output, (unsigned long)address, 7);
+    output_append(output, " ", 1);
+    output_append_hex_word(output, word);
+    output_append(output, "\n", 1);
+}
+
+/**
+ * Appends one record of the entries or externals file: the symbol name and the address as 7 decimal digits.
+ *
+ * @param output Pointer to the output buffer
+ * @param symbol_name The name of the symbol
+ * @param address The address to write
+ * @return void
+ */
+static void append_symbol_record(OutputBuffer *output, char *symbol_name, int address) {
+    output_append_string(output, symbol_name);
+    output_append(output, " ", 1);
+    output_append_decimal(output, (unsigned long)address, 7);
+    output_append(output, "\n", 1);
+}
+
+/**
+ * Appends the header line of the object file, the instruction and data counters (ICF - 100 and DCF).
+ *
+ * @param output Pointer to the output buffer
+ * @param ICF The instruction counter value
+ * @param DCF The data counter value
+ * @return void
+ */
+static void append_object_header(OutputBuffer *output, int ICF, int DCF) {
+    output_append(output, "    ", 4);
+    output_append_decimal(output, (unsigned long)(ICF - 100), 0);
+    output_append(output, " ", 1);
+    output_append_decimal(output, (unsigned long)DCF, 0);
+    output_append(output, "\n", 1);
+}
+
+/**
+ * Appends the records of the data image, which is placed right after the instructions.
+ *
+ * @param output Pointer to the output buffer
+ * @param data_image Pointer to the data image
+ * @param ICF The instruction counter value, the address of the first data word
+ * @return void
+ */
+static void append_data_records(OutputBuffer *output, DataImage *data_image, int ICF) {
+    int i;
+
+    for (i = 0; i < data_image->count; i++) {
+        append_word_record(output, ICF + i, data_image->words[i]);
+    }
+}
+
+int build_object_output(OutputBuffer *output, AssemblyLineList *head_of_lines_list, DataImage *data_image, int ICF, int DCF) {
+    BinaryMachineCode *sorted_code;
+    BinaryMachineCode *current_code;
+
+    /* Write the instruction and data counters (ICF - 100 and DCF) to the object file */
+    append_object_header(output, ICF, DCF);
+
+    /* Sort the machine code linked list */
+    if (sort_machine_code_list(head_of_lines_list, ICF, &sorted_code) == FALSE) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    current_code = sorted_code;
+
+    while (current_code != NULL) {
+        /* Write the machine code address and its corresponding packed value to the object file */
+        append_word_record(output, current_code->address, binary_word_value(current_code->word));
+        current_code = current_code->next;
+    }
+
+    /* Write the data image, which is placed right after the instructions */
+    append_data_records(output, data_image, ICF);
+
+    /* Free the machine code list */
+    free_machine_code_list(sorted_code, ICF - 100);
+    return output->is_out_of_memory ? ERROR_OUT_OF_MEMORY : TRUE;
+}
+
+int build_image_object_output(OutputBuffer *output, DataImage *code_image, DataImage *data_image, int ICF, int DCF) {
+    int i;
+
+    /* The instruction words are already packed in address order, so they need no sorting */
+    append_object_header(output, ICF, DCF);
+    for (i = 0; i < code_image->count; i++) {
+        append_word_record(output, 100 + i, code_image->words[i]);
+    }
+    append_data_records(output, data_image, ICF);
+    return output->is_out_of_memory ? ERROR_OUT_OF_MEMORY : TRUE;
+}
+
+int build_entries_output(OutputBuffer *output, SymbolNode *head_of_symbol_table) {
+    SymbolNode *current;
+
+    /* Check if there are any entry symbols in the symbol table */
+    if(is_entry_exist(head_of_symbol_table) == FALSE) {
+        return FALSE;
+    }
+
+    /* Iterate over the symbol table to find entry symbols */
+    current = head_of_symbol_table;
+    while (current != NULL) {
+
+        /* Check if the symbol has entry flag set to 1 */
+        if(current->entry_flag == 1) {
+
+            /* Write to the entries file the name and address of the symbol */
+            append_symbol_record(output, current->symbol_name, current->address);
+        }
+
+        /* Move to the next symbol in the table */
+        current = current->next;
+    }
+    return output->is_out_of_memory ? ERROR_OUT_OF_MEMORY : TRUE;
+}
+
+int collect_line_external_uses(SymbolNode *head_of_symbol_table, AssemblyLineList *head_of_lines_list,
+                               ExternalUse **external_uses) {
+    SymbolNode *curren_symbol;
+    int number_of_external_uses = 0;
+    int capacity = 0;
+
+    *external_uses = NULL;
+
+    /* Iterate over the symbol table to find external symbols */
+    curren_symbol = head_of_symbol_table;
+    while (curren_symbol != NULL) {
+
+        /* Check if the current symbol is external */
+        if(curren_symbol->type == EXTERN) {
+
+            /* Iterate over the assembly line list to find references to the external symbol */
+            AssemblyLineList *current_line = head_of_lines_list;
+            while (current_line != NULL) {
+                int number_of_extern_symbol = 0;
+                int word_offsets[MAX_OPERANDS];
+                int i;
+                char * line = current_line->line;
+
+                /* Count how many times the external symbol appears in the line, if it exists */
+                number_of_extern_symbol = count_extern_symbol_in_line(line, curren_symbol->symbol_name, word_offsets);
+
+                /* Make room for the uses of the line */
+                if (number_of_external_uses + number_of_extern_symbol > capacity) {
+                    ExternalUse *grown;
+
+                    capacity = capacity == 0 ? 16 : capacity * 2;
+                    grown = realloc(*external_uses, capacity * sizeof(ExternalUse));
+                    if (check_memory_allocation(grown) == FALSE) {
+                        free(*external_uses);
+                        *external_uses = NULL;
+                        return -1;
+                    }
+                    *external_uses = grown;
+                }
+
+                /* Record the address of every word naming the external symbol */
+                for (i = 0; i < number_of_extern_symbol; i++) {
+                    (*external_uses)[number_of_external_uses].symbol_name = curren_symbol->symbol_name;
+                    (*external_uses)[number_of_external_uses++].address = current_line->code->address + word_offsets[i];
+                }
+
+                /* Move to the next assembly line */
+                current_line = current_line->next;
+            }
+        }
+
+        /* Move to the next symbol in the symbol table */
+        curren_symbol = curren_symbol->next;
+    }
+    return number_of_external_uses;
+}
+
+int build_externals_output(OutputBuffer *output, SymbolNode *head_of_symbol_table, AssemblyLineList *head_of_lines_list) {
+    ExternalUse *external_uses;
+    int number_of_external_uses = collect_line_external_uses(head_of_symbol_table, head_of_lines_list,
+                                                             &external_uses);
+    int is_built;
+
+    if (number_of_external_uses < 0) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    is_built = build_external_uses_output(output, external_uses, number_of_external_uses);
+    free(external_uses);
+    return is_built;
+}
+
+int build_external_uses_output(OutputBuffer *output, ExternalUse *external_uses, int number_of_external_uses) {
+    int i;
+
+    /* Check if any external symbol is used */
+    if (number_of_external_uses == 0) {
+        return FALSE;
+    }
+
+    for (i = 0; i < number_of_external_uses; i++) {
+        append_symbol_record(output, external_uses[i].symbol_name, external_uses[i].address);
+    }
+    return output->is_out_of_memory ? ERROR_OUT_OF_MEMORY : TRUE;
+}
+
+unsigned long *collect_code_words(AssemblyLineList *head_of_lines_list, int ICF) {
+    unsigned long *code_words = malloc((ICF - 100 + 1) * sizeof(unsigned long));
+    AssemblyLineList *current = head_of_lines_list;
+
+    /* Check if memory allocation was successful */
+    if (check_memory_allocation(code_words) == FALSE) {
+        return NULL;
+    }
+
+    /* Traverse the assembly line list and its machine code words */
+    while (current != NULL) {
+        BinaryMachineCode *current_code = current->code;
+
+        while (current_code != NULL) {
+            code_words[current_code->address - 100] = binary_word_value(current_code->word);
+            current_code = current_code->next;
+        }
+        current = current->next;
+    }
+    return code_words;
+}
+
+/**
+ * Thread routine that formats a range of fixed-width object file records into their slots.
+ *
+ * @param argument Pointer to the ObjectFormatJob describing the range
+ * @return void* NULL
+ */
+static void *format_object_records(void *argument) {
+    ObjectFormatJob *job = (ObjectFormatJob *)argument;
+    char *slot = job->records + (size_t)job->first_index * OBJECT_RECORD_SIZE;
+    int index;
+
+    for (index = job->first_index; index < job->last_index; index++) {
+        unsigned long word;
+
+        /* The instruction words come first, followed by the data image */
+        if (index < job->code_count) {
+            word = job->code_words[index];
+        } else {
+            word = job->data_image->words[index - job->code_count];
+        }
+
+        /* Format the "AAAAAAA WWWWWW\n" record */
+        format_fixed_decimal(slot, (unsigned long)(100 + index), 7);
+        slot[7] = ' ';
+        format_hex_word(slot + 8, word);
+        slot[14] = '\n';
+        slot += OBJECT_RECORD_SIZE;
+    }
+    return NULL;
+}
+
+/**
+ * Writes the object file of packed instruction words by sizing it up front, mapping it, and formatting
+ * disjoint ranges of its fixed-width records in parallel. The records are synced to the file before it is closed,
+ * and every failure is reported.
+ *
+ * @param file_name The name of the object file to create
+ * @param code_words The packed instruction words, indexed by their address - 100
+ * @param data_image Pointer to the data image holding the .data and .string words
+ * @param ICF The instruction counter value
+ * @param DCF The data counter value
+ * @param number_of_threads The number of threads to format the records with
+ * @return int TRUE if the file was written successfully, FALSE otherwise
+ */
+static int write_words_object_file(char *file_name, unsigned long *code_words, DataImage *data_image,
+                                   int ICF, int DCF, int number_of_threads) {
+    OutputBuffer header = {NULL, 0, 0};
+    ObjectFormatJob single_job;
+    ObjectFormatJob *jobs;
+    pthread_t *threads;
+    int word_count = (ICF - 100) + DCF;
+    size_t file_size;
+    char *mapped;
+    int started_threads = 0;
+    int is_written;
+    int fd;
+    int i;
+
+    /* Build the header line, whose length fixes where the records start */
+    append_object_header(&header, ICF, DCF);
+    if (header.is_out_of_memory) {
+        report_diagnostic("Memory allocation failed!\n");
+        free_output_buffer(&header);
+        return FALSE;
+    }
+    file_size = header.length + (size_t)word_count * OBJECT_RECORD_SIZE;
+
+    /* Size the object file up front, with its blocks reserved so that storing into the mapping cannot
+     * run out of space, and map it for writing */
+    fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) {
+        report_diagnostic("Error opening file: %s\n", file_name);
+        free_output_buffer(&header);
+        return FALSE;
+    }
+    if (ftruncate(fd, (off_t)file_size) == -1 || posix_fallocate(fd, 0, (off_t)file_size) != 0) {
+        report_diagnostic("Error reserving space for file: %s\n", file_name);
+        close(fd);
+        free_output_buffer(&header);
+        return FALSE;
+    }
+    mapped = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        report_diagnostic("Error mapping file: %s\n", file_name);
+        close(fd);
+        free_output_buffer(&header);
+        return FALSE;
+    }
+
+    memcpy(mapped, header.data, header.length);
+
+    /* Never start more threads than there are words */
+    if (number_of_threads > word_count) {
+        number_of_threads = word_count;
+    }
+    if (number_of_threads < 1) {
+        number_of_threads = 1;
+    }
+
+    /* Without memory for the jobs, every record is formatted on the calling thread */
+    jobs = malloc(number_of_threads * sizeof(ObjectFormatJob));
+    threads = malloc(number_of_threads * sizeof(pthread_t));
+    if (jobs == NULL || threads == NULL) {
+        free(jobs);
+        free(threads);
+        jobs = &single_job;
+        threads = NULL;
+        number_of_threads = 1;
+    }
+
+    /* Split the words into disjoint ranges of about the same size */
+    for (i = 0; i < number_of_threads; i++) {
+        jobs[i].records = mapped + header.length;
+        jobs[i].code_words = code_words;
+        jobs[i].code_count = ICF - 100;
+        jobs[i].data_image = data_image;
+        jobs[i].first_index = (int)((long)word_count * i / number_of_threads);
+        jobs[i].last_index = (int)((long)word_count * (i + 1) / number_of_threads);
+    }
+
+    /* Format the first range on the calling thread and the others on worker threads */
+    for (i = 1; i < number_of_threads; i++) {
+        if (pthread_create(&threads[i], NULL, format_object_records, &jobs[i]) != 0) {
+            break;
+        }
+        started_threads = i;
+    }
+    format_object_records(&jobs[0]);
+
+    /* Format on the calling thread any range whose thread could not be started */
+    for (i = started_threads + 1; i < number_of_threads; i++) {
+        format_object_records(&jobs[i]);
+    }
+    for (i = 1; i <= started_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Write the records back before unmapping, so that a failed write is reported rather than lost */
+    is_written = msync(mapped, file_size, MS_SYNC) == 0;
+    munmap(mapped, file_size);
+    if (close(fd) != 0) {
+        is_written = FALSE;
+    }
+    if (!is_written) {
+        report_diagnostic("Error writing file: %s\n", file_name);
+    }
+    if (jobs != &single_job) {
+        free(threads);
+        free(jobs);
+    }
+    free_output_buffer(&header);
+    return is_written;
+}
+
+int write_object_file_parallel(char *file_name, AssemblyLineList *head_of_lines_list, DataImage *data_image,
+                               int ICF, int DCF, int number_of_threads) {
+    unsigned long *code_words = collect_code_words(head_of_lines_list, ICF);
+    int is_written;
+
+    if (code_words == NULL) {
+        return FALSE;
+    }
+    is_written = write_words_object_file(file_name, code_words, data_image, ICF, DCF, number_of_threads);
+    free(code_words);
+    return is_written;
+}
+
+int write_image_object_file_parallel(char *file_name, DataImage *code_image, DataImage *data_image,
+                                     int ICF, int DCF, int number_of_threads) {
+    return write_words_object_file(file_name, code_image->words, data_image, ICF, DCF, number_of_threads);
+}
@@ -0,0 +1,120 @@
+#ifndef OBJECT_OUTPUT_H
+#define OBJECT_OUTPUT_H
+
+#include "first_second_pass_data.h"
+#include "output_buffer.h"
+
+#define OBJECT_RECORD_SIZE 15 /* Length of an object file record: 7 address digits, a space, 6 hex digits and a newline */
+#define MAX_FIXED_WIDTH_ADDRESS 9999999 /* Largest address that fits in the 7 address digits of a record */
+
+/**
+ * Builds the content of the object file: a header line holding ICF - 100 and DCF,
+ * followed by the memory image of the machine code and their matching addresses.
+ *
+ * @param output Pointer to the output buffer to append the content to
+ * @param head_of_lines_list Pointer to the head of the assembly line list
+ * @param data_image Pointer to the data image holding the .data and .string words
+ * @param ICF The instruction counter value
+ * @param DCF The data counter value
+ * @return int TRUE if the content was built, ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int build_object_output(OutputBuffer *output, AssemblyLineList *head_of_lines_list, DataImage *data_image, int ICF, int DCF);
+
+/**
+ * Builds the content of the object file from packed instruction words, with the same content as build_object_output.
+ *
+ * @param output Pointer to the output buffer to append the content to
+ * @param code_image Pointer to the packed instruction words, indexed by their address - 100
+ * @param data_image Pointer to the data image holding the .data and .string words
+ * @param ICF The instruction counter value
+ * @param DCF The data counter value
+ * @return int TRUE if the content was built, ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int build_image_object_output(OutputBuffer *output, DataImage *code_image, DataImage *data_image, int ICF, int DCF);
+
+/**
+ * Collects the instruction words of the assembly line list into an array of packed words,
+ * placing every word at the index of its address - 100, so no sorting is needed.
+ *
+ * @param head_of_lines_list Pointer to the head of the assembly line list
+ * @param ICF The instruction counter value
+ * @return unsigned long* A dynamically allocated array of ICF - 100 packed words, or NULL if memory ran out
+ */
+unsigned long *collect_code_words(AssemblyLineList *head_of_lines_list, int ICF);
+
+/**
+ * Writes the object file by sizing it up front, mapping it, and formatting disjoint ranges of
+ * its fixed-width records in parallel. The content is identical to build_object_output, as long as
+ * every address fits in 7 digits (ICF + DCF - 1 <= MAX_FIXED_WIDTH_ADDRESS).
+ *
+ * @param file_name The name of the object file to create
+ * @param head_of_lines_list Pointer to the head of the assembly line list
+ * @param data_image Pointer to the data image holding the .data and .string words
+ * @param ICF The instruction counter value
+ * @param DCF The data counter value
+ * @param number_of_threads The number of threads to format the records with
+ * @return int TRUE if the file was written successfully, FALSE otherwise
+ */
+int write_object_file_parallel(char *file_name, AssemblyLineList *head_of_lines_list, DataImage *data_image,
+                               int ICF, int DCF, int number_of_threads);
+
+/**
+ * Writes the object file of packed instruction words the way write_object_file_parallel does.
+ *
+ * @param file_name The name of the object file to create
+ * @param code_image Pointer to the packed instruction words, indexed by their address - 100
+ * @param data_image Pointer to the data image holding the .data and .string words
+ * @param ICF The instruction counter value
+ * @param DCF The data counter value
+ * @param number_of_threads The number of threads to format the records with
+ * @return int TRUE if the file was written successfully, FALSE otherwise
+ */
+int write_image_object_file_parallel(char *file_name, DataImage *code_image, DataImage *data_image,
+                                     int ICF, int DCF, int number_of_threads);
+
+/**
+ * Builds the content of the entries file, the names and addresses of all entry symbols.
+ *
+ * @param output Pointer to the output buffer to append the content to
+ * @param head_of_symbol_table Pointer to the head of the symbol table
+ * @return int TRUE if there are entry symbols and the content was built, FALSE if there are none,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int build_entries_output(OutputBuffer *output, SymbolNode *head_of_symbol_table);
+
+/**
+ * Builds the content of the externals file, all external symbols names
+ * and the addresses in the machine code where they are used.
+ *
+ * @param output Pointer to the output buffer to append the content to
+ * @param head_of_symbol_table Pointer to the head of the symbol table
+ * @param head_of_lines_list Pointer to the head of the assembly line list
+ * @return int TRUE if external symbols are used and the content was built, FALSE if none are,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int build_externals_output(OutputBuffer *output, SymbolNode *head_of_symbol_table, AssemblyLineList *head_of_lines_list);
+
+/**
+ * Collects the uses of external symbols in the order of the externals file: symbol by symbol,
+ * then line by line, with the address of every word that names the symbol.
+ *
+ * @param head_of_symbol_table Pointer to the head of the symbol table
+ * @param head_of_lines_list Pointer to the head of the assembly line list
+ * @param external_uses Pointer to set to a dynamically allocated array of the uses, or NULL if there are none
+ * @return int The number of uses, or -1 if memory ran out
+ */
+int collect_line_external_uses(SymbolNode *head_of_symbol_table, AssemblyLineList *head_of_lines_list,
+                               ExternalUse **external_uses);
+
+/**
+ * Builds the content of the externals file from the external uses collected while assembling.
+ *
+ * @param output Pointer to the output buffer to append the content to
+ * @param external_uses The uses of external symbols, in the order of the file
+ * @param number_of_external_uses The number of uses
+ * @return int TRUE if external symbols are used and the content was built, FALSE if none are,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int build_external_uses_output(OutputBuffer *output, ExternalUse *external_uses, int number_of_external_uses);
+
+#endif
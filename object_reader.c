@@ -0,0 +1,425 @@
+#include <stdlib.h>
+#include <string.h>
+#include "macro_data.h"
+#include "diagnostics.h"
+#include "source_file.h"
+#include "object_output.h"
+#include "binary_object.h"
+#include "assembly.h"
+#include "object_reader.h"
+
+/**
+ * Reads the decimal number at a position of a text, advancing past its digits.
+ *
+ * @param position Pointer to the position in the text, advanced past the digits
+ * @param end The end of the text
+ * @param value Pointer to set to the number
+ * @return int The number of digits read, 0 if there is no digit at the position
+ */
+static int read_decimal(const char **position, const char *end, unsigned long *value) {
+    const char *start = *position;
+
+    *value = 0;
+    while (*position < end && (unsigned)(**position - '0') <= 9) {
+        *value = *value * 10 + (unsigned long)(**position - '0');
+        (*position)++;
+    }
+    return (int)(*position - start);
+}
+
+/**
+ * Decodes the 6 hexadecimal digits of a word, upper or lower case.
+ *
+ * @param digits Pointer to the 6 digits
+ * @param word Pointer to set to the word
+ * @return int TRUE if every digit is hexadecimal, FALSE otherwise
+ */
+static int decode_hex_word(const unsigned char *digits, unsigned long *word) {
+    unsigned long value = 0;
+    unsigned invalid = 0;
+    int i;
+
+    for (i = 0; i < 6; i++) {
+        unsigned c = digits[i];
+
+        /* '0'-'9' keep their low nibble, 'a'-'f' and 'A'-'F' have bit 6 set and a low nibble of 1 to 6 */
+        value = (value << 4) | ((c & 0xF) + 9 * (c >> 6));
+        invalid |= ((unsigned)(c - '0') > 9) & ((unsigned)((c | 0x20) - 'a') > 5);
+    }
+    *word = value;
+    return !invalid;
+}
+
+/**
+ * Decodes one fixed-width record, "AAAAAAA WWWWWW\n", whose separator and newline are already checked.
+ *
+ * @param record Pointer to the record
+ * @param address Pointer to set to the address
+ * @param word Pointer to set to the word
+ * @return int TRUE if every digit is valid, FALSE otherwise
+ */
+static int decode_fixed_record(const unsigned char *record, unsigned long *address, unsigned long *word) {
+    unsigned long value = 0;
+    unsigned invalid = 0;
+    int i;
+
+    for (i = 0; i < 7; i++) {
+        unsigned digit = (unsigned) record[i] - '0';
+
+        value = value * 10 + digit;
+        invalid |= digit > 9;
+    }
+    *address = value;
+    return decode_hex_word(record + 8, word) && !invalid;
+}
+
+/**
+ * Decodes one record of any width, for the addresses past 7 digits.
+ *
+ * @param position Pointer to the position of the record, advanced past it
+ * @param end The end of the text
+ * @param address Pointer to set to the address
+ * @param word Pointer to set to the word
+ * @return int TRUE if the record is well formed, FALSE otherwise
+ */
+static int decode_record(const char **position, const char *end, unsigned long *address, unsigned long *word) {
+    if (read_decimal(position, end, address) < 7 || end - *position < 8 || **position != ' ' ||
+        (*position)[7] != '\n' || decode_hex_word((const unsigned char *)*position + 1, word) == FALSE) {
+        return FALSE;
+    }
+    *position += 8;
+    return TRUE;
+}
+
+/**
+ * Reports an error found in a file read back.
+ *
+ * @param file_name The name of the file
+ * @param line_number The line of the error, or 0 if it is not about a line
+ * @param message The message
+ * @return int ERROR_FOUND
+ */
+static int report_object_error(char *file_name, int line_number, const char *message) {
+    if (line_number > 0) {
+        report_diagnostic("Error in %s, line %d: %s\n", file_name, line_number, message);
+    } else {
+        report_diagnostic("Error in %s: %s\n", file_name, message);
+    }
+    return ERROR_FOUND;
+}
+
+void init_object_module(ObjectModule *module) {
+    memset(module, 0, sizeof(ObjectModule));
+}
+
+int parse_object_text(const char *data, size_t length, char *file_name, ObjectModule *module) {
+    const char *position = data;
+    const char *end = data + length;
+    unsigned long code_words, data_words, address, word;
+    size_t number_of_words;
+    size_t i;
+
+    /* The header line holds ICF - 100 and DCF */
+    while (position < end && *position == ' ') {
+        position++;
+    }
+    if (read_decimal(&position, end, &code_words) == 0 || position == end || *position++ != ' ' ||
+        read_decimal(&position, end, &data_words) == 0 || position == end || *position++ != '\n') {
+        return report_object_error(file_name, 1, "the header does not hold the instruction and data counts.");
+    }
+
+    /* Every record takes at least its fixed width, which bounds the counts before anything is allocated */
+    number_of_words = (size_t)(code_words + data_words);
+    if (code_words > MAX_FIXED_WIDTH_ADDRESS || data_words > MAX_FIXED_WIDTH_ADDRESS ||
+        number_of_words > (size_t)(end - position) / OBJECT_RECORD_SIZE) {
+        return report_object_error(file_name, 1, "the header counts more words than the file holds.");
+    }
+    module->words = (unsigned long *) malloc((number_of_words + 1) * sizeof(unsigned long));
+    if (module->words == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    module->number_of_code_words = (int) code_words;
+    module->number_of_data_words = (int) data_words;
+
+    for (i = 0; i < number_of_words; i++) {
+        /* Records of 7 address digits are all the same width and decoded in place */
+        if (end - position >= OBJECT_RECORD_SIZE && position[7] == ' ' && position[OBJECT_RECORD_SIZE - 1] == '\n') {
+            if (decode_fixed_record((const unsigned char *) position, &address, &word) == FALSE) {
+                return report_object_error(file_name, (int) i + 2, "the record is not an address and a word.");
+            }
+            position += OBJECT_RECORD_SIZE;
+        } else if (decode_record(&position, end, &address, &word) == FALSE) {
+            return report_object_error(file_name, (int) i + 2, "the record is not an address and a word.");
+        }
+
+        if (address != OBJECT_FIRST_ADDRESS + i) {
+            return report_object_error(file_name, (int) i + 2, "the address does not follow the previous record.");
+        }
+        module->words[i] = word;
+    }
+    if (position != end) {
+        return report_object_error(file_name, (int) number_of_words + 2,
+                                   "the file holds more records than the header counts.");
+    }
+    return ERROR_WAS_NOT_FOUND;
+}
+
+int parse_symbol_text(const char *data, size_t length, char *file_name, ObjectSymbol **symbols,
+                      int *number_of_symbols, char **names) {
+    char *position, *end;
+    int count = 0;
+    size_t i;
+
+    *symbols = NULL;
+    *number_of_symbols = 0;
+    *names = NULL;
+
+    /* Every record is one line */
+    for (i = 0; i < length; i++) {
+        count += data[i] == '\n';
+    }
+    if (length > 0 && data[length - 1] != '\n') {
+        return report_object_error(file_name, count + 1, "the last line does not end.");
+    }
+    if (count == 0) {
+        return ERROR_WAS_NOT_FOUND;
+    }
+
+    /* The names are the text itself, each ending with a null character instead of the space after it */
+    *symbols = (ObjectSymbol *) malloc(count * sizeof(ObjectSymbol));
+    *names = (char *) malloc(length);
+    if (*symbols == NULL || *names == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(*names, data, length);
+
+    for (position = *names, end = *names + length; position < end; (*number_of_symbols)++) {
+        ObjectSymbol *symbol = &(*symbols)[*number_of_symbols];
+        char *newline = memchr(position, '\n', (size_t)(end - position));
+        char *separator = memchr(position, ' ', (size_t)(newline - position));
+        const char *digits;
+        unsigned long address;
+
+        if (separator == NULL || separator == position) {
+            return report_object_error(file_name, *number_of_symbols + 1, "the record is not a name and an address.");
+        }
+        digits = separator + 1;
+        if (read_decimal(&digits, newline, &address) == 0 || digits != newline || address > MAX_FIXED_WIDTH_ADDRESS) {
+            return report_object_error(file_name, *number_of_symbols + 1, "the record is not a name and an address.");
+        }
+
+        *separator = '\0';
+        symbol->symbol_name = position;
+        symbol->address = (int) address;
+        position = newline + 1;
+    }
+    return ERROR_WAS_NOT_FOUND;
+}
+
+/**
+ * Reads the entry or external records of a binary object.
+ *
+ * @param bytes The content of the binary object
+ * @param offset The offset of the first record
+ * @param count The number of records
+ * @param names The names of the module, a copy of the names of the object
+ * @param names_length The length of the names
+ * @param file_name The name the errors are reported with
+ * @param symbols Pointer to set to a dynamically allocated array of the records
+ * @return int ERROR_WAS_NOT_FOUND if the records were read, ERROR_FOUND if a name is outside the names,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+static int read_binary_symbols(const unsigned char *bytes, unsigned long offset, unsigned long count, char *names,
+                               size_t names_length, char *file_name, ObjectSymbol **symbols) {
+    unsigned long i;
+
+    if (count == 0) {
+        return ERROR_WAS_NOT_FOUND;
+    }
+    *symbols = (ObjectSymbol *) malloc(count * sizeof(ObjectSymbol));
+    if (*symbols == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    for (i = 0; i < count; i++) {
+        const unsigned char *record = bytes + offset + i * BINARY_OBJECT_SYMBOL_SIZE;
+        unsigned long name_offset = read_binary_field(record + 4);
+
+        if (name_offset >= names_length || memchr(names + name_offset, '\0', names_length - name_offset) == NULL) {
+            return report_object_error(file_name, 0, "a record names a symbol outside the names.");
+        }
+        (*symbols)[i].address = (int) read_binary_field(record);
+        (*symbols)[i].symbol_name = names + name_offset;
+    }
+    return ERROR_WAS_NOT_FOUND;
+}
+
+int parse_binary_object(const char *data, size_t length, char *file_name, ObjectModule *module) {
+    const unsigned char *bytes = (const unsigned char *) data;
+    unsigned long fields[BINARY_HEADER_FIELDS];
+    unsigned long number_of_words, i;
+    size_t names_length;
+    int error_flag;
+
+    if (length < BINARY_OBJECT_HEADER_SIZE || memcmp(data, BINARY_OBJECT_MAGIC, 4) != 0) {
+        return report_object_error(file_name, 0, "the file is not a binary object.");
+    }
+    for (i = 0; i < BINARY_HEADER_FIELDS; i++) {
+        fields[i] = read_binary_field(bytes + 4 + 4 * i);
+    }
+    if (fields[BINARY_TOTAL_SIZE] != length ||
+        fields[BINARY_CHECKSUM] != binary_object_checksum(bytes + BINARY_OBJECT_HEADER_SIZE,
+                                                          length - BINARY_OBJECT_HEADER_SIZE)) {
+        return report_object_error(file_name, 0, "the size or the checksum does not match the content.");
+    }
+
+    /* The sections follow each other in the order of the header */
+    number_of_words = fields[BINARY_CODE_WORDS] + fields[BINARY_DATA_WORDS];
+    if (fields[BINARY_CODE_WORDS] > MAX_FIXED_WIDTH_ADDRESS || fields[BINARY_DATA_WORDS] > MAX_FIXED_WIDTH_ADDRESS ||
+        fields[BINARY_ENTRIES_OFFSET] < BINARY_OBJECT_HEADER_SIZE + number_of_words * BINARY_OBJECT_WORD_SIZE ||
+        fields[BINARY_ENTRIES_OFFSET] > length ||
+        fields[BINARY_ENTRIES] > (length - fields[BINARY_ENTRIES_OFFSET]) / BINARY_OBJECT_SYMBOL_SIZE ||
+        fields[BINARY_EXTERNALS_OFFSET] != fields[BINARY_ENTRIES_OFFSET] +
+                                           fields[BINARY_ENTRIES] * BINARY_OBJECT_SYMBOL_SIZE ||
+        fields[BINARY_EXTERNALS] > (length - fields[BINARY_EXTERNALS_OFFSET]) / BINARY_OBJECT_SYMBOL_SIZE ||
+        fields[BINARY_STRINGS_OFFSET] != fields[BINARY_EXTERNALS_OFFSET] +
+                                         fields[BINARY_EXTERNALS] * BINARY_OBJECT_SYMBOL_SIZE) {
+        return report_object_error(file_name, 0, "the header counts and offsets do not match the content.");
+    }
+
+    module->words = (unsigned long *) malloc((number_of_words + 1) * sizeof(unsigned long));
+    names_length = length - fields[BINARY_STRINGS_OFFSET];
+    module->external_names = (char *) malloc(names_length + 1);
+    if (module->words == NULL || module->external_names == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    module->number_of_code_words = (int) fields[BINARY_CODE_WORDS];
+    module->number_of_data_words = (int) fields[BINARY_DATA_WORDS];
+    for (i = 0; i < number_of_words; i++) {
+        const unsigned char *word = bytes + BINARY_OBJECT_HEADER_SIZE + i * BINARY_OBJECT_WORD_SIZE;
+
+        module->words[i] = (unsigned long) word[0] | ((unsigned long) word[1] << 8) | ((unsigned long) word[2] << 16);
+    }
+
+    /* The entry and external records share the names */
+    memcpy(module->external_names, data + fields[BINARY_STRINGS_OFFSET], names_length);
+    error_flag = read_binary_symbols(bytes, fields[BINARY_ENTRIES_OFFSET], fields[BINARY_ENTRIES],
+                                     module->external_names, names_length, file_name, &module->entries);
+    if (error_flag != ERROR_WAS_NOT_FOUND) {
+        return error_flag;
+    }
+    module->number_of_entries = (int) fields[BINARY_ENTRIES];
+    error_flag = read_binary_symbols(bytes, fields[BINARY_EXTERNALS_OFFSET], fields[BINARY_EXTERNALS],
+                                     module->external_names, names_length, file_name, &module->externals);
+    module->number_of_externals = error_flag == ERROR_WAS_NOT_FOUND ? (int) fields[BINARY_EXTERNALS] : 0;
+    return error_flag;
+}
+
+int verify_object_module(ObjectModule *module, char *base_name) {
+    int number_of_words = module->number_of_code_words + module->number_of_data_words;
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    int i;
+
+    for (i = 0; i < module->number_of_entries; i++) {
+        int address = module->entries[i].address;
+
+        if (address < OBJECT_FIRST_ADDRESS || address >= OBJECT_FIRST_ADDRESS + number_of_words) {
+            report_diagnostic("Error in %s: the entry %s is outside the module.\n", base_name,
+                              module->entries[i].symbol_name);
+            error_flag = ERROR_FOUND;
+        }
+    }
+    for (i = 0; i < module->number_of_externals; i++) {
+        int address = module->externals[i].address;
+
+        if (address < OBJECT_FIRST_ADDRESS || address >= OBJECT_FIRST_ADDRESS + module->number_of_code_words ||
+            (module->words[address - OBJECT_FIRST_ADDRESS] & ARE_MASK) != ARE_EXTERNAL) {
+            report_diagnostic("Error in %s: the use of %s at %d is not an external word of the code.\n", base_name,
+                              module->externals[i].symbol_name, address);
+            error_flag = ERROR_FOUND;
+        }
+    }
+    return error_flag;
+}
+
+/**
+ * Maps one file of a module and parses it, for read_object_module.
+ *
+ * @param base_name The file name without any extension
+ * @param extension The extension of the file
+ * @param is_required TRUE if a missing file is an error, FALSE if it means the file is empty
+ * @param module Pointer to the module to fill
+ * @return int ERROR_WAS_NOT_FOUND if the file was parsed or is missing and not required,
+ *         ERROR_FOUND if it could not be opened or is malformed, or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+static int read_module_file(char *base_name, char *extension, int is_required, ObjectModule *module) {
+    char *file_name = make_file_name(base_name, extension);
+    SourceFile file;
+    int error_flag;
+
+    if (file_name == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    if (map_source_file(&file, file_name) == FALSE) {
+        if (is_required) {
+            report_diagnostic("Error opening file: %s\n", file_name);
+        }
+        free(file_name);
+        return is_required ? ERROR_FOUND : ERROR_WAS_NOT_FOUND;
+    }
+
+    if (strcmp(extension, ".ob") == 0) {
+        error_flag = parse_object_text(file.data, file.size, file_name, module);
+    } else if (strcmp(extension, ".ent") == 0) {
+        error_flag = parse_symbol_text(file.data, file.size, file_name, &module->entries, &module->number_of_entries,
+                                       &module->entry_names);
+    } else {
+        error_flag = parse_symbol_text(file.data, file.size, file_name, &module->externals,
+                                       &module->number_of_externals, &module->external_names);
+    }
+    close_source_file(&file);
+    free(file_name);
+    return error_flag;
+}
+
+int read_object_module(char *base_name, ObjectModule *module) {
+    int error_flag;
+
+    init_object_module(module);
+    error_flag = read_module_file(base_name, ".ob", TRUE, module);
+    if (error_flag == ERROR_WAS_NOT_FOUND) {
+        error_flag = read_module_file(base_name, ".ent", FALSE, module);
+    }
+    if (error_flag == ERROR_WAS_NOT_FOUND) {
+        error_flag = read_module_file(base_name, ".ext", FALSE, module);
+    }
+    if (error_flag == ERROR_WAS_NOT_FOUND) {
+        error_flag = verify_object_module(module, base_name);
+    }
+    return error_flag;
+}
+
+int read_binary_object_module(char *file_name, ObjectModule *module) {
+    SourceFile file;
+    int error_flag;
+
+    init_object_module(module);
+    if (map_source_file(&file, file_name) == FALSE) {
+        report_diagnostic("Error opening file: %s\n", file_name);
+        return ERROR_FOUND;
+    }
+    error_flag = parse_binary_object(file.data, file.size, file_name, module);
+    close_source_file(&file);
+    if (error_flag == ERROR_WAS_NOT_FOUND) {
+        error_flag = verify_object_module(module, file_name);
+    }
+    return error_flag;
+}
+
+void free_object_module(ObjectModule *module) {
+    free(module->words);
+    free(module->entries);
+    free(module->externals);
+    free(module->entry_names);
+    free(module->external_names);
+    init_object_module(module);
+}
@@ -0,0 +1,125 @@
+#ifndef OBJECT_READER_H
+#define OBJECT_READER_H
+
+#include <stddef.h>
+
+#define OBJECT_FIRST_ADDRESS 100 /* The address of the first code word of every object */
+#define ARE_MASK 7UL /* The A, R and E bits of a word */
+#define ARE_EXTERNAL 1UL /* The E bit alone, the word names an external symbol */
+#define ARE_RELOCATABLE 2UL /* The R bit alone, the word holds the address of a symbol of the module */
+
+/**
+ * Represents one record of an entries or externals file.
+ */
+typedef struct {
+    char *symbol_name; /* The name of the symbol, null-terminated, owned by the module */
+    int address; /* The address of the record */
+} ObjectSymbol;
+
+/**
+ * Holds an object read back into memory: its words, its entry symbols and the uses of external symbols.
+ */
+typedef struct {
+    unsigned long *words; /* The packed 24-bit words, the code words then the data words, indexed by address - 100 */
+    int number_of_code_words; /* The number of code words, ICF - 100 */
+    int number_of_data_words; /* The number of data words, DCF */
+    ObjectSymbol *entries; /* The entry records, in the order of the entries file */
+    int number_of_entries; /* The number of entry records */
+    ObjectSymbol *externals; /* The external records, in the order of the externals file */
+    int number_of_externals; /* The number of external records */
+    char *entry_names; /* The names the entry records point to */
+    char *external_names; /* The names the external records point to */
+} ObjectModule;
+
+/**
+ * Initializes an empty object module.
+ *
+ * @param module Pointer to the module
+ * @return void
+ */
+void init_object_module(ObjectModule *module);
+
+/**
+ * Parses the content of an object file into the words of a module. The header counts must match
+ * the records, and the records must hold the addresses from 100 on, one after another.
+ * Records of the fixed width are decoded without branching on their digits,
+ * the validity of every digit being checked once per record.
+ *
+ * @param data The content of the object file
+ * @param length The length of the content
+ * @param file_name The name the errors are reported with
+ * @param module Pointer to the module to fill the words of
+ * @return int ERROR_WAS_NOT_FOUND if the content was parsed, ERROR_FOUND if it is malformed,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int parse_object_text(const char *data, size_t length, char *file_name, ObjectModule *module);
+
+/**
+ * Parses the content of an entries or externals file, one "name address" record per line.
+ *
+ * @param data The content of the file
+ * @param length The length of the content
+ * @param file_name The name the errors are reported with
+ * @param symbols Pointer to set to a dynamically allocated array of the records, or NULL if there are none
+ * @param number_of_symbols Pointer to set to the number of records
+ * @param names Pointer to set to the dynamically allocated names the records point to
+ * @return int ERROR_WAS_NOT_FOUND if the content was parsed, ERROR_FOUND if it is malformed,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int parse_symbol_text(const char *data, size_t length, char *file_name, ObjectSymbol **symbols,
+                      int *number_of_symbols, char **names);
+
+/**
+ * Parses a binary object, as build_binary_object_output writes it, into a module. The checksum,
+ * the counts and the offsets of the header are checked against the content.
+ *
+ * @param data The content of the binary object
+ * @param length The length of the content
+ * @param file_name The name the errors are reported with
+ * @param module Pointer to the module to fill
+ * @return int ERROR_WAS_NOT_FOUND if the content was parsed, ERROR_FOUND if it is malformed,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int parse_binary_object(const char *data, size_t length, char *file_name, ObjectModule *module);
+
+/**
+ * Checks the symbols of a module against its words: every entry must be inside the module,
+ * and every external use must be a code word with only the E bit among its A, R and E bits.
+ *
+ * @param module Pointer to the module
+ * @param base_name The name the errors are reported with
+ * @return int ERROR_WAS_NOT_FOUND if the module is consistent, ERROR_FOUND otherwise
+ */
+int verify_object_module(ObjectModule *module, char *base_name);
+
+/**
+ * Reads the object, entries and externals files of an assembled program into a module and verifies it.
+ * The object file must exist, and a missing entries or externals file means the program has no such records.
+ * Every file is mapped rather than read.
+ *
+ * @param base_name The file name without any extension
+ * @param module Pointer to the module to fill, to be released with free_object_module even if reading failed
+ * @return int ERROR_WAS_NOT_FOUND if the files were read and are consistent, ERROR_FOUND otherwise,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int read_object_module(char *base_name, ObjectModule *module);
+
+/**
+ * Reads a binary object file into a module and verifies it.
+ *
+ * @param file_name The name of the binary object file
+ * @param module Pointer to the module to fill, to be released with free_object_module even if reading failed
+ * @return int ERROR_WAS_NOT_FOUND if the file was read and is consistent, ERROR_FOUND otherwise,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out
+ */
+int read_binary_object_module(char *file_name, ObjectModule *module);
+
+/**
+ * Releases the memory of a module, leaving it empty.
+ *
+ * @param module Pointer to the module
+ * @return void
+ */
+void free_object_module(ObjectModule *module);
+
+#endif
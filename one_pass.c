@@ -0,0 +1,749 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include "one_pass.h"
+
+#define INITIAL_SYMBOL_BUCKETS 4096 /* The number of buckets the forward symbol index starts with */
+
+/**
+ * Represents a word slot that uses a symbol and waits for its address.
+ */
+typedef struct SymbolReference {
+    BinaryMachineCode *slot; /* The word of the line to fill, NULL once the line is packed into the code image */
+    int address; /* The address of the word */
+    int address_of_line; /* The address of the first word of the line, for relative addressing */
+    AddressingCase addressing_mode; /* DIRECT_ADDRESSING or RELATIVE_ADDRESSING */
+    struct SymbolReference *next; /* Pointer to the next reference to the same symbol */
+} SymbolReference;
+
+/**
+ * Represents a symbol name used or defined so far, with the backpatch chain of its references.
+ */
+typedef struct ForwardSymbol {
+    char *symbol_name; /* The name of the symbol */
+    SymbolNode *definition; /* The first symbol table entry with the name, NULL while the symbol is undefined */
+    int external_flag; /* TRUE if an .extern directive declared the name */
+    int entry_flag; /* TRUE if an .entry directive named the symbol */
+    SymbolReference *references; /* The word slots that use the symbol, in line order */
+    SymbolReference *last_reference; /* The last word slot that uses the symbol */
+    struct ForwardSymbol *next; /* Pointer to the next symbol in the same bucket */
+} ForwardSymbol;
+
+/**
+ * Represents a line that uses symbols that must be defined by the end of the source.
+ */
+typedef struct SymbolCheck {
+    int line_number; /* The number of the line in the expanded source */
+    int column_start; /* The offset of the first character of the statement of the line */
+    int column_end; /* The offset past its last character */
+    int number_of_symbols; /* The number of symbols the line uses */
+    ForwardSymbol *symbols[MAX_OPERANDS]; /* The symbols the line uses */
+    struct SymbolCheck *next; /* Pointer to the next line to check */
+} SymbolCheck;
+
+/**
+ * Holds the state of a one-pass assembly between the lines it processes.
+ */
+typedef struct {
+    FirstPassState first_pass; /* The first pass over the lines read so far */
+    AssemblyLineList *last_line; /* The last line of the line list, NULL while it is empty */
+    SymbolNode *last_symbol; /* The last entry of the symbol table, NULL while it is empty */
+    ForwardSymbol **buckets; /* The forward symbol index, a chain per bucket */
+    unsigned long number_of_buckets; /* The number of buckets of the index */
+    unsigned long number_of_symbols; /* The number of symbols in the index */
+    SymbolCheck *head_of_checks; /* The lines that use symbols, in order */
+    SymbolCheck *last_check; /* The last line that uses symbols */
+    CompactProgram *program; /* The program packed in the low-memory mode, NULL to keep the line list */
+} OnePassState;
+
+/**
+ * Hashes a symbol name for the forward symbol index.
+ *
+ * @param symbol_name The name of the symbol
+ * @return unsigned long The hash of the name, to be reduced modulo the number of buckets
+ */
+static unsigned long hash_symbol_name(char *symbol_name) {
+    unsigned long hash = 5381;
+
+    while (*symbol_name != '\0') {
+        hash = hash * 33 + (unsigned char) *symbol_name++;
+    }
+    return hash;
+}
+
+/**
+ * Doubles the number of buckets of the forward symbol index, moving every symbol to its new bucket.
+ * If memory runs out the index keeps its buckets, which only makes the lookups longer.
+ *
+ * @param state Pointer to the one-pass state
+ * @return void
+ */
+static void grow_forward_index(OnePassState *state) {
+    unsigned long number_of_buckets = state->number_of_buckets * 2;
+    ForwardSymbol **buckets = (ForwardSymbol **) calloc(number_of_buckets, sizeof(ForwardSymbol *));
+    unsigned long i;
+
+    if (buckets == NULL) {
+        return;
+    }
+    for (i = 0; i < state->number_of_buckets; i++) {
+        while (state->buckets[i] != NULL) {
+            ForwardSymbol *symbol = state->buckets[i];
+            unsigned long bucket = hash_symbol_name(symbol->symbol_name) % number_of_buckets;
+
+            state->buckets[i] = symbol->next;
+            symbol->next = buckets[bucket];
+            buckets[bucket] = symbol;
+        }
+    }
+    free(state->buckets);
+    state->buckets = buckets;
+    state->number_of_buckets = number_of_buckets;
+}
+
+/**
+ * Finds a symbol name in the forward symbol index, adding it if it is not there yet.
+ *
+ * @param state Pointer to the one-pass state
+ * @param symbol_name The name of the symbol
+ * @return ForwardSymbol* The symbol, or NULL if memory ran out
+ */
+static ForwardSymbol *find_forward_symbol(OnePassState *state, char *symbol_name) {
+    ForwardSymbol **bucket = &state->buckets[hash_symbol_name(symbol_name) % state->number_of_buckets];
+    ForwardSymbol *symbol;
+
+    for (symbol = *bucket; symbol != NULL; symbol = symbol->next) {
+        if (strcmp(symbol->symbol_name, symbol_name) == 0) {
+            return symbol;
+        }
+    }
+
+    symbol = (ForwardSymbol *) malloc(sizeof(ForwardSymbol));
+    if (check_memory_allocation(symbol) == FALSE) {
+        return NULL;
+    }
+    symbol->symbol_name = (char *) malloc(strlen(symbol_name) + 1);
+    if (check_memory_allocation(symbol->symbol_name) == FALSE) {
+        free(symbol);
+        return NULL;
+    }
+    strcpy(symbol->symbol_name, symbol_name);
+    symbol->definition = NULL;
+    symbol->external_flag = FALSE;
+    symbol->entry_flag = FALSE;
+    symbol->references = NULL;
+    symbol->last_reference = NULL;
+    symbol->next = *bucket;
+    *bucket = symbol;
+
+    /* Keep the chains short as the index fills up */
+    if (++state->number_of_symbols > state->number_of_buckets) {
+        grow_forward_index(state);
+    }
+    return symbol;
+}
+
+/**
+ * Checks if the address of a symbol is final. Code labels and external symbols keep their address,
+ * data labels move after the code at the end of the source.
+ *
+ * @param symbol Pointer to the symbol
+ * @return int TRUE if the symbol is defined and its address is final, FALSE otherwise
+ */
+static int is_address_final(ForwardSymbol *symbol) {
+    return symbol->definition != NULL && symbol->definition->type != DATA;
+}
+
+/**
+ * Fills one word slot with the address of its symbol, the way the second pass builds the missing word.
+ * An undefined symbol gives address 0, as in the second pass. A slot whose line was packed is patched
+ * in the code image.
+ *
+ * @param state Pointer to the one-pass state
+ * @param symbol Pointer to the symbol
+ * @param reference Pointer to the reference to patch
+ * @return int TRUE if the word was patched, FALSE if memory ran out
+ */
+static int patch_reference(OnePassState *state, ForwardSymbol *symbol, SymbolReference *reference) {
+    int address = symbol->definition != NULL ? symbol->definition->address : 0;
+    char *word;
+
+    if (reference->addressing_mode == DIRECT_ADDRESSING) {
+        word = build_word_second_pass(address, DIRECT_ADDRESSING, symbol->external_flag);
+    } else {
+        word = build_word_second_pass(address - reference->address_of_line, RELATIVE_ADDRESSING, FALSE);
+    }
+    if (word == NULL) {
+        return FALSE;
+    }
+
+    if (reference->slot != NULL) {
+        replace_word(reference->slot, word);
+    } else {
+        state->program->code_image.words[reference->address - 100] = binary_word_value(word);
+        free(word);
+    }
+    return TRUE;
+}
+
+/**
+ * Patches every word slot in the backpatch chain of a symbol.
+ *
+ * @param state Pointer to the one-pass state
+ * @param symbol Pointer to the symbol
+ * @return int TRUE if the chain was patched, FALSE if memory ran out
+ */
+static int patch_chain(OnePassState *state, ForwardSymbol *symbol) {
+    SymbolReference *reference;
+
+    for (reference = symbol->references; reference != NULL; reference = reference->next) {
+        if (patch_reference(state, symbol, reference) == FALSE) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Adds the operands of an instruction line that use symbols to the backpatch chains of their symbols.
+ * Each operand takes the next placeholder word of the line, as in the second pass, and is patched
+ * at once if the address of its symbol is already final.
+ *
+ * @param state Pointer to the one-pass state
+ * @param line Pointer to the instruction line
+ * @return int TRUE if the references were added, FALSE if memory ran out
+ */
+static int add_line_references(OnePassState *state, AssemblyLineList *line) {
+    char line_copy[MAX_LINE] = {0};
+    char *operands[MAX_OPERANDS];
+    int count = split_instruction_operands(line->line, line_copy, operands);
+    BinaryMachineCode *slot = line->code;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        AddressingCase addressing_mode;
+        ForwardSymbol *symbol;
+        SymbolReference *reference;
+
+        if (operands[i] == NULL) {
+            continue;
+        }
+        addressing_mode = get_operand_addressing_mode(operands[i]);
+        if (addressing_mode != DIRECT_ADDRESSING && addressing_mode != RELATIVE_ADDRESSING) {
+            continue;
+        }
+
+        /* Find the next placeholder word, a line without one left keeps its words */
+        while (slot != NULL && strcmp(slot->word, "?") != 0) {
+            slot = slot->next;
+        }
+        if (slot == NULL) {
+            return TRUE;
+        }
+
+        /* Skip the '&' character of relative addressing */
+        symbol = find_forward_symbol(state, addressing_mode == DIRECT_ADDRESSING ? operands[i] : operands[i] + 1);
+        reference = (SymbolReference *) malloc(sizeof(SymbolReference));
+        if (symbol == NULL || check_memory_allocation(reference) == FALSE) {
+            free(reference);
+            return FALSE;
+        }
+        reference->slot = slot;
+        reference->address = slot->address;
+        reference->address_of_line = line->code->address;
+        reference->addressing_mode = addressing_mode;
+        reference->next = NULL;
+        if (symbol->last_reference == NULL) {
+            symbol->references = reference;
+        } else {
+            symbol->last_reference->next = reference;
+        }
+        symbol->last_reference = reference;
+
+        /* Patch the word now if the symbol will not move, this also replaces the placeholder */
+        if (is_address_final(symbol) && patch_reference(state, symbol, reference) == FALSE) {
+            return FALSE;
+        }
+
+        /* A line that is packed next is patched in the code image from now on */
+        if (state->program != NULL) {
+            reference->slot = NULL;
+        }
+        slot = slot->next;
+    }
+    return TRUE;
+}
+
+/**
+ * Removes the last line from the line list and frees it.
+ *
+ * @param state Pointer to the one-pass state
+ * @param line Pointer to the last line of the line list
+ * @return void
+ */
+static void drop_last_line(OnePassState *state, AssemblyLineList *line) {
+    if (line->prev != NULL) {
+        line->prev->next = NULL;
+    } else {
+        state->first_pass.result.head_of_lines_list = NULL;
+    }
+    free_word_list(line->code);
+    free(line->line);
+    free(line);
+}
+
+/**
+ * Moves the words of the last line into the code image of the low-memory mode, and frees the line.
+ * The lines come in address order, so every word lands at the index of its address - 100.
+ *
+ * @param state Pointer to the one-pass state
+ * @param line Pointer to the last line of the line list
+ * @return int TRUE if the line was packed, FALSE if memory ran out, in which case the line is kept
+ */
+static int pack_line(OnePassState *state, AssemblyLineList *line) {
+    DataImage *code_image = &state->program->code_image;
+    BinaryMachineCode *code;
+
+    for (code = line->code; code != NULL; code = code->next) {
+        if (reserve_data_image(code_image, 1) == FALSE) {
+            return FALSE;
+        }
+        code_image->words[code_image->count++] = binary_word_value(code->word);
+    }
+    drop_last_line(state, line);
+    return TRUE;
+}
+
+/**
+ * Records the symbol named by an .entry line, and removes the line from the line list as the second pass does.
+ *
+ * @param state Pointer to the one-pass state
+ * @param line Pointer to the .entry line, the last line of the line list
+ * @return int TRUE if the entry was recorded, FALSE if memory ran out
+ */
+static int take_entry_line(OnePassState *state, AssemblyLineList *line) {
+    char line_copy[MAX_LINE] = {0};
+    char *symbol_name;
+    char *save_pointer;
+    int is_recorded = TRUE;
+
+    strcpy(line_copy, line->line);
+
+    /* Skip the label and the directive, the symbol name follows them */
+    if (is_symbol(line_copy) == TRUE) {
+        strtok_r(line_copy, ":", &save_pointer);
+        strtok_r(NULL, " \n\t", &save_pointer);
+    } else {
+        strtok_r(line_copy, " \n\t", &save_pointer);
+    }
+    symbol_name = strtok_r(NULL, " \n\t", &save_pointer);
+
+    if (symbol_name != NULL) {
+        ForwardSymbol *symbol = find_forward_symbol(state, symbol_name);
+
+        if (symbol == NULL) {
+            is_recorded = FALSE;
+        } else {
+            symbol->entry_flag = TRUE;
+        }
+    }
+
+    /* Remove the entry line from the end of the linked list */
+    drop_last_line(state, line);
+    return is_recorded;
+}
+
+/**
+ * Takes in a symbol the first pass just added to the symbol table. The first entry with a name defines it,
+ * and an external entry marks it external, patching its chain if its address is final.
+ *
+ * @param state Pointer to the one-pass state
+ * @param definition Pointer to the new entry of the symbol table
+ * @return int TRUE if the symbol was taken in, FALSE if memory ran out
+ */
+static int define_symbol(OnePassState *state, SymbolNode *definition) {
+    ForwardSymbol *symbol = find_forward_symbol(state, definition->symbol_name);
+    int is_changed = FALSE;
+
+    if (symbol == NULL) {
+        return FALSE;
+    }
+    if (symbol->definition == NULL) {
+        symbol->definition = definition;
+        is_changed = TRUE;
+    }
+    if (definition->type == EXTERN && symbol->external_flag == FALSE) {
+        symbol->external_flag = TRUE;
+        is_changed = TRUE;
+    }
+    if (is_changed && is_address_final(symbol)) {
+        return patch_chain(state, symbol);
+    }
+    return TRUE;
+}
+
+/**
+ * Records the symbols a line uses that must be defined by the end of the source.
+ * A line whose symbols are all defined already can never report an error, so it is not recorded.
+ *
+ * @param state Pointer to the one-pass state
+ * @param line The line
+ * @param line_number The number of the line
+ * @return int TRUE if the symbols were recorded, FALSE if memory ran out
+ */
+static int record_symbol_check(OnePassState *state, char *line, int line_number) {
+    char symbols[MAX_OPERANDS][MAX_LINE];
+    ForwardSymbol *used_symbols[MAX_OPERANDS];
+    int number_of_symbols = find_second_pass_symbols(line, symbols);
+    int is_defined = TRUE;
+    SymbolCheck *check;
+    int i;
+
+    for (i = 0; i < number_of_symbols; i++) {
+        used_symbols[i] = find_forward_symbol(state, symbols[i]);
+        if (used_symbols[i] == NULL) {
+            return FALSE;
+        }
+        if (used_symbols[i]->definition == NULL) {
+            is_defined = FALSE;
+        }
+    }
+    if (is_defined) {
+        return TRUE;
+    }
+
+    check = (SymbolCheck *) malloc(sizeof(SymbolCheck));
+    if (check_memory_allocation(check) == FALSE) {
+        return FALSE;
+    }
+    check->line_number = line_number;
+    find_statement_span(line, &check->column_start, &check->column_end);
+    check->number_of_symbols = number_of_symbols;
+    check->next = NULL;
+    for (i = 0; i < number_of_symbols; i++) {
+        check->symbols[i] = used_symbols[i];
+    }
+
+    if (state->last_check == NULL) {
+        state->head_of_checks = check;
+    } else {
+        state->last_check->next = check;
+    }
+    state->last_check = check;
+    return TRUE;
+}
+
+/**
+ * Runs the first pass on one line and takes in the line and the symbol it added.
+ * The first pass appends to the tails of the lists, so processing a line does not depend on the lines before it.
+ *
+ * @param state Pointer to the one-pass state
+ * @param line The line, it must have passed the first pass checks
+ * @return int TRUE if the line was processed, FALSE if memory ran out
+ */
+static int assemble_line(OnePassState *state, char *line) {
+    FirstPassResult *so_far = &state->first_pass.result;
+    AssemblyLineList *head_of_lines_list = so_far->head_of_lines_list;
+    SymbolNode *head_of_symbol_table = so_far->head_of_symbol_table;
+    AssemblyLineList *new_line;
+    SymbolNode *new_symbol;
+    int is_processed;
+
+    /* Let the first pass append after the last line and symbol instead of walking both lists from their heads */
+    if (state->last_line != NULL) {
+        so_far->head_of_lines_list = state->last_line;
+    }
+    if (state->last_symbol != NULL) {
+        so_far->head_of_symbol_table = state->last_symbol;
+    }
+    is_processed = first_pass_line(&state->first_pass, line);
+    if (state->last_line != NULL) {
+        so_far->head_of_lines_list = head_of_lines_list;
+    }
+    if (state->last_symbol != NULL) {
+        so_far->head_of_symbol_table = head_of_symbol_table;
+    }
+    if (is_processed == FALSE) {
+        return FALSE;
+    }
+
+    /* Take in the symbol the line defined, if any */
+    new_symbol = state->last_symbol == NULL ? so_far->head_of_symbol_table : state->last_symbol->next;
+    for (; new_symbol != NULL; new_symbol = new_symbol->next) {
+        state->last_symbol = new_symbol;
+        if (define_symbol(state, new_symbol) == FALSE) {
+            return FALSE;
+        }
+    }
+
+    /* Take in the line the first pass added, if any */
+    new_line = state->last_line == NULL ? so_far->head_of_lines_list : state->last_line->next;
+    if (new_line == NULL) {
+        return TRUE;
+    }
+    if (new_line->type == ENTRY) {
+        return take_entry_line(state, new_line);
+    }
+    if (new_line->type == CODE && add_line_references(state, new_line) == FALSE) {
+        return FALSE;
+    }
+    if (state->program != NULL) {
+        return pack_line(state, new_line);
+    }
+    state->last_line = new_line;
+    return TRUE;
+}
+
+/**
+ * Frees the forward symbol index, its backpatch chains and the recorded symbol checks.
+ *
+ * @param state Pointer to the one-pass state
+ * @return void
+ */
+static void free_one_pass_state(OnePassState *state) {
+    unsigned long i;
+
+    while (state->head_of_checks != NULL) {
+        SymbolCheck *next = state->head_of_checks->next;
+        free(state->head_of_checks);
+        state->head_of_checks = next;
+    }
+    for (i = 0; i < state->number_of_buckets; i++) {
+        while (state->buckets[i] != NULL) {
+            ForwardSymbol *next = state->buckets[i]->next;
+
+            while (state->buckets[i]->references != NULL) {
+                SymbolReference *next_reference = state->buckets[i]->references->next;
+                free(state->buckets[i]->references);
+                state->buckets[i]->references = next_reference;
+            }
+            free(state->buckets[i]->symbol_name);
+            free(state->buckets[i]);
+            state->buckets[i] = next;
+        }
+    }
+    free(state->buckets);
+}
+
+/**
+ * Appends one use of an external symbol to the external uses of a compact program.
+ *
+ * @param program Pointer to the compact program
+ * @param capacity Pointer to the number of uses allocated
+ * @param symbol_name The name of the external symbol
+ * @param address The address of the use
+ * @return int TRUE if the use was appended, FALSE if memory ran out
+ */
+static int append_external_use(CompactProgram *program, int *capacity, char *symbol_name, int address) {
+    if (program->number_of_external_uses == *capacity) {
+        int new_capacity = *capacity == 0 ? 64 : *capacity * 2;
+        ExternalUse *new_uses = (ExternalUse *) realloc(program->external_uses, new_capacity * sizeof(ExternalUse));
+
+        if (check_memory_allocation(new_uses) == FALSE) {
+            return FALSE;
+        }
+        program->external_uses = new_uses;
+        *capacity = new_capacity;
+    }
+    program->external_uses[program->number_of_external_uses].symbol_name = symbol_name;
+    program->external_uses[program->number_of_external_uses].address = address;
+    program->number_of_external_uses++;
+    return TRUE;
+}
+
+/**
+ * Collects the records of the externals file of the low-memory mode from the backpatch chains, in the order
+ * build_externals_output writes them: by external symbol table entry, then by line, and within a line
+ * by the address of the word of every direct use.
+ *
+ * @param state Pointer to the one-pass state
+ * @param head_of_symbol_table Pointer to the head of the symbol table
+ * @return int TRUE if the uses were collected, FALSE if memory ran out
+ */
+static int collect_external_uses(OnePassState *state, SymbolNode *head_of_symbol_table) {
+    SymbolNode *current;
+    int capacity = 0;
+
+    for (current = head_of_symbol_table; current != NULL; current = current->next) {
+        ForwardSymbol *symbol;
+        SymbolReference *reference;
+
+        if (current->type != EXTERN) {
+            continue;
+        }
+        symbol = find_forward_symbol(state, current->symbol_name);
+        if (symbol == NULL) {
+            return FALSE;
+        }
+
+        /* The references of one line are next to each other in the chain */
+        reference = symbol->references;
+        while (reference != NULL) {
+            int address_of_line = reference->address_of_line;
+            int addresses[MAX_OPERANDS];
+            int uses = 0;
+            int i;
+
+            for (; reference != NULL && reference->address_of_line == address_of_line; reference = reference->next) {
+                if (reference->addressing_mode == DIRECT_ADDRESSING && uses < MAX_OPERANDS) {
+                    addresses[uses++] = reference->address;
+                }
+            }
+
+            /* A line has at most two uses, the first operand comes first */
+            if (uses == 2 && addresses[0] > addresses[1]) {
+                int address = addresses[0];
+
+                addresses[0] = addresses[1];
+                addresses[1] = address;
+            }
+            for (i = 0; i < uses; i++) {
+                if (append_external_use(state->program, &capacity, current->symbol_name, addresses[i]) == FALSE) {
+                    return FALSE;
+                }
+            }
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Finishes the assembly at the end of the source: patches the chains of the data labels, now that the data
+ * follows the code, marks the entry symbols, and reports the lines that use undefined symbols.
+ * In the low-memory mode, it also collects the uses of the external symbols.
+ *
+ * @param state Pointer to the one-pass state
+ * @param result Pointer to the result, filled by end_first_pass
+ * @return int ERROR_WAS_NOT_FOUND, ERROR_FOUND or ERROR_OUT_OF_MEMORY
+ */
+static int finish_one_pass(OnePassState *state, FirstPassResult *result) {
+    SymbolCheck *check;
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    unsigned long bucket;
+    int i;
+
+    *result = end_first_pass(&state->first_pass);
+
+    for (bucket = 0; bucket < state->number_of_buckets; bucket++) {
+        ForwardSymbol *symbol;
+
+        for (symbol = state->buckets[bucket]; symbol != NULL; symbol = symbol->next) {
+
+            /* Data labels and the symbols that stayed undefined are patched last */
+            if (!is_address_final(symbol) && patch_chain(state, symbol) == FALSE) {
+                return ERROR_OUT_OF_MEMORY;
+            }
+            if (symbol->entry_flag == TRUE && symbol->definition != NULL) {
+                symbol->definition->entry_flag = 1;
+            }
+        }
+    }
+
+    /* Report the lines that use symbols that were never defined */
+    for (check = state->head_of_checks; check != NULL; check = check->next) {
+        for (i = 0; i < check->number_of_symbols; i++) {
+            if (check->symbols[i]->definition == NULL) {
+                report_error(ERR_SYMBOL_NOT_FOUND, check->line_number, check->column_start, check->column_end);
+                error_flag = ERROR_FOUND;
+                break;
+            }
+        }
+    }
+
+    if (error_flag == ERROR_WAS_NOT_FOUND && state->program != NULL &&
+        collect_external_uses(state, result->head_of_symbol_table) == FALSE) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    return error_flag;
+}
+
+/**
+ * Runs a one-pass assembly, keeping the line list, or packing the words of the lines into the code image
+ * of a compact program as they are encoded.
+ *
+ * @param source Pointer to the expanded assembly source code
+ * @param head_of_macro_table Pointer to the head of the macro table, for the first pass checks
+ * @param result Pointer to the FirstPassResult structure to fill
+ * @param program Pointer to the compact program whose code image and external uses to fill,
+ *        or NULL to keep the line list
+ * @return int ERROR_WAS_NOT_FOUND, ERROR_FOUND or ERROR_OUT_OF_MEMORY, nothing is left to free unless
+ *         the source was assembled
+ */
+static int run_one_pass(SourceFile *source, MacroNode *head_of_macro_table, FirstPassResult *result,
+                        CompactProgram *program) {
+    OnePassState state;
+    char line[MAX_LINE] = {0};
+    int line_number = 0;
+    int error_flag = ERROR_WAS_NOT_FOUND;
+
+    begin_first_pass(&state.first_pass);
+    state.last_line = NULL;
+    state.last_symbol = NULL;
+    state.head_of_checks = NULL;
+    state.last_check = NULL;
+    state.program = program;
+    if (program != NULL) {
+        DataImage empty_image = {NULL, 0, 0};
+
+        program->code_image = empty_image;
+        program->external_uses = NULL;
+        program->number_of_external_uses = 0;
+    }
+    state.number_of_buckets = INITIAL_SYMBOL_BUCKETS;
+    state.number_of_symbols = 0;
+    state.buckets = (ForwardSymbol **) calloc(INITIAL_SYMBOL_BUCKETS, sizeof(ForwardSymbol *));
+    if (check_memory_allocation(state.buckets) == FALSE) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+
+    /* Read the file line by line, checking every line and assembling them until an error is found */
+    while (error_flag != ERROR_OUT_OF_MEMORY && read_source_line(line, sizeof(line), source)) {
+        line_number++;
+
+        if (report_first_pass_line_errors(line, line_number, head_of_macro_table,
+                                          check_line_errors_first_pass(line)) == ERROR_FOUND) {
+            error_flag = ERROR_FOUND;
+        }
+        if (error_flag == ERROR_WAS_NOT_FOUND &&
+            (record_symbol_check(&state, line, line_number) == FALSE || assemble_line(&state, line) == FALSE)) {
+            error_flag = ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    if (error_flag == ERROR_WAS_NOT_FOUND) {
+        error_flag = finish_one_pass(&state, result);
+        if (error_flag != ERROR_WAS_NOT_FOUND) {
+            free_first_pass_result(result);
+        }
+    } else {
+        free_first_pass_result(&state.first_pass.result);
+    }
+    if (error_flag != ERROR_WAS_NOT_FOUND && program != NULL) {
+        free_data_image(&program->code_image);
+        free(program->external_uses);
+        program->external_uses = NULL;
+    }
+    free_one_pass_state(&state);
+    return error_flag;
+}
+
+int one_pass(SourceFile *source, MacroNode *head_of_macro_table, FirstPassResult *result) {
+    return run_one_pass(source, head_of_macro_table, result, NULL);
+}
+
+int one_pass_compact(SourceFile *source, MacroNode *head_of_macro_table, CompactProgram *program) {
+    FirstPassResult result;
+    int error_flag = run_one_pass(source, head_of_macro_table, &result, program);
+
+    /* Every line was packed and dropped, only the symbols and the data are left of the first pass */
+    if (error_flag == ERROR_WAS_NOT_FOUND) {
+        program->head_of_symbol_table = result.head_of_symbol_table;
+        program->data_image = result.data_image;
+        program->ICF = result.ICF;
+        program->DCF = result.DCF;
+        program->memo_hits = result.memo_hits;
+        program->memo_misses = result.memo_misses;
+    }
+    return error_flag;
+}
@@ -0,0 +1,39 @@
+#ifndef ONE_PASS_H
+#define ONE_PASS_H
+
+#include "first_second_pass.h"
+
+/**
+ * Assembles the expanded source in a single traversal. Every line is checked and encoded as in the first pass,
+ * and every operand word that uses a symbol joins the backpatch chain of that symbol. A chain is patched
+ * as soon as the address of its symbol is final: when a code label or an .extern directive defines it,
+ * or, for data labels, once the data is moved after the code at the end of the source.
+ * An .extern directive seen after a symbol was used patches its direct references again as external.
+ * Symbols still undefined at the end of the source are reported as ERR_SYMBOL_NOT_FOUND on the lines that use them.
+ * The errors, the words and the symbol table are the same as those of the two passes with their checks.
+ *
+ * @param source Pointer to the expanded assembly source code
+ * @param head_of_macro_table Pointer to the head of the macro table, for the first pass checks
+ * @param result Pointer to the FirstPassResult structure to fill with the lines and symbols of the finished
+ *        second pass, the .entry lines removed and the entry symbols marked
+ * @return int ERROR_WAS_NOT_FOUND if the source was assembled, ERROR_FOUND if errors were reported,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out; nothing is left to free unless the source was assembled
+ */
+int one_pass(SourceFile *source, MacroNode *head_of_macro_table, FirstPassResult *result);
+
+/**
+ * Assembles the expanded source in a single traversal the way one_pass does, keeping only what the outputs need:
+ * every line is packed into the code image as soon as it is encoded and freed, and the backpatch chains
+ * patch the packed words. The uses of external symbols are collected from the chains, so no line text is kept.
+ * Memory is proportional to the output, not to the source.
+ *
+ * @param source Pointer to the expanded assembly source code
+ * @param head_of_macro_table Pointer to the head of the macro table, for the first pass checks
+ * @param program Pointer to the compact program to fill, with the same words, symbols and external uses
+ *        as the two passes give
+ * @return int ERROR_WAS_NOT_FOUND if the source was assembled, ERROR_FOUND if errors were reported,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out; nothing is left to free unless the source was assembled
+ */
+int one_pass_compact(SourceFile *source, MacroNode *head_of_macro_table, CompactProgram *program);
+
+#endif
@@ -0,0 +1,268 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "macro_data.h"
+#include "output_buffer.h"
+#include "diagnostics.h"
+
+/* Hexadecimal digit of every nibble value */
+static const char hex_digits[] = "0123456789abcdef";
+
+/* Two decimal digits of every value from 0 to 99 */
+static const char decimal_digit_pairs[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+/**
+ * Writes all the given bytes to a file descriptor, retrying after partial writes and interrupts.
+ *
+ * @param fd The file descriptor to write to
+ * @param bytes Pointer to the bytes to write
+ * @param length The number of bytes to write
+ * @return int TRUE if all the bytes were written, FALSE otherwise
+ */
+static int write_all(int fd, const char *bytes, size_t length) {
+    while (length > 0) {
+        size_t chunk = length < OUTPUT_CHUNK_SIZE ? length : OUTPUT_CHUNK_SIZE;
+        ssize_t written = write(fd, bytes, chunk);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return FALSE;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return TRUE;
+}
+
+char *output_reserve(OutputBuffer *buffer, size_t length) {
+    char *reserved;
+
+    /* Grow the buffer geometrically if the bytes do not fit */
+    if (buffer->length + length > buffer->capacity) {
+        size_t new_capacity = buffer->capacity == 0 ? 4096 : buffer->capacity * 2;
+        char *new_data;
+
+        while (new_capacity < buffer->length + length) {
+            new_capacity *= 2;
+        }
+
+        new_data = (char *) realloc(buffer->data, new_capacity);
+
+        /* The caller finds out through the mark, reporting it would append to a diagnostics sink in turn */
+        if (new_data == NULL) {
+            buffer->is_out_of_memory = TRUE;
+            return NULL;
+        }
+
+        buffer->data = new_data;
+        buffer->capacity = new_capacity;
+    }
+
+    reserved = buffer->data + buffer->length;
+    buffer->length += length;
+    return reserved;
+}
+
+void output_append(OutputBuffer *buffer, const char *bytes, size_t length) {
+    char *destination = output_reserve(buffer, length);
+
+    if (destination != NULL) {
+        memcpy(destination, bytes, length);
+    }
+}
+
+void output_append_decimal(OutputBuffer *buffer, unsigned long value, int width) {
+    char digits[32];
+    char *destination;
+    int length = 0;
+    int i;
+
+    /* Produce the digits from the least significant, two at a time */
+    while (value >= 100) {
+        int pair = (int)(value % 100) * 2;
+        value /= 100;
+        digits[length++] = decimal_digit_pairs[pair + 1];
+        digits[length++] = decimal_digit_pairs[pair];
+    }
+    if (value >= 10) {
+        int pair = (int)value * 2;
+        digits[length++] = decimal_digit_pairs[pair + 1];
+        digits[length++] = decimal_digit_pairs[pair];
+    } else {
+        digits[length++] = (char)('0' + value);
+    }
+
+    /* Pad with leading zeros up to the width */
+    while (length < width && length < (int)sizeof(digits)) {
+        digits[length++] = '0';
+    }
+
+    /* Copy the digits in their reading order */
+    destination = output_reserve(buffer, length);
+    for (i = 0; destination != NULL && i < length; i++) {
+        destination[i] = digits[length - 1 - i];
+    }
+}
+
+void format_fixed_decimal(char *destination, unsigned long value, int width) {
+    int i = width;
+
+    /* Fill the digits from the least significant, two at a time */
+    while (i >= 2) {
+        int pair = (int)(value % 100) * 2;
+        value /= 100;
+        destination[--i] = decimal_digit_pairs[pair + 1];
+        destination[--i] = decimal_digit_pairs[pair];
+    }
+    if (i == 1) {
+        destination[0] = (char)('0' + value % 10);
+    }
+}
+
+void format_hex_word(char *destination, unsigned long word) {
+    destination[0] = hex_digits[(word >> 20) & 0xF];
+    destination[1] = hex_digits[(word >> 16) & 0xF];
+    destination[2] = hex_digits[(word >> 12) & 0xF];
+    destination[3] = hex_digits[(word >> 8) & 0xF];
+    destination[4] = hex_digits[(word >> 4) & 0xF];
+    destination[5] = hex_digits[word & 0xF];
+}
+
+void output_append_hex_word(OutputBuffer *buffer, unsigned long word) {
+    char *destination = output_reserve(buffer, 6);
+
+    if (destination != NULL) {
+        format_hex_word(destination, word);
+    }
+}
+
+void output_append_string(OutputBuffer *buffer, const char *string) {
+    output_append(buffer, string, strlen(string));
+}
+
+void output_reset(OutputBuffer *buffer) {
+    buffer->length = 0;
+    buffer->is_out_of_memory = FALSE;
+}
+
+void free_output_buffer(OutputBuffer *buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+    buffer->is_out_of_memory = FALSE;
+}
+
+int write_output_file(OutputBuffer *buffer, char *file_name) {
+    int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (fd == -1) {
+        report_diagnostic("Error opening file: %s\n", file_name);
+        return FALSE;
+    }
+
+    if (write_all(fd, buffer->data, buffer->length) == FALSE) {
+        close(fd);
+        return FALSE;
+    }
+
+    return close(fd) == 0;
+}
+
+int write_output_frame(int fd, char *section_name, OutputBuffer *buffer) {
+    char header[MAX_LINE];
+
+    /* Write the frame header, then the payload */
+    sprintf(header, "%s %lu\n", section_name, (unsigned long)buffer->length);
+    if (write_all(fd, header, strlen(header)) == FALSE) {
+        return FALSE;
+    }
+    return write_all(fd, buffer->data, buffer->length);
+}
+
+void output_append_frame(OutputBuffer *buffer, const char *section_name, const char *payload, size_t length) {
+    output_append_string(buffer, section_name);
+    output_append_string(buffer, " ");
+    output_append_decimal(buffer, (unsigned long)length, 1);
+    output_append_string(buffer, "\n");
+    if (length > 0) {
+        output_append(buffer, payload, length);
+    }
+}
+
+int write_output_bytes(int fd, OutputBuffer *buffer) {
+    return write_all(fd, buffer->data, buffer->length);
+}
+
+int read_output_frame(int fd, char section_name[MAX_FRAME_NAME], OutputBuffer *payload) {
+    char header[MAX_FRAME_NAME + 24];
+    size_t header_length = 0;
+    int is_header_ended = FALSE;
+    unsigned long size;
+    char *separator, *end;
+    char *destination;
+
+    /* Read the header line a byte at a time, so no byte of the payload is consumed */
+    while (header_length < sizeof(header) - 1) {
+        ssize_t count = read(fd, header + header_length, 1);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return FALSE;
+        }
+        if (header[header_length] == '\n') {
+            is_header_ended = TRUE;
+            break;
+        }
+        header_length++;
+    }
+    header[header_length] = '\0';
+    if (!is_header_ended) {
+        return FALSE;
+    }
+
+    separator = strchr(header, ' ');
+    if (separator == NULL || separator == header || separator - header >= MAX_FRAME_NAME ||
+        separator[1] < '0' || separator[1] > '9') {
+        return FALSE;
+    }
+    size = strtoul(separator + 1, &end, 10);
+    if (*end != '\0' || size > MAX_FRAME_PAYLOAD) {
+        return FALSE;
+    }
+    memcpy(section_name, header, (size_t)(separator - header));
+    section_name[separator - header] = '\0';
+
+    /* Read exactly the announced payload */
+    output_reset(payload);
+    destination = output_reserve(payload, (size_t)size);
+    if (payload->is_out_of_memory) {
+        return FALSE;
+    }
+    while (size > 0) {
+        ssize_t count = read(fd, destination, size < OUTPUT_CHUNK_SIZE ? size : OUTPUT_CHUNK_SIZE);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return FALSE;
+        }
+        destination += count;
+        size -= (unsigned long)count;
+    }
+    return TRUE;
+}
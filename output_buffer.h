@@ -0,0 +1,160 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <stddef.h>
+
+#define OUTPUT_CHUNK_SIZE 1048576 /* The largest number of bytes handed to a single write call */
+#define MAX_FRAME_NAME 16 /* Maximum length of a frame section name, including the null character */
+#define MAX_FRAME_PAYLOAD 268435456UL /* The largest payload a frame is read with, in bytes */
+
+/**
+ * Represents a growable in-memory buffer that output files are built in before they are written.
+ */
+typedef struct {
+    char *data; /* The bytes written so far */
+    size_t length; /* The number of bytes written */
+    size_t capacity; /* The number of bytes allocated */
+    int is_out_of_memory; /* TRUE once bytes could not be added for lack of memory, until the buffer is reset */
+} OutputBuffer;
+
+/**
+ * Appends bytes to the end of an output buffer, growing it as needed.
+ * If memory runs out, the bytes are dropped and the buffer is marked out of memory.
+ *
+ * @param buffer Pointer to the output buffer
+ * @param bytes Pointer to the bytes to append
+ * @param length The number of bytes to append
+ * @return void
+ */
+void output_append(OutputBuffer *buffer, const char *bytes, size_t length);
+
+/**
+ * Makes room for bytes at the end of an output buffer and counts them as written,
+ * so the caller can format straight into the buffer.
+ *
+ * @param buffer Pointer to the output buffer
+ * @param length The number of bytes the caller is about to write
+ * @return char* Pointer to the first of the reserved bytes, or NULL if memory ran out,
+ *         which marks the buffer out of memory
+ */
+char *output_reserve(OutputBuffer *buffer, size_t length);
+
+/**
+ * Formats a non-negative number in decimal with exactly the given number of digits, padded with leading zeros.
+ * Digits beyond the width are dropped, so the caller must make sure the number fits.
+ *
+ * @param destination Pointer to the width bytes to format into, no null character is written
+ * @param value The number to format
+ * @param width The number of digits
+ * @return void
+ */
+void format_fixed_decimal(char *destination, unsigned long value, int width);
+
+/**
+ * Formats a 24-bit machine word as exactly 6 lowercase hexadecimal digits.
+ *
+ * @param destination Pointer to the 6 bytes to format into, no null character is written
+ * @param word The machine word to format
+ * @return void
+ */
+void format_hex_word(char *destination, unsigned long word);
+
+/**
+ * Appends a non-negative number in decimal, padded with leading zeros to a minimum width,
+ * like the "%0*lu" format but without parsing a format string.
+ *
+ * @param buffer Pointer to the output buffer
+ * @param value The number to append
+ * @param width The minimum number of digits
+ * @return void
+ */
+void output_append_decimal(OutputBuffer *buffer, unsigned long value, int width);
+
+/**
+ * Appends a 24-bit machine word as exactly 6 lowercase hexadecimal digits, like the "%06lx" format.
+ *
+ * @param buffer Pointer to the output buffer
+ * @param word The machine word to append
+ * @return void
+ */
+void output_append_hex_word(OutputBuffer *buffer, unsigned long word);
+
+/**
+ * Appends a null-terminated string to the end of an output buffer.
+ *
+ * @param buffer Pointer to the output buffer
+ * @param string The string to append, without its terminating null character
+ * @return void
+ */
+void output_append_string(OutputBuffer *buffer, const char *string);
+
+/**
+ * Empties an output buffer while keeping its memory for reuse, and clears its out of memory mark.
+ *
+ * @param buffer Pointer to the output buffer
+ * @return void
+ */
+void output_reset(OutputBuffer *buffer);
+
+/**
+ * Frees the memory allocated for an output buffer and resets it to an empty buffer.
+ *
+ * @param buffer Pointer to the output buffer
+ * @return void
+ */
+void free_output_buffer(OutputBuffer *buffer);
+
+/**
+ * Writes the content of an output buffer to a file, replacing the file if it exists.
+ * The content is handed to the kernel directly in chunks of up to OUTPUT_CHUNK_SIZE bytes.
+ *
+ * @param buffer Pointer to the output buffer
+ * @param file_name The name of the file to create
+ * @return int TRUE if the file was written successfully, FALSE otherwise
+ */
+int write_output_file(OutputBuffer *buffer, char *file_name);
+
+/**
+ * Writes the content of an output buffer to a file descriptor as a single frame.
+ * A frame is a header line holding the section name and the payload size in bytes,
+ * followed by exactly that many payload bytes: "<section_name> <size>\n<payload>".
+ *
+ * @param fd The file descriptor to write to
+ * @param section_name The name of the section carried by the frame (e.g. "ob", "ent", "ext")
+ * @param buffer Pointer to the output buffer holding the payload
+ * @return int TRUE if the frame was written successfully, FALSE otherwise
+ */
+int write_output_frame(int fd, char *section_name, OutputBuffer *buffer);
+
+/**
+ * Appends a frame, as write_output_frame writes it, to the end of an output buffer.
+ *
+ * @param buffer Pointer to the output buffer
+ * @param section_name The name of the section carried by the frame, shorter than MAX_FRAME_NAME
+ * @param payload Pointer to the payload
+ * @param length The length of the payload
+ * @return void
+ */
+void output_append_frame(OutputBuffer *buffer, const char *section_name, const char *payload, size_t length);
+
+/**
+ * Writes the content of an output buffer to a file descriptor as it is.
+ *
+ * @param fd The file descriptor to write to
+ * @param buffer Pointer to the output buffer
+ * @return int TRUE if the content was written successfully, FALSE otherwise
+ */
+int write_output_bytes(int fd, OutputBuffer *buffer);
+
+/**
+ * Reads one frame written by write_output_frame from a file descriptor.
+ *
+ * @param fd The file descriptor to read from
+ * @param section_name The buffer to write the section name of the frame to
+ * @param payload Pointer to the output buffer to replace the content of with the payload
+ * @return int TRUE if a whole frame was read, FALSE at the end of the input, on a read error,
+ *         if the header is not well formed or announces more than MAX_FRAME_PAYLOAD bytes, or if memory ran out
+ */
+int read_output_frame(int fd, char section_name[MAX_FRAME_NAME], OutputBuffer *payload);
+
+#endif
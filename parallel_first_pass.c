@@ -0,0 +1,184 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include "parallel_first_pass.h"
+#include "source_chunks.h"
+
+/**
+ * Holds the state of one chunk of a parallel first pass.
+ */
+typedef struct {
+    SourceChunk lines; /* The lines of the chunk */
+    FirstPassState state; /* The first pass over the chunk, with counters starting from zero */
+    int is_encoded; /* TRUE if every line of the chunk was processed, FALSE if memory ran out */
+    int code_base; /* The number of instruction words in all the chunks before this one */
+    int data_base; /* The number of data words in all the chunks before this one */
+    DataImage *data_image; /* The data image of the whole source */
+    AssemblyLineList *last_line; /* The last line of the chunk, found while relocating */
+    SymbolNode *last_symbol; /* The last symbol of the chunk, found while relocating */
+} FirstPassChunk;
+
+/**
+ * Runs the first pass over the lines of one chunk.
+ *
+ * @param argument Pointer to the FirstPassChunk
+ * @return void* Always NULL
+ */
+static void *encode_chunk(void *argument) {
+    FirstPassChunk *chunk = (FirstPassChunk *) argument;
+    SourceFile lines;
+    char line[MAX_LINE] = {0};
+
+    view_source_buffer(&lines, chunk->lines.data, chunk->lines.size);
+    begin_first_pass(&chunk->state);
+    chunk->is_encoded = TRUE;
+    while (chunk->is_encoded && read_source_line(line, sizeof(line), &lines)) {
+        chunk->is_encoded = first_pass_line(&chunk->state, line);
+    }
+    return NULL;
+}
+
+/**
+ * Moves the words and symbols of one chunk from the addresses of its own first pass
+ * to the addresses that follow the chunks before it, and copies its data words into the data image.
+ *
+ * @param argument Pointer to the FirstPassChunk
+ * @return void* Always NULL
+ */
+static void *relocate_chunk(void *argument) {
+    FirstPassChunk *chunk = (FirstPassChunk *) argument;
+    AssemblyLineList *current_line = chunk->state.result.head_of_lines_list;
+    SymbolNode *current_symbol = chunk->state.result.head_of_symbol_table;
+    DataImage *local_image = &chunk->state.result.data_image;
+
+    /* Instruction words are at IC, and the word of an .entry line at DC */
+    while (current_line != NULL) {
+        if (current_line->type == CODE || current_line->type == ENTRY) {
+            int base = current_line->type == CODE ? chunk->code_base : chunk->data_base;
+            BinaryMachineCode *current_word;
+
+            for (current_word = current_line->code; current_word != NULL; current_word = current_word->next) {
+                current_word->address += base;
+            }
+        }
+        chunk->last_line = current_line;
+        current_line = current_line->next;
+    }
+
+    /* Code symbols are at IC and data symbols at DC, external symbols stay at 0 */
+    while (current_symbol != NULL) {
+        if (current_symbol->type == CODE) {
+            current_symbol->address += chunk->code_base;
+        } else if (current_symbol->type == DATA) {
+            current_symbol->address += chunk->data_base;
+        }
+        chunk->last_symbol = current_symbol;
+        current_symbol = current_symbol->next;
+    }
+
+    /* Copy the data words into their slot of the data image */
+    if (local_image->count > 0) {
+        memcpy(chunk->data_image->words + chunk->data_base, local_image->words,
+               local_image->count * sizeof(unsigned long));
+    }
+    free_data_image(local_image);
+    return NULL;
+}
+
+int parallel_first_pass(SourceFile *source, int number_of_threads, FirstPassResult *result) {
+    FirstPassChunk *chunks;
+    SourceChunk *lines;
+    FirstPassState merged;
+    AssemblyLineList *last_line = NULL;
+    SymbolNode *last_symbol = NULL;
+    int code_words = 0, data_words = 0;
+    int is_encoded = TRUE;
+    int i;
+
+    if (number_of_threads < 1) {
+        number_of_threads = 1;
+    }
+
+    chunks = (FirstPassChunk *) malloc(number_of_threads * sizeof(FirstPassChunk));
+    lines = (SourceChunk *) malloc(number_of_threads * sizeof(SourceChunk));
+
+    /* Check if memory allocation was successful */
+    if (check_memory_allocation(chunks) == FALSE || check_memory_allocation(lines) == FALSE) {
+        free(chunks);
+        free(lines);
+        return FALSE;
+    }
+
+    /* Split the source into chunks of whole lines, one per thread */
+    split_source_chunks(source, lines, number_of_threads);
+    for (i = 0; i < number_of_threads; i++) {
+        chunks[i].lines = lines[i];
+    }
+    free(lines);
+
+    /* Encode the chunks in parallel, each with counters starting from zero */
+    run_on_threads(encode_chunk, chunks, sizeof(FirstPassChunk), number_of_threads);
+
+    /* Give every chunk the counters that follow the chunks before it */
+    for (i = 0; i < number_of_threads; i++) {
+        chunks[i].code_base = code_words;
+        chunks[i].data_base = data_words;
+        code_words += chunks[i].state.IC - 100;
+        data_words += chunks[i].state.DC;
+    }
+
+    /* Relocate the chunks into their slots in parallel, unless memory ran out */
+    begin_first_pass(&merged);
+    for (i = 0; i < number_of_threads && is_encoded; i++) {
+        is_encoded = chunks[i].is_encoded;
+    }
+    if (!is_encoded || reserve_data_image(&merged.result.data_image, data_words) == FALSE) {
+        for (i = 0; i < number_of_threads; i++) {
+            free_first_pass_result(&chunks[i].state.result);
+        }
+        free(chunks);
+        free_first_pass_result(&merged.result);
+        return FALSE;
+    }
+    merged.result.data_image.count = data_words;
+    for (i = 0; i < number_of_threads; i++) {
+        chunks[i].data_image = &merged.result.data_image;
+        chunks[i].last_line = NULL;
+        chunks[i].last_symbol = NULL;
+    }
+    run_on_threads(relocate_chunk, chunks, sizeof(FirstPassChunk), number_of_threads);
+
+    /* Join the lines and symbols of the chunks in order, counting the encoding memo hits of every chunk */
+    for (i = 0; i < number_of_threads; i++) {
+        AssemblyLineList *first_line = chunks[i].state.result.head_of_lines_list;
+        SymbolNode *first_symbol = chunks[i].state.result.head_of_symbol_table;
+
+        merged.memo.hits += chunks[i].state.memo.hits;
+        merged.memo.misses += chunks[i].state.memo.misses;
+        if (first_line != NULL) {
+            if (last_line == NULL) {
+                merged.result.head_of_lines_list = first_line;
+            } else {
+                last_line->next = first_line;
+                first_line->prev = last_line;
+            }
+            last_line = chunks[i].last_line;
+        }
+        if (first_symbol != NULL) {
+            if (last_symbol == NULL) {
+                merged.result.head_of_symbol_table = first_symbol;
+            } else {
+                last_symbol->next = first_symbol;
+            }
+            last_symbol = chunks[i].last_symbol;
+        }
+    }
+    free(chunks);
+
+    /* Finish the first pass as if it ran over the whole source */
+    merged.IC = 100 + code_words;
+    merged.DC = data_words;
+    *result = end_first_pass(&merged);
+    return TRUE;
+}
@@ -0,0 +1,21 @@
+#ifndef PARALLEL_FIRST_PASS_H
+#define PARALLEL_FIRST_PASS_H
+
+#include "first_second_pass.h"
+
+/**
+ * Performs the first pass on several threads. The source is split into chunks of whole lines,
+ * and every chunk runs the first pass on its own thread with counters starting from zero.
+ * A prefix sum over the instruction and data word counts of the chunks then gives every chunk
+ * its base IC and DC, and the chunks move their words and symbols to those addresses in parallel,
+ * copy their data words into their slots of the data image, and are joined in order.
+ * The result is the same as the result of first_pass.
+ *
+ * @param source Pointer to the assembly source code, every line must have passed the first pass checks
+ * @param number_of_threads The number of threads, and chunks, to split the first pass into
+ * @param result Pointer to the FirstPassResult structure to fill with the same result first_pass gives for the source
+ * @return int TRUE if the pass was completed, FALSE if memory ran out, in which case nothing is left to free
+ */
+int parallel_first_pass(SourceFile *source, int number_of_threads, FirstPassResult *result);
+
+#endif
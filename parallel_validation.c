@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include "parallel_validation.h"
+#include "source_chunks.h"
+
+/**
+ * Represents an error found in a line, numbered from the start of its chunk.
+ */
+typedef struct {
+    int line_number; /* The number of the line within its chunk, from 1 */
+    ErrorCode code; /* The error found in the line */
+    int column_start; /* The offset of the first character of the statement of the line */
+    int column_end; /* The offset past its last character */
+} LineError;
+
+/**
+ * Holds the state of one chunk of a parallel check.
+ */
+typedef struct {
+    SourceChunk lines; /* The lines of the chunk */
+    MacroNode *head_of_macro_table; /* The macro table, for the first pass checks */
+    SymbolNode *head_of_symbol_table; /* The symbol table, for the second pass checks */
+    int number_of_lines; /* The number of lines in the chunk */
+    LineError *errors; /* The errors found in the chunk, in line order */
+    int number_of_errors; /* The number of errors found */
+    int capacity; /* The number of errors allocated */
+    int is_checked; /* TRUE if every line of the chunk was checked, FALSE if memory ran out */
+} ValidationChunk;
+
+/**
+ * Adds an error to the errors of a chunk.
+ *
+ * @param chunk Pointer to the chunk
+ * @param line_number The number of the line within the chunk
+ * @param code The error found in the line
+ * @param line The line, whose statement the error spans
+ * @return int TRUE if the error was added, FALSE if memory ran out
+ */
+static int add_line_error(ValidationChunk *chunk, int line_number, ErrorCode code, const char *line) {
+    if (chunk->number_of_errors == chunk->capacity) {
+        int new_capacity = chunk->capacity == 0 ? 16 : chunk->capacity * 2;
+        LineError *new_errors = (LineError *) realloc(chunk->errors, new_capacity * sizeof(LineError));
+
+        /* Check if memory allocation was successful */
+        if (check_memory_allocation(new_errors) == FALSE) {
+            return FALSE;
+        }
+        chunk->errors = new_errors;
+        chunk->capacity = new_capacity;
+    }
+    chunk->errors[chunk->number_of_errors].line_number = line_number;
+    chunk->errors[chunk->number_of_errors].code = code;
+    find_statement_span(line, &chunk->errors[chunk->number_of_errors].column_start,
+                        &chunk->errors[chunk->number_of_errors].column_end);
+    chunk->number_of_errors++;
+    return TRUE;
+}
+
+/**
+ * Collects the first pass errors of the lines of one chunk.
+ *
+ * @param argument Pointer to the ValidationChunk
+ * @return void* Always NULL
+ */
+static void *check_first_pass_chunk(void *argument) {
+    ValidationChunk *chunk = (ValidationChunk *) argument;
+    SourceFile lines;
+    char line[MAX_LINE] = {0};
+
+    view_source_buffer(&lines, chunk->lines.data, chunk->lines.size);
+    while (chunk->is_checked && read_source_line(line, sizeof(line), &lines)) {
+        ErrorCode errors[MAX_LINE_ERRORS];
+        int number_of_errors;
+        int i;
+
+        chunk->number_of_lines++;
+        number_of_errors = find_first_pass_line_errors(line, chunk->head_of_macro_table,
+                                                       check_line_errors_first_pass(line), errors);
+        for (i = 0; i < number_of_errors && chunk->is_checked; i++) {
+            chunk->is_checked = add_line_error(chunk, chunk->number_of_lines, errors[i], line);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Collects the second pass errors of the lines of one chunk.
+ *
+ * @param argument Pointer to the ValidationChunk
+ * @return void* Always NULL
+ */
+static void *check_second_pass_chunk(void *argument) {
+    ValidationChunk *chunk = (ValidationChunk *) argument;
+    SourceFile lines;
+    char line[MAX_LINE] = {0};
+
+    view_source_buffer(&lines, chunk->lines.data, chunk->lines.size);
+    while (chunk->is_checked && read_source_line(line, sizeof(line), &lines)) {
+        ErrorCode error_check = check_line_errors_second_pass(line, chunk->head_of_symbol_table);
+
+        chunk->number_of_lines++;
+        if (error_check != NO_ERROR) {
+            chunk->is_checked = add_line_error(chunk, chunk->number_of_lines, error_check, line);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Checks the chunks of a source on several threads, then prints the errors of every chunk in order,
+ * numbering the lines from the start of the source.
+ *
+ * @param source Pointer to the source
+ * @param check_chunk The function that collects the errors of a chunk
+ * @param head_of_macro_table Pointer to the head of the macro table
+ * @param head_of_symbol_table Pointer to the head of the symbol table
+ * @param number_of_threads The number of threads, and chunks
+ * @return int ERROR_FOUND if any error was found, ERROR_WAS_NOT_FOUND otherwise,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out before every line was checked
+ */
+static int check_chunks(SourceFile *source, void *(*check_chunk)(void *), MacroNode *head_of_macro_table,
+                        SymbolNode *head_of_symbol_table, int number_of_threads) {
+    ValidationChunk *chunks;
+    SourceChunk *lines;
+    int error_flag = ERROR_WAS_NOT_FOUND;
+    int first_line_number = 0;
+    int i, j;
+
+    if (number_of_threads < 1) {
+        number_of_threads = 1;
+    }
+
+    chunks = (ValidationChunk *) malloc(number_of_threads * sizeof(ValidationChunk));
+    lines = (SourceChunk *) malloc(number_of_threads * sizeof(SourceChunk));
+
+    /* Check if memory allocation was successful */
+    if (check_memory_allocation(chunks) == FALSE || check_memory_allocation(lines) == FALSE) {
+        free(chunks);
+        free(lines);
+        return ERROR_OUT_OF_MEMORY;
+    }
+
+    /* Split the source into chunks of whole lines, one per thread */
+    split_source_chunks(source, lines, number_of_threads);
+    for (i = 0; i < number_of_threads; i++) {
+        chunks[i].lines = lines[i];
+        chunks[i].head_of_macro_table = head_of_macro_table;
+        chunks[i].head_of_symbol_table = head_of_symbol_table;
+        chunks[i].number_of_lines = 0;
+        chunks[i].errors = NULL;
+        chunks[i].number_of_errors = 0;
+        chunks[i].capacity = 0;
+        chunks[i].is_checked = TRUE;
+    }
+    free(lines);
+
+    run_on_threads(check_chunk, chunks, sizeof(ValidationChunk), number_of_threads);
+    for (i = 0; i < number_of_threads; i++) {
+        if (!chunks[i].is_checked) {
+            error_flag = ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    /* Print the errors in line order, every chunk starts after the lines of the chunks before it */
+    for (i = 0; i < number_of_threads; i++) {
+        for (j = 0; j < chunks[i].number_of_errors && error_flag != ERROR_OUT_OF_MEMORY; j++) {
+            LineError *error = &chunks[i].errors[j];
+
+            report_error(error->code, first_line_number + error->line_number, error->column_start, error->column_end);
+            error_flag = ERROR_FOUND;
+        }
+        first_line_number += chunks[i].number_of_lines;
+        free(chunks[i].errors);
+    }
+    free(chunks);
+    return error_flag;
+}
+
+int check_errors_in_first_pass_parallel(SourceFile *source, MacroNode *head_of_macro_table, int number_of_threads) {
+    return check_chunks(source, check_first_pass_chunk, head_of_macro_table, NULL, number_of_threads);
+}
+
+int check_errors_in_second_pass_parallel(SourceFile *source, SymbolNode *head_of_symbol_table, int number_of_threads) {
+    return check_chunks(source, check_second_pass_chunk, NULL, head_of_symbol_table, number_of_threads);
+}
@@ -0,0 +1,32 @@
+#ifndef PARALLEL_VALIDATION_H
+#define PARALLEL_VALIDATION_H
+
+#include "first_second_pass.h"
+
+/**
+ * Checks the lines of a source for first pass errors on several threads, like check_errors_in_first_pass.
+ * The source is split into chunks of whole lines, every thread collects the errors of its chunk
+ * with their line numbers, and the errors are printed in line order once all the chunks are checked,
+ * so the output is the same as that of check_errors_in_first_pass.
+ *
+ * @param source Pointer to the expanded source
+ * @param head_of_macro_table Pointer to the head of the macro table, only read by the threads
+ * @param number_of_threads The number of threads, and chunks, to split the checks into
+ * @return int ERROR_FOUND if any error was found, ERROR_WAS_NOT_FOUND otherwise,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out before every line was checked
+ */
+int check_errors_in_first_pass_parallel(SourceFile *source, MacroNode *head_of_macro_table, int number_of_threads);
+
+/**
+ * Checks the lines of a source for second pass errors on several threads, like check_errors_in_second_pass.
+ * The errors are printed in line order once all the chunks are checked.
+ *
+ * @param source Pointer to the expanded source
+ * @param head_of_symbol_table Pointer to the head of the symbol table, only read by the threads
+ * @param number_of_threads The number of threads, and chunks, to split the checks into
+ * @return int ERROR_FOUND if any error was found, ERROR_WAS_NOT_FOUND otherwise,
+ *         or ERROR_OUT_OF_MEMORY if memory ran out before every line was checked
+ */
+int check_errors_in_second_pass_parallel(SourceFile *source, SymbolNode *head_of_symbol_table, int number_of_threads);
+
+#endif
@@ -1,12 +1,18 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "macro_data.h"
+#include "error_handler.h"
+#include "diagnostics.h"
 
 int check_file_open(FILE *file, char *file_name) {
     if (file == NULL) {
-        printf("Error opening file: %s\n", file_name);
+        report_diagnostic("Error opening file: %s\n", file_name);
         return FALSE;
     }
     return TRUE;
@@ -38,9 +44,10 @@ static int is_empty_or_comment(char *line) {
  *
  * @param macro_name Pointer to the string representing the macro name
  * @param number_of_line The line number where the macro is defined
+ * @param line The line defining the macro, which the errors span
  * @return int ERROR_FOUND if the macro name is invalid, otherwise ERROR_WAS_NOT_FOUND.
  */
-static int check_macro_name(char *macro_name, int number_of_line) {
+static int check_macro_name(char *macro_name, int number_of_line, const char *line) {
     int error_flag = ERROR_WAS_NOT_FOUND;
     int i;
 
@@ -53,14 +60,14 @@ static int check_macro_name(char *macro_name, int number_of_line) {
 
     /* Check if a macro name is longer than 31 characters */
     if(strlen(macro_name) > MAX_MACRO_NAME) {
-        printf("Error in line %d: A macro name cannot be longer than 31 characters.\n", number_of_line);
+        report_line_error(ERR_MACRO_NAME_TOO_LONG, number_of_line, line);
         error_flag = ERROR_FOUND;
     }
 
     /* Check if a macro name contains only letters, digits, or underscores. */
     for(i=0; i < strlen(macro_name); i++) {
         if (!(isalnum(macro_name[i]) || macro_name[i] == '_')) {
-            printf("Error in line %d: A macro name can only contain letters, digits, and underscores.\n", number_of_line);
+            report_line_error(ERR_INVALID_MACRO_NAME_CHAR, number_of_line, line);
             error_flag = ERROR_FOUND;
         }
     }
@@ -68,14 +75,14 @@ static int check_macro_name(char *macro_name, int number_of_line) {
     /* Check if the macro name matches an assembly command */
     for(i=0; i < number_of_commands; i++) {
         if(strcmp(macro_name, commands[i]) == 0) {
-            printf("Error in line %d: A macro name cannot be the same as a command name.\n", number_of_line);
+            report_line_error(ERR_MACRO_COMMAND_NAME, number_of_line, line);
             error_flag = ERROR_FOUND;
         }
     }
 
     /* Check if the macro name matches a directive name */
     if(strcmp(macro_name, "entry") == 0 || strcmp(macro_name, "entry") == 0 || strcmp(macro_name, "extern") == 0 || strcmp(macro_name, "data") == 0) {
-        printf("Error in line %d: A macro name cannot be the same as a directive name.\n", number_of_line);
+        report_line_error(ERR_MACRO_DIRECTIVE_NAME, number_of_line, line);
         error_flag = ERROR_FOUND;
     }
 
@@ -83,7 +90,7 @@ static int check_macro_name(char *macro_name, int number_of_line) {
     if(strcmp(macro_name, "r0") == 0 || strcmp(macro_name, "r1") == 0 || strcmp(macro_name, "r2") == 0 ||
        strcmp(macro_name, "r3") == 0 || strcmp(macro_name, "r4") == 0 || strcmp(macro_name, "r5") == 0 ||
        strcmp(macro_name, "r6") == 0 || strcmp(macro_name, "r7") == 0 ) {
-        printf("Error in Line %d: A macro name cannot be a reserved assembly keyword.\n", number_of_line);
+        report_line_error(ERR_MACRO_RESERVED_NAME, number_of_line, line);
         error_flag = ERROR_FOUND;
     }
     return error_flag;
@@ -116,7 +123,7 @@ static int check_macro_definition_line(const char *line, int number_of_line) {
     /* Check for extraneous text */
     while (line[i] != '\0') {
         if (!isspace(line[i])) {
-            printf("Error in line %d: The macro definition and termination lines must not contain extra characters.\n", number_of_line);
+            report_line_error(ERR_MACRO_EXTRA_TEXT, number_of_line, line);
             error_flag = ERROR_FOUND;
             return error_flag;
         }
@@ -146,7 +153,7 @@ static int check_macro_termination_line(char *line, int number_of_line) {
     /* Check for extraneous text */
     while (line[i] != '\0') {
         if (!isspace(line[i])) {
-            printf("Error in line %d: The macro definition and termination lines must not contain extra characters.\n", number_of_line);
+            report_line_error(ERR_MACRO_EXTRA_TEXT, number_of_line, line);
             error_flag = ERROR_FOUND;
             return error_flag;
         }
@@ -155,14 +162,7 @@ static int check_macro_termination_line(char *line, int number_of_line) {
     return error_flag;
 }
 
-/**
- * Checks if a macro with a given name exists in the macro linked list.
- *
- * @param head Pointer to the head of the macro linked list
- * @param macro_name The name of the macro to search for
- * @return int TRUE if the macro exists, otherwise FALSE.
- */
-static int is_macro_exist(MacroNode *head, char *macro_name) {
+int is_macro_exist(MacroNode *head, char *macro_name) {
     /* Traverse the macro linked list */
     while (head != NULL) {
 
@@ -181,126 +181,203 @@ static int is_macro_exist(MacroNode *head, char *macro_name) {
     return FALSE;
 }
 
-int check_preprocessing_errors(FILE *fd) {
-    char line[MAX_LINE] = {0};
+int check_preprocessing_line(char *line, int number_of_line) {
     char copy_line[MAX_LINE] = {0};
     char macro_name[MAX_LINE] = {0};
     char command[MAX_LINE] = {0};
-
-    int number_of_line = 0;
+    char *token;
+    char *save_pointer;
 
     int error_flag = ERROR_WAS_NOT_FOUND;
 
-    /* Read the file line by line */
-    while (fgets(line, sizeof(line), fd)) {
-        number_of_line++;
-        /* If the current line is not a comment line or empty line */
-        if(!is_empty_or_comment(line)) {
-            strcpy(copy_line, line);
-            strcpy(command,strtok(copy_line, " :,\n\t"));
+    /* If the current line is not a comment line or empty line */
+    if(!is_empty_or_comment(line)) {
+        strcpy(copy_line, line);
 
-            /* Check if the line defines a macro */
-            if (strcmp(command, "mcro") == 0) {
+        /* A line of separators alone has no command */
+        token = strtok_r(copy_line, " :,\n\t", &save_pointer);
+        if (token != NULL) {
+            strcpy(command, token);
+        }
 
-                /* Extract the macro name */
-                strcpy(macro_name, strtok(NULL, "\n"));
+        /* Check if the line defines a macro */
+        if (strcmp(command, "mcro") == 0) {
 
-                /* Validate the macro name and definition format */
-                if ((check_macro_name(macro_name, number_of_line) == 1) ||
-                    check_macro_definition_line(line, number_of_line) == 1) {
-                    error_flag = ERROR_FOUND;
-                }
+            /* Extract the macro name, empty if the line ends after "mcro" */
+            token = strtok_r(NULL, "\n", &save_pointer);
+            if (token != NULL) {
+                strcpy(macro_name, token);
             }
 
-            /* Check if the line marks the end of a macro */
-            if (strcmp(command, "mcroend") == 0) {
+            /* Validate the macro name and definition format */
+            if ((check_macro_name(macro_name, number_of_line, line) == 1) ||
+                check_macro_definition_line(line, number_of_line) == 1) {
+                error_flag = ERROR_FOUND;
+            }
+        }
 
-                /* Validate the termination line format */
-                if (check_macro_termination_line(line, number_of_line) == 1) {
-                    error_flag = ERROR_FOUND;
-                }
+        /* Check if the line marks the end of a macro */
+        if (strcmp(command, "mcroend") == 0) {
+
+            /* Validate the termination line format */
+            if (check_macro_termination_line(line, number_of_line) == 1) {
+                error_flag = ERROR_FOUND;
             }
         }
     }
-    /* Return whether an error was found */
     return error_flag;
 }
 
-MacroNode * file_preprocessing(FILE *fd, char *output_filename) {
-    MacroNode *head_of_macro_table = NULL;
-    MacroState macro_state = MACRO_OUTSIDE; /* Flag to indicate if we are inside a macro definition */
-
+int check_preprocessing_errors(SourceFile *source) {
     char line[MAX_LINE] = {0};
-    char copy_line[MAX_LINE] = {0};
-    char macro_name[MAX_LINE] = {0};
-    char command[MAX_LINE] = {0};
 
-    /* Open the output file for writing */
-    FILE *output_file = fopen(output_filename, "w");
-    if (check_file_open(output_file, output_filename) == FALSE) {
-        exit(1);
+    int number_of_line = 0;
+
+    int error_flag = ERROR_WAS_NOT_FOUND;
+
+    /* Read the file line by line, until the diagnostics reach their limit */
+    while (!is_diagnostic_limit_reached() && read_source_line(line, sizeof(line), source)) {
+        number_of_line++;
+        if (check_preprocessing_line(line, number_of_line) == ERROR_FOUND) {
+            error_flag = ERROR_FOUND;
+        }
     }
+    /* Return whether an error was found */
+    return error_flag;
+}
 
-    /* Read the file line by line */
-    while (fgets(line, sizeof(line), fd)) {
-        strcpy(copy_line, line);
+void begin_macro_expansion(MacroExpansion *expansion) {
+    expansion->head_of_macro_table = NULL;
+    expansion->macro_state = MACRO_OUTSIDE;
+    expansion->macro_name[0] = '\0';
+}
 
-        /* If the current line is not a comment line or empty line */
-        if(!is_empty_or_comment(line)) {
+int expand_macro_line(MacroExpansion *expansion, char *line, OutputBuffer *expanded) {
+    char copy_line[MAX_LINE] = {0};
+    char command[MAX_LINE] = {0};
+    char *save_pointer;
 
-            /* If not currently inside a macro definition */
-            if (macro_state == MACRO_OUTSIDE)  {
+    strcpy(copy_line, line);
 
-                /* Extract the first word of the line */
-                strcpy(command, strtok(copy_line, " \n\t"));
+    /* If the current line is not a comment line or empty line */
+    if(!is_empty_or_comment(line)) {
 
-                /* Check if the line contains a previously defined macro */
-                if (is_macro_exist(head_of_macro_table, command) == 1) {
-                    char *combined;
+        /* If not currently inside a macro definition */
+        if (expansion->macro_state == MACRO_OUTSIDE)  {
 
-                    /* Get the macro's content */
-                    combined = str_combined(head_of_macro_table, command);
+            /* Extract the first word of the line */
+            strcpy(command, strtok_r(copy_line, " \n\t", &save_pointer));
 
-                    /* Write the macro's content to the output file */
-                    fputs(combined, output_file);
-                    free(combined);
+            /* Check if the line contains a previously defined macro */
+            if (is_macro_exist(expansion->head_of_macro_table, command) == 1) {
+                char *combined;
 
-                } else {
-                    /* Check if the current line starts a macro definition */
-                    if (strcmp(command, "mcro") == 0) {
+                /* Get the macro's content */
+                combined = str_combined(expansion->head_of_macro_table, command);
+                if (combined == NULL) {
+                    return FALSE;
+                }
 
-                        /* Change state to inside macro */
-                        macro_state = MACRO_INSIDE;
+                /* Write the macro's content to the expanded output */
+                output_append_string(expanded, combined);
+                free(combined);
 
-                        /* Extract the macro name */
-                        strcpy(macro_name, strtok(NULL, "\n"));
+            } else {
+                /* Check if the current line starts a macro definition */
+                if (strcmp(command, "mcro") == 0) {
+                    char *name;
 
-                        /* Add the macro name to the macro table */
-                        add_macro_name(&head_of_macro_table, macro_name);
-                    } else {
+                    /* Change state to inside macro */
+                    expansion->macro_state = MACRO_INSIDE;
 
-                        /* Write non-macro lines to output file */
-                        fputs(line, output_file);
+                    /* Extract the macro name, empty if the line ends after "mcro" */
+                    name = strtok_r(NULL, "\n", &save_pointer);
+                    strcpy(expansion->macro_name, name != NULL ? name : "");
+
+                    /* Add the macro name to the macro table */
+                    if (add_macro_name(&expansion->head_of_macro_table, expansion->macro_name) == FALSE) {
+                        return FALSE;
                     }
+                } else {
+
+                    /* Write non-macro lines to the expanded output */
+                    output_append_string(expanded, line);
                 }
-            } else {  /* If currently inside a macro definition */
-                strcpy(command, strtok(copy_line, " \n\t"));
+            }
+        } else {  /* If currently inside a macro definition */
+            strcpy(command, strtok_r(copy_line, " \n\t", &save_pointer));
 
-                /* Check if the current line ends a macro definition */
-                if (strcmp(command, "mcroend") == 0) {
+            /* Check if the current line ends a macro definition */
+            if (strcmp(command, "mcroend") == 0) {
 
-                    /* Change state to outside macro */
-                    macro_state = MACRO_OUTSIDE;
-                } else {
+                /* Change state to outside macro */
+                expansion->macro_state = MACRO_OUTSIDE;
+            } else {
 
-                    /* Add the current line to the macro definition */
-                    add_macro_content(head_of_macro_table, macro_name, line);
+                /* Add the current line to the macro definition */
+                if (add_macro_content(expansion->head_of_macro_table, expansion->macro_name, line) == FALSE) {
+                    return FALSE;
                 }
             }
         }
     }
+    return expanded->is_out_of_memory ? FALSE : TRUE;
+}
+
+int file_preprocessing(SourceFile *source, OutputBuffer *expanded, MacroNode **head_of_macro_table) {
+    MacroExpansion expansion;
+    char line[MAX_LINE] = {0};
+
+    begin_macro_expansion(&expansion);
 
-    /* Close the output file */
-    fclose(output_file);
-    return head_of_macro_table;
+    /* Read the file line by line */
+    while (read_source_line(line, sizeof(line), source)) {
+        if (expand_macro_line(&expansion, line, expanded) == FALSE) {
+            free_macro_nodes(expansion.head_of_macro_table);
+            *head_of_macro_table = NULL;
+            return FALSE;
+        }
+    }
+
+    *head_of_macro_table = expansion.head_of_macro_table;
+    return TRUE;
+}
+
+int stream_file_preprocessing(SourceFile *source, char *file_name, MacroNode **head_of_macro_table) {
+    MacroExpansion expansion;
+    OutputBuffer pending = {NULL, 0, 0};
+    char line[MAX_LINE] = {0};
+    int status = TRUE;
+    int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    *head_of_macro_table = NULL;
+    if (fd == -1) {
+        report_diagnostic("Error opening file: %s\n", file_name);
+        return FALSE;
+    }
+    begin_macro_expansion(&expansion);
+
+    /* Read the file line by line, writing the expanded lines out once enough of them were gathered */
+    while (status == TRUE && read_source_line(line, sizeof(line), source)) {
+        if (expand_macro_line(&expansion, line, &pending) == FALSE) {
+            status = ERROR_OUT_OF_MEMORY;
+        } else if (pending.length >= STREAMED_EXPANSION_SIZE) {
+            status = write_output_bytes(fd, &pending);
+            output_reset(&pending);
+        }
+    }
+    if (status == TRUE) {
+        status = write_output_bytes(fd, &pending);
+    }
+    free_output_buffer(&pending);
+    if (close(fd) != 0 && status == TRUE) {
+        status = FALSE;
+    }
+
+    if (status != TRUE) {
+        free_macro_nodes(expansion.head_of_macro_table);
+        return status;
+    }
+    *head_of_macro_table = expansion.head_of_macro_table;
+    return TRUE;
 }
@@ -1,9 +1,12 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include "first_second_pass.h"
 #include "first_second_pass_data.h"
 #include "error_handler.h"
+#include "diagnostics.h"
 
 
 /**
@@ -110,9 +113,8 @@ void add_missing_word(BinaryMachineCode *head_of_code_list, char *word) {
 
         /* Checks if the current word in the binary machine code list is marked as incomplete ("?") */
         if (strcmp(current_code->word, "?") == 0) {
-            free(current_code->word);
             /* replace the placeholder with the given word */
-            current_code->word = word;
+            replace_word(current_code, word);
             return;
         }
 
@@ -121,19 +123,19 @@ void add_missing_word(BinaryMachineCode *head_of_code_list, char *word) {
     }
 }
 
-int check_errors_in_second_pass(FILE *fd, SymbolNode * head_of_symbol_table) {
+int check_errors_in_second_pass(SourceFile *source, SymbolNode * head_of_symbol_table) {
     char line[MAX_LINE] = {0};
     int line_number = 1;
     int error_flag = ERROR_WAS_NOT_FOUND;
 
-    /* Read line by line from the file until the end */
-    while (fgets(line, sizeof(line), fd)) {
+    /* Read line by line from the file until the end, or until the diagnostics reach their limit */
+    while (!is_diagnostic_limit_reached() && read_source_line(line, sizeof(line), source)) {
         ErrorCode error_check = NO_ERROR;
         error_check = check_line_errors_second_pass(line, head_of_symbol_table);
 
         /* If an error is found, print it and update the error flag */
         if (error_check != NO_ERROR) {
-            print_error(error_check, line_number);
+            report_line_error(error_check, line_number, line);
             error_flag = ERROR_FOUND;
         }
         line_number++;
@@ -141,8 +143,7 @@ int check_errors_in_second_pass(FILE *fd, SymbolNode * head_of_symbol_table) {
     return error_flag;
 }
 
-SecondPassResult second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList **head_of_line_list) {
-    SecondPassResult result;
+int second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList **head_of_line_list, SecondPassResult *result) {
     AssemblyLineList *current_line_list = *head_of_line_list;
 
     /* Traverse through the assembly line list */
@@ -150,6 +151,7 @@ SecondPassResult second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList
         int next_flag = 0;
         char *current_line = current_line_list->line;
         char *command;
+        char *save_pointer;
 
         char line_copy[MAX_LINE] = {0};
 
@@ -159,12 +161,12 @@ SecondPassResult second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList
         if (is_symbol(current_line) == TRUE) {
 
             /* Extract the command after the label */
-            strtok(line_copy, ":");
-            command = strtok(NULL, " \n\t");
+            strtok_r(line_copy, ":", &save_pointer);
+            command = strtok_r(NULL, " \n\t", &save_pointer);
         } else {
 
             /* Extract the command from the beginning of the line */
-            command = strtok(line_copy, " \n\t");
+            command = strtok_r(line_copy, " \n\t", &save_pointer);
 
         }
 
@@ -177,7 +179,7 @@ SecondPassResult second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList
                 char *symbol;
 
                 /* Extract the symbol name */
-                symbol = strtok(NULL, " \n\t");
+                symbol = strtok_r(NULL, " \n\t", &save_pointer);
 
                 /* Mark the symbol as an entry in the symbol table */
                 mark_as_entry(head_of_symbol_table, symbol);
@@ -199,8 +201,7 @@ SecondPassResult second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList
                     *head_of_line_list = temp->next;
                 }
 
-                free(temp->code->word);
-                free(temp->code);
+                free_word_list(temp->code);
                 free(temp->line);
                 free(temp);
 
@@ -208,9 +209,9 @@ SecondPassResult second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList
             } else {
 
                 /* Check if extra word is needed */
-                if(needs_extra(current_line_list->code) == TRUE) {
-                    /* Create the missing word */
-                    create_missing_word_second_pass(current_line_list, head_of_symbol_table);
+                if(needs_extra(current_line_list->code) == TRUE &&
+                   create_missing_word_second_pass(current_line_list, head_of_symbol_table) == FALSE) {
+                    return FALSE;
                 }
             }
         }
@@ -220,9 +221,9 @@ SecondPassResult second_pass(SymbolNode *head_of_symbol_table, AssemblyLineList
             current_line_list = current_line_list->next;
         }
     }
-    result.head_of_lines_list = *head_of_line_list;
-    result.head_of_symbol_table = head_of_symbol_table;
+    result->head_of_lines_list = *head_of_line_list;
+    result->head_of_symbol_table = head_of_symbol_table;
 
-    /*print_assembly_lines(result.head_of_lines_list); */
-    return result;
+    /*print_assembly_lines(result->head_of_lines_list); */
+    return TRUE;
 }
@@ -0,0 +1,135 @@
+#include <string.h>
+#include "sha256.h"
+
+#define MASK_32 0xFFFFFFFFUL /* Keeps the low 32 bits, unsigned long may be wider */
+#define ROTATE_RIGHT(x, n) ((((x) >> (n)) | ((x) << (32 - (n)))) & MASK_32)
+
+/* The round constants, the first 32 bits of the fractional parts of the cube roots of the first 64 primes */
+static const unsigned long round_constants[64] = {
+    0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+    0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+    0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL, 0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+    0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL, 0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+    0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL, 0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+    0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL, 0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+    0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL, 0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+    0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL, 0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+/**
+ * Runs the compression function over the full block of a hash.
+ *
+ * @param hash Pointer to the hash
+ * @return void
+ */
+static void compress_block(Sha256 *hash) {
+    unsigned long schedule[64];
+    unsigned long a, b, c, d, e, f, g, h;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        schedule[i] = ((unsigned long)hash->block[4 * i] << 24) | ((unsigned long)hash->block[4 * i + 1] << 16) |
+                      ((unsigned long)hash->block[4 * i + 2] << 8) | (unsigned long)hash->block[4 * i + 3];
+    }
+    for (i = 16; i < 64; i++) {
+        unsigned long s0 = ROTATE_RIGHT(schedule[i - 15], 7) ^ ROTATE_RIGHT(schedule[i - 15], 18) ^ (schedule[i - 15] >> 3);
+        unsigned long s1 = ROTATE_RIGHT(schedule[i - 2], 17) ^ ROTATE_RIGHT(schedule[i - 2], 19) ^ (schedule[i - 2] >> 10);
+
+        schedule[i] = (schedule[i - 16] + s0 + schedule[i - 7] + s1) & MASK_32;
+    }
+
+    a = hash->state[0]; b = hash->state[1]; c = hash->state[2]; d = hash->state[3];
+    e = hash->state[4]; f = hash->state[5]; g = hash->state[6]; h = hash->state[7];
+
+    for (i = 0; i < 64; i++) {
+        unsigned long s1 = ROTATE_RIGHT(e, 6) ^ ROTATE_RIGHT(e, 11) ^ ROTATE_RIGHT(e, 25);
+        unsigned long choice = (e & f) ^ (~e & g);
+        unsigned long temp1 = (h + s1 + choice + round_constants[i] + schedule[i]) & MASK_32;
+        unsigned long s0 = ROTATE_RIGHT(a, 2) ^ ROTATE_RIGHT(a, 13) ^ ROTATE_RIGHT(a, 22);
+        unsigned long majority = (a & b) ^ (a & c) ^ (b & c);
+        unsigned long temp2 = (s0 + majority) & MASK_32;
+
+        h = g; g = f; f = e;
+        e = (d + temp1) & MASK_32;
+        d = c; c = b; b = a;
+        a = (temp1 + temp2) & MASK_32;
+    }
+
+    hash->state[0] = (hash->state[0] + a) & MASK_32;
+    hash->state[1] = (hash->state[1] + b) & MASK_32;
+    hash->state[2] = (hash->state[2] + c) & MASK_32;
+    hash->state[3] = (hash->state[3] + d) & MASK_32;
+    hash->state[4] = (hash->state[4] + e) & MASK_32;
+    hash->state[5] = (hash->state[5] + f) & MASK_32;
+    hash->state[6] = (hash->state[6] + g) & MASK_32;
+    hash->state[7] = (hash->state[7] + h) & MASK_32;
+}
+
+void sha256_begin(Sha256 *hash) {
+    /* The first 32 bits of the fractional parts of the square roots of the first 8 primes */
+    hash->state[0] = 0x6a09e667UL; hash->state[1] = 0xbb67ae85UL;
+    hash->state[2] = 0x3c6ef372UL; hash->state[3] = 0xa54ff53aUL;
+    hash->state[4] = 0x510e527fUL; hash->state[5] = 0x9b05688cUL;
+    hash->state[6] = 0x1f83d9abUL; hash->state[7] = 0x5be0cd19UL;
+    hash->length_high = 0;
+    hash->length_low = 0;
+    hash->block_length = 0;
+}
+
+void sha256_update(Sha256 *hash, const void *bytes, size_t length) {
+    const unsigned char *input = (const unsigned char *) bytes;
+
+    while (length > 0) {
+        size_t part = sizeof(hash->block) - hash->block_length;
+
+        if (part > length) {
+            part = length;
+        }
+        memcpy(hash->block + hash->block_length, input, part);
+        hash->block_length += part;
+        input += part;
+        length -= part;
+
+        /* Count the bytes in 64 bits, carrying into the high word */
+        hash->length_low = (hash->length_low + part) & MASK_32;
+        if (hash->length_low < part) {
+            hash->length_high = (hash->length_high + 1) & MASK_32;
+        }
+
+        if (hash->block_length == sizeof(hash->block)) {
+            compress_block(hash);
+            hash->block_length = 0;
+        }
+    }
+}
+
+void sha256_end_hex(Sha256 *hash, char hex[SHA256_HEX_SIZE + 1]) {
+    static const char digits[] = "0123456789abcdef";
+    unsigned long bits_high = ((hash->length_high << 3) | (hash->length_low >> 29)) & MASK_32;
+    unsigned long bits_low = (hash->length_low << 3) & MASK_32;
+    int i;
+
+    /* Pad with a 1 bit and zeros up to the last 8 bytes of a block */
+    hash->block[hash->block_length++] = 0x80;
+    if (hash->block_length > 56) {
+        memset(hash->block + hash->block_length, 0, sizeof(hash->block) - hash->block_length);
+        compress_block(hash);
+        hash->block_length = 0;
+    }
+    memset(hash->block + hash->block_length, 0, 56 - hash->block_length);
+
+    /* The message length in bits, big-endian */
+    for (i = 0; i < 4; i++) {
+        hash->block[56 + i] = (unsigned char)((bits_high >> (24 - 8 * i)) & 0xFF);
+        hash->block[60 + i] = (unsigned char)((bits_low >> (24 - 8 * i)) & 0xFF);
+    }
+    compress_block(hash);
+
+    for (i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        unsigned long byte = (hash->state[i / 4] >> (24 - 8 * (i % 4))) & 0xFF;
+
+        hex[2 * i] = digits[byte >> 4];
+        hex[2 * i + 1] = digits[byte & 0xF];
+    }
+    hex[SHA256_HEX_SIZE] = '\0';
+}
@@ -0,0 +1,47 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+
+#define SHA256_DIGEST_SIZE 32 /* Size of a SHA-256 digest in bytes */
+#define SHA256_HEX_SIZE 64 /* Length of a SHA-256 digest written as hexadecimal digits */
+
+/**
+ * Holds the state of a SHA-256 hash that is fed in parts.
+ */
+typedef struct {
+    unsigned long state[8]; /* The eight 32-bit working values */
+    unsigned long length_high; /* The high 32 bits of the number of bytes hashed */
+    unsigned long length_low; /* The low 32 bits of the number of bytes hashed */
+    unsigned char block[64]; /* The bytes of the block being filled */
+    size_t block_length; /* The number of bytes in the block */
+} Sha256;
+
+/**
+ * Starts a SHA-256 hash.
+ *
+ * @param hash Pointer to the hash to initialize
+ * @return void
+ */
+void sha256_begin(Sha256 *hash);
+
+/**
+ * Feeds bytes to a SHA-256 hash.
+ *
+ * @param hash Pointer to the hash
+ * @param bytes Pointer to the bytes
+ * @param length The number of bytes
+ * @return void
+ */
+void sha256_update(Sha256 *hash, const void *bytes, size_t length);
+
+/**
+ * Finishes a SHA-256 hash and writes its digest as lowercase hexadecimal digits.
+ *
+ * @param hash Pointer to the hash
+ * @param hex The buffer to write the SHA256_HEX_SIZE digits and a terminating null character to
+ * @return void
+ */
+void sha256_end_hex(Sha256 *hash, char hex[SHA256_HEX_SIZE + 1]);
+
+#endif
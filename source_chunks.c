@@ -0,0 +1,89 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "source_chunks.h"
+#include "diagnostics.h"
+
+void split_source_chunks(SourceFile *source, SourceChunk *chunks, int number_of_chunks) {
+    size_t start = 0;
+    int i;
+
+    for (i = 0; i < number_of_chunks; i++) {
+        size_t end = source->size / number_of_chunks * (i + 1);
+
+        if (i == number_of_chunks - 1) {
+            end = source->size;
+        } else if (end <= start) {
+            end = start;
+        } else {
+            char *newline = memchr(source->data + end, '\n', source->size - end);
+            end = newline == NULL ? source->size : (size_t)(newline - source->data) + 1;
+        }
+
+        chunks[i].data = source->data + start;
+        chunks[i].size = end - start;
+        start = end;
+    }
+}
+
+/**
+ * Represents a function to run on one element, on a thread of run_on_threads.
+ */
+typedef struct {
+    void *(*function)(void *); /* The function to run */
+    void *element; /* The element to run it on */
+    OutputBuffer *sink; /* The diagnostic sink of the thread that started it */
+    DiagnosticReport *report; /* The diagnostic report of the thread that started it */
+    pthread_t thread; /* The thread running it */
+    int is_started; /* TRUE if the thread was created */
+} ThreadTask;
+
+/**
+ * The main function of a thread of run_on_threads.
+ *
+ * @param argument Pointer to the ThreadTask
+ * @return void* The value the function returned
+ */
+static void *run_thread_task(void *argument) {
+    ThreadTask *task = (ThreadTask *) argument;
+
+    capture_diagnostics(task->sink);
+    use_diagnostic_report(task->report);
+    return task->function(task->element);
+}
+
+void run_on_threads(void *(*function)(void *), void *elements, size_t element_size, int number_of_elements) {
+    ThreadTask *tasks = (ThreadTask *) malloc(number_of_elements * sizeof(ThreadTask));
+    int i;
+
+    /* Without room to track the threads, run every element on the calling thread */
+    if (tasks == NULL) {
+        for (i = 0; i < number_of_elements; i++) {
+            function((char *) elements + i * element_size);
+        }
+        return;
+    }
+
+    for (i = 1; i < number_of_elements; i++) {
+        tasks[i].function = function;
+        tasks[i].element = (char *) elements + i * element_size;
+        tasks[i].sink = current_diagnostics_sink();
+        tasks[i].report = current_diagnostic_report();
+        tasks[i].is_started = pthread_create(&tasks[i].thread, NULL, run_thread_task, &tasks[i]) == 0;
+        if (!tasks[i].is_started) {
+            function(tasks[i].element);
+        }
+    }
+    if (number_of_elements > 0) {
+        function(elements);
+    }
+
+    for (i = 1; i < number_of_elements; i++) {
+        if (tasks[i].is_started) {
+            pthread_join(tasks[i].thread, NULL);
+        }
+    }
+    free(tasks);
+}
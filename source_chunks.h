@@ -0,0 +1,38 @@
+#ifndef SOURCE_CHUNKS_H
+#define SOURCE_CHUNKS_H
+
+#include "source_file.h"
+
+/**
+ * Represents a chunk of whole lines of a source, as a range of its bytes.
+ */
+typedef struct {
+    char *data; /* The first byte of the chunk */
+    size_t size; /* The number of bytes of the chunk */
+} SourceChunk;
+
+/**
+ * Splits a source into chunks of about the same size. Every chunk but the last ends right after a newline,
+ * so reading the chunks one after the other gives exactly the lines of the whole source. Chunks may be empty.
+ *
+ * @param source Pointer to the source to split
+ * @param chunks The array to fill with the chunks
+ * @param number_of_chunks The number of chunks
+ * @return void
+ */
+void split_source_chunks(SourceFile *source, SourceChunk *chunks, int number_of_chunks);
+
+/**
+ * Runs a function on every element of an array, each on its own thread, and waits for all of them.
+ * The calling thread runs the first element itself, and any element whose thread could not be created.
+ * The threads report their diagnostics to the sink of the calling thread.
+ *
+ * @param function The function to run, given a pointer to an element
+ * @param elements The array of elements
+ * @param element_size The size of an element in bytes
+ * @param number_of_elements The number of elements
+ * @return void
+ */
+void run_on_threads(void *(*function)(void *), void *elements, size_t element_size, int number_of_elements);
+
+#endif
@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "macro_data.h"
+#include "source_file.h"
+
+int map_source_file(SourceFile *source, char *file_name) {
+    struct stat file_status;
+    void *mapped;
+    int fd;
+
+    source->data = NULL;
+    source->size = 0;
+    source->position = 0;
+    source->storage = SOURCE_MAPPED;
+
+    fd = open(file_name, O_RDONLY);
+    if (fd == -1) {
+        return FALSE;
+    }
+
+    if (fstat(fd, &file_status) == -1) {
+        close(fd);
+        return FALSE;
+    }
+
+    /* An empty file cannot be mapped, it is represented by an empty source */
+    if (file_status.st_size == 0) {
+        close(fd);
+        return TRUE;
+    }
+
+    mapped = mmap(NULL, (size_t)file_status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    /* The mapping keeps its own reference to the file */
+    close(fd);
+
+    if (mapped == MAP_FAILED) {
+        return FALSE;
+    }
+
+    /* Every stage reads the file from start to end */
+    posix_madvise(mapped, (size_t)file_status.st_size, POSIX_MADV_SEQUENTIAL);
+
+    source->data = (char *)mapped;
+    source->size = (size_t)file_status.st_size;
+    return TRUE;
+}
+
+int read_source_stream(SourceFile *source, int fd) {
+    size_t capacity = 0;
+
+    source->data = NULL;
+    source->size = 0;
+    source->position = 0;
+    source->storage = SOURCE_HEAP;
+
+    /* Read until the end of the stream, growing the buffer as needed */
+    while (1) {
+        ssize_t bytes_read;
+
+        if (source->size == capacity) {
+            char *new_data;
+
+            capacity = capacity == 0 ? 65536 : capacity * 2;
+            new_data = (char *) realloc(source->data, capacity);
+
+            /* Check if memory allocation was successful */
+            if (check_memory_allocation(new_data) == FALSE) {
+                free(source->data);
+                source->data = NULL;
+                source->size = 0;
+                return FALSE;
+            }
+            source->data = new_data;
+        }
+
+        bytes_read = read(fd, source->data + source->size, capacity - source->size);
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            free(source->data);
+            source->data = NULL;
+            source->size = 0;
+            return FALSE;
+        }
+        if (bytes_read == 0) {
+            return TRUE;
+        }
+        source->size += (size_t)bytes_read;
+    }
+}
+
+void view_source_buffer(SourceFile *source, char *data, size_t size) {
+    source->data = data;
+    source->size = size;
+    source->position = 0;
+    source->storage = SOURCE_BORROWED;
+}
+
+void close_source_file(SourceFile *source) {
+    if (source->data != NULL && source->storage == SOURCE_MAPPED) {
+        munmap(source->data, source->size);
+    }
+    if (source->storage == SOURCE_HEAP) {
+        free(source->data);
+    }
+    source->data = NULL;
+    source->size = 0;
+    source->position = 0;
+}
+
+void rewind_source_file(SourceFile *source) {
+    source->position = 0;
+}
+
+char *read_source_line(char *line, int size, SourceFile *source) {
+    size_t remaining = source->size - source->position;
+    size_t length;
+    char *newline;
+
+    /* Check if the end of the file was reached */
+    if (remaining == 0 || size <= 1) {
+        return NULL;
+    }
+
+    /* Copy at most size - 1 characters, up to and including the next newline */
+    length = remaining < (size_t)(size - 1) ? remaining : (size_t)(size - 1);
+    newline = memchr(source->data + source->position, '\n', length);
+    if (newline != NULL) {
+        length = (size_t)(newline - (source->data + source->position)) + 1;
+    }
+
+    memcpy(line, source->data + source->position, length);
+    line[length] = '\0';
+    source->position += length;
+    return line;
+}
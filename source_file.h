@@ -0,0 +1,81 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <stddef.h>
+
+/**
+ * Represents where the bytes of a source file are stored.
+ */
+typedef enum {
+    SOURCE_MAPPED, /* Mapped read-only from a file */
+    SOURCE_HEAP, /* Read from a stream into memory owned by the source */
+    SOURCE_BORROWED /* A view of memory owned by the caller */
+} SourceStorage;
+
+/**
+ * Represents a source file held in memory, with a read position for line by line reading.
+ */
+typedef struct {
+    char *data; /* The bytes of the file, NULL for an empty file */
+    size_t size; /* The size of the file in bytes */
+    size_t position; /* The offset of the next byte to read */
+    SourceStorage storage; /* Where the bytes are stored */
+} SourceFile;
+
+/**
+ * Opens a file and maps its content read-only into memory,
+ * hinting the kernel that the file will be read sequentially.
+ *
+ * @param source Pointer to the source file structure to fill
+ * @param file_name The name of the file to map
+ * @return int TRUE if the file was mapped successfully, FALSE otherwise
+ */
+int map_source_file(SourceFile *source, char *file_name);
+
+/**
+ * Reads a whole stream (such as standard input or a pipe) into memory as a source file.
+ *
+ * @param source Pointer to the source file structure to fill
+ * @param fd The file descriptor to read until its end
+ * @return int TRUE if the stream was read successfully, FALSE otherwise
+ */
+int read_source_stream(SourceFile *source, int fd);
+
+/**
+ * Makes a source file that reads from memory owned by the caller, without copying it.
+ *
+ * @param source Pointer to the source file structure to fill
+ * @param data Pointer to the bytes to read
+ * @param size The number of bytes to read
+ * @return void
+ */
+void view_source_buffer(SourceFile *source, char *data, size_t size);
+
+/**
+ * Releases a source file, unmapping or freeing its bytes if the source owns them.
+ *
+ * @param source Pointer to the source file
+ * @return void
+ */
+void close_source_file(SourceFile *source);
+
+/**
+ * Moves the read position of a source file back to its beginning.
+ *
+ * @param source Pointer to the source file
+ * @return void
+ */
+void rewind_source_file(SourceFile *source);
+
+/**
+ * Reads the next line of a mapped source file, with the same semantics as fgets:
+ * at most size - 1 characters are copied, stopping after a newline character.
+ *
+ * @param line The buffer to copy the line into
+ * @param size The size of the buffer
+ * @param source Pointer to the source file
+ * @return char* The buffer, or NULL if the end of the file was reached
+ */
+char *read_source_line(char *line, int size, SourceFile *source);
+
+#endif
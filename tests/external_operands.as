@@ -0,0 +1,8 @@
+.extern W
+.extern Z
+MAIN:   cmp #1, W
+        mov Z, W
+        add r1, Z
+        lea W, r3
+        jmp W
+        stop
@@ -0,0 +1,4 @@
+.entry L38
+   L38: not r1
+	L2: mov L38, r2
+L3: stop
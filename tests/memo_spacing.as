@@ -0,0 +1,8 @@
+MAIN: mov r1, r2
+  mov   r1 ,r2
+ mov r1,r2
+	mov	r1, r2   
+ add #1, LIST
+X: add   #1,LIST
+ stop
+LIST: .data 3
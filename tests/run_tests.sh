@@ -0,0 +1,76 @@
+#!/bin/sh
+# Runs the regression tests: builds the assembler, assembles every tests/NAME.as in each mode
+# and compares the outputs with the expected tests/NAME.ob, tests/NAME.ent and tests/NAME.ext.
+# A missing expected file means the output must not be written.
+# The library is then built as libassembler.a from every source but assembler.c,
+# and every tests/test_NAME.c is linked with it and run.
+#
+# Usage: tests/run_tests.sh [compiler]
+
+CC=${1:-gcc}
+CFLAGS="-ansi -pedantic -Wall -pthread"
+TESTS_DIR=$(cd "$(dirname "$0")" && pwd)
+SOURCE_DIR=$(dirname "$TESTS_DIR")
+WORK_DIR=$(mktemp -d) || exit 1
+MODES="default --one-pass --low-memory"
+failures=0
+
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+if ! $CC $CFLAGS -o "$WORK_DIR/assembler" "$SOURCE_DIR"/*.c; then
+    echo "FAIL: the assembler does not build"
+    exit 1
+fi
+
+for source in "$TESTS_DIR"/*.as; do
+    name=$(basename "$source" .as)
+    for mode in $MODES; do
+        rm -f "$WORK_DIR/$name".*
+        cp "$source" "$WORK_DIR/$name.as"
+        if [ "$mode" = default ]; then
+            (cd "$WORK_DIR" && ./assembler "$name" > "$name.log" 2>&1)
+        else
+            (cd "$WORK_DIR" && ./assembler "$mode" "$name" > "$name.log" 2>&1)
+        fi
+        for extension in ob ent ext; do
+            expected="$TESTS_DIR/$name.$extension"
+            actual="$WORK_DIR/$name.$extension"
+            if [ -f "$expected" ] || [ -f "$actual" ]; then
+                if ! cmp -s "$expected" "$actual"; then
+                    echo "FAIL: $name.$extension ($mode)"
+                    failures=$((failures + 1))
+                fi
+            fi
+        done
+    done
+done
+
+mkdir "$WORK_DIR/library"
+for library_source in $(ls "$SOURCE_DIR"/*.c | grep -v '/assembler\.c$'); do
+    if ! $CC $CFLAGS -c -o "$WORK_DIR/library/$(basename "$library_source" .c).o" "$library_source"; then
+        echo "FAIL: the library does not build"
+        exit 1
+    fi
+done
+if ! ar rcs "$WORK_DIR/libassembler.a" "$WORK_DIR"/library/*.o; then
+    echo "FAIL: the library does not build"
+    exit 1
+fi
+
+for test in "$TESTS_DIR"/test_*.c; do
+    [ -f "$test" ] || continue
+    name=$(basename "$test" .c)
+    if ! $CC $CFLAGS -o "$WORK_DIR/$name" "$test" "$WORK_DIR/libassembler.a"; then
+        echo "FAIL: $name does not build"
+        failures=$((failures + 1))
+    elif ! "$WORK_DIR/$name"; then
+        echo "FAIL: $name"
+        failures=$((failures + 1))
+    fi
+done
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures failed"
+    exit 1
+fi
+echo "all passed"
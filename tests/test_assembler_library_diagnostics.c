@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <string.h>
+#include "../assembler_library.h"
+
+/**
+ * Holds a diagnostic an assembly is expected to give.
+ */
+typedef struct {
+    int line_number; /* The expected line */
+    int code; /* The expected code */
+    int column_start; /* The expected start of the span */
+    int column_end; /* The expected end of the span */
+    const char *message; /* The expected message */
+} ExpectedDiagnostic;
+
+/**
+ * Assembles a source and checks that its diagnostics are the expected ones, field by field.
+ *
+ * @param source The source, null-terminated
+ * @param name The name given to the source, or NULL for the default one
+ * @param expected The expected diagnostics, in order
+ * @param number_of_expected The number of expected diagnostics
+ * @return int 0 if the diagnostics are the expected ones, 1 otherwise
+ */
+static int check_diagnostics(const char *source, const char *name, const ExpectedDiagnostic *expected,
+                             int number_of_expected) {
+    AssemblerResults results;
+    const char *file = name != NULL ? name : "-";
+    int failures = 0;
+    int i;
+
+    if (assemble_buffer(source, strlen(source), name, NULL, &results) != ASSEMBLY_HAS_ERRORS) {
+        printf("FAIL: \"%s\" did not report errors\n", file);
+        return 1;
+    }
+    if (results.number_of_diagnostics != number_of_expected) {
+        printf("FAIL: \"%s\" gave %d diagnostics instead of %d\n", file, results.number_of_diagnostics,
+               number_of_expected);
+        free_assembler_results(&results, NULL);
+        return 1;
+    }
+    for (i = 0; i < number_of_expected; i++) {
+        AssemblerDiagnostic *diagnostic = &results.diagnostics[i];
+
+        if (strcmp(diagnostic->file, file) != 0 || diagnostic->line_number != expected[i].line_number ||
+            diagnostic->code != expected[i].code || diagnostic->column_start != expected[i].column_start ||
+            diagnostic->column_end != expected[i].column_end || strcmp(diagnostic->message, expected[i].message) != 0) {
+            printf("FAIL: diagnostic %d of \"%s\" is %s:%d code %d [%d,%d] \"%s\"\n", i, file, diagnostic->file,
+                   diagnostic->line_number, diagnostic->code, diagnostic->column_start, diagnostic->column_end,
+                   diagnostic->message);
+            failures = 1;
+        }
+    }
+    free_assembler_results(&results, NULL);
+    return failures;
+}
+
+int main(void) {
+    static const ExpectedDiagnostic first_pass[] = {
+        {1, 4, 0, 12, "Missing comma."},
+        {2, 0, 2, 8, "Undefined command name."}
+    };
+    static const ExpectedDiagnostic second_pass[] = {
+        {2, 13, 2, 13, "Used symbol not found."}
+    };
+    static const ExpectedDiagnostic empty[] = {
+        {0, -1, 0, 0, "The source is empty."}
+    };
+    int failures = 0;
+
+    /* The records carry what the JSON diagnostics of the assembler give for the same source */
+    failures += check_diagnostics("MAIN: mov r1\n  foo r2\n  stop\n", "prog.as", first_pass, 2);
+    failures += check_diagnostics("  stop\n  jmp UNKNOWN\n", "prog.as", second_pass, 1);
+
+    /* A diagnostic that is not about a line has no line and no code */
+    failures += check_diagnostics("", NULL, empty, 1);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "../assembler_library.h"
+
+#define NUMBER_OF_LINES 4000 /* The lines of the source, enough for the working memory to grow over many limits */
+#define LIMIT_STEP (64L * 1024) /* The address space added to the limit from one assembly to the next */
+#define MAX_STEPS 400 /* The largest number of limits tried */
+
+/**
+ * Reads the address space the process already uses.
+ *
+ * @return long The size of the address space in bytes, or -1 if it cannot be read
+ */
+static long address_space_in_use(void) {
+    FILE *statm = fopen("/proc/self/statm", "r");
+    long pages = -1;
+
+    if (statm == NULL) {
+        return -1;
+    }
+    if (fscanf(statm, "%ld", &pages) != 1) {
+        pages = -1;
+    }
+    fclose(statm);
+    return pages < 0 ? -1 : pages * sysconf(_SC_PAGESIZE);
+}
+
+int main(void) {
+    static const char *lines[] = {"  add #5, r2\n", "  jmp &MAIN\n"};
+    AssemblerResults results;
+    AssemblyStatus status;
+    struct rlimit limit;
+    char *source;
+    size_t length = 0;
+    long in_use;
+    long step_limit = 0;
+    int i;
+    int has_run_out = 0;
+    int has_succeeded = 0;
+
+    source = malloc(NUMBER_OF_LINES * 32);
+    if (source == NULL) {
+        return 1;
+    }
+    strcpy(source, "MAIN: mov r1, LIST\n");
+    length = strlen(source);
+    for (i = 2; i < NUMBER_OF_LINES; i++) {
+        strcpy(source + length, lines[i % 2]);
+        length += strlen(source + length);
+    }
+    strcpy(source + length, "LIST: .data 6, -9\n");
+    length += strlen(source + length);
+    in_use = address_space_in_use();
+    if (in_use < 0 || getrlimit(RLIMIT_AS, &limit) != 0) {
+        /* The address space cannot be limited here, there is nothing to check */
+        free(source);
+        return 0;
+    }
+
+    /* Every limit either lets the assembly succeed or makes it report running out of memory */
+    for (i = 0; i < MAX_STEPS && !has_succeeded; i++) {
+        step_limit = in_use + i * LIMIT_STEP;
+        limit.rlim_cur = step_limit;
+        if (setrlimit(RLIMIT_AS, &limit) != 0) {
+            break;
+        }
+        status = assemble_buffer(source, length, NULL, NULL, &results);
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_AS, &limit);
+        if (status == ASSEMBLY_OUT_OF_MEMORY) {
+            if (results.object.data != NULL || results.diagnostics != NULL) {
+                printf("FAIL: results are not empty after running out of memory\n");
+                return 1;
+            }
+            has_run_out = 1;
+        } else if (status == ASSEMBLY_SUCCEEDED) {
+            has_succeeded = 1;
+        } else {
+            printf("FAIL: the assembly with a limit of %ld bytes returned %d\n", step_limit, (int) status);
+            return 1;
+        }
+        free_assembler_results(&results, NULL);
+    }
+    free(source);
+    if (!has_run_out || !has_succeeded) {
+        printf("FAIL: the limits did not cover both running out of memory and succeeding\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <string.h>
+#include "../instruction_encoder.h"
+#include "../first_second_pass.h"
+#include "../build_binary_word.h"
+
+/**
+ * Describes a symbol the resolver of the tests defines.
+ */
+typedef struct {
+    char *name; /* The name of the symbol */
+    int address; /* The address of the symbol, 0 for an external one */
+    int is_external; /* TRUE if the symbol is external */
+} TestSymbol;
+
+static TestSymbol test_symbols[] = {{"LIST", 130, FALSE}, {"LOOP", 110, FALSE}, {"EXT", 0, TRUE}};
+
+#define NUMBER_OF_TEST_SYMBOLS ((int) (sizeof(test_symbols) / sizeof(test_symbols[0])))
+
+/**
+ * Resolves the symbols of test_symbols.
+ *
+ * @param symbol_name The name of the symbol
+ * @param context Unused
+ * @param address Pointer to set to the address of the symbol
+ * @param is_external Pointer to set to TRUE if the symbol is external
+ * @return int TRUE if the symbol is one of test_symbols, FALSE otherwise
+ */
+static int resolve_test_symbol(const char *symbol_name, void *context, int *address, int *is_external) {
+    int i;
+
+    for (i = 0; i < NUMBER_OF_TEST_SYMBOLS; i++) {
+        if (strcmp(test_symbols[i].name, symbol_name) == 0) {
+            *address = test_symbols[i].address;
+            *is_external = test_symbols[i].is_external;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Assembles a line at address 100 with the first pass, then completes its symbol words with the second pass
+ * against a symbol table holding test_symbols, and checks that it gives the words of the encoded line.
+ *
+ * @param line The line
+ * @param encoded Pointer to the encoded line
+ * @return int 1 if the passes give the same words, 0 otherwise
+ */
+static int check_against_passes(const char *line, EncodedInstruction *encoded) {
+    FirstPassState state;
+    FirstPassResult result;
+    SymbolNode *symbol_table = NULL;
+    BinaryMachineCode *code;
+    char line_copy[MAX_LINE];
+    int number_of_words = 0;
+    int is_same = 1;
+    int i;
+
+    for (i = 0; i < NUMBER_OF_TEST_SYMBOLS; i++) {
+        if (insert_to_symbol_table(&symbol_table, test_symbols[i].name,
+                                   test_symbols[i].is_external ? EXTERN : CODE, test_symbols[i].address) == FALSE) {
+            return 0;
+        }
+    }
+    sprintf(line_copy, "%s\n", line);
+    begin_first_pass(&state);
+    if (first_pass_line(&state, line_copy) == FALSE) {
+        free_symbol_table(symbol_table);
+        return 0;
+    }
+    result = end_first_pass(&state);
+
+    if (create_missing_word_second_pass(result.head_of_lines_list, symbol_table) == FALSE) {
+        is_same = 0;
+    }
+    for (code = result.head_of_lines_list->code; is_same && code != NULL; code = code->next) {
+        if (number_of_words >= encoded->number_of_words ||
+            binary_word_value(code->word) != encoded->words[number_of_words]) {
+            printf("FAIL: \"%s\" word %d differs from the one of the passes\n", line, number_of_words);
+            is_same = 0;
+        }
+        number_of_words++;
+    }
+    if (is_same && number_of_words != encoded->number_of_words) {
+        printf("FAIL: \"%s\" has %d words, the passes give %d\n", line, encoded->number_of_words, number_of_words);
+        is_same = 0;
+    }
+
+    free_first_pass_result(&result);
+    free_symbol_table(symbol_table);
+    return is_same;
+}
+
+/**
+ * Encodes a line at address 100, resolving its symbols with test_symbols, and checks its exact words,
+ * then checks them against those the first and second pass give for the same line.
+ *
+ * @param line The line, an instruction without errors
+ * @param expected_words The words the line must encode to
+ * @param expected_number_of_words The number of words
+ * @return int 1 if the line encodes as expected, 0 otherwise
+ */
+static int check_resolved_encoding(const char *line, const unsigned long *expected_words,
+                                   int expected_number_of_words) {
+    EncodedInstruction encoded;
+    int i;
+
+    if (encode_instruction(line, 100, resolve_test_symbol, NULL, &encoded) != TRUE ||
+        encoded.number_of_words != expected_number_of_words) {
+        printf("FAIL: \"%s\" did not encode to %d words\n", line, expected_number_of_words);
+        return 0;
+    }
+    for (i = 0; i < expected_number_of_words; i++) {
+        if (encoded.words[i] != expected_words[i] || encoded.is_unresolved[i]) {
+            printf("FAIL: \"%s\" word %d is %06lx, not %06lx\n", line, i, encoded.words[i], expected_words[i]);
+            return 0;
+        }
+    }
+    return check_against_passes(line, &encoded);
+}
+
+/**
+ * Encodes a line without a resolver and checks its result, its words and its first error.
+ *
+ * @param line The line
+ * @param expected_result The result encode_instruction must return
+ * @param expected_words The words the line must encode to
+ * @param expected_number_of_words The number of words
+ * @param expected_error The first error, or NO_ERROR if the line must have none
+ * @return int 1 if the line encodes as expected, 0 otherwise
+ */
+static int check_encoding(const char *line, int expected_result, const unsigned long *expected_words,
+                          int expected_number_of_words, ErrorCode expected_error) {
+    EncodedInstruction encoded;
+    int result = encode_instruction(line, 100, NULL, NULL, &encoded);
+    int i;
+
+    if (result != expected_result || encoded.number_of_words != expected_number_of_words ||
+        (expected_error == NO_ERROR) != (encoded.number_of_errors == 0) ||
+        (expected_error != NO_ERROR && encoded.errors[0] != expected_error)) {
+        printf("FAIL: \"%s\" returned %d with %d words and %d errors\n", line, result, encoded.number_of_words,
+               encoded.number_of_errors);
+        return 0;
+    }
+    for (i = 0; i < expected_number_of_words; i++) {
+        if (encoded.words[i] != expected_words[i]) {
+            printf("FAIL: \"%s\" word %d is %06lx, not %06lx\n", line, i, encoded.words[i], expected_words[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    static const unsigned long not_r1[] = {0x141914};
+    static const unsigned long mov_r1_r2[] = {0x033a04};
+    static const unsigned long sub_r3_r4[] = {0x0b7c14};
+    static const unsigned long inc_r7[] = {0x141f1c};
+    static const unsigned long mov_immediate_r3[] = {0x001b04, 0xfffffc};
+    static const unsigned long cmp_list_immediate[] = {0x050004, 0x000412, 0x00002c};
+    static const unsigned long lea_list_r6[] = {0x111e04, 0x000412};
+    static const unsigned long jmp_relative_loop[] = {0x24100c, 0x000054};
+    static const unsigned long prn_ext[] = {0x340804, 0x000001};
+    static const unsigned long add_ext_list[] = {0x09080c, 0x000001, 0x000412};
+    int passed = 1;
+
+    /* A label after leading blanks is skipped like one at the start of the line */
+    passed &= check_encoding("L38: not r1", TRUE, not_r1, 1, NO_ERROR);
+    passed &= check_encoding("   L38: not r1", TRUE, not_r1, 1, NO_ERROR);
+    passed &= check_encoding("\tL38: not r1", TRUE, not_r1, 1, NO_ERROR);
+    passed &= check_encoding("  mov r1, r2", TRUE, mov_r1_r2, 1, NO_ERROR);
+    passed &= check_encoding("   L38: nop r1", FALSE, NULL, 0, ERR_UNDEFINED_COMMAND);
+
+    /* Two registers share the first word, and a single register is in it too */
+    passed &= check_resolved_encoding("mov r1, r2", mov_r1_r2, 1);
+    passed &= check_resolved_encoding("sub r3, r4", sub_r3_r4, 1);
+    passed &= check_resolved_encoding("inc r7", inc_r7, 1);
+
+    /* An immediate operand takes a word of its own, negative values in two's complement */
+    passed &= check_resolved_encoding("mov #-1, r3", mov_immediate_r3, 2);
+
+    /* A direct operand takes the address of its symbol, in operand order */
+    passed &= check_resolved_encoding("cmp LIST, #5", cmp_list_immediate, 3);
+    passed &= check_resolved_encoding("lea LIST, r6", lea_list_r6, 2);
+
+    /* A relative operand takes the distance from the first word of the line */
+    passed &= check_resolved_encoding("jmp &LOOP", jmp_relative_loop, 2);
+
+    /* An external symbol takes a word marked external */
+    passed &= check_resolved_encoding("prn EXT", prn_ext, 2);
+    passed &= check_resolved_encoding("add EXT, LIST", add_ext_list, 3);
+
+    /* A directive encodes to no words */
+    passed &= check_encoding("  L1: .data 5", TRUE, NULL, 0, NO_ERROR);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../output_buffer.h"
+
+int main(void) {
+    OutputBuffer frames = {NULL, 0, 0};
+    OutputBuffer payload = {NULL, 0, 0};
+    char name[MAX_FRAME_NAME];
+    int pipe_fds[2];
+    int passed = 1;
+
+    /* An empty payload is read into a buffer that never held anything */
+    output_append_frame(&frames, "ent", "", 0);
+    output_append_frame(&frames, "ob", "100 5\n", 6);
+    if (pipe(pipe_fds) != 0 || write_output_bytes(pipe_fds[1], &frames) == 0) {
+        printf("FAIL: the frames could not be written\n");
+        return 1;
+    }
+    close(pipe_fds[1]);
+
+    if (read_output_frame(pipe_fds[0], name, &payload) == 0 || strcmp(name, "ent") != 0 || payload.length != 0) {
+        printf("FAIL: the empty frame was not read\n");
+        passed = 0;
+    }
+    if (read_output_frame(pipe_fds[0], name, &payload) == 0 || strcmp(name, "ob") != 0 || payload.length != 6 ||
+        memcmp(payload.data, "100 5\n", 6) != 0) {
+        printf("FAIL: the frame after the empty one was not read\n");
+        passed = 0;
+    }
+    if (read_output_frame(pipe_fds[0], name, &payload) != 0) {
+        printf("FAIL: a frame was read past the end of the input\n");
+        passed = 0;
+    }
+
+    close(pipe_fds[0]);
+    free_output_buffer(&frames);
+    free_output_buffer(&payload);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include "../work_stealing_pool.h"
+#include "../diagnostics.h"
+
+#define NUMBER_OF_JOBS 1000 /* The jobs of the pool that runs */
+#define TOO_MANY_JOBS 100000000 /* Jobs whose queues do not fit in the limited address space */
+#define LIMITED_ADDRESS_SPACE (256L * 1024 * 1024) /* The address space the pool that cannot start gets */
+
+/**
+ * Counts a run of a job.
+ *
+ * @param job_index The index of the job
+ * @param worker_index The index of the worker running it
+ * @param context Pointer to the run counts of the jobs
+ * @return void
+ */
+static void count_run(int job_index, int worker_index, void *context) {
+    ((int *) context)[job_index]++;
+}
+
+int main(void) {
+    static long costs[NUMBER_OF_JOBS];
+    static int runs[NUMBER_OF_JOBS];
+    WorkStealingPool pool;
+    OutputBuffer diagnostics = {NULL, 0, 0};
+    struct rlimit limit;
+    int i;
+
+    /* Every job runs exactly once */
+    for (i = 0; i < NUMBER_OF_JOBS; i++) {
+        costs[i] = i % 7;
+    }
+    if (start_work_stealing_pool(&pool, NUMBER_OF_JOBS, costs, 4, count_run, runs) == 0) {
+        printf("FAIL: the pool did not start\n");
+        return 1;
+    }
+    for (i = 0; i < NUMBER_OF_JOBS; i++) {
+        wait_for_job(&pool, i);
+    }
+    join_work_stealing_pool(&pool);
+    for (i = 0; i < NUMBER_OF_JOBS; i++) {
+        if (runs[i] != 1) {
+            printf("FAIL: job %d ran %d times\n", i, runs[i]);
+            return 1;
+        }
+    }
+
+    /* A pool whose memory cannot be allocated reports it instead of ending the process */
+    capture_diagnostics(&diagnostics);
+    if (getrlimit(RLIMIT_AS, &limit) != 0) {
+        return 0;
+    }
+    limit.rlim_cur = LIMITED_ADDRESS_SPACE;
+    if (setrlimit(RLIMIT_AS, &limit) != 0) {
+        return 0;
+    }
+    if (start_work_stealing_pool(&pool, TOO_MANY_JOBS, costs, 4, count_run, runs) != 0) {
+        printf("FAIL: the pool started without its memory\n");
+        return 1;
+    }
+    return 0;
+}
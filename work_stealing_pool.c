@@ -0,0 +1,211 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include "macro_data.h"
+#include "work_stealing_pool.h"
+
+/**
+ * Represents a job and its estimated cost while the jobs are ordered.
+ */
+typedef struct {
+    long cost; /* The estimated cost of the job */
+    int index; /* The index of the job */
+} JobCost;
+
+/**
+ * Compares two jobs by their cost, the largest first, and by their index for equal costs.
+ *
+ * @param first Pointer to the first JobCost
+ * @param second Pointer to the second JobCost
+ * @return int A negative value if the first job runs before the second, a positive value otherwise
+ */
+static int compare_job_costs(const void *first, const void *second) {
+    const JobCost *first_job = (const JobCost *) first;
+    const JobCost *second_job = (const JobCost *) second;
+
+    if (first_job->cost != second_job->cost) {
+        return first_job->cost > second_job->cost ? -1 : 1;
+    }
+    return first_job->index - second_job->index;
+}
+
+/**
+ * Takes the next job from the front of a worker's own queue.
+ *
+ * @param queue Pointer to the queue of the worker
+ * @return int The index of the job, or -1 if the queue is empty
+ */
+static int take_job(WorkQueue *queue) {
+    int job = -1;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->front < queue->back) {
+        job = queue->jobs[queue->front++];
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return job;
+}
+
+/**
+ * Steals a job from the back of another worker's queue.
+ *
+ * @param queue Pointer to the queue to steal from
+ * @return int The index of the job, or -1 if the queue is empty
+ */
+static int steal_job(WorkQueue *queue) {
+    int job = -1;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->front < queue->back) {
+        job = queue->jobs[--queue->back];
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return job;
+}
+
+/**
+ * The main function of a worker thread. It runs the jobs of its own queue, then steals from the
+ * other queues until all of them are empty. No jobs are added after the pool starts, so a worker
+ * that finds every queue empty is done.
+ *
+ * @param argument Pointer to the Worker
+ * @return void* Always NULL
+ */
+static void *run_worker(void *argument) {
+    Worker *worker = (Worker *) argument;
+    WorkStealingPool *pool = worker->pool;
+
+    while (1) {
+        int job = take_job(&pool->queues[worker->index]);
+        int i;
+
+        /* Look for a victim, starting with the next worker */
+        for (i = 1; job == -1 && i < pool->number_of_workers; i++) {
+            job = steal_job(&pool->queues[(worker->index + i) % pool->number_of_workers]);
+        }
+        if (job == -1) {
+            return NULL;
+        }
+
+        pool->run_job(job, worker->index, pool->context);
+
+        pthread_mutex_lock(&pool->done_lock);
+        pool->is_done[job] = TRUE;
+        pthread_cond_broadcast(&pool->job_done);
+        pthread_mutex_unlock(&pool->done_lock);
+    }
+}
+
+/**
+ * Frees the memory of a pool and destroys the locks of its queues.
+ *
+ * @param pool Pointer to the pool
+ * @param number_of_queues The number of queues whose jobs and lock were set up
+ * @return void
+ */
+static void free_pool_memory(WorkStealingPool *pool, int number_of_queues) {
+    int i;
+
+    for (i = 0; i < number_of_queues; i++) {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+        free(pool->queues[i].jobs);
+    }
+    free(pool->is_done);
+    free(pool->workers);
+    free(pool->queues);
+    pool->is_done = NULL;
+    pool->workers = NULL;
+    pool->queues = NULL;
+}
+
+int start_work_stealing_pool(WorkStealingPool *pool, int number_of_jobs, long *job_costs, int number_of_workers,
+                             JobFunction run_job, void *context) {
+    JobCost *order;
+    int started = 0;
+    int i;
+
+    if (number_of_workers < 1) {
+        number_of_workers = 1;
+    }
+
+    pool->number_of_workers = number_of_workers;
+    pool->run_job = run_job;
+    pool->context = context;
+    pool->queues = (WorkQueue *) malloc(number_of_workers * sizeof(WorkQueue));
+    pool->workers = (Worker *) malloc(number_of_workers * sizeof(Worker));
+    pool->is_done = (char *) calloc(number_of_jobs + 1, sizeof(char));
+    order = (JobCost *) malloc((number_of_jobs + 1) * sizeof(JobCost));
+
+    /* Check if memory allocation was successful, the caller runs the jobs itself otherwise */
+    if (check_memory_allocation(pool->queues) == FALSE || check_memory_allocation(pool->workers) == FALSE ||
+        check_memory_allocation(pool->is_done) == FALSE || check_memory_allocation(order) == FALSE) {
+        free(order);
+        free_pool_memory(pool, 0);
+        return FALSE;
+    }
+
+    /* Order the jobs largest first, so the long ones do not end up last */
+    for (i = 0; i < number_of_jobs; i++) {
+        order[i].cost = job_costs[i];
+        order[i].index = i;
+    }
+    qsort(order, number_of_jobs, sizeof(JobCost), compare_job_costs);
+
+    /* Deal the jobs round-robin, every queue holds its jobs largest first */
+    for (i = 0; i < number_of_workers; i++) {
+        pool->queues[i].jobs = (int *) malloc((number_of_jobs / number_of_workers + 1) * sizeof(int));
+        if (check_memory_allocation(pool->queues[i].jobs) == FALSE) {
+            free(order);
+            free_pool_memory(pool, i);
+            return FALSE;
+        }
+        pool->queues[i].front = 0;
+        pool->queues[i].back = 0;
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+    for (i = 0; i < number_of_jobs; i++) {
+        WorkQueue *queue = &pool->queues[i % number_of_workers];
+        queue->jobs[queue->back++] = order[i].index;
+    }
+    free(order);
+
+    pthread_mutex_init(&pool->done_lock, NULL);
+    pthread_cond_init(&pool->job_done, NULL);
+
+    /* The jobs of a worker that could not be started are stolen by the others */
+    for (i = 0; i < number_of_workers; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        pool->workers[i].is_started = pthread_create(&pool->workers[i].thread, NULL, run_worker, &pool->workers[i]) == 0;
+        if (pool->workers[i].is_started) {
+            started++;
+        }
+    }
+
+    if (started == 0) {
+        join_work_stealing_pool(pool);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void wait_for_job(WorkStealingPool *pool, int job_index) {
+    pthread_mutex_lock(&pool->done_lock);
+    while (!pool->is_done[job_index]) {
+        pthread_cond_wait(&pool->job_done, &pool->done_lock);
+    }
+    pthread_mutex_unlock(&pool->done_lock);
+}
+
+void join_work_stealing_pool(WorkStealingPool *pool) {
+    int i;
+
+    for (i = 0; i < pool->number_of_workers; i++) {
+        if (pool->workers[i].is_started) {
+            pthread_join(pool->workers[i].thread, NULL);
+        }
+    }
+    pthread_mutex_destroy(&pool->done_lock);
+    pthread_cond_destroy(&pool->job_done);
+    free_pool_memory(pool, pool->number_of_workers);
+}
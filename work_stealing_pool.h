@@ -0,0 +1,86 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <pthread.h>
+
+/**
+ * A function that runs one job of the pool.
+ *
+ * @param job_index The index of the job to run
+ * @param worker_index The index of the worker thread running it, from 0 to the number of workers - 1
+ * @param context The context pointer given to the pool
+ */
+typedef void (*JobFunction)(int job_index, int worker_index, void *context);
+
+/**
+ * Represents the queue of jobs owned by one worker. The owner takes jobs from the front,
+ * and idle workers steal from the back.
+ */
+typedef struct {
+    int *jobs; /* The job indices, the queued ones are jobs[front] to jobs[back - 1] */
+    int front; /* Index of the next job the owner takes */
+    int back; /* Index past the job a thief takes */
+    pthread_mutex_t lock; /* Protects front and back */
+} WorkQueue;
+
+struct WorkStealingPool;
+
+/**
+ * Represents one worker thread of the pool.
+ */
+typedef struct {
+    struct WorkStealingPool *pool; /* The pool the worker belongs to */
+    int index; /* The index of the worker and of the queue it owns */
+    pthread_t thread; /* The thread running the worker */
+    int is_started; /* TRUE if the thread was created */
+} Worker;
+
+/**
+ * Represents a pool of worker threads that run a fixed set of jobs.
+ * The jobs are dealt to per-worker queues, largest first, and a worker whose queue
+ * runs dry steals from the queues of the others, so uneven jobs keep every worker busy.
+ */
+typedef struct WorkStealingPool {
+    WorkQueue *queues; /* One queue per worker */
+    Worker *workers; /* The worker threads */
+    int number_of_workers; /* The number of worker threads */
+    JobFunction run_job; /* The function that runs a job */
+    void *context; /* The context pointer passed to run_job */
+    char *is_done; /* TRUE for every job that has finished */
+    pthread_mutex_t done_lock; /* Protects is_done */
+    pthread_cond_t job_done; /* Signaled whenever a job finishes */
+} WorkStealingPool;
+
+/**
+ * Starts a pool of worker threads running a set of jobs.
+ *
+ * @param pool Pointer to the pool to start
+ * @param number_of_jobs The number of jobs, numbered from 0
+ * @param job_costs The estimated cost of every job (e.g. the size of its input), used to run the largest jobs first
+ * @param number_of_workers The number of worker threads
+ * @param run_job The function that runs a job
+ * @param context The context pointer passed to run_job
+ * @return int TRUE if the pool was started, FALSE if no thread could be created or memory ran out,
+ *         in which case nothing is left to release and the caller runs the jobs itself
+ */
+int start_work_stealing_pool(WorkStealingPool *pool, int number_of_jobs, long *job_costs, int number_of_workers,
+                             JobFunction run_job, void *context);
+
+/**
+ * Waits until a job of the pool has finished.
+ *
+ * @param pool Pointer to the pool
+ * @param job_index The index of the job to wait for
+ * @return void
+ */
+void wait_for_job(WorkStealingPool *pool, int job_index);
+
+/**
+ * Waits for all the worker threads to finish and frees the memory allocated for the pool.
+ *
+ * @param pool Pointer to the pool
+ * @return void
+ */
+void join_work_stealing_pool(WorkStealingPool *pool);
+
+#endif